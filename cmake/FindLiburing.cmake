@@ -0,0 +1,32 @@
+######################################################
+# - Try to find liburing (https://github.com/axboe/liburing)
+# Once done this will define
+#  LIBURING_FOUND - System has liburing
+#  LIBURING_INCLUDE_DIRS - The liburing include directories
+#  LIBURING_LIBRARIES - The libraries needed to use liburing
+#  LIBURING_DEFINITIONS - Compiler switches required for using liburing
+
+######################################################
+set(LIBURING_PREFIX ${CMAKE_INSTALL_PREFIX} CACHE STRING "Help cmake to find liburing library (https://github.com/axboe/liburing) into your system.")
+
+######################################################
+find_path(LIBURING_INCLUDE_DIR liburing.h
+	HINTS ${LIBURING_PREFIX}/include)
+
+######################################################
+find_library(LIBURING_LIBRARY NAMES uring
+	HINTS ${LIBURING_PREFIX}/lib ${LIBURING_PREFIX}/lib64)
+
+######################################################
+set(LIBURING_LIBRARIES ${LIBURING_LIBRARY} )
+set(LIBURING_INCLUDE_DIRS ${LIBURING_INCLUDE_DIR} )
+
+######################################################
+include(FindPackageHandleStandardArgs)
+# handle the QUIETLY and REQUIRED arguments and set LIBURING_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(Liburing  DEFAULT_MSG
+	LIBURING_LIBRARY LIBURING_INCLUDE_DIR)
+
+######################################################
+mark_as_advanced(LIBURING_INCLUDE_DIR LIBURING_LIBRARY )
@@ -819,6 +819,37 @@ int write_data_to_object_async(struct clovis_aio_op *aio)
 	return 0;
 }
 
+/*
+ * read_data_from_object_async()
+ * reads from an object in async manner
+ */
+int read_data_from_object_async(struct clovis_aio_op *aio)
+{
+	struct m0_clovis_obj    *obj;
+	struct m0_clovis_op_ops  op_ops;
+	struct clovis_aio_opgrp *grp;
+
+	grp = aio->cao_grp;
+	obj = &grp->cag_obj;
+
+	/* Create an READ op. */
+	m0_clovis_obj_op(obj, M0_CLOVIS_OC_READ,
+			 &aio->cao_ext, &aio->cao_data,
+			 &aio->cao_attr, 0, &aio->cao_op);
+	aio->cao_op->op_datum = aio;
+
+	/* Set op's Callbacks */
+	op_ops.oop_executed = clovis_aio_executed_cb;
+	op_ops.oop_stable = clovis_aio_stable_cb;
+	op_ops.oop_failed = clovis_aio_failed_cb;
+	m0_clovis_op_setup(aio->cao_op, &op_ops, 0);
+
+	/* Launch the read request */
+	m0_clovis_op_launch(&aio->cao_op, 1);
+
+	return 0;
+}
+
 /*
  * read_data_from_object()
  * read data from an object
@@ -881,6 +912,33 @@ void clovis_aio_vec_free(struct clovis_aio_op *aio)
 	m0_bufvec_free(&aio->cao_attr);
 }
 
+/*
+ * clovis_aio_vec_empty_alloc()
+ * allocate the vectors without the data buffers, the caller
+ * makes cao_data point to its own memory (zero copy).
+ */
+int clovis_aio_vec_empty_alloc(struct clovis_aio_op *aio, uint32_t blk_count)
+{
+	int rc = 0;
+
+	rc = m0_bufvec_empty_alloc(&aio->cao_data, blk_count) ?:
+	     m0_bufvec_alloc(&aio->cao_attr, blk_count, 1) ?:
+	     m0_indexvec_alloc(&aio->cao_ext, blk_count);
+	if (rc != 0) {
+		m0_bufvec_free2(&aio->cao_data);
+		m0_bufvec_free(&aio->cao_attr);
+	}
+	return rc;
+}
+
+void clovis_aio_vec_empty_free(struct clovis_aio_op *aio)
+{
+	/* Free the vectors but not the data buffers we do not own */
+	m0_indexvec_free(&aio->cao_ext);
+	m0_bufvec_free2(&aio->cao_data);
+	m0_bufvec_free(&aio->cao_attr);
+}
+
 int clovis_aio_opgrp_init(struct clovis_aio_opgrp *grp,
 				 int blk_cnt, int op_cnt)
 {
@@ -117,9 +117,12 @@ int write_data_to_object(struct m0_uint128 id, struct m0_indexvec *ext,
                                 struct m0_bufvec *data, struct m0_bufvec *attr);
 
 int write_data_to_object_async(struct clovis_aio_op *aio);
+int read_data_from_object_async(struct clovis_aio_op *aio);
 int clovis_aio_vec_alloc(struct clovis_aio_op *aio,
 			       uint32_t blk_count, uint32_t blk_size);
 void clovis_aio_vec_free(struct clovis_aio_op *aio);
+int clovis_aio_vec_empty_alloc(struct clovis_aio_op *aio, uint32_t blk_count);
+void clovis_aio_vec_empty_free(struct clovis_aio_op *aio);
 int clovis_aio_opgrp_init(struct clovis_aio_opgrp *grp,
 				 int blk_cnt, int op_cnt);
 void clovis_aio_opgrp_fini(struct clovis_aio_opgrp *grp);
@@ -0,0 +1,123 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <algorithm>
+//local
+#include "../common/Debug.hpp"
+#include "CreditTracker.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the credit tracker.
+ * @param capacity Number of messages the server can receive at the same time.
+ * @param window Maximum number of credits held by a client.
+**/
+CreditTracker::CreditTracker(size_t capacity, size_t window)
+{
+	//check
+	assert(window > 0);
+
+	//setup
+	this->capacity = capacity;
+	this->window = window;
+	this->outstanding = 0;
+	this->warned = false;
+}
+
+/****************************************************/
+/**
+ * Compute the credits to piggy-back on a message sent to the client. It
+ * refills the client window as much as the free capacity permits and always
+ * leaves at least one credit to the client.
+ * @param clientId The libfabric ID of the client.
+ * @return The number of new credits given to the client.
+**/
+uint32_t CreditTracker::grant(uint64_t clientId)
+{
+	//vars
+	size_t & held = this->held[clientId];
+	size_t credits = 0;
+
+	//refill the window with the free credits
+	if (held < this->window && this->outstanding < this->capacity)
+		credits = std::min(this->window - held, this->capacity - this->outstanding);
+
+	//never let the client without credit
+	if (held + credits == 0) {
+		credits = 1;
+		if (this->warned == false) {
+			IOC_WARNING_ARG("More clients than the %1 messages the server can receive, the flow control is oversubscribed !")
+				.arg(this->capacity)
+				.end();
+			this->warned = true;
+		}
+	}
+
+	//apply
+	held += credits;
+	this->outstanding += credits;
+	return credits;
+}
+
+/****************************************************/
+/**
+ * Give back the credit used by the client to send a message.
+ * @param clientId The libfabric ID of the client.
+**/
+void CreditTracker::onReceive(uint64_t clientId)
+{
+	//search
+	auto it = this->held.find(clientId);
+
+	//check
+	if (it == this->held.end() || it->second == 0) {
+		IOC_WARNING_ARG("Client %1 sent a message without credit !").arg(clientId).end();
+		return;
+	}
+
+	//release
+	it->second--;
+	this->outstanding--;
+}
+
+/****************************************************/
+/**
+ * Give back all the credits held by a client which disconnected so they
+ * can be granted to the other ones.
+ * @param clientId The libfabric ID of the client.
+**/
+void CreditTracker::forget(uint64_t clientId)
+{
+	//search
+	auto it = this->held.find(clientId);
+	if (it == this->held.end())
+		return;
+
+	//release
+	assert(this->outstanding >= it->second);
+	this->outstanding -= it->second;
+	this->held.erase(it);
+}
+
+/****************************************************/
+/**
+ * @param clientId The libfabric ID of the client.
+ * @return The number of credits currently held by the client.
+**/
+size_t CreditTracker::getHeld(uint64_t clientId) const
+{
+	auto it = this->held.find(clientId);
+	if (it == this->held.end())
+		return 0;
+	else
+		return it->second;
+}
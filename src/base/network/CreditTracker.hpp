@@ -0,0 +1,62 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_CREDIT_TRACKER_HPP
+#define IOC_CREDIT_TRACKER_HPP
+
+/****************************************************/
+//std
+#include <cstdlib>
+#include <cstdint>
+#include <map>
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Keep track on the server side of the credits granted to the clients. A
+ * credit allows a client to send one message to the server. The credits are
+ * granted piggy-backed on the messages sent to the client and are given back
+ * when its messages are received. The total of the granted credits is
+ * limited to the number of messages the receive buffers can hold so the
+ * clients cannot overrun them.
+ *
+ * A client always keeps at least one credit otherwise it could not send
+ * anything anymore and would never get new credits. When there are more
+ * clients than the capacity the pool is then oversubscribed.
+ *
+ * It is only used from the polling thread so it is not protected.
+ * @brief Keep track of the credits granted to the clients.
+**/
+class CreditTracker
+{
+	public:
+		CreditTracker(size_t capacity, size_t window);
+		uint32_t grant(uint64_t clientId);
+		void onReceive(uint64_t clientId);
+		void forget(uint64_t clientId);
+		size_t getHeld(uint64_t clientId) const;
+		size_t getOutstanding(void) const {return this->outstanding;};
+		size_t getCapacity(void) const {return this->capacity;};
+		size_t getWindow(void) const {return this->window;};
+	private:
+		/** Number of messages the server can receive at the same time. **/
+		size_t capacity;
+		/** Maximum number of credits held by a client. **/
+		size_t window;
+		/** Number of credits held by all the clients. **/
+		size_t outstanding;
+		/** Already warned about the oversubscription. **/
+		bool warned;
+		/** Number of credits held by each client. **/
+		std::map<uint64_t, size_t> held;
+};
+
+}
+
+#endif //IOC_CREDIT_TRACKER_HPP
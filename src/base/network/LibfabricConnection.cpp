@@ -8,6 +8,7 @@
 //std
 #include <cassert>
 #include <cstring>
+#include <algorithm>
 //libfabric
 #include "rdma/fi_cm.h"
 #include "rdma/fi_rma.h"
@@ -29,6 +30,7 @@ LibfabricPostAction::LibfabricPostAction(void)
 	this->bufferId = IOC_LF_NO_BUFFER;
 	this->connection = NULL;
 	this->domainBuffer = NULL;
+	this->pool = NULL;
 };
 
 /****************************************************/
@@ -55,6 +57,29 @@ void LibfabricPostAction::attachDomainBuffer(LibfabricConnection * connection, v
 	this->domainBuffer = domainBuffer;
 }
 
+/****************************************************/
+/**
+ * Attach the pool from which the action has been built.
+ * @param pool The pool to return the action to on release.
+**/
+void LibfabricPostAction::setPool(LibfabricPostActionPool * pool)
+{
+	this->pool = pool;
+}
+
+/****************************************************/
+/**
+ * Destroy the action once it has been run and return it to its pool, or
+ * delete it if it has not been built from a pool.
+**/
+void LibfabricPostAction::release(void)
+{
+	if (this->pool != NULL)
+		this->pool->release(this);
+	else
+		delete this;
+}
+
 /****************************************************/
 /**
  * On deletion of the object we detach the attached recieve buffer to return it to
@@ -112,11 +137,23 @@ LibfabricConnection::LibfabricConnection(LibfabricDomain * lfDomain, bool passiv
 	this->recvBuffers = NULL;
 	this->nextEndpointId = 0;
 	this->recvBuffersSize = 0;
+	this->multiRecv = false;
+	this->recvSlabSize = 0;
 	this->tcpClientId = 0;
 	this->tcpClientKey = 0;
 	this->checkClientAuth = false;
 	this->disableReceive = false;
 	this->pendingAction = 0;
+	this->cqRing.resize(IOC_LF_CQ_RING_SIZE);
+	this->cqRingHead = 0;
+	this->cqRingCount = 0;
+	this->cqBatchSize = IOC_LF_DEFAULT_CQ_BATCH;
+	this->localEagerLimits.maxRead = IOC_EAGER_MAX_READ;
+	this->localEagerLimits.maxWrite = IOC_EAGER_MAX_WRITE;
+	this->creditTracker = NULL;
+	this->creditsEnabled = false;
+	this->credits = 0;
+	this->hasPendingDisconnects = false;
 
 	//debug
 	IOC_DEBUG("libfabric:conn", "Create new connection");
@@ -128,6 +165,10 @@ LibfabricConnection::LibfabricConnection(LibfabricDomain * lfDomain, bool passiv
 	//vars
 	int err;
 
+	//iov send, the descriptors are not needed as FI_MR_LOCAL is not requested
+	this->sendIovLimit = std::min(fi->tx_attr->iov_limit, (size_t)IOC_LF_MAX_SEND_IOV);
+	this->injectSize = std::min(fi->tx_attr->inject_size, (size_t)IOC_LF_MAX_INJECT_SIZE);
+
 	//to init completion queues
 	fi_cq_attr cq_attr;
 	fi_av_attr av_attr;
@@ -135,7 +176,7 @@ LibfabricConnection::LibfabricConnection(LibfabricDomain * lfDomain, bool passiv
 	memset(&av_attr, 0, sizeof(av_attr));
 	
 	//setup attr
-	cq_attr.format = FI_CQ_FORMAT_MSG;
+	cq_attr.format = FI_CQ_FORMAT_DATA;
 	cq_attr.size = fi->tx_attr->size;
 	if (passivePolling)
 		cq_attr.wait_obj = FI_WAIT_UNSPEC;
@@ -193,6 +234,10 @@ LibfabricConnection::~LibfabricConnection(void)
 	//destroy hooks
 	for (auto & it : this->hooks)
 		delete it.second;
+
+	//destroy credit tracker
+	if (this->creditTracker != NULL)
+		delete this->creditTracker;
 }
 
 /****************************************************/
@@ -225,9 +270,122 @@ void LibfabricConnection::postReceives(size_t size, int count)
 	}
 }
 
+/****************************************************/
+/**
+ * Allocate large receive slabs and post them with FI_MULTI_RECV so many
+ * messages land in the same buffer. The memory used then depends on the
+ * messages in flight and not on the maximum message size. A slab is reposted
+ * when the provider released it and all its messages have been terminated.
+ * If the provider does not support FI_MULTI_RECV it falls back on simple
+ * receive buffers of the maximum message size using the same total memory.
+ * @param slabSize Size of each slab.
+ * @param slabCount Number of slabs to allocate and post.
+ * @param maxMsgSize Maximum size of a message, the provider releases a slab
+ * when it has less free space.
+**/
+void LibfabricConnection::postMultiReceives(size_t slabSize, int slabCount, size_t maxMsgSize)
+{
+	//check
+	assert(slabCount > 0);
+	assume(slabSize >= maxMsgSize, "The receive slab size must be larger than the maximum message size !");
+
+	//fallback
+	if (this->lfDomain->supportsMultiRecv() == false) {
+		size_t count = (slabSize / maxMsgSize) * slabCount;
+		IOC_DEBUG_ARG("libfabric:conn", "FI_MULTI_RECV not supported, post %1 receive buffers of %2").arg(count).argUnit1024(maxMsgSize).end();
+		this->postReceives(maxMsgSize, count);
+		return;
+	}
+
+	//setup
+	this->multiRecv = true;
+	this->recvBuffersCount = slabCount;
+	this->recvBuffersSize = maxMsgSize;
+	this->recvSlabSize = slabSize;
+	this->recvSlabPending.assign(slabCount, 0);
+	this->recvSlabReleased.assign(slabCount, false);
+
+	//release the slabs when they cannot receive a message of the maximum size
+	int err = fi_setopt(&this->ep->fid, FI_OPT_ENDPOINT, FI_OPT_MIN_MULTI_RECV, &maxMsgSize, sizeof(maxMsgSize));
+	LIBFABRIC_CHECK_STATUS("fi_setopt", err);
+
+	//allocate & post
+	this->recvBuffers = new char * [slabCount];
+	for (int i = 0 ; i < slabCount ; i++) {
+		this->recvBuffers[i] = new char[slabSize];
+		this->postSlab(i);
+	}
+}
+
+/****************************************************/
+/**
+ * Post a receive slab to libfabric in multi receive mode.
+ * @param id ID of the slab to post.
+**/
+void LibfabricConnection::postSlab(size_t id)
+{
+	//debug
+	IOC_DEBUG_ARG("libfabric:conn", "Post receive slab %1").arg(id).end();
+
+	//build
+	struct iovec iov = {this->recvBuffers[id], this->recvSlabSize};
+	struct fi_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.iov_count = 1;
+	msg.addr = FI_ADDR_UNSPEC;
+	msg.context = (void*)id;
+
+	//post
+	int err = fi_recvmsg(this->ep, &msg, FI_MULTI_RECV);
+	LIBFABRIC_CHECK_STATUS("fi_recvmsg", err);
+}
+
+/****************************************************/
+/**
+ * Get the buffer containing the message of a receive completion. In multi
+ * receive mode it counts the message on its slab and tracks the release of
+ * the slab by the provider.
+ * @param entry The receive completion.
+ * @param size Set to the size of the buffer to deserialize.
+ * @return The buffer or NULL if the completion only releases a slab.
+**/
+void * LibfabricConnection::getRecvBuffer(const fi_cq_data_entry & entry, size_t & size)
+{
+	//vars
+	size_t id = (size_t)entry.op_context;
+	assert(id < this->recvBuffersCount);
+
+	//simple buffers
+	if (this->multiRecv == false) {
+		size = this->recvBuffersSize;
+		return this->recvBuffers[id];
+	}
+
+	//count the message
+	bool hasMessage = (entry.len > 0);
+	if (hasMessage)
+		this->recvSlabPending[id]++;
+
+	//released by the provider, repost if nothing is using it
+	if (entry.flags & FI_MULTI_RECV) {
+		this->recvSlabReleased[id] = true;
+		if (this->recvSlabPending[id] == 0) {
+			this->recvSlabReleased[id] = false;
+			this->postSlab(id);
+		}
+	}
+
+	//ret
+	size = entry.len;
+	return hasMessage ? entry.buf : NULL;
+}
+
 /****************************************************/
 /**
  * Republish a receive buffer to libfabric by identifying it by its ID.
+ * In multi receive mode it terminates one of the messages of the slab and
+ * reposts the slab when it was the last one and the provider released it.
  * @param id ID of the buffer to repost.
 **/
 void LibfabricConnection::repostReceive(size_t id)
@@ -235,6 +393,17 @@ void LibfabricConnection::repostReceive(size_t id)
 	//check
 	assumeArg(id <recvBuffersCount, "Invalid receive buffer ID: %1").arg(id).end();
 
+	//multi receive
+	if (this->multiRecv) {
+		assert(this->recvSlabPending[id] > 0);
+		this->recvSlabPending[id]--;
+		if (this->recvSlabPending[id] == 0 && this->recvSlabReleased[id]) {
+			this->recvSlabReleased[id] = false;
+			this->postSlab(id);
+		}
+		return;
+	}
+
 	//debug
 	IOC_DEBUG_ARG("libfabric:conn", "Repost receive buffer %1").arg(id).end();
 
@@ -271,11 +440,19 @@ void LibfabricConnection::joinServer(void)
 	if (err != 1)
 		LIBFABRIC_CHECK_STATUS("fi_av_insert", -1);
 
+	//check we can receive the eager reads
+	assumeArg(IOC_POST_RECEIVE_SIZE(this->localEagerLimits.maxRead) <= this->recvBuffersSize, "Receive buffers (%1) too small for the eager read size %2 !")
+		.arg(this->recvBuffersSize)
+		.arg(this->localEagerLimits.maxRead)
+		.end();
+
 	//build message data
 	LibfabricFirstClientMessage firstClientMessage;
 	err = fi_getname(&this->ep->fid, firstClientMessage.addr, &addrlen);
 	LIBFABRIC_CHECK_STATUS("fi_getname", err);
 	assert(addrlen <= IOC_LF_MAX_ADDR_LEN);
+	firstClientMessage.eagerMaxRead = this->localEagerLimits.maxRead;
+	firstClientMessage.eagerMaxWrite = this->localEagerLimits.maxWrite;
 
 	//register hook
 	this->registerHook(IOC_LF_MSG_ASSIGN_ID, [this](LibfabricConnection* connection, LibfabricClientRequest & request) {
@@ -294,6 +471,12 @@ void LibfabricConnection::joinServer(void)
 				.arg(firstHandshakeResponse.protocolVersion)
 				.end();
 
+		//keep the agreed eager limits
+		LibfabricEagerLimits & eagerLimits = this->remoteEagerLimits[IOC_LF_SERVER_ID];
+		eagerLimits.maxRead = firstHandshakeResponse.eagerMaxRead;
+		eagerLimits.maxWrite = firstHandshakeResponse.eagerMaxWrite;
+		IOC_DEBUG_ARG("libfabric:conn", "Eager limits agreed with server, read=%1, write=%2").arg(eagerLimits.maxRead).arg(eagerLimits.maxWrite).end();
+
 		//return back
 		return LF_WAIT_LOOP_UNBLOCK;
 	});
@@ -335,7 +518,7 @@ void LibfabricConnection::broadcastErrrorMessage(const std::string & message)
 	//send to all
 	size_t cnt = this->remoteLiAddr.size();
 	for (auto & it : this->remoteLiAddr) {
-		this->sendMessage(IOC_LF_MSG_FATAL_ERROR, it.first, errorMessage, new LibfabricPostActionNop(LF_WAIT_LOOP_UNBLOCK));
+		this->sendMessage(IOC_LF_MSG_FATAL_ERROR, it.first, errorMessage, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_UNBLOCK));
 	}
 
 	//wait all
@@ -367,6 +550,13 @@ void LibfabricConnection::sendRawMessage(void * buffer, size_t size, int destina
 	assert(buffer != NULL);
 	assert(size <= recvBuffersSize);
 
+	//no credit left, keep it until the server grants more
+	if (this->takeCredit(destinationEpId) == false) {
+		struct iovec iov = {buffer, size};
+		this->queueSend(&iov, 1, destinationEpId, postAction);
+		return;
+	}
+
 	//debug
 	IOC_DEBUG_ARG("libfabric:msg", "Send message: dest=%1, buffer=%2").arg(destinationEpId).arg(buffer).end();
 
@@ -388,6 +578,252 @@ void LibfabricConnection::sendRawMessage(void * buffer, size_t size, int destina
 	this->pendingAction++;
 }
 
+/****************************************************/
+/**
+ * Send a small message with fi_inject(). The buffer can be reused as soon as
+ * the function returns and no completion will be generated.
+ * @param buffer Buffer to be sent.
+ * @param size Size of the given buffer, it must be lower than the inject size.
+ * @param destrinationEpId ID of the destination.
+**/
+void LibfabricConnection::sendRawMessageInject(void * buffer, size_t size, int destinationEpId)
+{
+	//vars
+	int err;
+
+	//checks
+	assert(buffer != NULL);
+	assert(size <= this->injectSize);
+
+	//debug
+	IOC_DEBUG_ARG("libfabric:msg", "Inject message: dest=%1, size=%2").arg(destinationEpId).arg(size).end();
+
+	//search
+	auto it = this->remoteLiAddr.find(destinationEpId);
+	assumeArg(it != this->remoteLiAddr.end(), "Client endpoint id not found : %1")
+		.arg(destinationEpId)
+		.end();
+
+	//send
+	do {
+		err = fi_inject(this->ep, buffer, size, it->second);
+		if (err == -FI_EAGAIN)
+			this->pollAllCqInCache();
+	} while(err == -FI_EAGAIN);
+	LIBFABRIC_CHECK_STATUS("fi_inject", err);
+}
+
+/****************************************************/
+/**
+ * Send a message made of several buffers to the given destination ID. They are
+ * concatenated on the wire so the remote receives a single message. The
+ * buffers must stay valid until the post action is called.
+ * @param iov List of buffers to be sent.
+ * @param count Number of entries in the iov.
+ * @param destrinationEpId ID of the destination.
+ * @param postAction The action to be called when the message has been sent.
+**/
+void LibfabricConnection::sendRawMessagev(struct iovec * iov, size_t count, int destinationEpId, LibfabricPostAction * postAction)
+{
+	//vars
+	int err;
+
+	//checks
+	assert(iov != NULL);
+	assert(count > 0 && count <= this->sendIovLimit);
+
+	//compute size
+	size_t size = 0;
+	for (size_t i = 0 ; i < count ; i++)
+		size += iov[i].iov_len;
+	assert(size <= recvBuffersSize);
+
+	//no credit left, keep it until the server grants more
+	if (this->takeCredit(destinationEpId) == false) {
+		this->queueSend(iov, count, destinationEpId, postAction);
+		return;
+	}
+
+	//debug
+	IOC_DEBUG_ARG("libfabric:msg", "Send message: dest=%1, buffer=%2, fragments=%3").arg(destinationEpId).arg(iov[0].iov_base).arg(count).end();
+
+	//search
+	auto it = this->remoteLiAddr.find(destinationEpId);
+	assumeArg(it != this->remoteLiAddr.end(), "Client endpoint id not found : %1")
+		.arg(destinationEpId)
+		.end();
+
+	//build, no descriptors as for fi_send()
+	struct fi_msg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.desc = NULL;
+	msg.iov_count = count;
+	msg.addr = it->second;
+	msg.context = postAction;
+
+	//send
+	do {
+		err = fi_sendmsg(this->ep, &msg, FI_COMPLETION);
+		if (err == -FI_EAGAIN)
+			this->pollAllCqInCache();
+	} while(err == -FI_EAGAIN);
+	LIBFABRIC_CHECK_STATUS("fi_sendmsg", err);
+
+	//incr
+	this->pendingAction++;
+}
+
+/****************************************************/
+/**
+ * Compute the credits to piggy-back on a message. Only the server grants
+ * credits to its clients when the flow control is enabled.
+ * @param destinationEpId ID of the destination.
+ * @return The number of credits to put in the header.
+**/
+uint32_t LibfabricConnection::grantCredits(int destinationEpId)
+{
+	if (this->creditTracker == NULL)
+		return 0;
+	else
+		return this->creditTracker->grant(destinationEpId);
+}
+
+/****************************************************/
+/**
+ * Consume a credit before sending a message to the server. It always
+ * succeeds if the server did not enable the flow control.
+ * @param destinationEpId ID of the destination.
+ * @return False if there is no credit left, the message has to be queued.
+**/
+bool LibfabricConnection::takeCredit(int destinationEpId)
+{
+	//no flow control
+	if (this->creditsEnabled == false || destinationEpId != IOC_LF_SERVER_ID)
+		return true;
+
+	//consume
+	if (this->credits == 0)
+		return false;
+	this->credits--;
+	return true;
+}
+
+/****************************************************/
+/**
+ * Keep a message until the server grants a credit to send it.
+ * @param iov List of buffers to be sent.
+ * @param count Number of entries in the iov.
+ * @param destinationEpId ID of the destination.
+ * @param postAction The action to be called when the message has been sent.
+**/
+void LibfabricConnection::queueSend(struct iovec * iov, size_t count, int destinationEpId, LibfabricPostAction * postAction)
+{
+	//check
+	assert(count > 0 && count <= IOC_LF_MAX_SEND_IOV);
+
+	//debug
+	IOC_DEBUG_ARG("libfabric:msg", "No credit left, queue message: dest=%1, queued=%2").arg(destinationEpId).arg(this->creditQueue.size()).end();
+
+	//queue
+	LibfabricQueuedSend send;
+	memcpy(send.iov, iov, count * sizeof(struct iovec));
+	send.count = count;
+	send.destinationEpId = destinationEpId;
+	send.postAction = postAction;
+	this->creditQueue.push_back(send);
+}
+
+/****************************************************/
+/**
+ * Account the credits piggy-backed on a message received from the server
+ * and send the messages waiting for them.
+ * @param credits Number of credits granted by the server.
+**/
+void LibfabricConnection::onCredits(uint32_t credits)
+{
+	//nothing granted or we are the server
+	if (credits == 0 || this->creditTracker != NULL)
+		return;
+
+	//the server uses the flow control
+	this->creditsEnabled = true;
+	this->credits += credits;
+
+	//send the messages waiting for a credit
+	while (this->credits > 0 && this->creditQueue.empty() == false) {
+		LibfabricQueuedSend send = this->creditQueue.front();
+		this->creditQueue.pop_front();
+		if (send.count == 1)
+			this->sendRawMessage(send.iov[0].iov_base, send.iov[0].iov_len, send.destinationEpId, send.postAction);
+		else
+			this->sendRawMessagev(send.iov, send.count, send.destinationEpId, send.postAction);
+	}
+}
+
+/****************************************************/
+/**
+ * Enable the flow control on the server side. The clients get credits
+ * piggy-backed on the messages sent to them and cannot send more messages
+ * than the server can receive. It has to be called before the clients
+ * connect.
+ * @param capacity Number of messages the receive buffers can hold.
+ * @param window Maximum number of credits held by a client.
+**/
+void LibfabricConnection::enableCredits(size_t capacity, size_t window)
+{
+	//check
+	assert(window > 0);
+	assert(this->creditTracker == NULL);
+
+	//debug
+	IOC_DEBUG_ARG("libfabric:conn", "Enable flow control, capacity=%1, window=%2").arg(capacity).arg(window).end();
+
+	//setup
+	this->creditTracker = new CreditTracker(capacity, window);
+}
+
+/****************************************************/
+/**
+ * Notify the disconnection of a TCP client on the server side. It is called
+ * by the TCP thread so the event is passed to the polling thread which gives
+ * back the credits held by the endpoints of the client in the next poll().
+ * @param tcpClientId The TCP ID of the client.
+**/
+void LibfabricConnection::onClientDisconnect(uint64_t tcpClientId)
+{
+	std::lock_guard<std::mutex> lockGuard(this->disconnectMutex);
+	this->pendingDisconnects.push_back(tcpClientId);
+	this->hasPendingDisconnects = true;
+}
+
+/****************************************************/
+/**
+ * Handle the disconnections notified by onClientDisconnect() from the
+ * polling thread.
+**/
+void LibfabricConnection::applyPendingDisconnects(void)
+{
+	//extract
+	std::vector<uint64_t> disconnects;
+	{
+		std::lock_guard<std::mutex> lockGuard(this->disconnectMutex);
+		disconnects.swap(this->pendingDisconnects);
+		this->hasPendingDisconnects = false;
+	}
+
+	//release the credits of the endpoints of each client
+	for (auto & tcpClientId : disconnects) {
+		auto it = this->tcpClientEndpoints.find(tcpClientId);
+		if (it == this->tcpClientEndpoints.end())
+			continue;
+		if (this->creditTracker != NULL)
+			for (auto & epId : it->second)
+				this->creditTracker->forget(epId);
+		this->tcpClientEndpoints.erase(it);
+	}
+}
+
 /****************************************************/
 /**
  * Send a message to the given destination ID.
@@ -400,7 +836,7 @@ void LibfabricConnection::sendRawMessage(void * buffer, size_t size, int destina
 **/
 void LibfabricConnection::sendMessage(void * buffer, size_t size, int destinationEpId, std::function<LibfabricActionResult(void)> postAction)
 {
-	this->sendRawMessage(buffer, size, destinationEpId, new LibfabricPostActionFunction(postAction));
+	this->sendRawMessage(buffer, size, destinationEpId, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
 }
 
 /****************************************************/
@@ -416,6 +852,18 @@ void LibfabricConnection::sendRawMessageNoPollWakeup(void * buffer, size_t size,
 	this->sendRawMessage(buffer, size, destinationEpId, IOC_LF_NO_WAKEUP_POST_ACTION);
 }
 
+/****************************************************/
+/**
+ * Variant of rdmaRead() attaching a lambda function as post action.
+ * @param postAction A lambda function without parameters to be called when the operation completes.
+ * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
+ * or if it needs to return.
+**/
+void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, std::function<LibfabricActionResult(void)> postAction)
+{
+	this->rdmaRead(destinationEpId, localAddr, remoteAddr, remoteKey, size, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
+}
+
 /****************************************************/
 /**
  * Start a rdma read operation to fetch data from the remote server.
@@ -424,11 +872,11 @@ void LibfabricConnection::sendRawMessageNoPollWakeup(void * buffer, size_t size,
  * @param remoteAddr The remote address to read from.
  * @param remoteKey The remote key to be allowed to read the remote segment.
  * @param size the size to read.
- * @param postAction A lambda function without parameters to be called when the message has been sent.
- * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
- * or if it needs to return.
+ * @param postAction The action to run when the operation completes, typically built with
+ * newPostAction(). It returns a LibfabricActionResult which tell to the poll() function if it
+ * need to continue polling or if it needs to return.
 **/
-void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, std::function<LibfabricActionResult(void)> postAction)
+void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, LibfabricPostAction * postAction)
 {
 	//check
 	assert(localAddr != NULL);
@@ -455,7 +903,7 @@ void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, Libfab
 	//do action and retry while we got FI_EAGAIN error
 	int ret = 0;
 	do {
-		ret = fi_read(ep, localAddr, size, mrDesc, it->second, (uint64_t)remoteAddr, remoteKey, new LibfabricPostActionFunction(postAction));
+		ret = fi_read(ep, localAddr, size, mrDesc, it->second, (uint64_t)remoteAddr, remoteKey, postAction);
 		if (ret == -FI_EAGAIN)
 			this->pollAllCqInCache();
 	} while(ret == -FI_EAGAIN);
@@ -465,6 +913,18 @@ void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, Libfab
 	this->pendingAction++;
 }
 
+/****************************************************/
+/**
+ * Variant of rdmaReadv() attaching a lambda function as post action.
+ * @param postAction A lambda function without parameters to be called when the operation completes.
+ * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
+ * or if it needs to return.
+**/
+void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction)
+{
+	this->rdmaReadv(destinationEpId, iov, count, remoteAddr, remoteKey, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
+}
+
 /****************************************************/
 /**
  * Start a rdma read operation to fetch data from the remote server.
@@ -476,11 +936,11 @@ void LibfabricConnection::rdmaRead(int destinationEpId, void * localAddr, Libfab
  * @param remoteAddr The remote address to read from.
  * @param remoteKey The remote key to be allowed to read the remote segment.
  * @param size the size to read.
- * @param postAction A lambda function without parameters to be called when the message has been sent.
- * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
- * or if it needs to return.
+ * @param postAction The action to run when the operation completes, typically built with
+ * newPostAction(). It returns a LibfabricActionResult which tell to the poll() function if it
+ * need to continue polling or if it needs to return.
 **/
-void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction)
+void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, LibfabricPostAction * postAction)
 {
 	//check
 	assert(iov != NULL);
@@ -511,7 +971,7 @@ void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int
 	//do action and retry while we got FI_EAGAIN error
 	int ret = 0;
 	do {
-		ret = fi_readv(ep, iov, mrDesc, count, it->second, (uint64_t)remoteAddr, remoteKey, new LibfabricPostActionFunction(postAction));
+		ret = fi_readv(ep, iov, mrDesc, count, it->second, (uint64_t)remoteAddr, remoteKey, postAction);
 		if (ret == -FI_EAGAIN)
 			this->pollAllCqInCache();
 	} while(ret == -FI_EAGAIN);
@@ -524,6 +984,18 @@ void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int
 	delete [] mrDesc;
 }
 
+/****************************************************/
+/**
+ * Variant of rdmaWritev() attaching a lambda function as post action.
+ * @param postAction A lambda function without parameters to be called when the operation completes.
+ * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
+ * or if it needs to return.
+**/
+void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction)
+{
+	this->rdmaWritev(destinationEpId, iov, count, remoteAddr, remoteKey, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
+}
+
 /****************************************************/
 /**
  * Start a rdma write operation to send data from the remote server.
@@ -535,11 +1007,11 @@ void LibfabricConnection::rdmaReadv(int destinationEpId, struct iovec * iov, int
  * @param remoteAddr The remote address to write to.
  * @param remoteKey The remote key to be allowed to read the remote segment.
  * @param size the size to read.
- * @param postAction A lambda function without parameters to be called when the message has been sent.
- * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
- * or if it needs to return.
+ * @param postAction The action to run when the operation completes, typically built with
+ * newPostAction(). It returns a LibfabricActionResult which tell to the poll() function if it
+ * need to continue polling or if it needs to return.
 **/
-void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction)
+void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, LibfabricPostAction * postAction)
 {
 	//checks
 	assert(iov != NULL);
@@ -570,7 +1042,7 @@ void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, in
 	//do action and retry while we got FI_EAGAIN error
 	int ret = 0;
 	do {
-		ret = fi_writev(ep, iov, mrDesc, count, it->second, (uint64_t)remoteAddr, remoteKey, new LibfabricPostActionFunction(postAction));
+		ret = fi_writev(ep, iov, mrDesc, count, it->second, (uint64_t)remoteAddr, remoteKey, postAction);
 		if (ret == -FI_EAGAIN)
 			this->pollAllCqInCache();
 	} while(ret == -FI_EAGAIN);
@@ -583,6 +1055,18 @@ void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, in
 	delete [] mrDesc;
 }
 
+/****************************************************/
+/**
+ * Variant of rdmaWrite() attaching a lambda function as post action.
+ * @param postAction A lambda function without parameters to be called when the operation completes.
+ * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
+ * or if it needs to return.
+**/
+void LibfabricConnection::rdmaWrite(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, std::function<LibfabricActionResult(void)> postAction)
+{
+	this->rdmaWrite(destinationEpId, localAddr, remoteAddr, remoteKey, size, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
+}
+
 /****************************************************/
 /**
  * Start a rdma write operation to send data to the remote server.
@@ -591,11 +1075,11 @@ void LibfabricConnection::rdmaWritev(int destinationEpId, struct iovec * iov, in
  * @param remoteAddr The remote address where to place the data.
  * @param remoteKey The remote key to be allowed to read the remote segment.
  * @param size the size to read.
- * @param postAction A lambda function without parameters to be called when the message has been sent.
- * It returns a LibfabricActionResult which tell to the poll() function if it need to continue polling
- * or if it needs to return.
+ * @param postAction The action to run when the operation completes, typically built with
+ * newPostAction(). It returns a LibfabricActionResult which tell to the poll() function if it
+ * need to continue polling or if it needs to return.
 **/
-void LibfabricConnection::rdmaWrite(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, std::function<LibfabricActionResult(void)> postAction)
+void LibfabricConnection::rdmaWrite(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, LibfabricPostAction * postAction)
 {
 	//checks
 	assert(localAddr != NULL);
@@ -623,7 +1107,7 @@ void LibfabricConnection::rdmaWrite(int destinationEpId, void * localAddr, Libfa
 	//do action and retry while we got FI_EAGAIN error
 	int ret = 0;
 	do {
-		ret = fi_write(ep, localAddr, size, mrDesc, it->second, (uint64_t)remoteAddr, remoteKey, new LibfabricPostActionFunction(postAction));
+		ret = fi_write(ep, localAddr, size, mrDesc, it->second, (uint64_t)remoteAddr, remoteKey, postAction);
 		if (ret == -FI_EAGAIN)
 			this->pollAllCqInCache();
 	} while(ret == -FI_EAGAIN);
@@ -647,20 +1131,26 @@ void LibfabricConnection::rdmaWrite(int destinationEpId, void * localAddr, Libfa
 void LibfabricConnection::poll(bool waitMsg)
 {
 	//vars
-	fi_cq_msg_entry entry;
+	fi_cq_data_entry entry;
+
+	//clients disconnected by the TCP thread
+	if (this->hasPendingDisconnects)
+		this->applyPendingDisconnects();
 
 	//poll
 	for (;;) {
 		int status = pollForCompletion(this->cq, &entry, this->passivePolling);
 		if (status == 1) {
-			if (entry.flags & FI_RECV) {
-				if (disableReceive == false)
-					if (this->onRecv((size_t)entry.op_context))
+			if (entry.flags & (FI_RECV | FI_MULTI_RECV)) {
+				size_t size = 0;
+				void * buffer = this->getRecvBuffer(entry, size);
+				if (disableReceive == false && buffer != NULL)
+					if (this->onRecv((size_t)entry.op_context, buffer, size))
 						break;
 			} else if (entry.op_context != IOC_LF_NO_WAKEUP_POST_ACTION) {
 				LibfabricPostAction * action = (LibfabricPostAction*)entry.op_context;
 				LibfabricActionResult status = action->runPostAction();
-				delete action;
+				action->release();
 				this->pendingAction--;
 				assert(this->pendingAction >= 0);
 				if (status == LF_WAIT_LOOP_UNBLOCK)
@@ -670,7 +1160,8 @@ void LibfabricConnection::poll(bool waitMsg)
 				assert(this->pendingAction >= 0);
 			}
 		}
-		if (!waitMsg)
+		//without waiting, still dispatch all the entries of the last batch
+		if (!waitMsg && this->cqRingCount == 0)
 			break;
 	}
 }
@@ -689,7 +1180,7 @@ void LibfabricConnection::pollAllPendingAction(void)
 bool LibfabricConnection::pollMessage(LibfabricRemoteResponse & response, LibfabricMessageType expectedMessageType)
 {
 	//vars
-	fi_cq_msg_entry entry;
+	fi_cq_data_entry entry;
 
 	//debug
 	IOC_DEBUG_ARG("libfabric:msg", "Wait message: type=%1")
@@ -705,8 +1196,12 @@ bool LibfabricConnection::pollMessage(LibfabricRemoteResponse & response, Libfab
 	for (;;) {
 		int status = pollForCompletion(this->cq, &entry, this->passivePolling);
 		if (status == 1) {
-			if (entry.flags & FI_RECV) {
-				bool status = this->onRecvMessage(response, (size_t)entry.op_context);
+			if (entry.flags & (FI_RECV | FI_MULTI_RECV)) {
+				size_t size = 0;
+				void * buffer = this->getRecvBuffer(entry, size);
+				if (buffer == NULL)
+					continue;
+				bool status = this->onRecvMessage(response, (size_t)entry.op_context, buffer, size);
 				if (status) {
 					assumeArg(response.header.msgType == expectedMessageType, "Got an invalide message type (%1) where %2 is expected")
 						.arg(response.header.msgType)
@@ -725,7 +1220,7 @@ bool LibfabricConnection::pollMessage(LibfabricRemoteResponse & response, Libfab
 				LibfabricActionResult status = action->runPostAction();
 				this->pendingAction--;
 				assert(this->pendingAction >= 0);
-				delete action;
+				action->release();
 				if (status == LF_WAIT_LOOP_UNBLOCK)
 					return false;
 			}
@@ -792,17 +1287,22 @@ bool LibfabricConnection::checkAuth(LibfabricMessageHeader & header, uint64_t lf
 /**
  * Function to be called when a message is received by the poll() function.
  * @param id ID of the receive buffer where the message has been received.
+ * @param buffer Address of the message in the receive buffer.
+ * @param size Size of the message or of the receive buffer.
 **/
-LibfabricActionResult LibfabricConnection::onRecv(size_t id)
+LibfabricActionResult LibfabricConnection::onRecv(size_t id, void * buffer, size_t size)
 {
 	//check
 	assert(id < this->recvBuffersCount);
 
 	//deserialize
 	LibfabricMessageHeader header;
-	DeSerializer deserializer(this->recvBuffers[id], this->recvBuffersSize);
+	DeSerializer deserializer(buffer, size);
 	deserializer.apply("header", header);
 
+	//credits granted by the server
+	this->onCredits(header.credits);
+
 	//build struct
 	LibfabricClientRequest request = {
 		.lfClientId = header.lfClientId,
@@ -846,6 +1346,10 @@ LibfabricActionResult LibfabricConnection::onRecv(size_t id)
 			}
 		default:
 			{
+				//give back the credit used by the client, even if the message is rejected
+				if (this->creditTracker != NULL)
+					this->creditTracker->onReceive(header.lfClientId);
+
 				//check auth
 				if (this->checkAuth(header, header.lfClientId, id) == false)
 					return LF_WAIT_LOOP_UNBLOCK;
@@ -871,22 +1375,24 @@ LibfabricActionResult LibfabricConnection::onRecv(size_t id)
  * Function to be called when a message is received by the pollMessage() function.
  * @param response Reference to the response struct to be filled back when the message has been received.
  * @param id ID of the receive buffer where the message has been received.
+ * @param buffer Address of the message in the receive buffer.
+ * @param size Size of the message or of the receive buffer.
  * @return True if we get a message false otherwise. Caution, it does not check the type of message,
  * the responsability is left to the caller. It just checks the potential auth.
 **/
-bool LibfabricConnection::onRecvMessage(LibfabricRemoteResponse & response, size_t id)
+bool LibfabricConnection::onRecvMessage(LibfabricRemoteResponse & response, size_t id, void * buffer, size_t size)
 {
 	//check
 	assert(id < this->recvBuffersCount);
 
-	//cast
-	void * buffer =  this->recvBuffers[id];
-
 	//deserialize
-	DeSerializer deserializer(buffer, this->recvBuffersSize);
+	DeSerializer deserializer(buffer, size);
 	LibfabricMessageHeader header;
 	deserializer.apply("header", header);
 
+	//credits granted by the server
+	this->onCredits(header.credits);
+
 	//switch
 	if (header.msgType == IOC_LF_MSG_BAD_AUTH) {
 		if (this->hookOnBadAuth) {
@@ -1010,10 +1516,20 @@ void LibfabricConnection::onConnInit(LibfabricClientRequest & request)
 		.arg(epId)
 		.end();
 
+	//remember the endpoints of the client to handle its disconnection
+	this->tcpClientEndpoints[request.header.tcpClientId].push_back(epId);
+
+	//agree on the eager limits
+	LibfabricEagerLimits & eagerLimits = this->remoteEagerLimits[epId];
+	eagerLimits.maxRead = std::min((size_t)firstClientMessage.eagerMaxRead, this->localEagerLimits.maxRead);
+	eagerLimits.maxWrite = std::min((size_t)firstClientMessage.eagerMaxWrite, this->localEagerLimits.maxWrite);
+
 	//send response
 	LibfabricFirstHandshake firstHandshakeResponse = {
 		.protocolVersion = IOC_LF_PROTOCOL_VERSION,
 		.assignLfClientId = epId,
+		.eagerMaxRead = eagerLimits.maxRead,
+		.eagerMaxWrite = eagerLimits.maxWrite,
 	};
 	this->sendMessageNoPollWakeup(IOC_LF_MSG_ASSIGN_ID, epId, firstHandshakeResponse);
 
@@ -1032,64 +1548,115 @@ void LibfabricConnection::onConnInit(LibfabricClientRequest & request)
  * of the application.
  * @remark This might solve an issue we encouter when scaling to 2048 clients
  * being stopped on fi_read/fi_write with FI_EAGAIN.
- * @todo Can use a more performance structure to store cache and avoid memory allocations.
 **/
 void LibfabricConnection::pollAllCqInCache(void)
 {
-	//vars
-	struct fi_cq_msg_entry entry;
-
 	//loop while we have entries
-	while(pollForCompletion(this->cq, &entry, false, false) == 1) {
-		//push to list
-		this->cqEntries.push_back(entry);
-
+	bool warned = false;
+	while(this->fillCqRing(this->cq, false) > 0) {
 		//warn
-		if (this->cqEntries.size() == 1000)
+		if (this->cqRingCount >= 1000 && warned == false) {
 			IOC_WARNING_ARG("Start to have lots (1000) os pending messaged in the cqEntry cache, this might be a problem to study !");
+			warned = true;
+		}
 	}
 }
 
 /****************************************************/
 /**
- * Poll the libfabric completion queue to get a completion.
- * @param cq The completion queue to poll.
- * @param entry The completion entry to fill on event receive.
- * @param passivePolling Use passive or active polling. On passive polling the function
- * will block waiting an event. On active polling it will return on the first
- * check so the caller need to establish the waiting loop.
- * @param acceptCache Allow taking event from the completion cache.
+ * Set the maximum number of entries read from the completion queue in one
+ * call. They are then dispatched one by one from the ring buffer.
+ * @param size The batch size, 1 to read the entries one by one.
 **/
-int LibfabricConnection::pollForCompletion(struct fid_cq * cq, struct fi_cq_msg_entry* entry, bool passivePolling, bool acceptCache)
+void LibfabricConnection::setCqBatchSize(size_t size)
 {
-	//vars
-	struct fi_cq_msg_entry localEntry;
-	int ret;
+	assert(size > 0);
+	this->cqBatchSize = size;
+}
+
+/****************************************************/
+/**
+ * Set the eager limits announced to the remote side when the connection is
+ * established. The receive buffers and the message buffers must be large
+ * enough for them. It has to be called before joinServer() on the client side
+ * and before the clients connect on the server side.
+ * @param maxRead Max size of a read answered with the data in the response.
+ * @param maxWrite Max size of a write sending the data in the request.
+**/
+void LibfabricConnection::setEagerLimits(size_t maxRead, size_t maxWrite)
+{
+	this->localEagerLimits.maxRead = maxRead;
+	this->localEagerLimits.maxWrite = maxWrite;
+}
+
+/****************************************************/
+/**
+ * Get the eager limits agreed with the given remote endpoint.
+ * @param epId ID of the remote endpoint (IOC_LF_SERVER_ID on the client side).
+ * @return The agreed limits.
+**/
+const LibfabricEagerLimits & LibfabricConnection::getEagerLimits(int epId) const
+{
+	auto it = this->remoteEagerLimits.find(epId);
+	assumeArg(it != this->remoteEagerLimits.end(), "Eager limits not found for endpoint id : %1")
+		.arg(epId)
+		.end();
+	return it->second;
+}
 
+/****************************************************/
+/**
+ * Double the size of the completion ring when it is full. It keeps the
+ * entries in order starting at index 0.
+**/
+void LibfabricConnection::growCqRing(void)
+{
+	//copy in order
+	std::vector<fi_cq_data_entry> ring(2 * this->cqRing.size());
+	for (size_t i = 0 ; i < this->cqRingCount ; i++)
+		ring[i] = this->cqRing[(this->cqRingHead + i) % this->cqRing.size()];
+
+	//replace
+	this->cqRing.swap(ring);
+	this->cqRingHead = 0;
+}
+
+/****************************************************/
+/**
+ * Read a batch of entries from the completion queue and append them to the
+ * ring buffer. They are read directly in the free space after the last entry.
+ * @param cq The completion queue to poll.
+ * @param passivePolling Block until at least one entry is available.
+ * @return The number of entries read.
+**/
+size_t LibfabricConnection::fillCqRing(struct fid_cq * cq, bool passivePolling)
+{
 	//check
 	assert(cq != NULL);
-	assert(entry != NULL);
 
-	//has no entry
-	if (entry == NULL)
-		entry = &localEntry;
+	//make space
+	if (this->cqRingCount == this->cqRing.size())
+		this->growCqRing();
+	if (this->cqRingCount == 0)
+		this->cqRingHead = 0;
 
-	//remove from internal cache
-	if (acceptCache == true && this->cqEntries.empty() == false) {
-		*entry = this->cqEntries.front();
-		this->cqEntries.pop_front();
-		return 1;
-	}
+	//contiguous free space after the tail
+	size_t capacity = this->cqRing.size();
+	size_t tail = (this->cqRingHead + this->cqRingCount) % capacity;
+	size_t space = (tail >= this->cqRingHead) ? capacity - tail : this->cqRingHead - tail;
+	size_t batch = std::min(space, this->cqBatchSize);
 
 	//active or passive
+	ssize_t ret;
 	if (passivePolling)
-		ret = fi_cq_sread(cq, entry, 1, NULL, -1);
+		ret = fi_cq_sread(cq, &this->cqRing[tail], batch, NULL, -1);
 	else
-		ret = fi_cq_read(cq, entry, 1);
+		ret = fi_cq_read(cq, &this->cqRing[tail], batch);
 
-	//has one
+	//has some
 	if (ret > 0) {
-		return 1;
+		this->cqRingCount += ret;
+		return ret;
 	} else if (ret != -FI_EAGAIN) {
 		struct fi_cq_err_entry err_entry;
 		fi_cq_readerr(cq, &err_entry, 0);
@@ -1103,6 +1670,35 @@ int LibfabricConnection::pollForCompletion(struct fid_cq * cq, struct fi_cq_msg_
 	}
 }
 
+/****************************************************/
+/**
+ * Poll the libfabric completion queue to get a completion. The entries are
+ * read in batch in a ring buffer and returned one by one so a message storm
+ * costs one call to the completion queue per batch.
+ * @param cq The completion queue to poll.
+ * @param entry The completion entry to fill on event receive.
+ * @param passivePolling Use passive or active polling. On passive polling the function
+ * will block waiting an event. On active polling it will return on the first
+ * check so the caller need to establish the waiting loop.
+ * @return 1 if an entry has been returned, 0 otherwise.
+**/
+int LibfabricConnection::pollForCompletion(struct fid_cq * cq, struct fi_cq_data_entry* entry, bool passivePolling)
+{
+	//check
+	assert(cq != NULL);
+	assert(entry != NULL);
+
+	//read a new batch
+	if (this->cqRingCount == 0 && this->fillCqRing(cq, passivePolling) == 0)
+		return 0;
+
+	//pop
+	*entry = this->cqRing[this->cqRingHead];
+	this->cqRingHead = (this->cqRingHead + 1) % this->cqRing.size();
+	this->cqRingCount--;
+	return 1;
+}
+
 /****************************************************/
 /**
  * Define various hooks to be called on events.
@@ -1140,6 +1736,7 @@ void LibfabricConnection::fillProtocolHeader(LibfabricMessageHeader & header, ui
 	header.lfClientId = this->clientId;
 	header.tcpClientId = this->tcpClientId;
 	header.tcpClientKey = this->tcpClientKey;
+	header.credits = 0;
 }
 
 /****************************************************/
@@ -1190,11 +1787,11 @@ void LibfabricConnection::sendResponse(LibfabricMessageType msgType, uint64_t lf
 		.optionalData = NULL,
 	};
 
-	//send message
+	//send message, inject it if nothing to do when sent
 	if (unblock)
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_UNBLOCK));
-	else
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_KEEP_WAITING));
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_UNBLOCK));
+	else if (this->sendMessageInject(msgType, lfClientId, response) == false)
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_KEEP_WAITING));
 }
 
 /****************************************************/
@@ -1219,9 +1816,9 @@ void LibfabricConnection::sendResponse(LibfabricMessageType msgType, uint64_t lf
 
 	//send message
 	if (unblock)
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_UNBLOCK));
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_UNBLOCK));
 	else
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_KEEP_WAITING));
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_KEEP_WAITING));
 }
 
 /****************************************************/
@@ -1257,9 +1854,9 @@ void LibfabricConnection::sendResponse(LibfabricMessageType msgType, uint64_t lf
 
 	//send message
 	if (unblock)
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_UNBLOCK));
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_UNBLOCK));
 	else
-		this->sendMessage(msgType, lfClientId, response, new LibfabricPostActionNop(LF_WAIT_LOOP_KEEP_WAITING));
+		this->sendMessage(msgType, lfClientId, response, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_KEEP_WAITING));
 }
 
 }
@@ -11,6 +11,10 @@
 //std
 #include <functional>
 #include <map>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
 #include <cassert>
 //libfabric
 #include <rdma/fabric.h>
@@ -18,9 +22,11 @@
 #include <rdma/fi_endpoint.h>
 //local
 #include "LibfabricDomain.hpp"
+#include "LibfabricPostActionPool.hpp"
 #include "Serializer.hpp"
 #include "Protocol.hpp"
 #include "Hook.hpp"
+#include "CreditTracker.hpp"
 
 /****************************************************/
 namespace IOC
@@ -33,10 +39,49 @@ namespace IOC
 #define IOC_LF_NO_WAKEUP_POST_ACTION ((LibfabricPostAction*)-1)
 /** Has no buffer attached to the post action so nothing to repost in the receive queue. **/
 #define IOC_LF_NO_BUFFER ((size_t)-1)
+/** Default maximum number of completion entries read in one call. **/
+#define IOC_LF_DEFAULT_CQ_BATCH 64
+/** Initial size of the ring buffer keeping the completion entries not yet dispatched. **/
+#define IOC_LF_CQ_RING_SIZE 1024
+/** Maximum number of iov entries (header plus payload fragments) used to send a message without copying its payload. **/
+#define IOC_LF_MAX_SEND_IOV 16
+/** Maximum size of the messages sent with fi_inject(), the provider limit might be lower. **/
+#define IOC_LF_MAX_INJECT_SIZE 128
 
 /****************************************************/
 class LibfabricConnection;
 
+/****************************************************/
+/**
+ * Max sizes of the eager operations, above them the data are transfered with
+ * RDMA. Each side announces its limits on connection establishment and the
+ * smallest ones are kept for the connection.
+**/
+struct LibfabricEagerLimits
+{
+	/** Max size of a read answered with the data in the response. **/
+	size_t maxRead;
+	/** Max size of a write sending the data in the request. **/
+	size_t maxWrite;
+};
+
+/****************************************************/
+/**
+ * A message kept on the client side until the server grants a credit to
+ * send it. Its buffers stay valid until the post action is called.
+**/
+struct LibfabricQueuedSend
+{
+	/** Buffers of the message. **/
+	struct iovec iov[IOC_LF_MAX_SEND_IOV];
+	/** Number of entries in the iov. **/
+	size_t count;
+	/** ID of the destination. **/
+	int destinationEpId;
+	/** The action to be called when the message has been sent. **/
+	LibfabricPostAction * postAction;
+};
+
 /****************************************************/
 /**
  * Define a post action when we receive a message or when a RDMA operation finishes.
@@ -51,6 +96,8 @@ class LibfabricPostAction
 		void registerBuffer(LibfabricConnection * connection, bool isRecv, size_t bufferId);
 		void freeBuffer(void);
 		void attachDomainBuffer(LibfabricConnection * connection, void * domainBuffer);
+		void setPool(LibfabricPostActionPool * pool);
+		void release(void);
 	protected:
 		/** Keep track of the connection. **/
 		LibfabricConnection * connection;
@@ -60,6 +107,8 @@ class LibfabricPostAction
 		size_t bufferId;
 		/** keep track of the buffer. **/
 		void * domainBuffer;
+		/** Pool to return the action to on release, NULL if allocated with new. **/
+		LibfabricPostActionPool * pool;
 };
 
 /****************************************************/
@@ -71,7 +120,7 @@ class LibfabricPostAction
 class LibfabricPostActionFunction : public LibfabricPostAction
 {
 	public:
-		LibfabricPostActionFunction(std::function<LibfabricActionResult(void)> function) {this->function = function;};
+		LibfabricPostActionFunction(std::function<LibfabricActionResult(void)> function) {this->function = std::move(function);};
 		virtual LibfabricActionResult runPostAction(void);
 	private:
 		/** Keep track of the lambda operation. **/
@@ -107,6 +156,16 @@ class LibfabricConnection
 		LibfabricConnection(LibfabricDomain * lfDomain, bool passivePolling);
 		~LibfabricConnection(void);
 		void postReceives(size_t size, int count);
+		void postMultiReceives(size_t slabSize, int slabCount, size_t maxMsgSize);
+		bool isMultiRecv(void) const {return this->multiRecv;};
+		void setCqBatchSize(size_t size);
+		void setEagerLimits(size_t maxRead, size_t maxWrite);
+		const LibfabricEagerLimits & getEagerLimits(int epId) const;
+		void enableCredits(size_t capacity, size_t window);
+		CreditTracker * getCreditTracker(void) {return this->creditTracker;};
+		void onClientDisconnect(uint64_t tcpClientId);
+		size_t getCredits(void) const {return this->credits;};
+		size_t getQueuedSends(void) const {return this->creditQueue.size();};
 		void joinServer(void);
 		void poll(bool waitMsg);
 		bool pollMessage(LibfabricRemoteResponse & response, LibfabricMessageType expectedMessageType);
@@ -120,6 +179,12 @@ class LibfabricConnection
 		void rdmaReadv(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction);
 		void rdmaWrite(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, std::function<LibfabricActionResult(void)> postAction);
 		void rdmaWritev(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, std::function<LibfabricActionResult(void)> postAction);
+		void rdmaRead(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, LibfabricPostAction * postAction);
+		void rdmaReadv(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, LibfabricPostAction * postAction);
+		void rdmaWrite(int destinationEpId, void * localAddr, LibfabricAddr remoteAddr, uint64_t remoteKey, size_t size, LibfabricPostAction * postAction);
+		void rdmaWritev(int destinationEpId, struct iovec * iov, int count, LibfabricAddr remoteAddr, uint64_t remoteKey, LibfabricPostAction * postAction);
+		template <class T, class ... Args> T * newPostAction(Args && ... args);
+		LibfabricPostActionPool & getPostActionPool(void) {return this->postActionPool;};
 		void repostReceive(size_t id);
 		void repostReceive(const LibfabricClientRequest & request);
 		void registerHook(int messageType, Hook * hook);
@@ -129,6 +194,7 @@ class LibfabricConnection
 		LibfabricDomain & getDomain(void) {return *lfDomain;};
 		void setUsed(bool used) {this->used = used;};
 		bool getUsed(void) {return this->used;}
+		int getPendingActions(void) const {return this->pendingAction;};
 		void setTcpClientInfos(uint64_t tcpClientId, uint64_t tcpClientKey);
 		void fillProtocolHeader(LibfabricMessageHeader & header, uint64_t type);
 		ClientRegistry & getClientRegistry(void);
@@ -140,14 +206,26 @@ class LibfabricConnection
 	private:
 		void sendRawMessage(void * buffer, size_t size, int destinationEpId, LibfabricPostAction * postAction);
 		void sendRawMessageNoPollWakeup(void * buffer, size_t size, int destinationEpId);
-		int pollForCompletion(struct fid_cq * cq, struct fi_cq_msg_entry* entry, bool passivePolling, bool acceptCache = true);
-		LibfabricActionResult onRecv(size_t id);
-		bool onRecvMessage(LibfabricRemoteResponse & response, size_t id);
+		void sendRawMessagev(struct iovec * iov, size_t count, int destinationEpId, LibfabricPostAction * postAction);
+		template <class T> bool sendMessageInject(LibfabricMessageType msgType, int destinationEpId, T & data);
+		void sendRawMessageInject(void * buffer, size_t size, int destinationEpId);
+		uint32_t grantCredits(int destinationEpId);
+		bool takeCredit(int destinationEpId);
+		void queueSend(struct iovec * iov, size_t count, int destinationEpId, LibfabricPostAction * postAction);
+		void onCredits(uint32_t credits);
+		int pollForCompletion(struct fid_cq * cq, struct fi_cq_data_entry* entry, bool passivePolling);
+		size_t fillCqRing(struct fid_cq * cq, bool passivePolling);
+		void growCqRing(void);
+		LibfabricActionResult onRecv(size_t id, void * buffer, size_t size);
+		bool onRecvMessage(LibfabricRemoteResponse & response, size_t id, void * buffer, size_t size);
+		void * getRecvBuffer(const fi_cq_data_entry & entry, size_t & size);
+		void postSlab(size_t id);
 		void onSent(void * buffer);
 		void onConnInit(LibfabricClientRequest & request);
 		bool checkAuth(LibfabricMessageHeader & header, uint64_t clientId, int id);
 		void pollAllCqInCache(void);
 		void pollAllPendingAction(void);
+		void applyPendingDisconnects(void);
 	private:
 		/** Pointer to the libfabric domain to be used to establish the connection. **/
 		LibfabricDomain * lfDomain;
@@ -163,10 +241,22 @@ class LibfabricConnection
 		char ** recvBuffers;
 		/** Number of receive buffer. **/
 		size_t recvBuffersCount;
-		/** Size of each receive buffer. **/
+		/** Size of each receive buffer, the maximum size of a message in multi receive mode. **/
 		size_t recvBuffersSize;
+		/** The receive buffers are slabs receiving many messages (FI_MULTI_RECV). **/
+		bool multiRecv;
+		/** Size of each slab in multi receive mode. **/
+		size_t recvSlabSize;
+		/** Number of messages of each slab not yet terminated in multi receive mode. **/
+		std::vector<int> recvSlabPending;
+		/** The provider released the slab, it can be reposted when all its messages are terminated. **/
+		std::vector<bool> recvSlabReleased;
 		/** Map of remote addresses to be used to send messages or rdma operation.**/
 		std::map<int, fi_addr_t> remoteLiAddr;
+		/** Eager limits announced by this side of the connection. **/
+		LibfabricEagerLimits localEagerLimits;
+		/** Eager limits agreed with each remote endpoint. **/
+		std::map<int, LibfabricEagerLimits> remoteEagerLimits;
 		/** Keep track of the next ID to assign to the endpoints. **/
 		uint64_t nextEndpointId;
 		/** Hook to be called when a client connect. **/
@@ -202,10 +292,38 @@ class LibfabricConnection
 		bool checkClientAuth;
 		/** To be used when broacasting a crash message. **/
 		bool disableReceive;
-		/** Buffer to store batch readed completion queue entries **/
-		std::list<fi_cq_msg_entry> cqEntries;
+		/** Ring buffer to store the completion queue entries read in batch and not yet dispatched. **/
+		std::vector<fi_cq_data_entry> cqRing;
+		/** Index of the first entry in the ring. **/
+		size_t cqRingHead;
+		/** Number of entries in the ring. **/
+		size_t cqRingCount;
+		/** Maximum number of entries read from the completion queue in one call. **/
+		size_t cqBatchSize;
 		/** Number of pending send. **/
 		int pendingAction;
+		/** Maximum number of iov entries used to send a message, 0 or 1 to always copy the payload. **/
+		size_t sendIovLimit;
+		/** Maximum size of the messages sent with fi_inject(), 0 to disable. **/
+		size_t injectSize;
+		/** Recycle the post actions attached to the operations. **/
+		LibfabricPostActionPool postActionPool;
+		/** Credits granted to the clients on the server side, NULL if the flow control is disabled. **/
+		CreditTracker * creditTracker;
+		/** The server granted credits so the client has to respect them. **/
+		bool creditsEnabled;
+		/** Number of messages the client can still send to the server. **/
+		size_t credits;
+		/** Messages waiting for a credit on the client side. **/
+		std::deque<LibfabricQueuedSend> creditQueue;
+		/** Endpoints opened by each TCP client on the server side, used by the polling thread. **/
+		std::map<uint64_t, std::vector<int>> tcpClientEndpoints;
+		/** TCP clients disconnected by the TCP thread and not yet handled by the polling thread. **/
+		std::vector<uint64_t> pendingDisconnects;
+		/** Set when pendingDisconnects is not empty to check it without locking on every poll. **/
+		std::atomic<bool> hasPendingDisconnects;
+		/** Protect pendingDisconnects. **/
+		std::mutex disconnectMutex;
 };
 
 /****************************************************/
@@ -219,7 +337,7 @@ class LibfabricConnection
 template <class T>
 void LibfabricConnection::sendMessage(LibfabricMessageType msgType, int destinationEpId, T & data, std::function<LibfabricActionResult(void)> postAction)
 {
-	this->sendMessage(msgType, destinationEpId, data, new LibfabricPostActionFunction(postAction));
+	this->sendMessage(msgType, destinationEpId, data, this->newPostAction<LibfabricPostActionFunction>(std::move(postAction)));
 }
 
 /****************************************************/
@@ -237,12 +355,68 @@ void LibfabricConnection::sendMessage(LibfabricMessageType msgType, int destinat
 template <class T> 
 void LibfabricConnection::sendMessageNoPollWakeup(LibfabricMessageType msgType, int destinationEpId, T & data)
 {
-	this->sendMessage(msgType, destinationEpId, data, new LibfabricPostActionNop(LF_WAIT_LOOP_KEEP_WAITING));
+	if (this->sendMessageInject(msgType, destinationEpId, data) == false)
+		this->sendMessage(msgType, destinationEpId, data, this->newPostAction<LibfabricPostActionNop>(LF_WAIT_LOOP_KEEP_WAITING));
 }
 
 /****************************************************/
 /**
- * Serialize the given structure and send it as a message.
+ * Serialize the given structure and send it with fi_inject() if it is small
+ * enough. The message is then copied by the provider, it needs no message
+ * buffer, no post action and generates no completion. It is used for the
+ * acks and control messages which do not need to be notified when sent.
+ * @param msgType Define the type of message.
+ * @param destinationEpId Define the ID of the remote entity to target.
+ * @param data Define the value to serialize and send.
+ * @return False if the message is too large, it has to be sent with sendMessage().
+**/
+template <class T>
+bool LibfabricConnection::sendMessageInject(LibfabricMessageType msgType, int destinationEpId, T & data)
+{
+	//build the header
+	LibfabricMessageHeader header;
+	this->fillProtocolHeader(header, msgType);
+
+	//check size, without credit the message is queued by sendMessage()
+	size_t size = Serializer::computeSize(header) + Serializer::computeSize(data);
+	if (size > this->injectSize || this->takeCredit(destinationEpId) == false)
+		return false;
+
+	//piggy-back the credits
+	header.credits = this->grantCredits(destinationEpId);
+
+	//serialize
+	char buffer[IOC_LF_MAX_INJECT_SIZE];
+	Serializer serializer(buffer, size);
+	serializer.apply("header", header);
+	serializer.apply("data", data);
+
+	//send
+	this->sendRawMessageInject(buffer, serializer.getCursor(), destinationEpId);
+	return true;
+}
+
+/****************************************************/
+/**
+ * Build a post action of the given type in the pool of the connection so it
+ * can be attached to an operation without calling the allocator. The action
+ * is released by poll() once it has been run. This permits to attach a typed
+ * continuation with its state instead of a std::function.
+ * @param args Arguments to forward to the constructor of the action.
+ * @return The new action.
+**/
+template <class T, class ... Args>
+T * LibfabricConnection::newPostAction(Args && ... args)
+{
+	return this->postActionPool.acquire<T>(std::forward<Args>(args)...);
+}
+
+/****************************************************/
+/**
+ * Serialize the given structure and send it as a message. The payload of the
+ * eager messages is not copied in the message buffer, it is sent from its
+ * original location with the serialized header in a single iov send. It must
+ * then stay valid until the message has been sent.
  * @param msgType Define the type of message.
  * @param destinationEpId Define the ID of the remote entity to target.
  * @param data Define the value to serialize and send.
@@ -265,17 +439,36 @@ void LibfabricConnection::sendMessage(LibfabricMessageType msgType, int destinat
 	//build the header
 	LibfabricMessageHeader header;
 	this->fillProtocolHeader(header, msgType);
+	header.credits = this->grantCredits(destinationEpId);
 
-	//serialize
+	//serialize, the payload is referenced in the iov after the header
+	struct iovec iov[IOC_LF_MAX_SEND_IOV];
 	Serializer serializer(buffer, bufferSize);
+	if (this->sendIovLimit > 1)
+		serializer.setGather(iov + 1, this->sendIovLimit - 1);
 	serializer.apply("header", header);
 	serializer.apply("data", data);
 
+	//too many fragments, copy them
+	if (serializer.hasGatherOverflow()) {
+		Serializer copySerializer(buffer, bufferSize);
+		copySerializer.apply("header", header);
+		copySerializer.apply("data", data);
+		this->sendRawMessage(buffer, copySerializer.getCursor(), destinationEpId, postAction);
+		return;
+	}
+
 	//extract size
 	size_t finalSize = serializer.getCursor();
 
 	//send the message
-	this->sendRawMessage(buffer, finalSize, destinationEpId, postAction);
+	if (serializer.getGatherCount() == 0) {
+		this->sendRawMessage(buffer, finalSize, destinationEpId, postAction);
+	} else {
+		iov[0].iov_base = buffer;
+		iov[0].iov_len = finalSize;
+		this->sendRawMessagev(iov, serializer.getGatherCount() + 1, destinationEpId, postAction);
+	}
 }
 
 }
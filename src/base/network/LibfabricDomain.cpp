@@ -8,6 +8,8 @@
 //std
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <sched.h>
 //tmp
 #include <unistd.h>
 #include <sys/mman.h>
@@ -22,6 +24,19 @@
 namespace IOC
 {
 
+/****************************************************/
+/**
+ * Give each thread one of the reader slots so the threads do not share the
+ * same cache line when looking up the memory regions.
+ * @return The slot ID of the current thread.
+**/
+static int getReaderSlotId(void)
+{
+	static std::atomic<int> nextSlotId(0);
+	static thread_local int slotId = nextSlotId++ % IOC_LF_MR_READER_SLOTS;
+	return slotId;
+}
+
 /****************************************************/
 /**
  * Establish a new libfabric domain to latter create connections in this domain.
@@ -38,6 +53,12 @@ LibfabricDomain::LibfabricDomain(const std::string & serverIp, const std::string
 
 	//defaults is 1MB, can be changed by calling setMsgBuffeSize() before allocating buffers in the pool
 	this->msgBufferSize = 1024*1024;
+	this->mrCache = NULL;
+	this->snapshot = new MemoryRegionSnapshot{0, nullptr};
+	this->snapshotStale = false;
+	this->snapshotMisses = 0;
+	for (int i = 0 ; i < IOC_LF_MR_READER_SLOTS ; i++)
+		this->readerSlots[i].readers = 0;
 
 	//allocate fi
 	struct fi_info *hints = fi_allocinfo();
@@ -54,12 +75,16 @@ LibfabricDomain::LibfabricDomain(const std::string & serverIp, const std::string
 	hints->ep_attr->type = FI_EP_RDM;
 	//hints->fabric_attr->prov_name = strdup("verbs;ofi_rxm");
 
-	//get fi_info
+	//get fi_info, ask for multi receive buffers first and fallback if not supported
 	int err;
-	if (isDomainServer)
-		err = fi_getinfo(FI_VERSION(1,11), serverIp.c_str(), port.c_str(), FI_SOURCE, hints, &this->fi);
-	else
-		err = fi_getinfo(FI_VERSION(1,11), serverIp.c_str(), port.c_str(), 0, hints, &this->fi);
+	uint64_t flags = isDomainServer ? FI_SOURCE : 0;
+	hints->caps = FI_MSG | FI_MULTI_RECV;
+	err = fi_getinfo(FI_VERSION(1,11), serverIp.c_str(), port.c_str(), flags, hints, &this->fi);
+	if (err == -FI_ENODATA) {
+		IOC_DEBUG("libfaric:domain", "Provider does not support FI_MULTI_RECV, fallback on simple receive buffers");
+		hints->caps = FI_MSG;
+		err = fi_getinfo(FI_VERSION(1,11), serverIp.c_str(), port.c_str(), flags, hints, &this->fi);
+	}
 	LIBFABRIC_CHECK_STATUS("fi_getinfo",err);
 	//printf("MSG: %d\n", this->fi->caps & FI_MSG);
 	//printf("RMA: %d\n", this->fi->caps & FI_RMA);
@@ -92,6 +117,37 @@ LibfabricDomain::LibfabricDomain(const std::string & serverIp, const std::string
 	IOC_DEBUG_ARG("libfaric:domain", "Create domaine with provider '%1'").arg(getLFProviderName()).end();
 }
 
+/****************************************************/
+/**
+ * @return True if the provider can place many messages in a single receive
+ * buffer (FI_MULTI_RECV).
+**/
+bool LibfabricDomain::supportsMultiRecv(void) const
+{
+	return (this->fi->caps & FI_MULTI_RECV) != 0;
+}
+
+/****************************************************/
+/**
+ * Enable the cache of the memory registrations. It is used by the client to
+ * register its buffers only once over the transfers.
+ * @param maxSize The maximum size of the idle registrations to keep.
+**/
+void LibfabricDomain::enableMrCache(size_t maxSize)
+{
+	assume(this->mrCache == NULL, "The memory region cache is already enabled !");
+	this->mrCache = new MemoryRegionCache(this, maxSize);
+}
+
+/****************************************************/
+/**
+ * @return The memory region cache or NULL if not enabled.
+**/
+MemoryRegionCache * LibfabricDomain::getMrCache(void)
+{
+	return this->mrCache;
+}
+
 /****************************************************/
 /**
  * Destroy the domain and clean every ressources attached to it.
@@ -100,6 +156,10 @@ LibfabricDomain::LibfabricDomain(const std::string & serverIp, const std::string
 **/
 LibfabricDomain::~LibfabricDomain(void)
 {
+	//drop the cached registrations
+	if (this->mrCache != NULL)
+		delete this->mrCache;
+
 	//CRITICAL SECTION
 	{
 		//take lock
@@ -113,6 +173,9 @@ LibfabricDomain::~LibfabricDomain(void)
 		this->msgBuffers.clear();
 	}
 
+	//free the snapshot
+	delete this->snapshot.load();
+
 	//close
 	fi_close(&domain->fid);
 	fi_close(&fabric->fid);
@@ -217,6 +280,9 @@ Iov LibfabricDomain::registerSegment(void * ptr, size_t size, bool read, bool wr
 		LIBFABRIC_CHECK_STATUS("fi_mr_refresh",ret);*/
 
 		segments[(char*)ptr+size-1] = region;
+
+		//the lookups will miss it in the snapshot until rebuilt
+		this->snapshotStale = true;
 	}
 
 	Iov iov;
@@ -258,6 +324,17 @@ void LibfabricDomain::unregisterSegment(void * ptr, size_t size)
 			"Fail to find segment to unregister, one found does not match: %1 (%2).")
 				.arg(ptr).arg(size).end();
 
+		//mark it removed in the snapshot and wait the readers which might use it
+		MemoryRegionSnapshot * current = this->snapshot.load();
+		MemoryRegionSnapshotEntry * begin = current->entries.get();
+		MemoryRegionSnapshotEntry * entry = std::lower_bound(begin, begin + current->count, (char*)it->first, [](const MemoryRegionSnapshotEntry & entry, char * value) {
+			return entry.last < value;
+		});
+		if (entry != begin + current->count && entry->last == it->first && entry->removed == false) {
+			entry->removed = true;
+			this->waitSnapshotReaders();
+		}
+
 		//close & erase
 		fi_close(&it->second.mr->fid);
 		segments.erase(it);
@@ -266,7 +343,9 @@ void LibfabricDomain::unregisterSegment(void * ptr, size_t size)
 
 /****************************************************/
 /**
- * Get the libfabric MR description.
+ * Get the libfabric MR description. It is called for each RDMA operation so
+ * it first searches without locking in the snapshot of the segments and only
+ * takes the lock for the segments registered since the last rebuild.
  * @param ptr Base address of the segment.
  * @param size Size of the segment.
  * @return The memory region descriptor or null if not found.
@@ -277,12 +356,101 @@ fid_mr* LibfabricDomain::getFidMR ( void* ptr, size_t size )
 	assert(ptr != NULL);
 	assert(size > 0);
 
-	//get
-	MemoryRegion * region = getMR(ptr,size);
-	if (region == nullptr)
-		return nullptr;
-	else
-		return region->mr;
+	//fast path without locking
+	fid_mr * mr = nullptr;
+	if (this->lookupSnapshot(ptr, size, mr))
+		return mr;
+
+	//CRITICAL SECTION
+	{
+		//take lock
+		std::lock_guard<std::mutex> guard(this->segmentMutex);
+
+		//search in the map
+		MemoryRegion * region = this->findSegment(ptr, size);
+		if (region != nullptr)
+			mr = region->mr;
+
+		//rebuild the snapshot if it misses too many segments
+		if (this->snapshotStale && ++this->snapshotMisses >= IOC_LF_MR_SNAPSHOT_REBUILD_MISSES)
+			this->publishSnapshot();
+	}
+
+	//ret
+	return mr;
+}
+
+/****************************************************/
+/**
+ * Search the segment in the snapshot without locking. It runs concurrently
+ * with the registrations so it is tracked in a reader slot to prevent the
+ * snapshot or the registration to be freed while we read them.
+ * @param ptr Base address of the segment.
+ * @param size Size of the segment.
+ * @param mr Set to the libfabric registration if found.
+ * @return True if found, false to fallback on the locked search.
+**/
+bool LibfabricDomain::lookupSnapshot(void * ptr, size_t size, fid_mr * & mr)
+{
+	//enter
+	std::atomic<int> & readers = this->readerSlots[getReaderSlotId()].readers;
+	readers.fetch_add(1);
+
+	//quick search of the first segment ending after ptr
+	MemoryRegionSnapshot * current = this->snapshot.load();
+	MemoryRegionSnapshotEntry * begin = current->entries.get();
+	MemoryRegionSnapshotEntry * entry = std::lower_bound(begin, begin + current->count, (char*)ptr, [](const MemoryRegionSnapshotEntry & entry, char * value) {
+		return entry.last < value;
+	});
+
+	//check it fully contains the request
+	bool found = (entry != begin + current->count && entry->ptr <= ptr && (char*)ptr + size <= entry->last + 1 && entry->removed == false);
+	if (found)
+		mr = entry->mr;
+
+	//leave
+	readers.fetch_sub(1);
+	return found;
+}
+
+/****************************************************/
+/**
+ * Rebuild the snapshot from the segment map and free the old one once the
+ * threads which might read it have left. The segment mutex must be held.
+**/
+void LibfabricDomain::publishSnapshot(void)
+{
+	//build
+	MemoryRegionSnapshot * newSnapshot = new MemoryRegionSnapshot{this->segments.size(), std::unique_ptr<MemoryRegionSnapshotEntry[]>(new MemoryRegionSnapshotEntry[this->segments.size()])};
+	size_t i = 0;
+	for (auto & it : this->segments) {
+		MemoryRegionSnapshotEntry & entry = newSnapshot->entries[i++];
+		entry.ptr = (char*)it.second.ptr;
+		entry.last = (char*)it.first;
+		entry.mr = it.second.mr;
+		entry.removed = false;
+	}
+
+	//publish
+	MemoryRegionSnapshot * oldSnapshot = this->snapshot.exchange(newSnapshot);
+	this->snapshotStale = false;
+	this->snapshotMisses = 0;
+
+	//free
+	this->waitSnapshotReaders();
+	delete oldSnapshot;
+}
+
+/****************************************************/
+/**
+ * Wait until all the threads which were reading the snapshot have left so
+ * what they might have seen can be freed.
+**/
+void LibfabricDomain::waitSnapshotReaders(void)
+{
+	for (int i = 0 ; i < IOC_LF_MR_READER_SLOTS ; i++)
+		while (this->readerSlots[i].readers.load() != 0)
+			sched_yield();
 }
 
 /****************************************************/
@@ -298,28 +466,40 @@ MemoryRegion* LibfabricDomain::getMR ( void* ptr, size_t size )
 	assert(ptr != NULL);
 	assert(size > 0);
 
-	//search
-	MemoryRegion * mr = nullptr;
-
 	//CRITICAL SECTION
 	{
 		//take lock
 		std::lock_guard<std::mutex> guard(this->segmentMutex);
-	
-		//quick search
-		auto it = segments.lower_bound(ptr);
+		return this->findSegment(ptr, size);
+	}
+}
+
+/****************************************************/
+/**
+ * Search the memory region containing the given segment in the map. The
+ * segment mutex must be held.
+ * @param ptr Base address of the segment.
+ * @param size Size of the segment.
+ * @return Pointer to the memory region object or null if not found.
+**/
+MemoryRegion* LibfabricDomain::findSegment(void * ptr, size_t size)
+{
+	//search
+	MemoryRegion * mr = nullptr;
 
-		//if found
-		if (it != segments.end()) {
-			if (it->second.ptr <= ptr && (char*)it->second.ptr + it->second.size > ptr) {
-				if ((char*)ptr+size > (char*)it->second.ptr + it->second.size) {
-					DAQ_WARNING_ARG("Caution, a segment from libfabric not completetly fit with the request which is larger : wanted: %1:%2:%3, found: %4:%5:%6")
-						.arg(ptr).arg(size).arg((void*)((char*)ptr+size))
-						.arg(it->second.ptr).arg(it->second.size).arg((void*)((char*)it->second.ptr+it->second.size))
-						.end();
-				}
-				mr = &(it->second);
+	//quick search
+	auto it = segments.lower_bound(ptr);
+
+	//if found
+	if (it != segments.end()) {
+		if (it->second.ptr <= ptr && (char*)it->second.ptr + it->second.size > ptr) {
+			if ((char*)ptr+size > (char*)it->second.ptr + it->second.size) {
+				DAQ_WARNING_ARG("Caution, a segment from libfabric not completetly fit with the request which is larger : wanted: %1:%2:%3, found: %4:%5:%6")
+					.arg(ptr).arg(size).arg((void*)((char*)ptr+size))
+					.arg(it->second.ptr).arg(it->second.size).arg((void*)((char*)it->second.ptr+it->second.size))
+					.end();
 			}
+			mr = &(it->second);
 		}
 	}
 
@@ -13,6 +13,8 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <memory>
+#include <atomic>
 //libfabric
 #include <rdma/fabric.h>
 #include <rdma/fi_errno.h>
@@ -20,6 +22,7 @@
 //local
 #include "Protocol.hpp"
 #include "ClientRegistry.hpp"
+#include "MemoryRegionCache.hpp"
 
 //TMP
 //#define TEST_RDMA_SIZE (4*1024*1024)
@@ -44,6 +47,55 @@ struct MemoryRegion
 	fid_mr * mr;
 };
 
+/****************************************************/
+/** Number of slots used to track the threads reading the memory region snapshot. **/
+#define IOC_LF_MR_READER_SLOTS 64
+/** Number of lookups missing a stale snapshot before rebuilding it. **/
+#define IOC_LF_MR_SNAPSHOT_REBUILD_MISSES 16
+
+/****************************************************/
+/**
+ * Entry of the memory region snapshot.
+**/
+struct MemoryRegionSnapshotEntry
+{
+	/** Base address of the segment. **/
+	char * ptr;
+	/** Address of the last byte of the segment. **/
+	char * last;
+	/** Libfabric registration of the segment. **/
+	fid_mr * mr;
+	/** Set when the segment is unregistered, the entry must then be ignored. **/
+	std::atomic<bool> removed;
+};
+
+/****************************************************/
+/**
+ * Copy of the registered segments sorted by address so the lookups can be
+ * made without taking the lock. It is only modified to mark the removed
+ * segments and it is rebuilt when it misses too many new segments.
+**/
+struct MemoryRegionSnapshot
+{
+	/** Number of entries. **/
+	size_t count;
+	/** The entries sorted by address. **/
+	std::unique_ptr<MemoryRegionSnapshotEntry[]> entries;
+};
+
+/****************************************************/
+/**
+ * Counter of the threads currently reading the snapshot, padded to get one
+ * cache line per slot.
+**/
+struct MemoryRegionReaderSlot
+{
+	/** Number of readers using this slot. **/
+	std::atomic<int> readers;
+	/** Padding to avoid false sharing. **/
+	char padding[64 - sizeof(std::atomic<int>)];
+};
+
 /****************************************************/
 /**
  * Wrapper of a libfabric network domain. This is used to setup the library
@@ -68,6 +120,14 @@ class LibfabricDomain
 		void * getMsgBuffer(void);
 		void retMsgBuffer(void * buffer);
 		const char * getLFProviderName(void) const;
+		bool supportsMultiRecv(void) const;
+		void enableMrCache(size_t maxSize);
+		MemoryRegionCache * getMrCache(void);
+	private:
+		MemoryRegion * findSegment(void * ptr, size_t size);
+		bool lookupSnapshot(void * ptr, size_t size, fid_mr * & mr);
+		void publishSnapshot(void);
+		void waitSnapshotReaders(void);
 	private:
 		/** Libfabric configuration info being setup before the domain. **/
 		fi_info *fi;
@@ -103,6 +163,19 @@ class LibfabricDomain
 		 * connection instance.
 		**/
 		std::mutex segmentMutex;
+		/**
+		 * Snapshot of the segments used by getFidMR() without locking. It is
+		 * replaced under the segment mutex and freed once no reader uses it.
+		**/
+		std::atomic<MemoryRegionSnapshot*> snapshot;
+		/** Some segments have been registered since the snapshot was built. **/
+		bool snapshotStale;
+		/** Number of lookups which missed the stale snapshot. **/
+		size_t snapshotMisses;
+		/** Track the threads reading the snapshot. **/
+		MemoryRegionReaderSlot readerSlots[IOC_LF_MR_READER_SLOTS];
+		/** Optional cache of the registrations of the user buffers, NULL if disabled. **/
+		MemoryRegionCache * mrCache;
 };
 
 }
@@ -0,0 +1,111 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//local
+#include "LibfabricConnection.hpp"
+#include "LibfabricPostActionPool.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the pool, the slots are allocated on first use.
+**/
+LibfabricPostActionPool::LibfabricPostActionPool(void)
+{
+	this->freeList = NULL;
+	this->freeCount = 0;
+}
+
+/****************************************************/
+/**
+ * Destructor of the pool, it frees the memory of all the slots. The actions
+ * still pending are not destroyed.
+**/
+LibfabricPostActionPool::~LibfabricPostActionPool(void)
+{
+	for (auto & chunk : this->chunks)
+		delete [] chunk;
+}
+
+/****************************************************/
+/**
+ * Allocate a new chunk of slots and add them to the free list.
+**/
+void LibfabricPostActionPool::grow(void)
+{
+	//allocate
+	char * chunk = new char[IOC_LF_POST_ACTION_SLOT_SIZE * IOC_LF_POST_ACTION_CHUNK_SLOTS];
+	this->chunks.push_back(chunk);
+
+	//link
+	for (size_t i = 0 ; i < IOC_LF_POST_ACTION_CHUNK_SLOTS ; i++) {
+		LibfabricPostActionPoolSlot * slot = (LibfabricPostActionPoolSlot*)(chunk + i * IOC_LF_POST_ACTION_SLOT_SIZE);
+		slot->next = this->freeList;
+		this->freeList = slot;
+	}
+	this->freeCount += IOC_LF_POST_ACTION_CHUNK_SLOTS;
+}
+
+/****************************************************/
+/**
+ * Take a free slot, growing the pool if needed.
+ * @return Address of the slot.
+**/
+void * LibfabricPostActionPool::getSlot(void)
+{
+	//grow
+	if (this->freeList == NULL)
+		this->grow();
+
+	//pop
+	LibfabricPostActionPoolSlot * slot = this->freeList;
+	this->freeList = slot->next;
+	this->freeCount--;
+	return slot;
+}
+
+/****************************************************/
+/**
+ * Destroy an action built by acquire() and return its slot to the pool.
+ * @param action The action to release.
+**/
+void LibfabricPostActionPool::release(LibfabricPostAction * action)
+{
+	//check
+	assert(action != NULL);
+
+	//destroy
+	action->~LibfabricPostAction();
+
+	//push
+	LibfabricPostActionPoolSlot * slot = (LibfabricPostActionPoolSlot*)action;
+	slot->next = this->freeList;
+	this->freeList = slot;
+	this->freeCount++;
+}
+
+/****************************************************/
+/**
+ * @return The number of slots allocated by the pool.
+**/
+size_t LibfabricPostActionPool::getSlotCount(void) const
+{
+	return this->chunks.size() * IOC_LF_POST_ACTION_CHUNK_SLOTS;
+}
+
+/****************************************************/
+/**
+ * @return The number of slots currently free.
+**/
+size_t LibfabricPostActionPool::getFreeCount(void) const
+{
+	return this->freeCount;
+}
@@ -0,0 +1,97 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_LIBFABRIC_POST_ACTION_POOL_HPP
+#define IOC_LIBFABRIC_POST_ACTION_POOL_HPP
+
+/****************************************************/
+//std
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/** Size of each slot of the pool, the post actions larger than this are allocated with new. **/
+#define IOC_LF_POST_ACTION_SLOT_SIZE 128
+/** Number of slots allocated at once when the pool is empty. **/
+#define IOC_LF_POST_ACTION_CHUNK_SLOTS 256
+
+/****************************************************/
+class LibfabricPostAction;
+
+/****************************************************/
+/**
+ * Free slot of the pool, the link is stored in the slot memory itself.
+**/
+struct LibfabricPostActionPoolSlot
+{
+	/** Next free slot. **/
+	LibfabricPostActionPoolSlot * next;
+};
+
+/****************************************************/
+/**
+ * Pool of memory slots to build the post actions attached to the libfabric
+ * operations without calling the allocator on each send or RDMA operation.
+ * The actions are built in place with their real type and are recycled when
+ * the completion has been handled by LibfabricConnection::poll() through
+ * LibfabricPostAction::release().
+ *
+ * There is one pool per connection and it is used from the thread polling
+ * the connection so it is not thread safe, like the connection.
+**/
+class LibfabricPostActionPool
+{
+	public:
+		LibfabricPostActionPool(void);
+		~LibfabricPostActionPool(void);
+		template <class T, class ... Args> T * acquire(Args && ... args);
+		void release(LibfabricPostAction * action);
+		size_t getSlotCount(void) const;
+		size_t getFreeCount(void) const;
+	private:
+		LibfabricPostActionPool(const LibfabricPostActionPool &) = delete;
+		LibfabricPostActionPool & operator=(const LibfabricPostActionPool &) = delete;
+		void * getSlot(void);
+		void grow(void);
+	private:
+		/** Memory chunks allocated for the slots. **/
+		std::vector<char *> chunks;
+		/** List of free slots. **/
+		LibfabricPostActionPoolSlot * freeList;
+		/** Number of free slots. **/
+		size_t freeCount;
+};
+
+/****************************************************/
+/**
+ * Build a post action in a slot of the pool. If the type does not fit in a
+ * slot it is allocated with new and deleted on release.
+ * @param args Arguments to forward to the constructor of the action.
+ * @return Pointer to the new action.
+**/
+template <class T, class ... Args>
+T * LibfabricPostActionPool::acquire(Args && ... args)
+{
+	//too large, fallback on new
+	if (sizeof(T) > IOC_LF_POST_ACTION_SLOT_SIZE || alignof(T) > alignof(std::max_align_t))
+		return new T(std::forward<Args>(args)...);
+
+	//build in a slot
+	T * action = new (this->getSlot()) T(std::forward<Args>(args)...);
+	action->setPool(this);
+	return action;
+}
+
+}
+
+#endif //IOC_LIBFABRIC_POST_ACTION_POOL_HPP
@@ -0,0 +1,302 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <algorithm>
+#include <vector>
+//local
+#include "../common/Debug.hpp"
+#include "LibfabricDomain.hpp"
+#include "MemoryRegionCache.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the memory region cache.
+ * @param domain The domain used to register the memory.
+ * @param maxSize The maximum size of the idle registrations to keep.
+**/
+MemoryRegionCache::MemoryRegionCache(LibfabricDomain * domain, size_t maxSize)
+{
+	//check
+	assert(domain != NULL);
+
+	//setup
+	this->domain = domain;
+	this->maxSize = maxSize;
+	this->registeredSize = 0;
+	this->stats = MemoryRegionCacheStats{0, 0, 0, 0};
+}
+
+/****************************************************/
+/**
+ * Destructor of the cache, it unregisters all the segments.
+**/
+MemoryRegionCache::~MemoryRegionCache(void)
+{
+	this->clear();
+}
+
+/****************************************************/
+/**
+ * Search a valid registration covering the whole given range with the
+ * required access. The mutex must be held.
+ * @param ptr Base address of the range.
+ * @param size Size of the range.
+ * @param read Need remote read access.
+ * @param write Need remote write access.
+ * @return The registration or NULL if none.
+**/
+MemoryRegionCacheEntry * MemoryRegionCache::findCovering(char * ptr, size_t size, bool read, bool write)
+{
+	//the first one ending after ptr
+	auto it = this->entries.upper_bound(ptr);
+	if (it == this->entries.end())
+		return NULL;
+
+	//check
+	MemoryRegionCacheEntry * entry = it->second;
+	if (entry->ptr <= ptr && entry->ptr + entry->size >= ptr + size && entry->valid && (entry->read || !read) && (entry->write || !write))
+		return entry;
+	else
+		return NULL;
+}
+
+/****************************************************/
+/**
+ * Check if one of the registrations overlapping the given range is used by
+ * a transfer. The mutex must be held.
+ * @param ptr Base address of the range.
+ * @param size Size of the range.
+ * @return True if one is used.
+**/
+bool MemoryRegionCache::hasUsedOverlap(char * ptr, size_t size)
+{
+	for (auto it = this->entries.upper_bound(ptr) ; it != this->entries.end() && it->second->ptr < ptr + size ; ++it)
+		if (it->second->refs > 0)
+			return true;
+	return false;
+}
+
+/****************************************************/
+/**
+ * Unregister an idle registration and remove it from the cache. The mutex
+ * must be held.
+ * @param entry The registration to remove.
+**/
+void MemoryRegionCache::erase(MemoryRegionCacheEntry * entry)
+{
+	//check
+	assert(entry != NULL);
+	assert(entry->refs == 0);
+
+	//remove
+	this->lru.erase(entry->lruPos);
+	this->entries.erase(entry->ptr + entry->size);
+	this->registeredSize -= entry->size;
+
+	//unregister
+	this->domain->unregisterSegment(entry->ptr, entry->size);
+	delete entry;
+}
+
+/****************************************************/
+/**
+ * Unregister the least recently used idle registrations until the
+ * registered size is under the limit. The mutex must be held.
+**/
+void MemoryRegionCache::evict(void)
+{
+	while (this->registeredSize > this->maxSize && this->lru.empty() == false) {
+		this->erase(this->lru.front());
+		this->stats.evictions++;
+	}
+}
+
+/****************************************************/
+/**
+ * Get a registration covering the given buffer, registering it on a miss.
+ * It has to be returned with release() when the transfer is done.
+ * @param ptr Base address of the buffer.
+ * @param size Size of the buffer.
+ * @param read If the remote will read the buffer.
+ * @param write If the remote will write in the buffer.
+ * @param iov Set to the Iov describing the buffer for the remote.
+ * @return The registration to pass to release().
+**/
+MemoryRegionCacheEntry * MemoryRegionCache::acquire(void * ptr, size_t size, bool read, bool write, Iov & iov)
+{
+	//check
+	assert(ptr != NULL);
+	assert(size > 0);
+
+	//vars
+	char * base = (char*)ptr;
+	MemoryRegionCacheEntry * entry = NULL;
+
+	//lock
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	//hit
+	entry = this->findCovering(base, size, read, write);
+	if (entry != NULL) {
+		if (entry->refs++ == 0)
+			this->lru.erase(entry->lruPos);
+		this->stats.hits++;
+	} else {
+		//wait the overlapping registrations to be released
+		while (this->hasUsedOverlap(base, size))
+			this->releaseCond.wait(lock);
+
+		//it might have been registered by another thread meanwhile
+		entry = this->findCovering(base, size, read, write);
+		if (entry != NULL) {
+			this->lru.erase(entry->lruPos);
+			entry->refs++;
+			this->stats.hits++;
+		}
+	}
+
+	//miss, replace the overlapping ones by their union
+	if (entry == NULL) {
+		//compute union
+		char * start = base;
+		char * end = base + size;
+		std::vector<MemoryRegionCacheEntry*> overlaps;
+		for (auto it = this->entries.upper_bound(base) ; it != this->entries.end() && it->second->ptr < base + size ; ++it) {
+			MemoryRegionCacheEntry * overlap = it->second;
+			start = std::min(start, overlap->ptr);
+			end = std::max(end, overlap->ptr + overlap->size);
+			read |= overlap->read;
+			write |= overlap->write;
+			overlaps.push_back(overlap);
+		}
+		for (auto & overlap : overlaps)
+			this->erase(overlap);
+
+		//register
+		entry = new MemoryRegionCacheEntry;
+		entry->ptr = start;
+		entry->size = end - start;
+		entry->read = read;
+		entry->write = write;
+		entry->refs = 1;
+		entry->valid = true;
+		entry->iov = this->domain->registerSegment(start, end - start, read, write, false);
+		entry->lruPos = this->lru.end();
+		this->entries[end] = entry;
+		this->registeredSize += entry->size;
+		this->stats.misses++;
+
+		//respect the limit
+		this->evict();
+
+		//debug
+		IOC_DEBUG_ARG("libfaric:mrcache", "Register segment ptr=%1, size=%2 in cache").arg((void*)start).arg(end - start).end();
+	}
+
+	//build iov
+	iov = entry->iov;
+	iov.addr += base - entry->ptr;
+	return entry;
+}
+
+/****************************************************/
+/**
+ * Return a registration obtained from acquire(). It stays registered for the
+ * next transfers unless it has been invalidated or the cache is full.
+ * @param entry The registration.
+**/
+void MemoryRegionCache::release(MemoryRegionCacheEntry * entry)
+{
+	//check
+	assert(entry != NULL);
+	assert(entry->refs > 0);
+
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+
+	//release
+	if (--entry->refs == 0) {
+		entry->lruPos = this->lru.insert(this->lru.end(), entry);
+		if (entry->valid == false)
+			this->erase(entry);
+		this->evict();
+		this->releaseCond.notify_all();
+	}
+}
+
+/****************************************************/
+/**
+ * Drop the registrations overlapping the given range. It has to be called
+ * before unmapping or remapping the memory. The registrations used by a
+ * transfer are unregistered when released.
+ * @param ptr Base address of the range.
+ * @param size Size of the range.
+**/
+void MemoryRegionCache::invalidate(void * ptr, size_t size)
+{
+	//vars
+	char * base = (char*)ptr;
+	std::vector<MemoryRegionCacheEntry*> overlaps;
+
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+
+	//mark
+	for (auto it = this->entries.upper_bound(base) ; it != this->entries.end() && it->second->ptr < base + size ; ++it) {
+		it->second->valid = false;
+		overlaps.push_back(it->second);
+		this->stats.invalidations++;
+	}
+
+	//drop the idle ones
+	for (auto & entry : overlaps)
+		if (entry->refs == 0)
+			this->erase(entry);
+}
+
+/****************************************************/
+/**
+ * Unregister all the idle registrations.
+**/
+void MemoryRegionCache::clear(void)
+{
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+
+	//drop all
+	while (this->lru.empty() == false)
+		this->erase(this->lru.front());
+
+	//warn
+	if (this->entries.empty() == false)
+		IOC_WARNING_ARG("Memory region cache cleared while %1 registrations are still used !").arg(this->entries.size()).end();
+}
+
+/****************************************************/
+/**
+ * @return The size of the memory currently registered by the cache.
+**/
+size_t MemoryRegionCache::getRegisteredSize(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->registeredSize;
+}
+
+/****************************************************/
+/**
+ * @return The statistics of the cache.
+**/
+MemoryRegionCacheStats MemoryRegionCache::getStats(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->stats;
+}
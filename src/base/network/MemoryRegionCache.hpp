@@ -0,0 +1,123 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_REGION_CACHE_HPP
+#define IOC_MEMORY_REGION_CACHE_HPP
+
+/****************************************************/
+//std
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+//local
+#include "Protocol.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+class LibfabricDomain;
+
+/****************************************************/
+/**
+ * A registration kept by the memory region cache.
+**/
+struct MemoryRegionCacheEntry
+{
+	/** Base address of the registered segment. **/
+	char * ptr;
+	/** Size of the registered segment. **/
+	size_t size;
+	/** Registered for remote read. **/
+	bool read;
+	/** Registered for remote write. **/
+	bool write;
+	/** Number of transfers currently using the registration. **/
+	int refs;
+	/** False if the memory has been invalidated, it is then unregistered on last release. **/
+	bool valid;
+	/** Iov of the base address returned by the registration. **/
+	Iov iov;
+	/** Position in the LRU list when not used. **/
+	std::list<MemoryRegionCacheEntry*>::iterator lruPos;
+};
+
+/****************************************************/
+/**
+ * Statistics of the memory region cache.
+**/
+struct MemoryRegionCacheStats
+{
+	/** Number of acquire() served by an existing registration. **/
+	size_t hits;
+	/** Number of acquire() which had to register the memory. **/
+	size_t misses;
+	/** Number of registrations dropped to respect the size limit. **/
+	size_t evictions;
+	/** Number of registrations dropped by invalidate(). **/
+	size_t invalidations;
+};
+
+/****************************************************/
+/**
+ * Cache of the memory registrations of the client buffers so repeated
+ * transfers from the same buffers pay the registration only once.
+ *
+ * The registrations are reference counted while used by a transfer and kept
+ * in a LRU list when idle. The least recently used ones are unregistered
+ * when the registered size goes over the limit. The cached segments never
+ * overlap, a request overlapping some idle registrations replaces them by a
+ * registration covering their union. It waits if the overlapping
+ * registrations are used by another transfer.
+ *
+ * The cache cannot detect when the memory is unmapped, as the libfabric
+ * monitor is disabled to be compatible with ummap-io. The application (or
+ * ummap-io) has to call invalidate() before unmapping or remapping a range.
+ *
+ * The cache is thread safe as the domain is shared by the connections of the
+ * client threads.
+**/
+class MemoryRegionCache
+{
+	public:
+		MemoryRegionCache(LibfabricDomain * domain, size_t maxSize);
+		~MemoryRegionCache(void);
+		MemoryRegionCacheEntry * acquire(void * ptr, size_t size, bool read, bool write, Iov & iov);
+		void release(MemoryRegionCacheEntry * entry);
+		void invalidate(void * ptr, size_t size);
+		void clear(void);
+		size_t getRegisteredSize(void);
+		MemoryRegionCacheStats getStats(void);
+	private:
+		MemoryRegionCacheEntry * findCovering(char * ptr, size_t size, bool read, bool write);
+		bool hasUsedOverlap(char * ptr, size_t size);
+		void erase(MemoryRegionCacheEntry * entry);
+		void evict(void);
+	private:
+		/** Domain used to register the memory. **/
+		LibfabricDomain * domain;
+		/** Maximum size of the idle registrations to keep. **/
+		size_t maxSize;
+		/** Size currently registered. **/
+		size_t registeredSize;
+		/** The registrations indexed by their end address. **/
+		std::map<char*, MemoryRegionCacheEntry*> entries;
+		/** The idle registrations, the least recently used first. **/
+		std::list<MemoryRegionCacheEntry*> lru;
+		/** Statistics. **/
+		MemoryRegionCacheStats stats;
+		/** Protect the state. **/
+		std::mutex mutex;
+		/** Wake up the requests waiting for an overlapping registration to be released. **/
+		std::condition_variable releaseCond;
+};
+
+}
+
+#endif //IOC_MEMORY_REGION_CACHE_HPP
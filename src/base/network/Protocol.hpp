@@ -30,29 +30,40 @@ namespace IOC
 **/
 #define TEST_RDMA_SIZE (4096)
 /**
- * Max eager size for write operation. After this do RDMA.
+ * Default max eager size for write operation. After this do RDMA.
+ * The size in use is negotiated when the connection is established.
 **/
 #define IOC_EAGER_MAX_WRITE (32*1024)
 /**
- * Max eager size for read operation. After this ro RDMA.
+ * Default max eager size for read operation. After this ro RDMA.
+ * The size in use is negotiated when the connection is established.
 **/
 #define IOC_EAGER_MAX_READ (32*1024)
 /**
  * Define the considered max size of the struct.
  */
 #define IOC_STRUCT_MAX (64)
+/**
+ * Size of the receive buffers needed to get messages with the given eager size.
+**/
+#define IOC_POST_RECEIVE_SIZE(eagerSize) (sizeof(LibfabricMessageHeader) + IOC_STRUCT_MAX + (eagerSize))
 /**
  * Post receive to have enough room for eager read
  */
-#define IOC_POST_RECEIVE_READ (sizeof(LibfabricMessageHeader) + IOC_STRUCT_MAX + IOC_EAGER_MAX_READ)
+#define IOC_POST_RECEIVE_READ IOC_POST_RECEIVE_SIZE(IOC_EAGER_MAX_READ)
 /**
  * Post receive to have enough room for eager write
  */
-#define IOC_POST_RECEIVE_WRITE (sizeof(LibfabricMessageHeader) + IOC_STRUCT_MAX + IOC_EAGER_MAX_WRITE)
+#define IOC_POST_RECEIVE_WRITE IOC_POST_RECEIVE_SIZE(IOC_EAGER_MAX_WRITE)
+/**
+ * Status returned by the server when it is out of memory. The client can
+ * retry the request later when some memory has been released.
+**/
+#define IOC_LF_STATUS_RETRY_LATER (-11)
 /**
  * Define the protocol version
 **/
-#define IOC_LF_PROTOCOL_VERSION 2
+#define IOC_LF_PROTOCOL_VERSION 5
 
 /****************************************************/
 class SerializerBase;
@@ -105,6 +116,10 @@ enum LibfabricMessageType
 	IOC_LF_MSG_OBJ_COW,
 	/** The answer for the copy on write operation.**/
 	IOC_LF_MSG_OBJ_COW_ACK,
+	/** Client ask to change the bandwidth limits of the server. **/
+	IOC_LF_MSG_SET_QOS,
+	/** Server ack the bandwidth limits change. **/
+	IOC_LF_MSG_SET_QOS_ACK,
 };
 
 /****************************************************/
@@ -199,6 +214,8 @@ struct LibfabricMessageHeader
 	uint64_t tcpClientId;
 	/** Define the TCP client key for auth validation. **/
 	uint64_t tcpClientKey;
+	/** Number of new credits granted by the server to send messages to it. **/
+	uint32_t credits;
 };
 
 /****************************************************/
@@ -309,6 +326,20 @@ struct LibfabricObjectCow
 	uint64_t rangeSize;
 };
 
+/****************************************************/
+/**
+ * Message used to change the bandwidth limits of the server at runtime.
+**/
+struct LibfabricQosInfos
+{
+	/** Used to serialize and de-serialize the struct **/
+	inline void applySerializerDef(SerializerBase & serializer);
+	/** Bandwidth limit of the flush operations in bytes per second, 0 for unlimited. **/
+	uint64_t flushBandwidth;
+	/** Bandwidth limit of the storage reads made on the misses in bytes per second, 0 for unlimited. **/
+	uint64_t missBandwidth;
+};
+
 /****************************************************/
 /**
  * Answer to most of the messages.
@@ -352,6 +383,10 @@ struct LibfabricFirstHandshake
 	int32_t protocolVersion;
 	/** Define the client ID to assign. **/
 	uint64_t assignLfClientId;
+	/** Max eager size for read operations agreed for the connection. **/
+	uint64_t eagerMaxRead;
+	/** Max eager size for write operations agreed for the connection. **/
+	uint64_t eagerMaxWrite;
 };
 
 /****************************************************/
@@ -361,6 +396,10 @@ struct LibfabricFirstClientMessage
 	inline void applySerializerDef(SerializerBase & serializer);
 	/** Address of the client. **/
 	char addr[IOC_LF_MAX_ADDR_LEN];
+	/** Max eager size for read operations the client can receive. **/
+	uint64_t eagerMaxRead;
+	/** Max eager size for write operations the client would like to send. **/
+	uint64_t eagerMaxWrite;
 };
 
 /****************************************************/
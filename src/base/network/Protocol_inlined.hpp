@@ -48,6 +48,7 @@ inline void LibfabricMessageHeader::applySerializerDef(SerializerBase & serializ
 	serializer.apply("lfClientId", this->lfClientId);
 	serializer.apply("tcpClientId", this->tcpClientId);
 	serializer.apply("tcpClientKey", this->tcpClientKey);
+	serializer.apply("credits", this->credits);
 }
 
 /****************************************************/
@@ -105,6 +106,13 @@ inline void LibfabricObjectCow::applySerializerDef(SerializerBase & serializer)
 	serializer.apply("rangeSize", this->rangeSize);
 }
 
+/****************************************************/
+inline void LibfabricQosInfos::applySerializerDef(SerializerBase & serializer)
+{
+	serializer.apply("flushBandwidth", this->flushBandwidth);
+	serializer.apply("missBandwidth", this->missBandwidth);
+}
+
 /****************************************************/
 inline void LibfabricResponse::initStatusOnly(int32_t status)
 {
@@ -126,7 +134,7 @@ inline void LibfabricResponse::applySerializerDef(SerializerBase & serializer)
 		if ((serializer.getAction() == SERIALIZER_PACK || serializer.getAction() == SERIALIZER_SIZE) && this->optionalDataFragments != NULL) {
 			assert(this->optionalData == NULL);
 			for (uint64_t i = 0 ; i < this->optionalDataFragmentCount ; i++)
-				serializer.apply("optionalDataFragment", this->optionalDataFragments[i].buffer, this->optionalDataFragments[i].size);
+				serializer.applyPayload("optionalDataFragment", this->optionalDataFragments[i].buffer, this->optionalDataFragments[i].size);
 		} else {
 			serializer.serializeOrPoint("optionalData", this->optionalData, this->msgDataSize);
 		}
@@ -138,12 +146,16 @@ inline void LibfabricFirstHandshake::applySerializerDef(SerializerBase & seriali
 {
 	serializer.apply("protocolVersion", this->protocolVersion);
 	serializer.apply("assignLfClientId", this->assignLfClientId);
+	serializer.apply("eagerMaxRead", this->eagerMaxRead);
+	serializer.apply("eagerMaxWrite", this->eagerMaxWrite);
 }
 
 /****************************************************/
 inline void LibfabricFirstClientMessage::applySerializerDef(SerializerBase & serializer)
 {
 	serializer.apply("addr", this->addr, sizeof(this->addr));
+	serializer.apply("eagerMaxRead", this->eagerMaxRead);
+	serializer.apply("eagerMaxWrite", this->eagerMaxWrite);
 }
 
 /****************************************************/
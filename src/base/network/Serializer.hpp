@@ -13,6 +13,7 @@
 #include <string>
 #include <sstream>
 #include <cassert>
+#include <sys/uio.h>
 
 /****************************************************/
 namespace IOC
@@ -61,6 +62,7 @@ class SerializerBase
 		inline void apply(const char * fieldName, void * buffer, size_t size);
 		inline void apply(const char * fieldName, const void * buffer, size_t size);
 		inline void serializeOrPoint(const char * fieldName, const char * & buffer, size_t size);
+		inline void applyPayload(const char * fieldName, const void * buffer, size_t size);
 		inline void apply(const char * fieldName, bool & value);
 		template <class T > void apply(const char * fieldName, T & value);
 		inline const size_t getCursor(void);
@@ -69,8 +71,13 @@ class SerializerBase
 		template <class T> static std::string stringify(T & value);
 		template <class T> static size_t computeSize(T & value);
 		inline SerializerAction getAction(void) const;
+		inline void setGather(struct iovec * iov, size_t maxCount);
+		inline size_t getGatherCount(void) const;
+		inline size_t getGatherSize(void) const;
+		inline bool hasGatherOverflow(void) const;
 	private:
 		inline void checkSize(const char * fieldName, size_t size);
+		inline void gather(const void * buffer, size_t size);
 	private:
 		/** The buffer in which to serialize or to read from. **/
 		char * buffer;
@@ -93,6 +100,19 @@ class SerializerBase
 		 * False when we enter in the first member so we print the field name.
 		**/
 		bool root;
+		/**
+		 * If not NULL, the payloads packed by serializeOrPoint() and applyPayload()
+		 * are appended to this iov instead of being copied in the buffer.
+		**/
+		struct iovec * gatherIov;
+		/** Maximum number of entries in gatherIov. **/
+		size_t gatherMax;
+		/** Number of entries used in gatherIov. **/
+		size_t gatherCount;
+		/** Sum of the sizes of the gathered payloads. **/
+		size_t gatherSize;
+		/** More payloads than gatherMax have been requested, the gathered iov is incomplete. **/
+		bool gatherOverflow;
 };
 
 /****************************************************/
@@ -45,6 +45,11 @@ inline SerializerBase::SerializerBase(void * buffer, size_t size, SerializerActi
 	this->out = NULL;
 	this->outFirst = false;
 	this->root = true;
+	this->gatherIov = NULL;
+	this->gatherMax = 0;
+	this->gatherCount = 0;
+	this->gatherSize = 0;
+	this->gatherOverflow = false;
 }
 
 /****************************************************/
@@ -65,6 +70,11 @@ inline SerializerBase::SerializerBase(std::ostream * out)
 	this->out = out;
 	this->outFirst = true;
 	this->root = true;
+	this->gatherIov = NULL;
+	this->gatherMax = 0;
+	this->gatherCount = 0;
+	this->gatherSize = 0;
+	this->gatherOverflow = false;
 }
 
 /****************************************************/
@@ -433,6 +443,14 @@ inline void SerializerBase::serializeOrPoint(const char * fieldName, const char
 {
 	//check
 	assert(SERIALIZER_ACTION_DEFINED(this->action));
+
+	//reference it instead of copying
+	if (this->action == SERIALIZER_PACK && this->gatherIov != NULL) {
+		this->gather(buffer, size);
+		return;
+	}
+
+	//check size
 	this->checkSize(fieldName, size);
 
 	//modes
@@ -498,6 +516,99 @@ inline void SerializerBase::apply(const char * fieldName, const void * buffer, s
 	this->outFirst = false;
 }
 
+/****************************************************/
+/**
+ * Pack a raw payload which cannot be deserialized by itself, it is read back
+ * with serializeOrPoint(). In gather mode it is referenced instead of copied.
+ * @param fieldName Name of the value to be used for stringification and error 
+ * message in case of buffer overflow.
+ * @param buffer The data to push.
+ * @param size The size of the buffer to push.
+**/
+inline void SerializerBase::applyPayload(const char * fieldName, const void * buffer, size_t size)
+{
+	if (this->action == SERIALIZER_PACK && this->gatherIov != NULL)
+		this->gather(buffer, size);
+	else
+		this->apply(fieldName, buffer, size);
+}
+
+/****************************************************/
+/**
+ * Switch to gather mode. The payloads packed by serializeOrPoint() and
+ * applyPayload() are then appended to the given iov instead of being copied
+ * in the buffer, so they can be sent with the buffer content as header
+ * without an intermediate copy. The payloads must be the last packed fields
+ * as the buffer content stops at the first one.
+ * @param iov The iov to fill.
+ * @param maxCount Number of entries available in the iov.
+**/
+inline void SerializerBase::setGather(struct iovec * iov, size_t maxCount)
+{
+	//check
+	assert(iov != NULL || maxCount == 0);
+	assert(this->action == SERIALIZER_PACK);
+	assert(this->gatherCount == 0);
+
+	//setup
+	this->gatherIov = iov;
+	this->gatherMax = maxCount;
+}
+
+/****************************************************/
+/**
+ * Reference a payload in the gather iov. The cursor is not moved as the
+ * payload does not go in the buffer.
+ * @param buffer The data to reference.
+ * @param size The size of the data.
+**/
+inline void SerializerBase::gather(const void * buffer, size_t size)
+{
+	//nothing to send
+	if (size == 0)
+		return;
+
+	//append
+	if (this->gatherCount < this->gatherMax) {
+		this->gatherIov[this->gatherCount].iov_base = (void*)buffer;
+		this->gatherIov[this->gatherCount].iov_len = size;
+		this->gatherCount++;
+	} else {
+		this->gatherOverflow = true;
+	}
+
+	//track
+	this->gatherSize += size;
+}
+
+/****************************************************/
+/**
+ * @return The number of iov entries filled in gather mode.
+**/
+inline size_t SerializerBase::getGatherCount(void) const
+{
+	return this->gatherCount;
+}
+
+/****************************************************/
+/**
+ * @return The sum of the sizes of the payloads gathered.
+**/
+inline size_t SerializerBase::getGatherSize(void) const
+{
+	return this->gatherSize;
+}
+
+/****************************************************/
+/**
+ * @return True if there was more payloads than the iov entries, in which case
+ * the message has to be serialized again without gather mode.
+**/
+inline bool SerializerBase::hasGatherOverflow(void) const
+{
+	return this->gatherOverflow;
+}
+
 /****************************************************/
 /**
  * Return the cursor position in the buffer.
@@ -515,6 +626,9 @@ inline const size_t SerializerBase::getCursor(void)
 **/
 inline void SerializerBase::checkSize(const char * fieldName, size_t size)
 {
+	//nothing can follow a gathered payload
+	assert(this->gatherSize == 0);
+
 	if (this->action != SERIALIZER_STRINGIFY) {
 		size_t requested = this->cursor + size;
 		assumeArg(requested <= this->size, "Buffer is too small to get the new entry (%1) for field %2, size is %3, requested is %4")
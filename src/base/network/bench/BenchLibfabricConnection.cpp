@@ -0,0 +1,115 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "../LibfabricConnection.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Send pings from a client to a server and measure the message rate seen by
+ * the server depending on the number of completion entries read at once.
+ * @param port The port to use so each run gets its own server.
+ * @param batchSize The number of completion entries read in one call.
+ * @param count The number of messages to send.
+ * @param window The number of messages in flight for the client.
+**/
+void benchMessageRate(const char * port, size_t batchSize, size_t count, size_t window)
+{
+	//vars
+	volatile bool serverReady = false;
+	std::chrono::steady_clock::time_point start;
+	std::chrono::steady_clock::time_point stop;
+
+	//server
+	std::thread server([&serverReady, &start, &stop, port, batchSize, count, window]{
+		LibfabricDomain domain("127.0.0.1", port, true);
+		LibfabricConnection connection(&domain, false);
+		connection.setCqBatchSize(batchSize);
+		connection.postReceives(IOC_POST_RECEIVE_READ, 2 * window);
+		bool gotConnection = false;
+		connection.setHooks([&gotConnection](int id) {
+			gotConnection = true;
+		});
+
+		//count the messages
+		size_t received = 0;
+		connection.registerHook(IOC_LF_MSG_PING, [&received, &start, count](LibfabricConnection * connection, LibfabricClientRequest & request) {
+			if (received++ == 0)
+				start = std::chrono::steady_clock::now();
+			request.terminate();
+			return (received == count) ? LF_WAIT_LOOP_UNBLOCK : LF_WAIT_LOOP_KEEP_WAITING;
+		});
+
+		//wait connection
+		serverReady = true;
+		while (!gotConnection)
+			connection.poll(false);
+
+		//receive all
+		connection.poll(true);
+		stop = std::chrono::steady_clock::now();
+	});
+
+	//wait server
+	while (!serverReady) {};
+
+	//client
+	std::thread client([port, count, window]{
+		LibfabricDomain domain("127.0.0.1", port, false);
+		LibfabricConnection connection(&domain, false);
+		connection.postReceives(IOC_POST_RECEIVE_READ, 2);
+		connection.joinServer();
+
+		//send by windows
+		LibfabricEmpty empty;
+		for (size_t sent = 0 ; sent < count ; sent += window) {
+			size_t cnt = std::min(window, count - sent);
+			size_t done = 0;
+			for (size_t i = 0 ; i < cnt ; i++) {
+				connection.sendMessage(IOC_LF_MSG_PING, IOC_LF_SERVER_ID, empty, [&done, cnt](){
+					done++;
+					return (done == cnt) ? LF_WAIT_LOOP_UNBLOCK : LF_WAIT_LOOP_KEEP_WAITING;
+				});
+			}
+			connection.poll(true);
+		}
+	});
+
+	//join
+	server.join();
+	client.join();
+
+	//print
+	std::chrono::duration<double> elapsed = stop - start;
+	printf("Batch %4lu : %10.0f msg/s\n", batchSize, (double)(count - 1) / elapsed.count());
+}
+
+/****************************************************/
+int main(void)
+{
+	//print the provider, it can be selected with FI_PROVIDER=tcp
+	{
+		LibfabricDomain domain("127.0.0.1", "8560", true);
+		printf("Provider : %s\n", domain.getLFProviderName());
+	}
+
+	//bench 1
+	printf("================== Message rate =====================\n");
+	benchMessageRate("8561", 1, 200000, 32);
+	benchMessageRate("8562", IOC_LF_DEFAULT_CQ_BATCH, 200000, 32);
+
+	//ok
+	return EXIT_SUCCESS;
+}
@@ -6,6 +6,9 @@
 
 /****************************************************/
 #include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <vector>
 #include <x86intrin.h>
 #include "../LibfabricDomain.hpp"
 
@@ -52,6 +55,53 @@ void benchSegmentRegistration(void)
 	delete [] ptr;
 }
 
+/****************************************************/
+void benchConcurrentLookup(size_t threads)
+{
+	//create a domain
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+
+	//allocate & register memory
+	const size_t cnt = 16*1024;
+	const size_t size = 4096;
+	const size_t loops = 16;
+	std::vector<void*> ptr(cnt);
+	for (size_t i = 0 ; i < cnt ; i++) {
+		ptr[i] = malloc(size);
+		domain.registerSegment(ptr[i], size, true, true, false);
+	}
+
+	//lookup from all threads at the same time
+	std::vector<std::thread> workers;
+	std::vector<uint64_t> cycles(threads);
+	volatile bool go = false;
+	for (size_t t = 0 ; t < threads ; t++) {
+		workers.emplace_back([&domain, &ptr, &cycles, &go, t, cnt, loops]{
+			while (!go) {};
+			uint64_t start = _rdtsc();
+			for (size_t l = 0 ; l < loops ; l++)
+				for (size_t i = 0 ; i < cnt ; i++)
+					domain.getFidMR((char*)(ptr[(i * 7919 + t) % cnt]) + 1024, 1024);
+			cycles[t] = _rdtsc() - start;
+		});
+	}
+	go = true;
+	for (auto & worker : workers)
+		worker.join();
+
+	//print
+	uint64_t total = 0;
+	for (auto & it : cycles)
+		total += it;
+	printf("Threads %2lu, average time per getFidMR: %0.01f Cycles\n", threads, (float)total / (float)(threads * cnt * loops));
+
+	//clear mem
+	for (size_t i = 0 ; i < cnt ; i++) {
+		domain.unregisterSegment(ptr[i], size);
+		free(ptr[i]);
+	}
+}
+
 /****************************************************/
 int main(void)
 {
@@ -59,6 +109,11 @@ int main(void)
 	printf("================== Segment registration =====================\n");
 	benchSegmentRegistration();
 
+	//bench 2
+	printf("================== Concurrent lookups =======================\n");
+	for (size_t threads = 1 ; threads <= 16 ; threads *= 2)
+		benchConcurrentLookup(threads);
+
 	//ok
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,116 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include "../CreditTracker.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+TEST(TestCreditTracker, constructor)
+{
+	CreditTracker tracker(16, 4);
+	EXPECT_EQ(16, tracker.getCapacity());
+	EXPECT_EQ(4, tracker.getWindow());
+	EXPECT_EQ(0, tracker.getOutstanding());
+}
+
+/****************************************************/
+TEST(TestCreditTracker, grant_receive)
+{
+	//create
+	CreditTracker tracker(16, 4);
+
+	//first grant fills the window
+	EXPECT_EQ(4, tracker.grant(10));
+	EXPECT_EQ(4, tracker.getHeld(10));
+	EXPECT_EQ(0, tracker.grant(10));
+
+	//consume two
+	tracker.onReceive(10);
+	tracker.onReceive(10);
+	EXPECT_EQ(2, tracker.getHeld(10));
+	EXPECT_EQ(2, tracker.getOutstanding());
+
+	//refill
+	EXPECT_EQ(2, tracker.grant(10));
+	EXPECT_EQ(4, tracker.getOutstanding());
+}
+
+/****************************************************/
+TEST(TestCreditTracker, limited_by_capacity)
+{
+	//create
+	CreditTracker tracker(6, 4);
+
+	//second client gets what remains
+	EXPECT_EQ(4, tracker.grant(1));
+	EXPECT_EQ(2, tracker.grant(2));
+	EXPECT_EQ(6, tracker.getOutstanding());
+
+	//the credits given back go to the next one asking
+	tracker.onReceive(1);
+	EXPECT_EQ(1, tracker.grant(2));
+	EXPECT_EQ(0, tracker.grant(1));
+	EXPECT_EQ(3, tracker.getHeld(1));
+	EXPECT_EQ(3, tracker.getHeld(2));
+}
+
+/****************************************************/
+TEST(TestCreditTracker, oversubscribed)
+{
+	//create
+	CreditTracker tracker(2, 2);
+
+	//fill
+	EXPECT_EQ(2, tracker.grant(1));
+
+	//still get one to not block
+	EXPECT_EQ(1, tracker.grant(2));
+	EXPECT_EQ(3, tracker.getOutstanding());
+
+	//do not give more while over the capacity
+	tracker.onReceive(1);
+	EXPECT_EQ(0, tracker.grant(1));
+	tracker.onReceive(2);
+	EXPECT_EQ(1, tracker.grant(2));
+}
+
+/****************************************************/
+TEST(TestCreditTracker, forget)
+{
+	//create
+	CreditTracker tracker(6, 4);
+
+	//fill
+	EXPECT_EQ(4, tracker.grant(1));
+	EXPECT_EQ(2, tracker.grant(2));
+
+	//disconnect, the credits go to the other one
+	tracker.forget(1);
+	EXPECT_EQ(0, tracker.getHeld(1));
+	EXPECT_EQ(2, tracker.getOutstanding());
+	EXPECT_EQ(2, tracker.grant(2));
+	EXPECT_EQ(4, tracker.getHeld(2));
+
+	//unknown client is ignored
+	tracker.forget(5);
+	EXPECT_EQ(4, tracker.getOutstanding());
+}
+
+/****************************************************/
+TEST(TestCreditTracker, receive_without_credit)
+{
+	//create
+	CreditTracker tracker(2, 2);
+
+	//unknown client is ignored
+	tracker.onReceive(5);
+	EXPECT_EQ(0, tracker.getOutstanding());
+	EXPECT_EQ(0, tracker.getHeld(5));
+}
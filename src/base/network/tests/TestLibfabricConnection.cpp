@@ -20,16 +20,21 @@ using namespace IOC;
 
 /****************************************************/
 //helper function to quickly build a client connected to a server and play exchanges
-void clientServer(std::function<void(LibfabricConnection & connection,int clientId)> serverAction, std::function<void(LibfabricConnection & connection)> clientAction)
+void clientServer(std::function<void(LibfabricConnection & connection,int clientId)> serverAction, std::function<void(LibfabricConnection & connection)> clientAction, bool serverMultiRecv = false, size_t serverCredits = 0)
 {
 	bool gotConnection = false;
 	volatile bool serverReady = false;
 
 	//server
-	std::thread server([&gotConnection, &serverReady, &serverAction]{
+	std::thread server([&gotConnection, &serverReady, &serverAction, serverMultiRecv, serverCredits]{
 		LibfabricDomain domain("127.0.0.1", "8446", true);
 		LibfabricConnection connection(&domain, false);
-		connection.postReceives(1024*1024, 64);
+		if (serverMultiRecv)
+			connection.postMultiReceives(4*IOC_POST_RECEIVE_READ, 2, IOC_POST_RECEIVE_READ);
+		else
+			connection.postReceives(1024*1024, 64);
+		if (serverCredits > 0)
+			connection.enableCredits(64, serverCredits);
 		int clientId = 0;
 		connection.setHooks([&gotConnection,&clientId](int id) {
 			gotConnection = true;
@@ -87,6 +92,80 @@ TEST(TestLibfabricConnection, connect)
 	EXPECT_TRUE(serverOk);
 }
 
+/****************************************************/
+//check both sides agree on the eager limits
+TEST(TestLibfabricConnection, eager_limits)
+{
+	//vars
+	LibfabricEagerLimits serverLimits = {0, 0};
+	LibfabricEagerLimits clientLimits = {0, 0};
+
+	//play client server
+	clientServer([&serverLimits](LibfabricConnection & connection, int clientId){
+		//>>>> server <<<<
+		serverLimits = connection.getEagerLimits(clientId);
+	},[&clientLimits](LibfabricConnection & connection){
+		//>>>> client <<<<
+		clientLimits = connection.getEagerLimits(IOC_LF_SERVER_ID);
+	});
+
+	//check
+	EXPECT_EQ(IOC_EAGER_MAX_READ, serverLimits.maxRead);
+	EXPECT_EQ(IOC_EAGER_MAX_WRITE, serverLimits.maxWrite);
+	EXPECT_EQ(IOC_EAGER_MAX_READ, clientLimits.maxRead);
+	EXPECT_EQ(IOC_EAGER_MAX_WRITE, clientLimits.maxWrite);
+}
+
+/****************************************************/
+//check the client gets the credits and sends only with them
+TEST(TestLibfabricConnection, credits)
+{
+	//vars
+	size_t serverHeld = 0;
+	size_t clientCredits = 0;
+	size_t clientQueued = 0;
+	int gotMessages = 0;
+
+	//play client server
+	clientServer([&serverHeld, &gotMessages](LibfabricConnection & connection, int clientId){
+		//>>>> server <<<<
+		serverHeld = connection.getCreditTracker()->getHeld(clientId);
+
+		//answer to the pings, it returns the credits
+		connection.registerHook(IOC_LF_MSG_PING, [&gotMessages](LibfabricConnection * connection, LibfabricClientRequest & request) {
+			gotMessages++;
+			connection->sendResponse(IOC_LF_MSG_PONG, request.lfClientId, 0);
+			request.terminate();
+			return (gotMessages == 3) ? LF_WAIT_LOOP_UNBLOCK : LF_WAIT_LOOP_KEEP_WAITING;
+		});
+
+		//poll until get the messages
+		connection.poll(true);
+	},[&clientCredits, &clientQueued](LibfabricConnection & connection){
+		//>>>> client <<<<
+		clientCredits = connection.getCredits();
+
+		//send more than the credits, the last one is queued
+		LibfabricEmpty empty;
+		for (int i = 0 ; i < 3 ; i++)
+			connection.sendMessageNoPollWakeup(IOC_LF_MSG_PING, IOC_LF_SERVER_ID, empty);
+		clientQueued = connection.getQueuedSends();
+
+		//wait the responses, they carry the credits to send the queued one
+		for (int i = 0 ; i < 3 ; i++) {
+			LibfabricRemoteResponse response;
+			connection.pollMessage(response, IOC_LF_MSG_PONG);
+			connection.repostReceive(response.msgBufferId);
+		}
+	}, false, 2);
+
+	//check
+	EXPECT_EQ(2, serverHeld);
+	EXPECT_EQ(2, clientCredits);
+	EXPECT_EQ(1, clientQueued);
+	EXPECT_EQ(3, gotMessages);
+}
+
 /****************************************************/
 // Connect and client send a message.
 TEST(TestLibfabricConnection, message)
@@ -127,6 +206,47 @@ TEST(TestLibfabricConnection, message)
 	ASSERT_TRUE(sendMessage);
 }
 
+/****************************************************/
+// Send more messages than the receive slabs can hold at once.
+TEST(TestLibfabricConnection, message_multi_recv)
+{
+	//vars
+	const int count = 32;
+	int gotMessages = 0;
+	int sentMessages = 0;
+
+	//play client server
+	clientServer([&gotMessages, count](LibfabricConnection & connection, int clientId){
+		//>>>> server <<<<
+
+		//register hook
+		connection.registerHook(IOC_LF_MSG_PING, [&gotMessages, count](LibfabricConnection * connection, LibfabricClientRequest & request) {
+			gotMessages++;
+			request.terminate();
+			return (gotMessages == count) ? LF_WAIT_LOOP_UNBLOCK : LF_WAIT_LOOP_KEEP_WAITING;
+		});
+
+		//poll until get all the messages
+		connection.poll(true);
+	},[&sentMessages, count](LibfabricConnection & connection){
+		//>>>> client <<<<
+
+		//send messages one by one
+		LibfabricEmpty empty;
+		for (int i = 0 ; i < count ; i++) {
+			connection.sendMessage(IOC_LF_MSG_PING, IOC_LF_SERVER_ID, empty , [&sentMessages](){
+				sentMessages++;
+				return LF_WAIT_LOOP_UNBLOCK;
+			});
+			connection.poll(true);
+		}
+	}, true);
+
+	//check
+	ASSERT_EQ(count, gotMessages);
+	ASSERT_EQ(count, sentMessages);
+}
+
 /****************************************************/
 TEST(TestLibfabricConnection, sendResponse)
 {
@@ -737,3 +857,46 @@ TEST(TestLibfabricConnection, sendMessageNoPollWakeup_serialize)
 	ASSERT_TRUE(gotMessage);
 	ASSERT_TRUE(sendMessage);
 }
+
+/****************************************************/
+TEST(TestLibfabricConnection, sendResponse_inject)
+{
+	bool gotMessage = false;
+	int32_t status = 0;
+
+	//play client server
+	clientServer([&gotMessage](LibfabricConnection & connection, int clientId){
+		//>>>> server <<<<
+
+		//register hook
+		connection.registerHook(IOC_LF_MSG_PING, [&gotMessage](LibfabricConnection * connection, LibfabricClientRequest & request) {
+			//end
+			gotMessage = true;
+			request.terminate();
+
+			//small ack, injected if the provider allows it
+			connection->sendResponse(IOC_LF_MSG_PONG, request.lfClientId, 42);
+
+			//say to unblock the poll(true) loop when return
+			return LF_WAIT_LOOP_UNBLOCK;
+		});
+
+		//poll until get message
+		connection.poll(true);
+	},[&status](LibfabricConnection & connection){
+		//>>>> client <<<<
+		LibfabricEmpty empty;
+		connection.sendMessageNoPollWakeup(IOC_LF_MSG_PING, IOC_LF_SERVER_ID, empty);
+
+		//wait message back
+		LibfabricRemoteResponse response;
+		connection.pollMessage(response, IOC_LF_MSG_PONG);
+		LibfabricResponse ack;
+		response.deserializer.apply("ack", ack);
+		status = ack.status;
+		response.terminate();
+	});
+
+	ASSERT_TRUE(gotMessage);
+	ASSERT_EQ(42, status);
+}
@@ -8,6 +8,7 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <cstring>
+#include <vector>
 #include "../LibfabricDomain.hpp"
 
 /****************************************************/
@@ -57,3 +58,50 @@ TEST(TestLibfaricDomain, register_mem_and_getmr)
 	domain.unregisterSegment(buffer1, 1024);
 	domain.unregisterSegment(buffer2, 1024);
 }
+
+/****************************************************/
+// Test looking up segments from threads while others are registered.
+TEST(TestLibfaricDomain, getmr_concurrent_register)
+{
+	//build domain
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+
+	//stable buffer
+	static char stable[4096];
+	domain.registerSegment(stable, 4096, true, true, false);
+
+	//lookup from threads
+	volatile bool stop = false;
+	std::vector<std::thread> threads;
+	int errors[4] = {0, 0, 0, 0};
+	for (int t = 0 ; t < 4 ; t++) {
+		threads.emplace_back([&domain, &stop, &errors, t]{
+			while (!stop)
+				if (domain.getFidMR(stable + 1024, 1024) == nullptr)
+					errors[t]++;
+		});
+	}
+
+	//register & unregister others meanwhile
+	static char others[64][1024];
+	for (int i = 0 ; i < 64 ; i++)
+		domain.registerSegment(others[i], 1024, true, true, false);
+	for (int i = 0 ; i < 64 ; i++)
+		EXPECT_NE(nullptr, domain.getFidMR(others[i], 1024));
+	for (int i = 0 ; i < 64 ; i++) {
+		EXPECT_NE(nullptr, domain.getFidMR(others[i], 1024));
+		domain.unregisterSegment(others[i], 1024);
+		EXPECT_EQ(nullptr, domain.getFidMR(others[i], 1024));
+		EXPECT_EQ(nullptr, domain.getMR(others[i], 1024));
+	}
+
+	//stop
+	stop = true;
+	for (auto & thread : threads)
+		thread.join();
+
+	//check
+	for (int t = 0 ; t < 4 ; t++)
+		EXPECT_EQ(0, errors[t]);
+	domain.unregisterSegment(stable, 4096);
+}
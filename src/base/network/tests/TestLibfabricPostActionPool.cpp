@@ -0,0 +1,126 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//gtest
+#include <gtest/gtest.h>
+//local
+#include "../LibfabricConnection.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+//action counting its runs and destructions
+class CountingPostAction : public LibfabricPostAction
+{
+	public:
+		CountingPostAction(int * runs, int * destroyed) {this->runs = runs; this->destroyed = destroyed;};
+		~CountingPostAction(void) {(*this->destroyed)++;};
+		virtual LibfabricActionResult runPostAction(void) override {(*this->runs)++; return LF_WAIT_LOOP_KEEP_WAITING;};
+	private:
+		int * runs;
+		int * destroyed;
+};
+
+/****************************************************/
+//action too large to fit in a slot
+class LargePostAction : public CountingPostAction
+{
+	public:
+		LargePostAction(int * runs, int * destroyed) : CountingPostAction(runs, destroyed) {};
+	private:
+		char padding[2 * IOC_LF_POST_ACTION_SLOT_SIZE];
+};
+
+/****************************************************/
+TEST(TestLibfabricPostActionPool, constructor)
+{
+	LibfabricPostActionPool pool;
+	EXPECT_EQ(0, pool.getSlotCount());
+	EXPECT_EQ(0, pool.getFreeCount());
+}
+
+/****************************************************/
+TEST(TestLibfabricPostActionPool, acquire_release)
+{
+	//vars
+	LibfabricPostActionPool pool;
+	int runs = 0;
+	int destroyed = 0;
+
+	//acquire
+	CountingPostAction * action = pool.acquire<CountingPostAction>(&runs, &destroyed);
+	EXPECT_EQ(IOC_LF_POST_ACTION_CHUNK_SLOTS, pool.getSlotCount());
+	EXPECT_EQ(IOC_LF_POST_ACTION_CHUNK_SLOTS - 1, pool.getFreeCount());
+
+	//run & release
+	EXPECT_EQ(LF_WAIT_LOOP_KEEP_WAITING, action->runPostAction());
+	action->release();
+	EXPECT_EQ(1, runs);
+	EXPECT_EQ(1, destroyed);
+	EXPECT_EQ(IOC_LF_POST_ACTION_CHUNK_SLOTS, pool.getFreeCount());
+
+	//the slot is recycled
+	CountingPostAction * action2 = pool.acquire<CountingPostAction>(&runs, &destroyed);
+	EXPECT_EQ(action, action2);
+	action2->release();
+	EXPECT_EQ(IOC_LF_POST_ACTION_CHUNK_SLOTS, pool.getSlotCount());
+}
+
+/****************************************************/
+TEST(TestLibfabricPostActionPool, grow)
+{
+	//vars
+	LibfabricPostActionPool pool;
+	std::vector<LibfabricPostAction*> actions;
+
+	//fill more than one chunk
+	for (int i = 0 ; i < IOC_LF_POST_ACTION_CHUNK_SLOTS + 1 ; i++)
+		actions.push_back(pool.acquire<LibfabricPostActionNop>(LF_WAIT_LOOP_UNBLOCK));
+	EXPECT_EQ(2 * IOC_LF_POST_ACTION_CHUNK_SLOTS, pool.getSlotCount());
+	EXPECT_EQ(IOC_LF_POST_ACTION_CHUNK_SLOTS - 1, pool.getFreeCount());
+
+	//release all
+	for (auto & it : actions)
+		it->release();
+	EXPECT_EQ(2 * IOC_LF_POST_ACTION_CHUNK_SLOTS, pool.getFreeCount());
+}
+
+/****************************************************/
+TEST(TestLibfabricPostActionPool, function)
+{
+	//vars
+	LibfabricPostActionPool pool;
+	int value = 0;
+
+	//lambda
+	LibfabricPostAction * action = pool.acquire<LibfabricPostActionFunction>([&value](){
+		value = 10;
+		return LF_WAIT_LOOP_UNBLOCK;
+	});
+	EXPECT_EQ(LF_WAIT_LOOP_UNBLOCK, action->runPostAction());
+	EXPECT_EQ(10, value);
+	action->release();
+	EXPECT_EQ(pool.getSlotCount(), pool.getFreeCount());
+}
+
+/****************************************************/
+TEST(TestLibfabricPostActionPool, too_large)
+{
+	//vars
+	LibfabricPostActionPool pool;
+	int runs = 0;
+	int destroyed = 0;
+
+	//fallback on new
+	LargePostAction * action = pool.acquire<LargePostAction>(&runs, &destroyed);
+	EXPECT_EQ(0, pool.getSlotCount());
+	action->runPostAction();
+	action->release();
+	EXPECT_EQ(1, runs);
+	EXPECT_EQ(1, destroyed);
+}
@@ -0,0 +1,205 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+#include "../LibfabricDomain.hpp"
+#include "../MemoryRegionCache.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+TEST(TestMemoryRegionCache, constructor)
+{
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	EXPECT_EQ(0, cache.getRegisteredSize());
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, acquire_release_hit)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	static char buffer[8192];
+
+	//first is a miss
+	Iov iov1;
+	MemoryRegionCacheEntry * entry = cache.acquire(buffer, 8192, true, true, iov1);
+	ASSERT_NE(nullptr, entry);
+	EXPECT_EQ(8192, cache.getRegisteredSize());
+	cache.release(entry);
+
+	//still registered
+	EXPECT_NE(nullptr, domain.getMR(buffer, 8192));
+
+	//sub range is a hit
+	Iov iov2;
+	MemoryRegionCacheEntry * entry2 = cache.acquire(buffer + 4096, 1024, true, false, iov2);
+	EXPECT_EQ(entry, entry2);
+	EXPECT_EQ(iov1.key, iov2.key);
+	EXPECT_EQ(iov1.addr + 4096, iov2.addr);
+	cache.release(entry2);
+
+	//check stats
+	MemoryRegionCacheStats stats = cache.getStats();
+	EXPECT_EQ(1, stats.hits);
+	EXPECT_EQ(1, stats.misses);
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, merge)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	static char buffer[8192];
+	Iov iov;
+
+	//two parts
+	cache.release(cache.acquire(buffer, 4096, true, false, iov));
+	cache.release(cache.acquire(buffer + 4096, 4096, true, false, iov));
+	EXPECT_EQ(8192, cache.getRegisteredSize());
+
+	//overlapping both, replaced by the union
+	MemoryRegionCacheEntry * entry = cache.acquire(buffer + 2048, 4096, true, false, iov);
+	EXPECT_EQ(8192, cache.getRegisteredSize());
+	cache.release(entry);
+
+	//now a hit
+	MemoryRegionCacheEntry * entry2 = cache.acquire(buffer, 8192, true, false, iov);
+	EXPECT_EQ(entry, entry2);
+	cache.release(entry2);
+	EXPECT_EQ(1, cache.getStats().hits);
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, access_upgrade)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	static char buffer[4096];
+	Iov iov;
+
+	//register for read then ask write
+	cache.release(cache.acquire(buffer, 4096, true, false, iov));
+	cache.release(cache.acquire(buffer, 4096, false, true, iov));
+	EXPECT_EQ(2, cache.getStats().misses);
+
+	//now both are a hit
+	cache.release(cache.acquire(buffer, 4096, true, false, iov));
+	cache.release(cache.acquire(buffer, 4096, false, true, iov));
+	EXPECT_EQ(2, cache.getStats().hits);
+	EXPECT_EQ(4096, cache.getRegisteredSize());
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, lru_eviction)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 8192);
+	static char buffer[4*4096];
+	Iov iov;
+
+	//fill
+	cache.release(cache.acquire(buffer, 4096, true, true, iov));
+	cache.release(cache.acquire(buffer + 4096, 4096, true, true, iov));
+
+	//touch the first one
+	cache.release(cache.acquire(buffer, 4096, true, true, iov));
+
+	//over the limit, evict the second one
+	cache.release(cache.acquire(buffer + 3*4096, 4096, true, true, iov));
+	EXPECT_EQ(8192, cache.getRegisteredSize());
+	EXPECT_EQ(1, cache.getStats().evictions);
+	EXPECT_NE(nullptr, domain.getMR(buffer, 4096));
+	EXPECT_EQ(nullptr, domain.getMR(buffer + 4096, 4096));
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, used_not_evicted)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 4096);
+	static char buffer[2*4096];
+	Iov iov;
+
+	//two used, over the limit
+	MemoryRegionCacheEntry * entry1 = cache.acquire(buffer, 4096, true, true, iov);
+	MemoryRegionCacheEntry * entry2 = cache.acquire(buffer + 4096, 4096, true, true, iov);
+	EXPECT_EQ(8192, cache.getRegisteredSize());
+
+	//evicted on release
+	cache.release(entry1);
+	EXPECT_EQ(4096, cache.getRegisteredSize());
+	cache.release(entry2);
+	EXPECT_EQ(4096, cache.getRegisteredSize());
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, invalidate)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	static char buffer[2*4096];
+	Iov iov;
+
+	//one idle, one used
+	cache.release(cache.acquire(buffer, 4096, true, true, iov));
+	MemoryRegionCacheEntry * entry = cache.acquire(buffer + 4096, 4096, true, true, iov);
+
+	//invalidate both
+	cache.invalidate(buffer, 2*4096);
+	EXPECT_EQ(4096, cache.getRegisteredSize());
+	EXPECT_EQ(nullptr, domain.getMR(buffer, 4096));
+
+	//the used one is dropped on release
+	cache.release(entry);
+	EXPECT_EQ(0, cache.getRegisteredSize());
+	EXPECT_EQ(nullptr, domain.getMR(buffer + 4096, 4096));
+	EXPECT_EQ(2, cache.getStats().invalidations);
+
+	//registered again on next use
+	cache.release(cache.acquire(buffer + 4096, 4096, true, true, iov));
+	EXPECT_EQ(3, cache.getStats().misses);
+}
+
+/****************************************************/
+TEST(TestMemoryRegionCache, wait_used_overlap)
+{
+	//vars
+	LibfabricDomain domain("127.0.0.1", "8555", true);
+	MemoryRegionCache cache(&domain, 1024*1024);
+	static char buffer[2*4096];
+	Iov iov;
+
+	//used by a first transfer
+	MemoryRegionCacheEntry * entry = cache.acquire(buffer, 4096, true, true, iov);
+
+	//the overlapping one wait the release
+	volatile bool done = false;
+	std::thread thread([&cache, &done]{
+		Iov iov;
+		cache.release(cache.acquire(buffer + 2048, 4096, true, true, iov));
+		done = true;
+	});
+	usleep(10000);
+	EXPECT_FALSE(done);
+	cache.release(entry);
+	thread.join();
+	EXPECT_TRUE(done);
+
+	//merged
+	EXPECT_EQ(4096 + 2048, cache.getRegisteredSize());
+}
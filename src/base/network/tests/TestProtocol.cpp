@@ -9,6 +9,7 @@
 #include "../Serializer.hpp"
 #include "../Protocol.hpp"
 #include <sstream>
+#include <cstring>
 
 /****************************************************/
 using namespace IOC;
@@ -134,16 +135,18 @@ TEST(TestProtocol, LibfabricMessageHeader)
 		.lfClientId = 10,
 		.tcpClientId = 20,
 		.tcpClientKey = 30,
+		.credits = 4,
 	};
 
 	//apply
-	serializeDeserialize(in, out, 32);
+	serializeDeserialize(in, out, 36);
 
 	//check
 	EXPECT_EQ(in.msgType, out.msgType);
 	EXPECT_EQ(in.lfClientId, out.lfClientId);
 	EXPECT_EQ(in.tcpClientId, out.tcpClientId);
 	EXPECT_EQ(in.tcpClientKey, out.tcpClientKey);
+	EXPECT_EQ(in.credits, out.credits);
 }
 
 /****************************************************/
@@ -296,6 +299,23 @@ TEST(TestProtocol, LibfabricObjectCow)
 	EXPECT_EQ(in.rangeSize, out.rangeSize);
 }
 
+/****************************************************/
+TEST(TestProtocol, LibfabricQosInfos)
+{
+	//allocate
+	LibfabricQosInfos out, in = {
+		.flushBandwidth = 100,
+		.missBandwidth = 200,
+	};
+
+	//apply
+	serializeDeserialize(in, out, 16);
+
+	//check
+	EXPECT_EQ(in.flushBandwidth, out.flushBandwidth);
+	EXPECT_EQ(in.missBandwidth, out.missBandwidth);
+}
+
 /****************************************************/
 TEST(TestProtocol, LibfabricResponse)
 {
@@ -348,6 +368,99 @@ TEST(TestProtocol, LibfabricResponse_data_fragments)
 	EXPECT_STREQ("HelloWorld", out.optionalData);
 }
 
+/****************************************************/
+TEST(TestProtocol, LibfabricResponse_data_fragments_gather)
+{
+	//fragments
+	char f1[] = "Hello";
+	char f2[] = "World";
+	LibfabricBuffer fragments[2] = {
+		{f1, 5},
+		{f2, 6}
+	};
+
+	//allocate
+	LibfabricResponse in = {
+		.msgDataSize = 11,
+		.status = 10,
+		.msgHasData = true,
+		.optionalData = NULL,
+		.optionalDataFragments = fragments,
+		.optionalDataFragmentCount = 2
+	};
+
+	//copy mode as reference
+	char ref[1024];
+	Serializer refSerializer(ref, sizeof(ref));
+	refSerializer.apply("in", in);
+
+	//gather mode
+	char header[1024];
+	struct iovec iov[4];
+	Serializer serializer(header, sizeof(header));
+	serializer.setGather(iov, 4);
+	serializer.apply("in", in);
+
+	//check
+	ASSERT_FALSE(serializer.hasGatherOverflow());
+	ASSERT_EQ(2, serializer.getGatherCount());
+	EXPECT_EQ(11, serializer.getGatherSize());
+	EXPECT_EQ(f1, iov[0].iov_base);
+	EXPECT_EQ(f2, iov[1].iov_base);
+	ASSERT_EQ(refSerializer.getCursor(), serializer.getCursor() + serializer.getGatherSize());
+
+	//concat as on the wire
+	char wire[1024];
+	size_t cursor = serializer.getCursor();
+	memcpy(wire, header, cursor);
+	for (size_t i = 0 ; i < serializer.getGatherCount() ; i++) {
+		memcpy(wire + cursor, iov[i].iov_base, iov[i].iov_len);
+		cursor += iov[i].iov_len;
+	}
+	EXPECT_EQ(0, memcmp(ref, wire, cursor));
+
+	//deserialize
+	LibfabricResponse out;
+	DeSerializer deserializer(wire, cursor);
+	deserializer.apply("out", out);
+	EXPECT_EQ(in.status, out.status);
+	EXPECT_STREQ("HelloWorld", out.optionalData);
+}
+
+/****************************************************/
+TEST(TestProtocol, LibfabricResponse_data_fragments_gather_overflow)
+{
+	//fragments
+	char f1[] = "Hello";
+	char f2[] = "World";
+	LibfabricBuffer fragments[2] = {
+		{f1, 5},
+		{f2, 6}
+	};
+
+	//allocate
+	LibfabricResponse in = {
+		.msgDataSize = 11,
+		.status = 10,
+		.msgHasData = true,
+		.optionalData = NULL,
+		.optionalDataFragments = fragments,
+		.optionalDataFragmentCount = 2
+	};
+
+	//only one iov entry available
+	char header[1024];
+	struct iovec iov[1];
+	Serializer serializer(header, sizeof(header));
+	serializer.setGather(iov, 1);
+	serializer.apply("in", in);
+
+	//check
+	EXPECT_TRUE(serializer.hasGatherOverflow());
+	EXPECT_EQ(1, serializer.getGatherCount());
+	EXPECT_EQ(11, serializer.getGatherSize());
+}
+
 /****************************************************/
 TEST(TestProtocol, LibfabricFirstHandshake)
 {
@@ -355,14 +468,18 @@ TEST(TestProtocol, LibfabricFirstHandshake)
 	LibfabricFirstHandshake out, in = {
 		.protocolVersion = 10,
 		.assignLfClientId = 20,
+		.eagerMaxRead = 30,
+		.eagerMaxWrite = 40,
 	};
 
 	//apply
-	serializeDeserialize(in, out, 12);
+	serializeDeserialize(in, out, 28);
 
 	//check
 	EXPECT_EQ(in.protocolVersion, out.protocolVersion);
 	EXPECT_EQ(in.assignLfClientId, out.assignLfClientId);
+	EXPECT_EQ(in.eagerMaxRead, out.eagerMaxRead);
+	EXPECT_EQ(in.eagerMaxWrite, out.eagerMaxWrite);
 }
 
 /****************************************************/
@@ -371,12 +488,16 @@ TEST(TestProtocol, LibfabricFirstClientMessage)
 	//allocate
 	LibfabricFirstClientMessage out, in;
 	strcpy(in.addr, "192.168.1.1");
+	in.eagerMaxRead = 10;
+	in.eagerMaxWrite = 20;
 
 	//apply
-	serializeDeserialize(in, out, 32);
+	serializeDeserialize(in, out, 48);
 
 	//check
 	EXPECT_STREQ(in.addr, out.addr);
+	EXPECT_EQ(in.eagerMaxRead, out.eagerMaxRead);
+	EXPECT_EQ(in.eagerMaxWrite, out.eagerMaxWrite);
 }
 
 /****************************************************/
@@ -6,11 +6,83 @@
 
 /****************************************************/
 #include <cstring>
+#include <unistd.h>
 #include "Actions.hpp"
 
 /****************************************************/
 using namespace IOC;
 
+/****************************************************/
+/**
+ * Check if the server asked to retry the request later because it is out
+ * of memory or reached a bandwidth limit and wait before retrying with an exponential backoff.
+ * @param status The status returned by the server.
+ * @param retry The retry counter, incremented on each call returning true.
+ * @return True if the request has to be sent again, false otherwise.
+**/
+static bool waitBeforeRetry(ssize_t status, int & retry)
+{
+	//no need to retry or give up
+	if (status != IOC_LF_STATUS_RETRY_LATER || retry >= IOC_CLIENT_MAX_RETRY)
+		return false;
+
+	//compute delay
+	useconds_t delay = IOC_CLIENT_RETRY_DELAY_US << retry;
+	if (delay > IOC_CLIENT_RETRY_MAX_DELAY_US)
+		delay = IOC_CLIENT_RETRY_MAX_DELAY_US;
+
+	//wait
+	usleep(delay);
+	retry++;
+	return true;
+}
+
+/****************************************************/
+/**
+ * Register a user buffer for the RDMA operations of a transfer. It goes
+ * through the memory region cache of the domain if it is enabled.
+ * @param connection Reference to the libfabric connection to use.
+ * @param buffer The buffer to register.
+ * @param size Size of the buffer.
+ * @param read If the server will read the buffer.
+ * @param write If the server will write in the buffer.
+ * @param entry Set to the cached registration to release or NULL if not cached.
+ * @return The Iov to send to the server.
+**/
+static Iov registerBuffer(LibfabricConnection &connection, void * buffer, size_t size, bool read, bool write, MemoryRegionCacheEntry * & entry)
+{
+	//vars
+	Iov iov;
+	MemoryRegionCache * cache = connection.getDomain().getMrCache();
+
+	//register
+	if (cache != NULL) {
+		entry = cache->acquire(buffer, size, read, write, iov);
+	} else {
+		entry = NULL;
+		iov = connection.getDomain().registerSegment(buffer, size, read, write, false);
+	}
+
+	//ret
+	return iov;
+}
+
+/****************************************************/
+/**
+ * Release a buffer registered by registerBuffer().
+ * @param connection Reference to the libfabric connection to use.
+ * @param buffer The registered buffer.
+ * @param size Size of the buffer.
+ * @param entry The cached registration or NULL if not cached.
+**/
+static void unregisterBuffer(LibfabricConnection &connection, void * buffer, size_t size, MemoryRegionCacheEntry * entry)
+{
+	if (entry != NULL)
+		connection.getDomain().getMrCache()->release(entry);
+	else
+		connection.getDomain().unregisterSegment(buffer, size);
+}
+
 /****************************************************/
 /**
  * Implement the ping pong operation for the client side. We can ask to make the loop
@@ -92,7 +164,7 @@ void IOC::ping_pong(LibfabricDomain & domain, LibfabricConnection &connection, i
  * @param offset Offset of the data to read from the object.
  * @return Size of the read operation or negative value on error.
 **/
-ssize_t IOC::obj_read(LibfabricConnection &connection, const LibfabricObjectId & objectId, void* buffer, size_t size, size_t offset)
+static ssize_t obj_read_once(LibfabricConnection &connection, const LibfabricObjectId & objectId, void* buffer, size_t size, size_t offset)
 {
 	//build request
 	LibfabricObjReadWriteInfos objReadWrite = {
@@ -103,10 +175,14 @@ ssize_t IOC::obj_read(LibfabricConnection &connection, const LibfabricObjectId &
 		.optionalData = NULL
 	};
 
+	//eager size agreed with the server
+	size_t eagerMax = connection.getEagerLimits(IOC_LF_SERVER_ID).maxRead;
+
 	//if rdma
-	if (size > IOC_EAGER_MAX_READ) {
+	MemoryRegionCacheEntry * entry = NULL;
+	if (size > eagerMax) {
 		//register
-		Iov iov = connection.getDomain().registerSegment(buffer, size, true, true, false);
+		Iov iov = registerBuffer(connection, buffer, size, true, true, entry);
 		objReadWrite.iov = iov;
 	}
 
@@ -136,17 +212,38 @@ ssize_t IOC::obj_read(LibfabricConnection &connection, const LibfabricObjectId &
 	serverResponse.terminate();
 
 	//unregister
-	if (size > IOC_EAGER_MAX_READ)
-		connection.getDomain().unregisterSegment(buffer, size);
+	if (size > eagerMax)
+		unregisterBuffer(connection, buffer, size, entry);
 
 	//check status
-	if (status != 0)
+	if (status != 0 && status != IOC_LF_STATUS_RETRY_LATER)
 		printf("Invalid status read : %d\n", status);
 	
 	//ret
 	return status;
 }
 
+/****************************************************/
+/**
+ * Make read read operation to read an object from the server. If the server
+ * is out of memory, the request is sent again after a delay.
+ * @param connection Reference to the libfabric connection to use.
+ * @param objectID The ID of the object to read.
+ * @param buffer Buffer where to place the data.
+ * @param size Size of the read operation.
+ * @param offset Offset of the data to read from the object.
+ * @return Size of the read operation or negative value on error.
+**/
+ssize_t IOC::obj_read(LibfabricConnection &connection, const LibfabricObjectId & objectId, void* buffer, size_t size, size_t offset)
+{
+	ssize_t status;
+	int retry = 0;
+	do {
+		status = obj_read_once(connection, objectId, buffer, size, offset);
+	} while (waitBeforeRetry(status, retry));
+	return status;
+}
+
 /****************************************************/
 /**
  * Make read write operation to write to an object on the server. It can handle it via eager or RDMA operation.
@@ -157,7 +254,7 @@ ssize_t IOC::obj_read(LibfabricConnection &connection, const LibfabricObjectId &
  * @param offset Offset of the data where to write in the object.
  * @return Size of the write operation or negative value on error.
 **/
-ssize_t IOC::obj_write(LibfabricConnection &connection, const LibfabricObjectId & objectId, const void* buffer, size_t size, size_t offset)
+static ssize_t obj_write_once(LibfabricConnection &connection, const LibfabricObjectId & objectId, const void* buffer, size_t size, size_t offset)
 {
 	//build request
 	LibfabricObjReadWriteInfos objReadWrite = {
@@ -168,15 +265,19 @@ ssize_t IOC::obj_write(LibfabricConnection &connection, const LibfabricObjectId
 		.optionalData = NULL
 	};
 
+	//eager size agreed with the server
+	size_t eagerMax = connection.getEagerLimits(IOC_LF_SERVER_ID).maxWrite;
+
 	//if rdma
-	if (size > IOC_EAGER_MAX_WRITE) {
+	MemoryRegionCacheEntry * entry = NULL;
+	if (size > eagerMax) {
 		//register
-		Iov iov = connection.getDomain().registerSegment((char*)buffer, size, true, false, false);
+		Iov iov = registerBuffer(connection, (char*)buffer, size, true, false, entry);
 		objReadWrite.iov = iov;
 	}
 
 	//embed small data in message
-	if (size <= IOC_EAGER_MAX_WRITE) {
+	if (size <= eagerMax) {
 		objReadWrite.msgHasData = true;
 		objReadWrite.optionalData = (const char*)buffer;
 	}
@@ -196,16 +297,37 @@ ssize_t IOC::obj_write(LibfabricConnection &connection, const LibfabricObjectId
 	serverResponse.terminate();
 
 	//unregister
-	if (size > IOC_EAGER_MAX_WRITE)
-		connection.getDomain().unregisterSegment((char*)buffer, size);
+	if (size > eagerMax)
+		unregisterBuffer(connection, (char*)buffer, size, entry);
 
 	//check status
-	if (status != 0)
+	if (status != 0 && status != IOC_LF_STATUS_RETRY_LATER)
 		printf("Invalid status write : %d\n", status);
 	
 	return status;
 }
 
+/****************************************************/
+/**
+ * Make read write operation to write to an object on the server. If the server
+ * is out of memory, the request is sent again after a delay.
+ * @param connection Reference to the libfabric connection to use.
+ * @param objectId The ID of the object to write.
+ * @param buffer Buffer containing the data to write.
+ * @param size Size of the write operation.
+ * @param offset Offset of the data where to write in the object.
+ * @return Size of the write operation or negative value on error.
+**/
+ssize_t IOC::obj_write(LibfabricConnection &connection, const LibfabricObjectId & objectId, const void* buffer, size_t size, size_t offset)
+{
+	ssize_t status;
+	int retry = 0;
+	do {
+		status = obj_write_once(connection, objectId, buffer, size, offset);
+	} while (waitBeforeRetry(status, retry));
+	return status;
+}
+
 /****************************************************/
 /**
  * Perform a flush operation on a range space of the given object.
@@ -215,7 +337,7 @@ ssize_t IOC::obj_write(LibfabricConnection &connection, const LibfabricObjectId
  * @param size Size of the segment to flush. Can use 0 to say all.
  * @return Return 0 on success, negative value on error.
 **/
-int IOC::obj_flush(LibfabricConnection &connection, const LibfabricObjectId & objectId, size_t offset, size_t size)
+static int obj_flush_once(LibfabricConnection &connection, const LibfabricObjectId & objectId, size_t offset, size_t size)
 {
 	//build message
 	LibfabricObjFlushInfos objFlush = {
@@ -239,12 +361,33 @@ int IOC::obj_flush(LibfabricConnection &connection, const LibfabricObjectId & ob
 	serverResponse.terminate();
 
 	//check status
-	if (status != 0)
+	if (status != 0 && status != IOC_LF_STATUS_RETRY_LATER)
 		printf("Invalid status flush : %d\n", status);
 	
 	return status;
 }
 
+/****************************************************/
+/**
+ * Perform a flush operation on a range space of the given object. If the
+ * server reached its flush bandwidth limit, the request is sent again after
+ * a delay.
+ * @param connection Reference to the libfabric connection to use.
+ * @param objectID The ID of the object to flush.
+ * @param offset Offset of the flush operation.
+ * @param size Size of the segment to flush. Can use 0 to say all.
+ * @return Return 0 on success, negative value on error.
+**/
+int IOC::obj_flush(LibfabricConnection &connection, const LibfabricObjectId & objectId, size_t offset, size_t size)
+{
+	int status;
+	int retry = 0;
+	do {
+		status = obj_flush_once(connection, objectId, offset, size);
+	} while (waitBeforeRetry(status, retry));
+	return status;
+}
+
 /****************************************************/
 /**
  * Perform a range registrion to notify we make a mapping on this part of the object.
@@ -407,3 +550,35 @@ int IOC::obj_cow(LibfabricConnection &connection, const LibfabricObjectId & sour
 	
 	return status;
 }
+
+/****************************************************/
+/**
+ * Change the bandwidth limits of the server.
+ * @param connection Reference to the libfabric connection to use.
+ * @param flushBandwidth Bandwidth limit of the flush operations in bytes per second, 0 for unlimited.
+ * @param missBandwidth Bandwidth limit of the storage reads made on the misses in bytes per second, 0 for unlimited.
+**/
+int IOC::set_qos(LibfabricConnection &connection, size_t flushBandwidth, size_t missBandwidth)
+{
+	//build message
+	LibfabricQosInfos qos = {
+		.flushBandwidth = flushBandwidth,
+		.missBandwidth = missBandwidth
+	};
+
+	//send message
+	connection.sendMessageNoPollWakeup(IOC_LF_MSG_SET_QOS, IOC_LF_SERVER_ID, qos);
+
+	//poll
+	LibfabricRemoteResponse serverResponse;
+	bool hasMessage = connection.pollMessage(serverResponse, IOC_LF_MSG_SET_QOS_ACK);
+	assume(hasMessage, "Fail to get message from pollMessage !");
+
+	//extract status & repost message
+	LibfabricResponse response;
+	serverResponse.deserializer.apply("response", response);
+	int status = response.status;
+	serverResponse.terminate();
+
+	return status;
+}
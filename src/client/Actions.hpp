@@ -16,6 +16,14 @@
 namespace IOC
 {
 
+/****************************************************/
+/** Maximum number of retries when the server is out of memory. **/
+#define IOC_CLIENT_MAX_RETRY 12
+/** First delay before retrying a request (in micro-seconds), doubled on each retry. **/
+#define IOC_CLIENT_RETRY_DELAY_US 100
+/** Maximum delay between two retries (in micro-seconds). **/
+#define IOC_CLIENT_RETRY_MAX_DELAY_US (100*1000)
+
 /****************************************************/
 void ping_pong(LibfabricDomain & domain, LibfabricConnection &connection, int cnt, size_t eagerSize = 0, size_t rdmaSize = 0);
 ssize_t obj_read(LibfabricConnection &connection, const LibfabricObjectId & objectId, void* buffer, size_t size, size_t offset);
@@ -25,6 +33,7 @@ int obj_create(LibfabricConnection &connection, const LibfabricObjectId & object
 int32_t obj_range_register(LibfabricConnection &connection, const LibfabricObjectId & objectId, size_t offset, size_t size, bool write);
 int obj_range_unregister(LibfabricConnection &connection, int32_t id, const LibfabricObjectId & objectId, size_t offset, size_t size, bool write);
 int obj_cow(LibfabricConnection &connection, const LibfabricObjectId & sourceObjectId, const LibfabricObjectId & destObjectId, bool allowExist, size_t offset, size_t size);
+int set_qos(LibfabricConnection &connection, size_t flushBandwidth, size_t missBandwidth);
 
 }
 
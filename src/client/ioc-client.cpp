@@ -37,6 +37,7 @@ struct ioc_client_s
 	sem_t connections_semaphore;
 	std::vector<LibfabricConnection *> connections;
 	bool passive_wait;
+	size_t eager_max;
 };
 typedef ioc_client_s ioc_client_t;
 
@@ -46,6 +47,7 @@ ioc_client_s::ioc_client_s(void)
 	this->domain = NULL;
 	this->tcpClient = NULL;
 	this->passive_wait = true;
+	this->eager_max = IOC_EAGER_MAX_READ;
 }
 
 /****************************************************/
@@ -83,7 +85,7 @@ static LibfabricConnection * ioc_client_get_connection(ioc_client_t * client)
 	}
 
 	//calc receive size
-	size_t recvSize = IOC_POST_RECEIVE_READ;
+	size_t recvSize = IOC_POST_RECEIVE_SIZE(client->eager_max);
 
 	//to have enougth room for error message transmissions
 	if (recvSize < 4096)
@@ -92,6 +94,7 @@ static LibfabricConnection * ioc_client_get_connection(ioc_client_t * client)
 	//setup connection
 	LibfabricConnection * connection = new LibfabricConnection(client->domain, client->passive_wait);
 	connection->setTcpClientInfos(client->clientConnInfo.clientId, client->clientConnInfo.key);
+	connection->setEagerLimits(client->eager_max, client->eager_max);
 	connection->postReceives(recvSize, 2);
 	connection->joinServer();
 	connection->setUsed(true);
@@ -122,7 +125,7 @@ ioc_client_t * ioc_client_init(const char * ip, const char * port)
 	//setup domain
 	client->domain = new LibfabricDomain(ip, port, false);
 	//client->domain->setMsgBuffeSize(sizeof(LibfabricMessage));
-	client->domain->setMsgBufferSize(IOC_POST_RECEIVE_WRITE);
+	client->domain->setMsgBufferSize(IOC_POST_RECEIVE_SIZE(client->eager_max));
 	client->passive_wait = true;
 
 	//init semaphore
@@ -229,6 +232,37 @@ void ioc_client_set_passive_wait(ioc_client_t * client, bool value)
 	client->passive_wait = value;
 }
 
+/****************************************************/
+void ioc_client_set_eager_max(ioc_client_t * client, size_t max_size)
+{
+	//check
+	std::lock_guard<std::mutex> take_lock(client->connections_mutex);
+	assume(client->connections.empty(), "Eager size must be set before the first operation of the client !");
+
+	//setup
+	client->eager_max = max_size;
+	client->domain->setMsgBufferSize(IOC_POST_RECEIVE_SIZE(max_size));
+}
+
+/****************************************************/
+void ioc_client_enable_mr_cache(ioc_client_t * client, size_t max_size)
+{
+	//check
+	std::lock_guard<std::mutex> take_lock(client->connections_mutex);
+	assume(client->connections.empty(), "Memory region cache must be enabled before the first operation of the client !");
+
+	//setup
+	client->domain->enableMrCache(max_size);
+}
+
+/****************************************************/
+void ioc_client_mr_cache_invalidate(ioc_client_t * client, void * ptr, size_t size)
+{
+	MemoryRegionCache * cache = client->domain->getMrCache();
+	if (cache != NULL)
+		cache->invalidate(ptr, size);
+}
+
 /****************************************************/
 int32_t ioc_client_obj_range_register(ioc_client_t * client, int64_t high, int64_t low, size_t offset, size_t size, bool write)
 {
@@ -276,6 +310,15 @@ int ioc_client_obj_cow(ioc_client_t * client, int64_t orig_high, int64_t orig_lo
 	return ret;
 }
 
+/****************************************************/
+int ioc_client_set_qos(ioc_client_t * client, size_t flush_bandwidth, size_t miss_bandwidth)
+{
+	LibfabricConnection * connection = ioc_client_get_connection(client);
+	int ret = set_qos(*connection, flush_bandwidth, miss_bandwidth);
+	ioc_client_ret_connection(client, connection);
+	return ret;
+}
+
 }
 
 #endif //IOC_CLIENT_H
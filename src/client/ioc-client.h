@@ -139,6 +139,44 @@ void ioc_client_set_passive_wait(ioc_client_t * client, bool value);
  * @param size The size of the range to cow. 0 will reset the object and copy the full original object.
 **/
 int ioc_client_obj_cow(ioc_client_t * client, int64_t orig_high, int64_t orig_low, int64_t dest_high, int64_t dest_low, bool allow_exist, size_t offset, size_t size);
+/**
+ * Change at runtime the bandwidth limits of the server to protect the
+ * application I/O from the background operations.
+ * @param client Reference to the client connection handler to use.
+ * @param flush_bandwidth Bandwidth limit of the flush operations in bytes per second, 0 for unlimited.
+ * @param miss_bandwidth Bandwidth limit of the storage reads made on the cache misses in bytes per second, 0 for unlimited.
+ * @return Return 0 on success and negative value on error.
+**/
+int ioc_client_set_qos(ioc_client_t * client, size_t flush_bandwidth, size_t miss_bandwidth);
+/**
+ * Set the max size of the operations sent with the data in the messages
+ * instead of RDMA. The server can lower it when the connections are
+ * established. The receive buffers are sized from it. It has to be called
+ * before the first operation of the client.
+ * @param client Reference to the client connection handler to configure.
+ * @param max_size The max eager size (32 KB by default).
+**/
+void ioc_client_set_eager_max(ioc_client_t * client, size_t max_size);
+/**
+ * Enable the cache of the RDMA registrations of the user buffers so repeated
+ * transfers from the same buffers register them only once. It is disabled by
+ * default as the registrations pin the memory. When enabled, the application
+ * (or ummap-io) must call ioc_client_mr_cache_invalidate() before unmapping
+ * or remapping a buffer used for the transfers. It has to be called before
+ * the first operation of the client.
+ * @param client Reference to the client connection handler to configure.
+ * @param max_size Maximum size of the idle registrations to keep.
+**/
+void ioc_client_enable_mr_cache(ioc_client_t * client, size_t max_size);
+/**
+ * Drop the cached registrations of the given memory range. It has to be
+ * called before unmapping or remapping the memory. Does nothing if the cache
+ * is not enabled.
+ * @param client Reference to the client connection handler to use.
+ * @param ptr Base address of the range.
+ * @param size Size of the range.
+**/
+void ioc_client_mr_cache_invalidate(ioc_client_t * client, void * ptr, size_t size);
 
 /****************************************************/
 #ifdef __cplusplus
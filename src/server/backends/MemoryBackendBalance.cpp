@@ -55,7 +55,9 @@ void MemoryBackendBalance::registerBackend(MemoryBackend * backend)
 /****************************************************/
 /**
  * Allocate a new segment on the less used sub memory backend.
+ * If it is out of memory the other backends are tried.
  * @param size Size of the memory segment to allocate.
+ * @return The address of the memory or NULL if all the backends are out of memory.
 **/
 void * MemoryBackendBalance::allocate(size_t size)
 {
@@ -76,6 +78,21 @@ void * MemoryBackendBalance::allocate(size_t size)
 
 	//send request to this one
 	void * ptr = this->backends[id]->allocate(size);
+
+	//if out of memory, try the others
+	for (size_t i = 0 ; ptr == NULL && i < this->backends.size() ; i++) {
+		if (i != id) {
+			ptr = this->backends[i]->allocate(size);
+			if (ptr != NULL)
+				id = i;
+		}
+	}
+
+	//all out of memory
+	if (ptr == NULL)
+		return NULL;
+
+	//account
 	this->backendMem[id] += size;
 
 	//register
@@ -113,6 +130,19 @@ void MemoryBackendBalance::deallocate(void * addr, size_t size)
 	this->backendMem[id] -= size;
 }
 
+/****************************************************/
+/**
+ * Trim all the sub backends.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackendBalance::trim(void)
+{
+	size_t released = 0;
+	for (auto & it : this->backends)
+		released += it->trim();
+	return released;
+}
+
 /****************************************************/
 /**
  * Return the memory used by the given memory backend.
@@ -35,6 +35,7 @@ class MemoryBackendBalance: public MemoryBackend
 	public:
 		virtual void * allocate(size_t size);
 		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
 	private:
 		/** Keep track of all the sub backends. **/
 		std::vector<MemoryBackend *> backends;
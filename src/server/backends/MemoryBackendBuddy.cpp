@@ -0,0 +1,354 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//internal
+#include "base/common/Debug.hpp"
+#include "MemoryBackendBuddy.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the buddy memory backend.
+ * @param backend Pointer to the sub backend to use to allocate and free
+ * the arenas. It will be deleted by the buddy backend at exit.
+ * @param arenaSize Size of the arenas to request to the sub backend. It
+ * need to be a power of two multiple of IOC_BUDDY_MIN_BLOCK_SIZE.
+ * @param maxCachedSize Maximum amount of free memory to keep in the
+ * cache before returning the free arenas to the sub backend. Use 0 for
+ * no limit.
+**/
+MemoryBackendBuddy::MemoryBackendBuddy(MemoryBackend * backend, size_t arenaSize, size_t maxCachedSize)
+	:MemoryBackend(NULL)
+{
+	//check
+	assert(backend != NULL);
+	assumeArg(arenaSize >= IOC_BUDDY_MIN_BLOCK_SIZE && (arenaSize & (arenaSize - 1)) == 0, "Invalid arena size for buddy allocator, should be a power of two : %1")
+		.arg(arenaSize)
+		.end();
+
+	//setup
+	this->backend = backend;
+	this->arenaSize = arenaSize;
+	this->maxCachedSize = maxCachedSize;
+	this->cachedSize = 0;
+	this->usedSize = 0;
+
+	//compute max order
+	this->maxOrder = 0;
+	while ((IOC_BUDDY_MIN_BLOCK_SIZE << this->maxOrder) < arenaSize)
+		this->maxOrder++;
+
+	//allocate free lists
+	this->freeLists.resize(this->maxOrder + 1);
+}
+
+/****************************************************/
+/**
+ * Destructor of the memory backend, it returns all the arenas to the
+ * sub backend and delete it.
+**/
+MemoryBackendBuddy::~MemoryBackendBuddy(void)
+{
+	//check that all has been returned
+	if (this->usedSize != 0 || this->largeChunks.empty() == false)
+		IOC_WARNING_ARG("Missing elements in buddy allocator, might not have free all: %1 bytes and %2 large chunks")
+			.arg(this->usedSize)
+			.arg(this->largeChunks.size())
+			.end();
+
+	//return arenas
+	for (auto & it : this->arenas)
+		this->backend->deallocate(it, this->arenaSize);
+
+	//return large chunks
+	for (auto & it : this->largeChunks)
+		this->backend->deallocate(it.first, it.second);
+
+	//clear
+	this->arenas.clear();
+	this->largeChunks.clear();
+	this->freeLists.clear();
+
+	//delete backend
+	delete this->backend;
+}
+
+/****************************************************/
+/**
+ * Compute the size of the block which will really be used to serve a
+ * request of the given size.
+ * @param size The requested size.
+**/
+size_t MemoryBackendBuddy::getBlockSize(size_t size)
+{
+	size_t blockSize = IOC_BUDDY_MIN_BLOCK_SIZE;
+	while (blockSize < size)
+		blockSize <<= 1;
+	return blockSize;
+}
+
+/****************************************************/
+/**
+ * Compute the order of the block to be used for the given size.
+ * @param size The requested size (need to be lower than the arena size).
+**/
+int MemoryBackendBuddy::getOrder(size_t size) const
+{
+	//check
+	assert(size <= this->arenaSize);
+
+	//search
+	int order = 0;
+	while ((IOC_BUDDY_MIN_BLOCK_SIZE << order) < size)
+		order++;
+
+	//return
+	return order;
+}
+
+/****************************************************/
+/**
+ * Request a new arena to the sub backend and register it as a free
+ * block of the higher order.
+ * @return False if the sub backend fails to provide the memory.
+**/
+bool MemoryBackendBuddy::newArena(void)
+{
+	//allocate
+	char * arena = (char*)this->backend->allocate(this->arenaSize);
+	if (arena == NULL)
+		return false;
+
+	//register
+	IOC_DEBUG_ARG("buddy", "Allocate new arena %1 of %2").arg(arena).argUnit1024(this->arenaSize).end();
+	this->arenas.insert(arena);
+	this->freeLists[this->maxOrder].insert(arena);
+	this->cachedSize += this->arenaSize;
+
+	//ok
+	return true;
+}
+
+/****************************************************/
+/**
+ * Extract a block of the given order by splitting a bigger block if
+ * needed.
+ * @param order The order of the requested block.
+ * @return The address of the block or NULL if the sub backend is out of
+ * memory.
+**/
+char * MemoryBackendBuddy::allocateBlock(int order)
+{
+	//check
+	assert(order >= 0 && order <= this->maxOrder);
+
+	//search the smaller non empty free list
+	int current = order;
+	while (current <= this->maxOrder && this->freeLists[current].empty())
+		current++;
+
+	//need a new arena
+	if (current > this->maxOrder) {
+		if (this->newArena() == false)
+			return NULL;
+		current = this->maxOrder;
+	}
+
+	//extract
+	auto it = this->freeLists[current].begin();
+	char * block = *it;
+	this->freeLists[current].erase(it);
+
+	//split until reaching the requested order, keeping the upper half
+	while (current > order) {
+		current--;
+		this->freeLists[current].insert(block + (IOC_BUDDY_MIN_BLOCK_SIZE << current));
+	}
+
+	//account
+	this->cachedSize -= IOC_BUDDY_MIN_BLOCK_SIZE << order;
+	this->usedSize += IOC_BUDDY_MIN_BLOCK_SIZE << order;
+
+	//return
+	return block;
+}
+
+/****************************************************/
+/**
+ * Return a block to the free lists by merging it with its buddies
+ * as long as they are free.
+ * @param ptr Address of the block to release.
+ * @param order Order of the block to release.
+**/
+void MemoryBackendBuddy::releaseBlock(char * ptr, int order)
+{
+	//search the arena
+	auto arenaIt = this->arenas.upper_bound(ptr);
+	assumeArg(arenaIt != this->arenas.begin(), "Fail to find the buddy arena of the given memory : %1 !").arg(ptr).end();
+	char * arena = *(--arenaIt);
+	assumeArg(ptr < arena + this->arenaSize, "Fail to find the buddy arena of the given memory : %1 !").arg(ptr).end();
+
+	//account
+	this->cachedSize += IOC_BUDDY_MIN_BLOCK_SIZE << order;
+	this->usedSize -= IOC_BUDDY_MIN_BLOCK_SIZE << order;
+
+	//merge with the buddies
+	size_t offset = ptr - arena;
+	while (order < this->maxOrder) {
+		size_t buddyOffset = offset ^ (IOC_BUDDY_MIN_BLOCK_SIZE << order);
+		if (this->freeLists[order].erase(arena + buddyOffset) == 0)
+			break;
+		if (buddyOffset < offset)
+			offset = buddyOffset;
+		order++;
+	}
+
+	//register
+	this->freeLists[order].insert(arena + offset);
+}
+
+/****************************************************/
+/**
+ * Allocate a block from the cached arenas or request a new arena to
+ * the sub backend.
+ * @param size Size of the desired memory.
+ * @return The address of the memory or NULL if the sub backend fail
+ * to provide it.
+**/
+void * MemoryBackendBuddy::allocate(size_t size)
+{
+	//check
+	assert(size > 0);
+
+	//too large for arenas, forward to sub backend
+	if (size > this->arenaSize) {
+		void * ptr = this->backend->allocateWithTrim(size);
+		if (ptr != NULL)
+			this->largeChunks[ptr] = size;
+		return ptr;
+	}
+
+	//get from arenas
+	char * ptr = this->allocateBlock(this->getOrder(size));
+
+	//if the sub backend is out of memory, make it release its caches and
+	//request a new arena again (we have no free arena to return as
+	//allocateBlock() would have used it)
+	if (ptr == NULL && this->backend->trim() > 0)
+		ptr = this->allocateBlock(this->getOrder(size));
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Return the given memory to the free lists and merge it with the
+ * neighbour free blocks. If the cache exceed the configured limit, the
+ * free arenas are returned to the sub backend.
+ * @param addr Address of the memory to return.
+ * @param size Size of the memory to return.
+**/
+void MemoryBackendBuddy::deallocate(void * addr, size_t size)
+{
+	//check
+	assert(addr != NULL);
+	assert(size > 0);
+
+	//large chunk
+	if (size > this->arenaSize) {
+		auto it = this->largeChunks.find(addr);
+		assumeArg(it != this->largeChunks.end(), "Fail to find the large chunk of the given memory : %1 !").arg(addr).end();
+		assert(it->second == size);
+		this->largeChunks.erase(it);
+		this->backend->deallocate(addr, size);
+		return;
+	}
+
+	//release
+	this->releaseBlock((char*)addr, this->getOrder(size));
+
+	//apply cache limit
+	if (this->maxCachedSize != 0 && this->cachedSize > this->maxCachedSize)
+		this->trim(this->maxCachedSize);
+}
+
+/****************************************************/
+/**
+ * Return all the fully free arenas to the sub backend and trim it.
+ * @return The amount of memory returned.
+**/
+size_t MemoryBackendBuddy::trim(void)
+{
+	size_t released = this->trim(0);
+	return released + this->backend->trim();
+}
+
+/****************************************************/
+/**
+ * Return fully free arenas to the sub backend until the cached memory
+ * goes under the given limit. Notice that partially used arenas cannot
+ * be returned.
+ * @param keep Amount of free memory we want to keep in the cache.
+ * @return The amount of memory returned.
+**/
+size_t MemoryBackendBuddy::trim(size_t keep)
+{
+	//vars
+	size_t released = 0;
+	auto & freeArenas = this->freeLists[this->maxOrder];
+
+	//loop
+	while (this->cachedSize > keep && freeArenas.empty() == false) {
+		//extract
+		auto it = freeArenas.begin();
+		char * arena = *it;
+		freeArenas.erase(it);
+		this->arenas.erase(arena);
+
+		//return
+		IOC_DEBUG_ARG("buddy", "Return arena %1 of %2").arg(arena).argUnit1024(this->arenaSize).end();
+		this->backend->deallocate(arena, this->arenaSize);
+		this->cachedSize -= this->arenaSize;
+		released += this->arenaSize;
+	}
+
+	//return
+	return released;
+}
+
+/****************************************************/
+/**
+ * Return the amount of free memory kept in the cache.
+**/
+size_t MemoryBackendBuddy::getCachedSize(void) const
+{
+	return this->cachedSize;
+}
+
+/****************************************************/
+/**
+ * Return the amount of memory handed to the caller (in blocks, so
+ * rounded to the block sizes) excepted the large chunks.
+**/
+size_t MemoryBackendBuddy::getUsedSize(void) const
+{
+	return this->usedSize;
+}
+
+/****************************************************/
+/**
+ * Return the number of arenas currently obtained from the sub backend.
+**/
+size_t MemoryBackendBuddy::getArenaCount(void) const
+{
+	return this->arenas.size();
+}
@@ -0,0 +1,85 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_BACKEND_BUDDY_HPP
+#define IOC_MEMORY_BACKEND_BUDDY_HPP
+
+/****************************************************/
+//std
+#include <vector>
+#include <set>
+#include <map>
+//internal
+#include "../core/MemoryBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/** Size of the smallest block handled by the buddy allocator. **/
+#define IOC_BUDDY_MIN_BLOCK_SIZE 4096UL
+/** Default size of the arenas requested to the sub backend. **/
+#define IOC_BUDDY_DEFAULT_ARENA_SIZE (256UL*1024UL*1024UL)
+
+/****************************************************/
+/**
+ * Implement a cached memory backend based on a buddy allocator. Compared
+ * to MemoryBackendCache, it request large arenas to the sub backend and
+ * split them in power of two blocks so freed memory can be reused for
+ * requests of another size by splitting and merging the blocks.
+ *
+ * The internal fragmentation is bounded as a request is never rounded to
+ * more than twice its size. Requests larger than the arena are directly
+ * forwarded to the sub backend.
+ *
+ * The amount of free memory kept in the cache can be capped, in this case
+ * the fully free arenas are returned to the sub backend when exceeding the
+ * limit. They can also be returned explicitly by calling trim().
+**/
+class MemoryBackendBuddy: public MemoryBackend
+{
+	public:
+		MemoryBackendBuddy(MemoryBackend * backend, size_t arenaSize = IOC_BUDDY_DEFAULT_ARENA_SIZE, size_t maxCachedSize = 0);
+		virtual ~MemoryBackendBuddy(void);
+	public:
+		virtual void * allocate(size_t size);
+		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
+		size_t trim(size_t keep);
+		size_t getCachedSize(void) const;
+		size_t getUsedSize(void) const;
+		size_t getArenaCount(void) const;
+		static size_t getBlockSize(size_t size);
+	private:
+		int getOrder(size_t size) const;
+		char * allocateBlock(int order);
+		void releaseBlock(char * ptr, int order);
+		bool newArena(void);
+	private:
+		/** Keep track of the underhood memory backend to use. **/
+		MemoryBackend * backend;
+		/** Size of the arenas requested to the sub backend (power of two). **/
+		size_t arenaSize;
+		/** Order of the arena block (arenaSize == IOC_BUDDY_MIN_BLOCK_SIZE << maxOrder). **/
+		int maxOrder;
+		/** Maximum free memory to keep in cache, 0 for no limit. **/
+		size_t maxCachedSize;
+		/** Free blocks for each order. **/
+		std::vector<std::set<char*>> freeLists;
+		/** Base address of the arenas obtained from the sub backend. **/
+		std::set<char*> arenas;
+		/** Allocations larger than the arena size directly forwarded to the sub backend. **/
+		std::map<void*, size_t> largeChunks;
+		/** Memory currently free in the arenas. **/
+		size_t cachedSize;
+		/** Memory currently handed to the caller (rounded to block size). **/
+		size_t usedSize;
+};
+
+}
+
+#endif //IOC_MEMORY_BACKEND_BUDDY_HPP
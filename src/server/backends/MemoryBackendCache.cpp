@@ -76,6 +76,7 @@ MemoryBackendCache::~MemoryBackendCache(void)
  * Check if chunks are available in the cache and return it,
  * if not found allocate new memory to the sub backend.
  * @param size Size of the desired memory.
+ * @return The address of the memory or NULL if the sub backend is out of memory.
 **/
 void * MemoryBackendCache::allocate(size_t size)
 {
@@ -88,8 +89,14 @@ void * MemoryBackendCache::allocate(size_t size)
 	//check if empty
 	void * ptr = NULL;
 	if (freeList.empty()) {
-		//get from backend
+		//get from backend, trim the other size classes if out of memory
 		ptr = this->backend->allocate(size);
+		if (ptr == NULL && this->trim() > 0)
+			ptr = this->backend->allocate(size);
+
+		//out of memory
+		if (ptr == NULL)
+			return NULL;
 
 		//register to range tracker
 		this->rangesTracker[ptr] = size;
@@ -124,6 +131,29 @@ void MemoryBackendCache::deallocate(void * addr, size_t size)
 	this->freeLists[size].push_front(addr);
 }
 
+/****************************************************/
+/**
+ * Return all the cached chunks to the sub backend so they can be
+ * reused for other sizes, then trim the sub backend.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackendCache::trim(void)
+{
+	//return all the free chunks
+	size_t released = 0;
+	for (auto & list : this->freeLists) {
+		for (auto & it : list.second) {
+			this->rangesTracker.erase(it);
+			this->backend->deallocate(it, list.first);
+			released += list.first;
+		}
+	}
+	this->freeLists.clear();
+
+	//trim sub
+	return released + this->backend->trim();
+}
+
 /****************************************************/
 /**
  * For debugging check if the given pointer belongs to the cache.
@@ -33,6 +33,7 @@ class MemoryBackendCache: public MemoryBackend
 	public:
 		virtual void * allocate(size_t size);
 		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
 	private:
 		bool isLocalMemory(void * ptr, size_t size);
 	private:
@@ -0,0 +1,356 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <cstring>
+//internal
+#include "base/common/Debug.hpp"
+#include "MemoryBackendConcurrentCache.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/** Number of bits used for the address in the tagged pointers. **/
+#define IOC_TAGGED_PTR_BITS 48
+/** Mask to extract the address of a tagged pointer. **/
+#define IOC_TAGGED_PTR_MASK ((1UL << IOC_TAGGED_PTR_BITS) - 1)
+
+/****************************************************/
+std::atomic<uint64_t> MemoryBackendConcurrentCache::nextInstanceId(1);
+
+/****************************************************/
+/**
+ * Last thread cache used by the current thread to avoid searching in the
+ * map on each call.
+**/
+static thread_local uint64_t gblLastInstanceId = 0;
+static thread_local MemoryBackendThreadCache * gblLastThreadCache = NULL;
+
+/****************************************************/
+/**
+ * Build a tagged pointer from an address and a tag.
+ * @param ptr The address to store.
+ * @param tag The tag to attach (incremented on each update).
+**/
+static inline uint64_t packTaggedPtr(void * ptr, uint64_t tag)
+{
+	assert(((uint64_t)ptr & ~IOC_TAGGED_PTR_MASK) == 0);
+	return ((uint64_t)ptr) | (tag << IOC_TAGGED_PTR_BITS);
+}
+
+/****************************************************/
+/**
+ * Extract the address from a tagged pointer.
+**/
+static inline void * getTaggedPtrAddr(uint64_t value)
+{
+	return (void*)(value & IOC_TAGGED_PTR_MASK);
+}
+
+/****************************************************/
+/**
+ * Extract the tag of a tagged pointer.
+**/
+static inline uint64_t getTaggedPtrTag(uint64_t value)
+{
+	return value >> IOC_TAGGED_PTR_BITS;
+}
+
+/****************************************************/
+/**
+ * Constructor of the thread cache, it init all magazines empty.
+**/
+MemoryBackendThreadCache::MemoryBackendThreadCache(void)
+{
+	memset(this->magazines, 0, sizeof(this->magazines));
+}
+
+/****************************************************/
+/**
+ * Constructor of the concurrent cached memory backend.
+ * @param backend Pointer to the sub backend to use to allocate and free
+ * memory. It will be deleted by the cache at exit.
+**/
+MemoryBackendConcurrentCache::MemoryBackendConcurrentCache(MemoryBackend * backend)
+	:MemoryBackend(NULL)
+{
+	//check
+	assert(backend != NULL);
+
+	//setup
+	this->backend = backend;
+	this->instanceId = nextInstanceId++;
+
+	//init classes
+	for (int i = 0 ; i < IOC_CONCURRENT_CACHE_CLASSES ; i++) {
+		this->classSizes[i] = 0;
+		this->freeLists[i] = 0;
+	}
+}
+
+/****************************************************/
+/**
+ * Destructor of the memory backend, it frees all the allocated memory.
+ * It must be called when no more thread use the cache.
+**/
+MemoryBackendConcurrentCache::~MemoryBackendConcurrentCache(void)
+{
+	//count the chunks in the magazines
+	size_t cnt = 0;
+	for (auto & threadCache : this->threadCaches)
+		for (int i = 0 ; i < IOC_CONCURRENT_CACHE_CLASSES ; i++)
+			cnt += threadCache->magazines[i].count;
+
+	//count the chunks in the global lists
+	for (int i = 0 ; i < IOC_CONCURRENT_CACHE_CLASSES ; i++)
+		for (void * it = getTaggedPtrAddr(this->freeLists[i]) ; it != NULL ; it = *(void**)it)
+			cnt++;
+
+	//check that all has been returned
+	if (cnt != this->rangesTracker.size())
+		IOC_WARNING_ARG("Missing elements in free list, might not have free all: %1 != %2")
+			.arg(cnt)
+			.arg(this->rangesTracker.size())
+			.end();
+
+	//remove ranges
+	for (auto & it : this->rangesTracker)
+		this->backend->deallocate(it.first, it.second);
+	this->rangesTracker.clear();
+
+	//free thread caches
+	for (auto & it : this->threadCaches)
+		delete it;
+	this->threadCaches.clear();
+
+	//delete backend
+	delete this->backend;
+}
+
+/****************************************************/
+/**
+ * Get the size class to be used for the given size. It assign a new class
+ * if this is the first time we see this size.
+ * @param size The size of the chunk.
+ * @return The size class or -1 if all the classes are already in use by
+ * other sizes.
+**/
+int MemoryBackendConcurrentCache::getClass(size_t size)
+{
+	//hash
+	int start = (size / 4096) % IOC_CONCURRENT_CACHE_CLASSES;
+
+	//open addressing search
+	for (int i = 0 ; i < IOC_CONCURRENT_CACHE_CLASSES ; i++) {
+		int id = (start + i) % IOC_CONCURRENT_CACHE_CLASSES;
+		size_t current = this->classSizes[id].load(std::memory_order_acquire);
+		if (current == size)
+			return id;
+		if (current == 0) {
+			size_t expected = 0;
+			if (this->classSizes[id].compare_exchange_strong(expected, size) || expected == size)
+				return id;
+		}
+	}
+
+	//not found
+	return -1;
+}
+
+/****************************************************/
+/**
+ * Return the magazines of the current thread for this cache. It creates
+ * them on first call.
+**/
+MemoryBackendThreadCache * MemoryBackendConcurrentCache::getThreadCache(void)
+{
+	//fast path
+	if (gblLastInstanceId == this->instanceId)
+		return gblLastThreadCache;
+
+	//search in the thread local map
+	static thread_local std::map<uint64_t, MemoryBackendThreadCache *> threadCacheMap;
+	MemoryBackendThreadCache * threadCache = NULL;
+	auto it = threadCacheMap.find(this->instanceId);
+	if (it != threadCacheMap.end()) {
+		threadCache = it->second;
+	} else {
+		threadCache = new MemoryBackendThreadCache;
+		threadCacheMap[this->instanceId] = threadCache;
+		std::lock_guard<std::mutex> lockGuard(this->threadCachesMutex);
+		this->threadCaches.push_back(threadCache);
+	}
+
+	//remember
+	gblLastInstanceId = this->instanceId;
+	gblLastThreadCache = threadCache;
+
+	//return
+	return threadCache;
+}
+
+/****************************************************/
+/**
+ * Push a chunk in the global lock-free list of the given class.
+ * @param sizeClass The size class of the chunk.
+ * @param ptr Address of the chunk.
+**/
+void MemoryBackendConcurrentCache::push(int sizeClass, void * ptr)
+{
+	//vars
+	std::atomic<uint64_t> & head = this->freeLists[sizeClass];
+	uint64_t current = head.load(std::memory_order_relaxed);
+	uint64_t next;
+
+	//loop until we succeed
+	do {
+		__atomic_store_n((void**)ptr, getTaggedPtrAddr(current), __ATOMIC_RELAXED);
+		next = packTaggedPtr(ptr, getTaggedPtrTag(current) + 1);
+	} while (head.compare_exchange_weak(current, next, std::memory_order_release, std::memory_order_relaxed) == false);
+}
+
+/****************************************************/
+/**
+ * Pop a chunk from the global lock-free list of the given class.
+ * @param sizeClass The size class of the chunk.
+ * @return Address of the chunk or NULL if the list is empty.
+**/
+void * MemoryBackendConcurrentCache::pop(int sizeClass)
+{
+	//vars
+	std::atomic<uint64_t> & head = this->freeLists[sizeClass];
+	uint64_t current = head.load(std::memory_order_acquire);
+	uint64_t next;
+	void * ptr;
+
+	//loop until we succeed, notice the chunks are never returned to the
+	//sub backend before destruction so reading the next field of a chunk
+	//taken in the mean time by another thread is safe, the tag will make
+	//the CAS failing.
+	do {
+		ptr = getTaggedPtrAddr(current);
+		if (ptr == NULL)
+			return NULL;
+		void * nextPtr = __atomic_load_n((void**)ptr, __ATOMIC_RELAXED);
+		next = packTaggedPtr(nextPtr, getTaggedPtrTag(current) + 1);
+	} while (head.compare_exchange_weak(current, next, std::memory_order_acquire, std::memory_order_acquire) == false);
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Allocate a new chunk from the sub backend.
+ * @param size Size of the chunk.
+**/
+void * MemoryBackendConcurrentCache::allocateFromBackend(size_t size)
+{
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->backendMutex);
+
+	//allocate
+	void * ptr = this->backend->allocate(size);
+
+	//register to range tracker
+	if (ptr != NULL)
+		this->rangesTracker[ptr] = size;
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Return a chunk to the sub backend (used for the sizes which cannot be
+ * assigned a size class).
+ * @param addr Address of the chunk.
+ * @param size Size of the chunk.
+**/
+void MemoryBackendConcurrentCache::deallocateToBackend(void * addr, size_t size)
+{
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->backendMutex);
+
+	//check
+	auto it = this->rangesTracker.find(addr);
+	assumeArg(it != this->rangesTracker.end(), "Fail to find the given memory in cache : %1 !").arg(addr).end();
+	assert(it->second == size);
+
+	//free
+	this->rangesTracker.erase(it);
+	this->backend->deallocate(addr, size);
+}
+
+/****************************************************/
+/**
+ * Take a chunk from the thread magazine, the global list or the sub
+ * backend in this order.
+ * @param size Size of the desired memory.
+**/
+void * MemoryBackendConcurrentCache::allocate(size_t size)
+{
+	//check
+	assert(size >= sizeof(void*));
+
+	//get class
+	int sizeClass = this->getClass(size);
+	if (sizeClass < 0)
+		return this->allocateFromBackend(size);
+
+	//try from magazine
+	MemoryBackendMagazine & magazine = this->getThreadCache()->magazines[sizeClass];
+	if (magazine.count > 0)
+		return magazine.entries[--magazine.count];
+
+	//try from global list and refill half the magazine
+	void * ptr = this->pop(sizeClass);
+	if (ptr != NULL) {
+		while (magazine.count < IOC_CONCURRENT_CACHE_MAGAZINE / 2) {
+			void * extra = this->pop(sizeClass);
+			if (extra == NULL)
+				break;
+			magazine.entries[magazine.count++] = extra;
+		}
+		return ptr;
+	}
+
+	//get from backend
+	return this->allocateFromBackend(size);
+}
+
+/****************************************************/
+/**
+ * Return the given chunk to the thread magazine. If full, half of it
+ * is moved to the global list.
+ * @param addr Address of the memory to return.
+ * @param size Size of the memory to return.
+**/
+void MemoryBackendConcurrentCache::deallocate(void * addr, size_t size)
+{
+	//check
+	assert(addr != NULL);
+	assert(size >= sizeof(void*));
+
+	//get class
+	int sizeClass = this->getClass(size);
+	if (sizeClass < 0) {
+		this->deallocateToBackend(addr, size);
+		return;
+	}
+
+	//drain half the magazine if full
+	MemoryBackendMagazine & magazine = this->getThreadCache()->magazines[sizeClass];
+	if (magazine.count == IOC_CONCURRENT_CACHE_MAGAZINE)
+		while (magazine.count > IOC_CONCURRENT_CACHE_MAGAZINE / 2)
+			this->push(sizeClass, magazine.entries[--magazine.count]);
+
+	//push
+	magazine.entries[magazine.count++] = addr;
+}
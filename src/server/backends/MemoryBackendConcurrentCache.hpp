@@ -0,0 +1,107 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_BACKEND_CONCURRENT_CACHE_HPP
+#define IOC_MEMORY_BACKEND_CONCURRENT_CACHE_HPP
+
+/****************************************************/
+//std
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <cstdint>
+//internal
+#include "../core/MemoryBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/** Maximum number of different sizes handled by the cache. **/
+#define IOC_CONCURRENT_CACHE_CLASSES 64
+/** Number of chunks kept in each per thread magazine. **/
+#define IOC_CONCURRENT_CACHE_MAGAZINE 16
+
+/****************************************************/
+/**
+ * Per thread magazine keeping a few chunks of one size class so most
+ * of the allocations and deallocations do not touch any shared state.
+**/
+struct MemoryBackendMagazine
+{
+	/** Number of chunks in the magazine. **/
+	size_t count;
+	/** Chunks currently in the magazine. **/
+	void * entries[IOC_CONCURRENT_CACHE_MAGAZINE];
+};
+
+/****************************************************/
+/**
+ * Magazines of one thread for all the size classes.
+**/
+struct MemoryBackendThreadCache
+{
+	MemoryBackendThreadCache(void);
+	/** One magazine per size class. **/
+	MemoryBackendMagazine magazines[IOC_CONCURRENT_CACHE_CLASSES];
+};
+
+/****************************************************/
+/**
+ * Thread safe version of MemoryBackendCache. Like it, it keeps the freed
+ * chunks per exact size to reuse them but it can be called from several
+ * threads at the same time.
+ *
+ * Each thread first uses its own magazines, when empty or full they are
+ * refilled or drained from/to global lock-free lists (one per size class).
+ * Only the allocations reaching the sub backend take a lock as the sub
+ * backends are not thread safe.
+ *
+ * The global lists are intrusive, the address of the next free chunk is
+ * stored in the first bytes of the free chunk. They use a tagged pointer
+ * to avoid the ABA problem.
+**/
+class MemoryBackendConcurrentCache: public MemoryBackend
+{
+	public:
+		MemoryBackendConcurrentCache(MemoryBackend * backend);
+		virtual ~MemoryBackendConcurrentCache(void);
+	public:
+		virtual void * allocate(size_t size);
+		virtual void deallocate(void * addr, size_t size);
+	private:
+		int getClass(size_t size);
+		MemoryBackendThreadCache * getThreadCache(void);
+		void push(int sizeClass, void * ptr);
+		void * pop(int sizeClass);
+		void * allocateFromBackend(size_t size);
+		void deallocateToBackend(void * addr, size_t size);
+	private:
+		/** Keep track of the underhood memory backend to use. **/
+		MemoryBackend * backend;
+		/** Unique ID of the instance used to find the thread caches. **/
+		uint64_t instanceId;
+		/** Size attached to each class, 0 if not yet used. **/
+		std::atomic<size_t> classSizes[IOC_CONCURRENT_CACHE_CLASSES];
+		/** Head of the global free list of each class as a tagged pointer. **/
+		std::atomic<uint64_t> freeLists[IOC_CONCURRENT_CACHE_CLASSES];
+		/** Protect the sub backend and the tracking of the ranges. **/
+		std::mutex backendMutex;
+		/** Register the ranges allocated from the sub backend. **/
+		std::map<void*, size_t> rangesTracker;
+		/** Protect the list of thread caches. **/
+		std::mutex threadCachesMutex;
+		/** Keep track of the thread caches to free them at exit. **/
+		std::vector<MemoryBackendThreadCache *> threadCaches;
+		/** Used to assign the instance IDs. **/
+		static std::atomic<uint64_t> nextInstanceId;
+};
+
+}
+
+#endif //IOC_MEMORY_BACKEND_CONCURRENT_CACHE_HPP
@@ -7,6 +7,7 @@
 /****************************************************/
 //std
 #include <cassert>
+#include <cstdlib>
 //internal
 #include "base/common/Debug.hpp"
 #include "MemoryBackendMalloc.hpp"
@@ -16,18 +17,24 @@ using namespace IOC;
 
 /****************************************************/
 /**
- * Allocate new memory chunk using malloc and register it to the
+ * Allocate new memory chunk using posix_memalign and register it to the
  * libfabric domain for RDMA operations.
  * @param size Size of the memory to allocate.
+ * @return The address of the memory or NULL if out of memory.
 **/
 void * MemoryBackendMalloc::allocate(size_t size)
 {
 	//check
 	assert(size > 0);
 
-	//allocate
-	void * ptr = malloc(size);
-	assume(ptr != NULL, "Fail to allocate memory, might get out of memory !");
+	//allocate, page aligned so the storage can use direct IO on it
+	void * ptr = NULL;
+	if (posix_memalign(&ptr, 4096, size) != 0)
+		ptr = NULL;
+	if (ptr == NULL) {
+		IOC_DEBUG_ARG("memory", "Fail to allocate %1 with posix_memalign, out of memory").argUnit1024(size).end();
+		return NULL;
+	}
 
 	//register
 	if (this->lfDomain != NULL)
@@ -52,6 +52,7 @@ MemoryBackendNvdimm::MemoryBackendNvdimm(LibfabricDomain * lfDomain, const std::
 	this->fileSize = 0;
 	this->chunks = 0;
 	this->fileOffset = 0;
+	this->populate = false;
 }
 
 /****************************************************/
@@ -130,6 +131,7 @@ void MemoryBackendNvdimm::openNewFile(size_t size)
  * Allocate a new memory chunk by growing the size of the mapped file via
  * ftruncate().
  * @param size Size of the requested memory space to allocate.
+ * @return The address of the memory or NULL if the mapping failed.
 **/
 void * MemoryBackendNvdimm::allocate(size_t size)
 {
@@ -147,8 +149,15 @@ void * MemoryBackendNvdimm::allocate(size_t size)
 	assert(this->fileOffset <= this->fileSize);
 	
 	//memory map
-	void * ptr = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_FILE|MAP_SHARED, this->fileFD, offset);
-	assumeArg(ptr != MAP_FAILED, "Failed to memory map the nvdimm file new range : %1").argStrErrno().end();
+	int flags = MAP_FILE|MAP_SHARED;
+	if (this->populate)
+		flags |= MAP_POPULATE;
+	void * ptr = mmap(NULL, size, PROT_READ|PROT_WRITE, flags, this->fileFD, offset);
+	if (ptr == MAP_FAILED) {
+		IOC_WARNING_ARG("Failed to memory map the nvdimm file new range : %1").argStrErrno().end();
+		this->fileOffset -= size;
+		return NULL;
+	}
 
 	//register for RDMA
 	if (this->lfDomain != NULL)
@@ -204,3 +213,15 @@ size_t MemoryBackendNvdimm::getChunks(void) const
 {
 	return this->chunks;
 }
+
+/****************************************************/
+/**
+ * Enable or disable the usage of MAP_POPULATE when mapping the new
+ * chunks so the page faults are made at allocation time instead of
+ * first access.
+ * @param populate Enable or disable.
+**/
+void MemoryBackendNvdimm::setPopulate(bool populate)
+{
+	this->populate = populate;
+}
@@ -32,6 +32,7 @@ class MemoryBackendNvdimm: public MemoryBackend
 		virtual ~MemoryBackendNvdimm(void);
 		size_t getFileSize(void) const;
 		size_t getChunks(void) const;
+		void setPopulate(bool populate);
 	public:
 		virtual void * allocate(size_t size);
 		virtual void deallocate(void * addr, size_t size);
@@ -48,6 +49,8 @@ class MemoryBackendNvdimm: public MemoryBackend
 		size_t chunks;
 		/** Keep track of the current offset in current file. **/
 		size_t fileOffset;
+		/** Map the chunks with MAP_POPULATE to prefault them. **/
+		bool populate;
 };
 
 }
@@ -0,0 +1,297 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//unix
+#include <sys/mman.h>
+//internal
+#include "base/common/Debug.hpp"
+#include "MemoryBackendPrefault.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the prefaulted pool memory backend. It starts the
+ * background thread which immediately start to fill the pool.
+ * @param backend Pointer to the sub backend to use to allocate and free
+ * memory. It will be deleted by the pool at exit.
+ * @param chunkSize Size of the chunks to keep in the pool.
+ * @param poolChunks Number of chunks to keep in the pool.
+**/
+MemoryBackendPrefault::MemoryBackendPrefault(MemoryBackend * backend, size_t chunkSize, size_t poolChunks)
+	:MemoryBackend(NULL)
+{
+	//check
+	assert(backend != NULL);
+	assert(chunkSize > 0);
+	assert(poolChunks > 0);
+
+	//setup
+	this->backend = backend;
+	this->chunkSize = chunkSize;
+	this->poolChunks = poolChunks;
+	this->stopRefill = false;
+	this->refillIdle = false;
+	this->outOfMemory = false;
+
+	//start the refill thread
+	this->refillThread = std::thread([this](){
+		this->refillThreadMain();
+	});
+}
+
+/****************************************************/
+/**
+ * Destructor of the memory backend, it stops the refill thread and
+ * return the pooled chunks to the sub backend.
+**/
+MemoryBackendPrefault::~MemoryBackendPrefault(void)
+{
+	//stop the thread
+	{
+		std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+		this->stopRefill = true;
+		this->refillCond.notify_all();
+	}
+	this->refillThread.join();
+
+	//return the pool
+	for (auto & it : this->pool)
+		this->backend->deallocate(it, this->chunkSize);
+	this->pool.clear();
+
+	//delete backend
+	delete this->backend;
+}
+
+/****************************************************/
+/**
+ * Touch all the pages of the given memory range so the page faults
+ * are made now and not on first access.
+ * @param addr Address of the memory range.
+ * @param size Size of the memory range.
+**/
+void MemoryBackendPrefault::prefault(void * addr, size_t size)
+{
+	//ask to the kernel if supported (and if page aligned)
+	#ifdef MADV_POPULATE_WRITE
+		if (madvise(addr, size, MADV_POPULATE_WRITE) == 0)
+			return;
+	#endif
+
+	//touch every page without changing the content (nvdimm files keep
+	//their data)
+	for (size_t offset = 0 ; offset < size ; offset += 4096) {
+		volatile char * ptr = (char*)addr + offset;
+		*ptr = *ptr;
+	}
+}
+
+/****************************************************/
+/**
+ * Main function of the refill thread. It fills the pool up to the
+ * requested size then sleeps until it goes under half its size. On out of
+ * memory it also sleeps until some memory is returned to the sub backend.
+**/
+void MemoryBackendPrefault::refillThreadMain(void)
+{
+	//lock
+	std::unique_lock<std::mutex> lock(this->poolMutex);
+
+	//warn only once until a refill succeeds again
+	bool warned = false;
+
+	//loop until exit
+	while (this->stopRefill == false) {
+		//fill
+		while (this->stopRefill == false && this->pool.size() < this->poolChunks) {
+			//allocate & prefault out of the lock
+			lock.unlock();
+			void * ptr = this->backendAllocate(this->chunkSize);
+			if (ptr != NULL)
+				prefault(ptr, this->chunkSize);
+			lock.lock();
+
+			//out of memory, wait some memory to be returned
+			if (ptr == NULL) {
+				if (warned == false)
+					IOC_WARNING("Fail to refill the prefaulted memory pool, out of memory !");
+				warned = true;
+				this->outOfMemory = true;
+				break;
+			}
+
+			//push
+			warned = false;
+			this->pool.push_back(ptr);
+		}
+
+		//notify waiters
+		this->refillIdle = true;
+		this->filledCond.notify_all();
+
+		//wait until need to refill
+		this->refillCond.wait(lock, [this]{
+			return this->stopRefill || (this->outOfMemory == false && this->pool.size() <= this->poolChunks / 2);
+		});
+	}
+}
+
+/****************************************************/
+/**
+ * Wake up the refill thread after an out of memory as some memory has been
+ * returned to the sub backend.
+**/
+void MemoryBackendPrefault::retryRefill(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+	if (this->outOfMemory) {
+		this->outOfMemory = false;
+		this->refillIdle = false;
+		this->refillCond.notify_one();
+	}
+}
+
+/****************************************************/
+/**
+ * Allocate from the sub backend under the lock.
+ * @param size Size of the memory to allocate.
+**/
+void * MemoryBackendPrefault::backendAllocate(size_t size)
+{
+	std::lock_guard<std::mutex> lockGuard(this->backendMutex);
+	return this->backend->allocate(size);
+}
+
+/****************************************************/
+/**
+ * Return memory to the sub backend under the lock.
+ * @param addr Address of the memory to return.
+ * @param size Size of the memory to return.
+**/
+void MemoryBackendPrefault::backendDeallocate(void * addr, size_t size)
+{
+	std::lock_guard<std::mutex> lockGuard(this->backendMutex);
+	this->backend->deallocate(addr, size);
+}
+
+/****************************************************/
+/**
+ * Take a warm chunk from the pool if the size match, otherwise fallback
+ * on the sub backend.
+ * @param size Size of the desired memory.
+**/
+void * MemoryBackendPrefault::allocate(size_t size)
+{
+	//check
+	assert(size > 0);
+
+	//try from pool
+	if (size == this->chunkSize) {
+		std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+		if (this->pool.empty() == false) {
+			void * ptr = this->pool.back();
+			this->pool.pop_back();
+			if (this->pool.size() <= this->poolChunks / 2) {
+				this->refillIdle = false;
+				this->refillCond.notify_one();
+			}
+			return ptr;
+		} else {
+			IOC_DEBUG("prefault", "Prefaulted pool empty, fallback on sub backend");
+			this->refillIdle = false;
+			this->refillCond.notify_one();
+		}
+	}
+
+	//fallback
+	return this->backendAllocate(size);
+}
+
+/****************************************************/
+/**
+ * Return the chunk to the pool if not full (it is still warm), otherwise
+ * to the sub backend.
+ * @param addr Address of the memory to return.
+ * @param size Size of the memory to return.
+**/
+void MemoryBackendPrefault::deallocate(void * addr, size_t size)
+{
+	//check
+	assert(addr != NULL);
+	assert(size > 0);
+
+	//try to keep in pool
+	if (size == this->chunkSize) {
+		std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+		if (this->pool.size() < this->poolChunks) {
+			this->pool.push_back(addr);
+			return;
+		}
+	}
+
+	//fallback
+	this->backendDeallocate(addr, size);
+
+	//the refill can try again
+	this->retryRefill();
+}
+
+/****************************************************/
+/**
+ * Return the pooled chunks to the sub backend and trim it. The pool
+ * will be refilled on the next allocations.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackendPrefault::trim(void)
+{
+	//extract pool
+	std::vector<void*> chunks;
+	{
+		std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+		chunks.swap(this->pool);
+	}
+
+	//return
+	size_t released = chunks.size() * this->chunkSize;
+	{
+		std::lock_guard<std::mutex> lockGuard(this->backendMutex);
+		for (auto & it : chunks)
+			this->backend->deallocate(it, this->chunkSize);
+		released += this->backend->trim();
+	}
+
+	//the refill can try again
+	this->retryRefill();
+	return released;
+}
+
+/****************************************************/
+/**
+ * Return the number of chunks currently in the pool.
+**/
+size_t MemoryBackendPrefault::getPoolSize(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->poolMutex);
+	return this->pool.size();
+}
+
+/****************************************************/
+/**
+ * Wait until the refill thread has finished to fill the pool. Used at
+ * startup and in unit tests.
+**/
+void MemoryBackendPrefault::waitPoolFull(void)
+{
+	std::unique_lock<std::mutex> lock(this->poolMutex);
+	this->filledCond.wait(lock, [this]{
+		return this->refillIdle || this->stopRefill;
+	});
+}
@@ -0,0 +1,85 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_BACKEND_PREFAULT_HPP
+#define IOC_MEMORY_BACKEND_PREFAULT_HPP
+
+/****************************************************/
+//std
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+//internal
+#include "../core/MemoryBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Implement a memory backend keeping a pool of warm chunks of a given size
+ * (the segment size of the server). The chunks are allocated (so registered
+ * for RDMA by the sub backend) and prefaulted by a background thread so
+ * the requests do not pay the page faults nor the memory registration.
+ *
+ * When the pool goes under half its size, the background thread is woken
+ * up to refill it. Requests of other sizes, or made when the pool is empty,
+ * are forwarded to the sub backend. If the sub backend is out of memory, the
+ * refill waits for some memory to be returned to it (deallocate() or trim())
+ * before trying again.
+ *
+ * The sub backend is only accessed under a mutex so it does not need to
+ * be thread safe.
+**/
+class MemoryBackendPrefault: public MemoryBackend
+{
+	public:
+		MemoryBackendPrefault(MemoryBackend * backend, size_t chunkSize, size_t poolChunks);
+		virtual ~MemoryBackendPrefault(void);
+	public:
+		virtual void * allocate(size_t size);
+		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
+		size_t getPoolSize(void);
+		void waitPoolFull(void);
+		static void prefault(void * addr, size_t size);
+	private:
+		void refillThreadMain(void);
+		void retryRefill(void);
+		void * backendAllocate(size_t size);
+		void backendDeallocate(void * addr, size_t size);
+	private:
+		/** Keep track of the underhood memory backend to use. **/
+		MemoryBackend * backend;
+		/** Size of the chunks kept in the pool. **/
+		size_t chunkSize;
+		/** Number of chunks we want to keep in the pool. **/
+		size_t poolChunks;
+		/** The warm chunks ready to be used. **/
+		std::vector<void*> pool;
+		/** Protect the pool. **/
+		std::mutex poolMutex;
+		/** Protect the access to the sub backend. **/
+		std::mutex backendMutex;
+		/** Used to wake up the refill thread. **/
+		std::condition_variable refillCond;
+		/** Used to notify waiters when the pool has been refilled. **/
+		std::condition_variable filledCond;
+		/** Thread refilling the pool in background. **/
+		std::thread refillThread;
+		/** Tell the refill thread to exit. **/
+		bool stopRefill;
+		/** True when the refill thread is waiting to be woken up. **/
+		bool refillIdle;
+		/** The last refill failed, do not try again before some memory is returned to the sub backend. **/
+		bool outOfMemory;
+};
+
+}
+
+#endif //IOC_MEMORY_BACKEND_PREFAULT_HPP
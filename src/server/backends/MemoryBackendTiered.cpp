@@ -0,0 +1,295 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <cstring>
+#include <set>
+#include <algorithm>
+//internal
+#include "base/common/Debug.hpp"
+#include "MemoryBackendTiered.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the tiered memory backend.
+ * @param fastBackend The backend to be used for the hot segments (DRAM).
+ * @param slowBackend The backend to be used for the cold segments (NVDIMM).
+ * @param fastCapacity Maximum memory to place on the fast backend.
+ * @param hotThreshold Minimal number of access since the last call to
+ * rebalance() to consider a segment as hot.
+ * Both backends will be deleted by the tiered backend at exit.
+**/
+MemoryBackendTiered::MemoryBackendTiered(MemoryBackend * fastBackend, MemoryBackend * slowBackend, size_t fastCapacity, size_t hotThreshold)
+	:MemoryBackend(NULL)
+{
+	//check
+	assert(fastBackend != NULL);
+	assert(slowBackend != NULL);
+
+	//setup
+	this->fastBackend = fastBackend;
+	this->slowBackend = slowBackend;
+	this->fastCapacity = fastCapacity;
+	this->hotThreshold = hotThreshold;
+	this->fastUsed = 0;
+	this->slowUsed = 0;
+}
+
+/****************************************************/
+/**
+ * Destroy the sub backends after checking that all the memory has
+ * been freed.
+**/
+MemoryBackendTiered::~MemoryBackendTiered(void)
+{
+	//warn if not all freed
+	if (this->tierOfMem.empty() == false)
+		IOC_WARNING_ARG("Delete tiered backend but it still has memory : %1 !").arg(this->tierOfMem.size()).end();
+
+	//delete
+	delete this->fastBackend;
+	delete this->slowBackend;
+}
+
+/****************************************************/
+/**
+ * Allocate on the given tier and register the address.
+ * @param size Size of the memory to allocate.
+ * @param tier The tier to use.
+ * @return The address of the memory or NULL if the tier failed.
+**/
+void * MemoryBackendTiered::allocateOnTier(size_t size, MemoryTier tier)
+{
+	//allocate
+	void * ptr = NULL;
+	if (tier == MEMORY_TIER_FAST)
+		ptr = this->fastBackend->allocate(size);
+	else
+		ptr = this->slowBackend->allocate(size);
+
+	//failed
+	if (ptr == NULL)
+		return NULL;
+
+	//register
+	this->tierOfMem[ptr] = tier;
+	if (tier == MEMORY_TIER_FAST)
+		this->fastUsed += size;
+	else
+		this->slowUsed += size;
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Allocate a new segment in the fast tier if it has room, in the slow
+ * tier otherwise.
+ * @param size Size of the memory to allocate.
+**/
+void * MemoryBackendTiered::allocate(size_t size)
+{
+	//check
+	assert(size > 0);
+
+	//try fast
+	void * ptr = NULL;
+	if (this->fastUsed + size <= this->fastCapacity)
+		ptr = this->allocateOnTier(size, MEMORY_TIER_FAST);
+
+	//fallback on slow
+	if (ptr == NULL)
+		ptr = this->allocateOnTier(size, MEMORY_TIER_SLOW);
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Return the memory to the tier it has been allocated on.
+ * @param addr Address of the memory space to free.
+ * @param size Size of the memory space to free.
+**/
+void MemoryBackendTiered::deallocate(void * addr, size_t size)
+{
+	//check
+	assert(addr != NULL);
+	assert(size > 0);
+
+	//search
+	auto it = this->tierOfMem.find(addr);
+	assumeArg(it != this->tierOfMem.end(), "Fail to find the tier of the given memory : %1 !").arg(addr).end();
+
+	//free
+	if (it->second == MEMORY_TIER_FAST) {
+		assert(this->fastUsed >= size);
+		this->fastUsed -= size;
+		this->fastBackend->deallocate(addr, size);
+	} else {
+		assert(this->slowUsed >= size);
+		this->slowUsed -= size;
+		this->slowBackend->deallocate(addr, size);
+	}
+
+	//unregister
+	this->tierOfMem.erase(it);
+}
+
+/****************************************************/
+/**
+ * Trim the two tiers.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackendTiered::trim(void)
+{
+	return this->fastBackend->trim() + this->slowBackend->trim();
+}
+
+/****************************************************/
+/**
+ * Move the content of a segment to the given tier.
+ * @param memory The segment memory to move.
+ * @param tier The destination tier.
+ * @return False if the destination tier fail to provide the memory.
+**/
+bool MemoryBackendTiered::migrate(ObjectSegmentMemory & memory, MemoryTier tier)
+{
+	//vars
+	size_t size = memory.getSize();
+	char * oldBuffer = memory.getBuffer();
+
+	//allocate
+	char * newBuffer = (char*)this->allocateOnTier(size, tier);
+	if (newBuffer == NULL)
+		return false;
+
+	//copy & replace
+	memcpy(newBuffer, oldBuffer, size);
+	memory.setBuffer(newBuffer);
+
+	//free old
+	this->deallocate(oldBuffer, size);
+
+	//ok
+	return true;
+}
+
+/****************************************************/
+/**
+ * Move the hot segments in the fast tier and the cold ones in the slow tier.
+ * The cold segments are demoted only to make room for the hot ones. The access
+ * counters are then divided by two so the hotness follows the recent accesses.
+ * No RDMA operation must be in flight on those segments while calling this
+ * function.
+ * @param segments The list of segments to consider (obtained from the
+ * container). The segments not allocated by this backend are ignored.
+ * @param maxMigration Maximum amount of data to move on this call.
+ * @return The amount of data moved.
+**/
+size_t MemoryBackendTiered::rebalance(std::vector<std::shared_ptr<ObjectSegmentMemory>> & segments, size_t maxMigration)
+{
+	//keep only ours & remove duplicates (COW), the segments can reference
+	//a backend placed on top of us so we check the address. The ones being
+	//written by a flush are not moved.
+	std::vector<ObjectSegmentMemory*> candidates;
+	std::set<ObjectSegmentMemory*> seen;
+	for (auto & it : segments)
+		if (it->getBuffer() != NULL && it->isFlushing() == false && this->tierOfMem.count(it->getBuffer()) > 0 && seen.insert(it.get()).second)
+			candidates.push_back(it.get());
+
+	//sort with hottest first
+	std::stable_sort(candidates.begin(), candidates.end(), [](ObjectSegmentMemory * a, ObjectSegmentMemory * b){
+		return a->getAccessCount() > b->getAccessCount();
+	});
+
+	//select the segments which should be in the fast tier
+	size_t budget = this->fastCapacity;
+	size_t needed = 0;
+	std::vector<ObjectSegmentMemory*> promote;
+	std::vector<ObjectSegmentMemory*> demote;
+	for (auto & it : candidates) {
+		bool hot = it->getAccessCount() >= this->hotThreshold && it->getSize() <= budget;
+		MemoryTier tier = this->getTier(it->getBuffer());
+		if (hot)
+			budget -= it->getSize();
+		if (hot && tier == MEMORY_TIER_SLOW) {
+			promote.push_back(it);
+			needed += it->getSize();
+		} else if (!hot && tier == MEMORY_TIER_FAST) {
+			demote.push_back(it);
+		}
+	}
+
+	//demote the coldest first until we have room for the promotions
+	size_t moved = 0;
+	for (auto it = demote.rbegin() ; it != demote.rend() ; ++it) {
+		if (this->fastCapacity - this->fastUsed >= needed || moved >= maxMigration)
+			break;
+		if (this->migrate(**it, MEMORY_TIER_SLOW))
+			moved += (*it)->getSize();
+	}
+
+	//promote the hottest first
+	for (auto & it : promote) {
+		if (moved >= maxMigration)
+			break;
+		if (this->fastUsed + it->getSize() > this->fastCapacity)
+			continue;
+		if (this->migrate(*it, MEMORY_TIER_FAST))
+			moved += it->getSize();
+	}
+
+	//debug
+	if (moved > 0)
+		IOC_DEBUG_ARG("tiered", "Migrated %1 of segments, fast tier use %2")
+			.argUnit1024(moved)
+			.argUnit1024(this->fastUsed)
+			.end();
+
+	//decay the counters
+	for (auto & it : candidates)
+		it->decayAccessCount();
+
+	//return
+	return moved;
+}
+
+/****************************************************/
+/**
+ * Return the tier on which the given address has been allocated.
+ * @param addr The base address of the allocated segment.
+**/
+MemoryTier MemoryBackendTiered::getTier(void * addr) const
+{
+	auto it = this->tierOfMem.find(addr);
+	assumeArg(it != this->tierOfMem.end(), "Fail to find the tier of the given memory : %1 !").arg(addr).end();
+	return it->second;
+}
+
+/****************************************************/
+/**
+ * Return the memory used on the fast tier.
+**/
+size_t MemoryBackendTiered::getFastUsed(void) const
+{
+	return this->fastUsed;
+}
+
+/****************************************************/
+/**
+ * Return the memory used on the slow tier.
+**/
+size_t MemoryBackendTiered::getSlowUsed(void) const
+{
+	return this->slowUsed;
+}
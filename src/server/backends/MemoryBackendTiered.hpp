@@ -0,0 +1,91 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_BACKEND_TIERED_HPP
+#define IOC_MEMORY_BACKEND_TIERED_HPP
+
+/****************************************************/
+//std
+#include <vector>
+#include <map>
+#include <memory>
+//internal
+#include "../core/MemoryBackend.hpp"
+#include "../core/ObjectSegment.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/** Minimal number of accesses in the current period to consider a segment as hot. **/
+#define IOC_TIERED_HOT_THRESHOLD 2
+/** Maximum amount of data migrated on each call to rebalance(). **/
+#define IOC_TIERED_MAX_MIGRATION (512UL*1024UL*1024UL)
+
+/****************************************************/
+/**
+ * Define the two memory tiers handled by MemoryBackendTiered.
+**/
+enum MemoryTier
+{
+	/** The fast tier (DRAM). **/
+	MEMORY_TIER_FAST,
+	/** The slow tier (NVDIMM). **/
+	MEMORY_TIER_SLOW,
+};
+
+/****************************************************/
+/**
+ * Implement a two level memory backend, typically DRAM on top of NVDIMM.
+ * New segments are placed in the fast tier as long as it has room, then
+ * on the slow tier.
+ *
+ * The rebalance() function has to be called regularly with the segments
+ * of the container. It uses the access counters of the segments to promote
+ * the hot ones in the fast tier and demote the cold ones in the slow tier.
+ * The migration copies the data and replace the buffer inside the
+ * ObjectSegmentMemory so the objects keep working transparently. As each
+ * sub backend registers its memory for RDMA, the registration follows
+ * the data. The caller must ensure no RDMA operation is in flight when
+ * calling rebalance().
+**/
+class MemoryBackendTiered: public MemoryBackend
+{
+	public:
+		MemoryBackendTiered(MemoryBackend * fastBackend, MemoryBackend * slowBackend, size_t fastCapacity, size_t hotThreshold = IOC_TIERED_HOT_THRESHOLD);
+		virtual ~MemoryBackendTiered(void);
+	public:
+		virtual void * allocate(size_t size);
+		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
+		size_t rebalance(std::vector<std::shared_ptr<ObjectSegmentMemory>> & segments, size_t maxMigration = IOC_TIERED_MAX_MIGRATION);
+		MemoryTier getTier(void * addr) const;
+		size_t getFastUsed(void) const;
+		size_t getSlowUsed(void) const;
+	private:
+		void * allocateOnTier(size_t size, MemoryTier tier);
+		bool migrate(ObjectSegmentMemory & memory, MemoryTier tier);
+	private:
+		/** The fast memory backend (DRAM). **/
+		MemoryBackend * fastBackend;
+		/** The slow memory backend (NVDIMM). **/
+		MemoryBackend * slowBackend;
+		/** Maximum memory to use on the fast tier. **/
+		size_t fastCapacity;
+		/** Minimal access count to promote a segment. **/
+		size_t hotThreshold;
+		/** Memory currently used on the fast tier. **/
+		size_t fastUsed;
+		/** Memory currently used on the slow tier. **/
+		size_t slowUsed;
+		/** Keep track of the tier of each allocated address. **/
+		std::map<void*, MemoryTier> tierOfMem;
+};
+
+}
+
+#endif //IOC_MEMORY_BACKEND_TIERED_HPP
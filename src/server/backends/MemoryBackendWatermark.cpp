@@ -0,0 +1,150 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//internal
+#include "base/common/Debug.hpp"
+#include "MemoryBackendWatermark.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the watermark memory backend.
+ * @param backend Pointer to the sub backend to use to allocate and free
+ * memory. It will be deleted at exit.
+ * @param limit Maximum amount of memory to allocate, 0 for no limit.
+**/
+MemoryBackendWatermark::MemoryBackendWatermark(MemoryBackend * backend, size_t limit)
+	:MemoryBackend(NULL)
+{
+	//check
+	assert(backend != NULL);
+
+	//setup
+	this->backend = backend;
+	this->limit = limit;
+	this->used = 0;
+	this->peak = 0;
+	this->failures = 0;
+}
+
+/****************************************************/
+/**
+ * Destroy the sub backend after checking that all the memory has been
+ * freed.
+**/
+MemoryBackendWatermark::~MemoryBackendWatermark(void)
+{
+	//warn if not all freed
+	if (this->used != 0)
+		IOC_WARNING_ARG("Delete watermark backend but it still has memory : %1 !").argUnit1024(this->used).end();
+
+	//delete
+	delete this->backend;
+}
+
+/****************************************************/
+/**
+ * Allocate from the sub backend if under the limit and update the
+ * high-water mark.
+ * @param size Size of the memory to allocate.
+ * @return The address of the memory or NULL if out of memory or over the
+ * limit.
+**/
+void * MemoryBackendWatermark::allocate(size_t size)
+{
+	//check
+	assert(size > 0);
+
+	//check limit
+	if (this->limit > 0 && this->used + size > this->limit) {
+		this->failures++;
+		return NULL;
+	}
+
+	//allocate
+	void * ptr = this->backend->allocate(size);
+	if (ptr == NULL) {
+		this->failures++;
+		return NULL;
+	}
+
+	//account
+	size_t current = (this->used += size);
+	size_t peak = this->peak.load();
+	while (current > peak && this->peak.compare_exchange_weak(peak, current) == false) {};
+
+	//return
+	return ptr;
+}
+
+/****************************************************/
+/**
+ * Return the memory to the sub backend.
+ * @param addr Address of the memory space to free.
+ * @param size Size of the memory space to free.
+**/
+void MemoryBackendWatermark::deallocate(void * addr, size_t size)
+{
+	//check
+	assert(addr != NULL);
+	assert(size > 0);
+	assert(this->used >= size);
+
+	//free
+	this->backend->deallocate(addr, size);
+	this->used -= size;
+}
+
+/****************************************************/
+/**
+ * Forward the trim to the sub backend.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackendWatermark::trim(void)
+{
+	return this->backend->trim();
+}
+
+/****************************************************/
+/**
+ * Return the memory currently allocated.
+**/
+size_t MemoryBackendWatermark::getUsed(void) const
+{
+	return this->used;
+}
+
+/****************************************************/
+/**
+ * Return the highest memory usage seen since the start.
+**/
+size_t MemoryBackendWatermark::getPeak(void) const
+{
+	return this->peak;
+}
+
+/****************************************************/
+/**
+ * Return the number of allocations which failed.
+**/
+size_t MemoryBackendWatermark::getFailures(void) const
+{
+	return this->failures;
+}
+
+/****************************************************/
+/**
+ * Return the configured limit, 0 if not limited.
+**/
+size_t MemoryBackendWatermark::getLimit(void) const
+{
+	return this->limit;
+}
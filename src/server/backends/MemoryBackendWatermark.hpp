@@ -0,0 +1,60 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_MEMORY_BACKEND_WATERMARK_HPP
+#define IOC_MEMORY_BACKEND_WATERMARK_HPP
+
+/****************************************************/
+//std
+#include <atomic>
+//internal
+#include "../core/MemoryBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Memory backend placed on top of the whole memory backend stack of the
+ * server to track the memory used by the segments, its high-water mark and
+ * the allocation failures so they can be reported in the statistics.
+ *
+ * It can also enforce a maximum amount of memory. When the limit is reached
+ * the allocations fail so the server answers to the clients to retry later
+ * until some memory is freed instead of exhausting the node memory.
+ *
+ * The counters can be read from another thread (the stats one).
+**/
+class MemoryBackendWatermark: public MemoryBackend
+{
+	public:
+		MemoryBackendWatermark(MemoryBackend * backend, size_t limit = 0);
+		virtual ~MemoryBackendWatermark(void);
+	public:
+		virtual void * allocate(size_t size);
+		virtual void deallocate(void * addr, size_t size);
+		virtual size_t trim(void);
+		size_t getUsed(void) const;
+		size_t getPeak(void) const;
+		size_t getFailures(void) const;
+		size_t getLimit(void) const;
+	private:
+		/** Keep track of the underhood memory backend to use. **/
+		MemoryBackend * backend;
+		/** Maximum memory allowed to be used, 0 for no limit. **/
+		size_t limit;
+		/** Memory currently allocated through this backend. **/
+		std::atomic<size_t> used;
+		/** Highest value reached by the used memory. **/
+		std::atomic<size_t> peak;
+		/** Number of allocations which failed. **/
+		std::atomic<size_t> failures;
+};
+
+}
+
+#endif //IOC_MEMORY_BACKEND_WATERMARK_HPP
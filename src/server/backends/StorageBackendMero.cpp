@@ -8,6 +8,9 @@
 //std
 #include <cassert>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <sys/uio.h>
 #include "base/common/Debug.hpp"
 #include "StorageBackendMero.hpp"
 #ifndef NOMERO
@@ -39,6 +42,12 @@ using namespace std;
 	#define CLOVIS_MAX_DATA_UNIT_PER_OPS  50
 #endif
 
+/****************************************************/
+/** Maximum number of mero operations launched in parallel for a single large IO. **/
+#ifndef MERO_MAX_OPS_IN_FLIGHT
+	#define MERO_MAX_OPS_IN_FLIGHT 8
+#endif
+
 
 /****************************************************/
 #ifndef NOMERO
@@ -56,6 +65,111 @@ using namespace std;
 	}
 #endif
 
+/****************************************************/
+#ifdef HAVE_MERO
+	/**
+	 * Make a read or write operation directly from/to the given buffers
+	 * (no intermediate copy). The range is cut in operations of at most
+	 * CLOVIS_MAX_DATA_UNIT_PER_OPS data units and up to
+	 * MERO_MAX_OPS_IN_FLIGHT of them are launched before waiting.
+	 * @param id The object ID.
+	 * @param isWrite True for a write, false for a read.
+	 * @param iov The list of buffers, contiguous in the object.
+	 * @param iovcnt The number of buffers.
+	 * @param offset Offset of the first buffer in the object.
+	 * @return 0 on success, an error code otherwise.
+	**/
+	static int meroPipelinedIo(struct m0_uint128 id, bool isWrite, const struct iovec * iov, int iovcnt, size_t offset)
+	{
+		// We assume here 2 things:
+		// -> That the object is opened
+		// -> And opened with the same layout as the default clovis one
+		int layout_id = m0_clovis_layout_id(clovis_instance);
+		size_t data_units_size = (size_t) m0_clovis_obj_layout_id_to_unit_size(layout_id);
+		assert(data_units_size > 0);
+
+		//cut the buffers in data units
+		std::vector<struct iovec> units;
+		for (int i = 0 ; i < iovcnt ; i++) {
+			for (size_t unitOffset = 0 ; unitOffset < iov[i].iov_len ; unitOffset += data_units_size) {
+				struct iovec unit;
+				unit.iov_base = (char*)iov[i].iov_base + unitOffset;
+				unit.iov_len = std::min(data_units_size, iov[i].iov_len - unitOffset);
+				units.push_back(unit);
+			}
+		}
+
+		//send by groups of ops
+		size_t done = 0;
+		size_t last_index = offset;
+		int rc = 0;
+		while (done < units.size() && rc == 0) {
+			//number of ops for this round
+			size_t remaining = units.size() - done;
+			int op_cnt = std::min<size_t>((remaining + CLOVIS_MAX_DATA_UNIT_PER_OPS - 1) / CLOVIS_MAX_DATA_UNIT_PER_OPS, MERO_MAX_OPS_IN_FLIGHT);
+
+			//setup group
+			struct clovis_aio_opgrp aio_grp;
+			rc = clovis_aio_opgrp_init(&aio_grp, 0, op_cnt);
+			if (rc != 0)
+				break;
+			m0_clovis_obj_init(&aio_grp.cag_obj, &clovis_uber_realm, &id, layout_id);
+			open_entity(&aio_grp.cag_obj.ob_entity);
+
+			//launch ops
+			int nr_ops_prepared = 0;
+			int nr_ops_sent = 0;
+			for (int i = 0 ; i < op_cnt ; i++) {
+				struct clovis_aio_op * aio = &aio_grp.cag_aio_ops[i];
+				int block_count = std::min<size_t>(units.size() - done, CLOVIS_MAX_DATA_UNIT_PER_OPS);
+
+				//point the vectors on the buffers
+				rc = clovis_aio_vec_empty_alloc(aio, block_count);
+				if (rc != 0)
+					break;
+				nr_ops_prepared++;
+				for (int j = 0 ; j < block_count ; j++) {
+					aio->cao_data.ov_buf[j] = units[done + j].iov_base;
+					aio->cao_data.ov_vec.v_count[j] = units[done + j].iov_len;
+					aio->cao_ext.iv_index[j] = last_index;
+					aio->cao_ext.iv_vec.v_count[j] = units[done + j].iov_len;
+					aio->cao_attr.ov_vec.v_count[j] = 0;
+					last_index += units[done + j].iov_len;
+				}
+
+				//launch
+				if (isWrite)
+					rc = write_data_to_object_async(aio);
+				else
+					rc = read_data_from_object_async(aio);
+				if (rc != 0)
+					break;
+				nr_ops_sent++;
+				done += block_count;
+			}
+
+			//wait all
+			for (int i = 0 ; i < nr_ops_sent ; i++)
+				m0_semaphore_down(&aio_grp.cag_sem);
+			rc = rc ?: aio_grp.cag_rc;
+
+			//finalize ops and group
+			for (int i = 0 ; i < nr_ops_prepared ; i++) {
+				struct clovis_aio_op * aio = &aio_grp.cag_aio_ops[i];
+				if (i < nr_ops_sent) {
+					m0_clovis_op_fini(aio->cao_op);
+					m0_clovis_op_free(aio->cao_op);
+				}
+				clovis_aio_vec_empty_free(aio);
+			}
+			m0_clovis_entity_fini(&aio_grp.cag_obj.ob_entity);
+			clovis_aio_opgrp_fini(&aio_grp);
+		}
+
+		return rc;
+	}
+#endif
+
 /****************************************************/
 /**
  * Constructor of the Mero storage backend, currently don't do anything.
@@ -126,73 +240,16 @@ ssize_t StorageBackendMero::pread(int64_t high, int64_t low, void * buffer, size
 			return -1;
 		}
 	#elif defined(HAVE_MERO)
-		struct m0_indexvec ext;
-		struct m0_bufvec data;
-		struct m0_bufvec attr;
+		struct iovec iov;
+		iov.iov_base = buffer;
+		iov.iov_len = size;
 
 		struct m0_uint128 m_object_id;
 		m_object_id.u_hi = high;
 		m_object_id.u_lo = low;
 
-		char *char_buf = (char *)buffer;
-		int ret = 0;
-		// We assume here 2 things: 
-		// -> That the object is opened
-		// -> And opened with the same layout as the default clovis one
-		int layout_id = m0_clovis_layout_id(clovis_instance);
-		size_t data_units_size = (size_t) m0_clovis_obj_layout_id_to_unit_size(layout_id);
-
-		assert(data_units_size > 0);
-
-		int total_blocks_to_read = 0;
-
-		if (data_units_size > size) {
-			data_units_size = size;
-			total_blocks_to_read = 1;        
-		} else {
-			total_blocks_to_read =  size / data_units_size;
-			if (size % data_units_size != 0) {
-				assert(false && "We don't handle the case where the IO size is not a multiple of the data units");
-			}
-		}
-
-		int last_index = offset;
-		int j = 0;
-
-		while(total_blocks_to_read > 0) {
-
-			int block_size = (total_blocks_to_read > CLOVIS_MAX_DATA_UNIT_PER_OPS)?
-						CLOVIS_MAX_DATA_UNIT_PER_OPS : total_blocks_to_read;
-
-			m0_bufvec_alloc(&data, block_size, data_units_size);
-			m0_bufvec_alloc(&attr, block_size, 1);
-			m0_indexvec_alloc(&ext, block_size);
-
-				/* Initialize the different arrays */
-			int i;
-			for (i = 0; i < block_size; i++) {
-				attr.ov_vec.v_count[i] = 1;
-				ext.iv_index[i] = last_index;
-				ext.iv_vec.v_count[i] = data_units_size;
-				last_index += data_units_size;
-			}
-
-			ret = read_data_from_object(m_object_id, &ext, &data, &attr);
-			// @todo: handling partial read 
-			if (ret != 0)
-				break;
-
-			for (i = 0; i < block_size; i++) {
-				memcpy((char_buf + i*data_units_size + j*block_size*data_units_size), data.ov_buf[i], data_units_size);
-			}
-
-			m0_indexvec_free(&ext);
-			m0_bufvec_free(&data);
-			m0_bufvec_free(&attr);
-			
-			total_blocks_to_read -= block_size;
-			j++;
-		};
+		//make the IO directly from/to the segment memory
+		int ret = meroPipelinedIo(m_object_id, false, &iov, 1, offset);
 
 		if (ret == 0) {
 			IOC_DEBUG_ARG("mero", "Success executing the MERO helperPread op, object ID=%1, offset=%3, size=%2")
@@ -247,96 +304,86 @@ ssize_t StorageBackendMero::pwrite(int64_t high, int64_t low, void * buffer, siz
 				.end();
 			return size;
 		} else {
-			cerr << "[Failed] Error executing the MERO helperWrite op, object ID=" << m_object_id << " , size=" << size
+			cerr << "[Failed] Error executing the MERO helperPwrite op, object ID=" << m_object_id << " , size=" << size
 						<< ", offset=" << offset << endl;
 			errno = EIO;
 			return -1;
 		}
 	#elif defined(HAVE_MERO)
-		struct m0_indexvec ext;
-		struct m0_bufvec data;
-		struct m0_bufvec attr;
-
-		char *char_buf = (char *) buffer;
-		int ret = 0;
+		struct iovec iov;
+		iov.iov_base = buffer;
+		iov.iov_len = size;
 
 		struct m0_uint128 m_object_id;
 		m_object_id.u_hi = high;
 		m_object_id.u_lo = low;
 
-		// We assume here 2 things:
-		// -> That the object is opened
-		// -> And opened with the same layout as the default clovis one
-		int layout_id = m0_clovis_layout_id(clovis_instance);
-		size_t data_units_size = (size_t) m0_clovis_obj_layout_id_to_unit_size(layout_id);
-
-		assert(data_units_size > 0);
-
-		int total_blocks_to_write = 0;
+		//make the IO directly from/to the segment memory
+		int ret = meroPipelinedIo(m_object_id, true, &iov, 1, offset);
 
-		if (data_units_size > size) {
-			data_units_size = size;
-			total_blocks_to_write = 1;        
+		if (ret == 0) {
+			IOC_DEBUG_ARG("mero", "Success executing the MERO helperWrite op, object ID=%1, offset=%3, size=%2")
+				.arg(m_object_id)
+				.arg(offset)
+				.arg(size)
+				.end();
+			return size;
 		} else {
-			total_blocks_to_write =  size / data_units_size;
-			if (size % data_units_size != 0) {
-				assert(false && "We don't handle the case where the IO size is not a multiple of the data units");
-			}
+			cerr << "[Failed] Error executing the MERO helperPwrite op, object ID=" << m_object_id << " , size=" << size
+						<< ", offset=" << offset << endl;
+			errno = EIO;
+			return -1;
 		}
+	#else
+		#error "Should never compile this line !"
+	#endif
+}
 
-		int last_index = offset;
-		int j = 0;
-
-		while(total_blocks_to_write > 0) {
-
-			int block_size = (total_blocks_to_write > CLOVIS_MAX_DATA_UNIT_PER_OPS)?
-						CLOVIS_MAX_DATA_UNIT_PER_OPS : total_blocks_to_write;
-
-			m0_bufvec_alloc(&data, block_size, data_units_size);
-			m0_bufvec_alloc(&attr, block_size, 1);
-			m0_indexvec_alloc(&ext, block_size);
-
-				/* Initialize the different arrays */
-			int i;
-			for (i = 0; i < block_size; i++) {
-
-				//@todo: Can we remove this extra copy ?
-				memcpy(data.ov_buf[i], (char_buf + i*data_units_size + j*block_size*data_units_size), data_units_size);
-
-				attr.ov_vec.v_count[i] = 1;
-
-				ext.iv_index[i] = last_index;
-				ext.iv_vec.v_count[i] = data_units_size;
-				last_index += data_units_size;
-			}
+/****************************************************/
+/**
+ * Write a list of buffers contiguous in the object. With Mero the data units
+ * of all the buffers are sent in the same operations (multi extent) instead
+ * of one operation per buffer, directly from the buffers.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param iov The list of buffers to write.
+ * @param iovcnt Number of buffers in the list.
+ * @param offset Offset in the object.
+ * @return The total size written or -1 on error.
+**/
+ssize_t StorageBackendMero::pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset)
+{
+	//check
+	assert(iov != NULL);
 
-			cout << "[Pending] Send MERO write ops, object ID=" << m_object_id;
-			cout << ", size=" << block_size << ", bs=" << data_units_size << endl;
-			
-			// Send the write ops to MERO and wait for completion 
-			ret = write_data_to_object(m_object_id, &ext, &data, &attr);
+	//compute size
+	size_t size = 0;
+	for (int i = 0 ; i < iovcnt ; i++)
+		size += iov[i].iov_len;
 
-			m0_indexvec_free(&ext);
-			m0_bufvec_free(&data);
-			m0_bufvec_free(&attr);
+	#ifdef NOMERO
+		return size;
+	#elif defined(HAVE_MOTR)
+		//the c0appz helpers work on a single buffer
+		return StorageBackend::pwritev(high, low, iov, iovcnt, offset);
+	#elif defined(HAVE_MERO)
+		struct m0_uint128 m_object_id;
+		m_object_id.u_hi = high;
+		m_object_id.u_lo = low;
 
-			// @todo: handling partial write
-			if (ret != 0) 
-				break;
-			
-			total_blocks_to_write -= block_size;
-			j++;
-		};
+		//make the IO directly from/to the segment memory
+		int ret = meroPipelinedIo(m_object_id, true, iov, iovcnt, offset);
 
 		if (ret == 0) {
-			IOC_DEBUG_ARG("mero", "Success executing the MERO helperWrite op, object ID=%1, offset=%3, size=%2")
+			IOC_DEBUG_ARG("mero", "Success executing the MERO helperPwritev op, object ID=%1, offset=%3, size=%2, buffers=%4")
 				.arg(m_object_id)
 				.arg(offset)
 				.arg(size)
+				.arg(iovcnt)
 				.end();
 			return size;
 		} else {
-			cerr << "[Failed] Error executing the MERO helperPwrite op, object ID=" << m_object_id << " , size=" << size
+			cerr << "[Failed] Error executing the MERO helperPwritev op, object ID=" << m_object_id << " , size=" << size
 						<< ", offset=" << offset << endl;
 			errno = EIO;
 			return -1;
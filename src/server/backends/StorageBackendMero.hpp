@@ -26,6 +26,7 @@ class StorageBackendMero : public StorageBackend
 		~StorageBackendMero(void);
 		virtual ssize_t pread(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override;
 		virtual ssize_t pwrite(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override;
+		virtual ssize_t pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset) override;
 		virtual int create(int64_t high, int64_t low) override;
 };
 
@@ -0,0 +1,753 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <climits>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+//unix
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+	#include <linux/fs.h>
+#endif
+//internal
+#include "base/common/Debug.hpp"
+#include "StorageBackendPosix.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the posix storage backend. It creates the storage
+ * directory if it does not exist.
+ * @param directory The directory where to store the objects.
+ * @param maxOpenFiles Maximum number of objects to keep opened.
+**/
+StorageBackendPosix::StorageBackendPosix(const std::string & directory, size_t maxOpenFiles)
+{
+	//check
+	assert(directory.empty() == false);
+	assert(maxOpenFiles > 0);
+
+	//setup
+	this->directory = directory;
+	this->maxOpenFiles = maxOpenFiles;
+	this->useDirect = true;
+
+	//create dir
+	int status = mkdir(directory.c_str(), 0755);
+	assumeArg(status == 0 || errno == EEXIST, "Fail to create the storage directory '%1': %2").arg(directory).argStrErrno().end();
+
+	//setup uring, fallback on sync operations if fails
+	#ifdef HAVE_LIBURING
+		status = io_uring_queue_init(IOC_POSIX_URING_DEPTH, &this->ring, 0);
+		this->ringReady = (status == 0);
+		this->ringInFlight = 0;
+		if (status != 0)
+			IOC_WARNING_ARG("Fail to init io_uring, use synchronous IO: %1").arg(strerror(-status)).end();
+	#endif
+}
+
+/****************************************************/
+/**
+ * Destructor of the posix storage backend, it closes all the files.
+**/
+StorageBackendPosix::~StorageBackendPosix(void)
+{
+	//wait the operations in flight
+	#ifdef HAVE_LIBURING
+		if (this->ringReady) {
+			while (this->ringInFlight > 0)
+				this->reapCompletions(true);
+			io_uring_queue_exit(&this->ring);
+		}
+	#endif
+
+	//close
+	for (auto & it : this->openFiles)
+		this->closeFds(it.second);
+	this->openFiles.clear();
+}
+
+/****************************************************/
+/**
+ * Build the path of the file storing the given object.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param createDir Create the parent directory if it does not exist.
+ * @return The path of the file.
+**/
+std::string StorageBackendPosix::getPath(int64_t high, int64_t low, bool createDir) const
+{
+	//hash to spread the objects in sub directories
+	unsigned int hash = (((uint64_t)high * 31UL) ^ (uint64_t)low) % 256;
+
+	//build dir
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "/%02x", hash);
+	std::string path = this->directory + buffer;
+	if (createDir) {
+		int status = mkdir(path.c_str(), 0755);
+		if (status != 0 && errno != EEXIST)
+			IOC_WARNING_ARG("Fail to create the storage directory '%1': %2").arg(path).argStrErrno().end();
+	}
+
+	//build file name
+	snprintf(buffer, sizeof(buffer), "/%016lx-%016lx", (uint64_t)high, (uint64_t)low);
+	path += buffer;
+
+	//return
+	return path;
+}
+
+/****************************************************/
+/**
+ * Close the files of an object.
+ * @param fds The file descriptors to close.
+**/
+void StorageBackendPosix::closeFds(StorageBackendPosixFds & fds)
+{
+	if (fds.fd >= 0)
+		close(fds.fd);
+	if (fds.directFd >= 0)
+		close(fds.directFd);
+	fds.fd = -1;
+	fds.directFd = -1;
+}
+
+/****************************************************/
+/**
+ * Close the files of the idle objects until no more than the given number
+ * of objects have opened files. The files used by an operation stay open.
+ * @param keep Number of objects allowed to keep their files opened.
+ * @warning The filesMutex must be held by the caller.
+**/
+void StorageBackendPosix::trimOpenFiles(size_t keep)
+{
+	for (auto it = this->openFiles.begin() ; it != this->openFiles.end() && this->openFiles.size() > keep ; ) {
+		if (it->second.users == 0) {
+			this->closeFds(it->second);
+			it = this->openFiles.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+/****************************************************/
+/**
+ * Release the files of an object taken by getFds() at the end of an
+ * operation. They stay open for the next operations unless too many files
+ * are opened.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+**/
+void StorageBackendPosix::releaseFds(int64_t high, int64_t low)
+{
+	//release
+	std::lock_guard<std::mutex> lock(this->filesMutex);
+	auto it = this->openFiles.find(std::make_pair(high, low));
+	assert(it != this->openFiles.end());
+	assert(it->second.users > 0);
+	it->second.users--;
+
+	//over the limit as all the files were used when opening, close it now it is idle
+	if (it->second.users == 0 && this->openFiles.size() > this->maxOpenFiles) {
+		this->closeFds(it->second);
+		this->openFiles.erase(it);
+	}
+}
+
+/****************************************************/
+/**
+ * Get the file descriptors of the given object, open the file if needed.
+ * The files are held until the caller calls releaseFds().
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param openFlags Extra flags for open(), O_CREAT and O_EXCL are supported.
+ * @return The file descriptors or NULL if it fails to open the file (errno
+ * is set).
+ * @warning The filesMutex must be held by the caller.
+**/
+StorageBackendPosixFds * StorageBackendPosix::getFds(int64_t high, int64_t low, int openFlags)
+{
+	//search in opened
+	auto key = std::make_pair(high, low);
+	auto it = this->openFiles.find(key);
+	if (it != this->openFiles.end()) {
+		if (openFlags & O_EXCL) {
+			errno = EEXIST;
+			return NULL;
+		}
+		it->second.users++;
+		return &it->second;
+	}
+
+	//make room by closing idle files
+	this->trimOpenFiles(this->maxOpenFiles - 1);
+
+	//open
+	std::string path = this->getPath(high, low, openFlags & O_CREAT);
+	int fd = open(path.c_str(), O_RDWR | openFlags, 0644);
+	if (fd < 0)
+		return NULL;
+
+	//register
+	StorageBackendPosixFds & fds = this->openFiles[key];
+	fds.fd = fd;
+	fds.directFd = -1;
+	fds.users = 1;
+
+	//return
+	return &fds;
+}
+
+/****************************************************/
+/**
+ * Check if the operation can be made with O_DIRECT.
+ * @param buffer The buffer of the operation.
+ * @param size The size of the operation.
+ * @param offset The offset of the operation.
+**/
+bool StorageBackendPosix::isAligned(void * buffer, size_t size, size_t offset) const
+{
+	return (size_t)buffer % IOC_POSIX_DIRECT_ALIGN == 0
+		&& size % IOC_POSIX_DIRECT_ALIGN == 0
+		&& offset % IOC_POSIX_DIRECT_ALIGN == 0;
+}
+
+/****************************************************/
+/**
+ * Check if a vectored operation can be made with O_DIRECT.
+ * @param iov The list of buffers of the operation.
+ * @param iovcnt Number of buffers in the list.
+ * @param offset The offset of the operation.
+**/
+bool StorageBackendPosix::isAligned(const struct iovec * iov, int iovcnt, size_t offset) const
+{
+	for (int i = 0 ; i < iovcnt ; i++)
+		if (this->isAligned(iov[i].iov_base, iov[i].iov_len, offset) == false)
+			return false;
+	return true;
+}
+
+/****************************************************/
+/**
+ * Get the file descriptor to be used for an operation. It uses the O_DIRECT
+ * one if the operation is aligned. On success the files are held until the
+ * caller calls releaseFds().
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param openFlags Extra flags to open the file if not already opened.
+ * @param aligned If the operation is aligned and can use O_DIRECT (see isAligned()).
+ * @param direct Set to true if the returned descriptor use O_DIRECT.
+ * @return The file descriptor or -1 on failure (errno is set).
+**/
+int StorageBackendPosix::getFd(int64_t high, int64_t low, int openFlags, bool aligned, bool & direct)
+{
+	//get files
+	std::lock_guard<std::mutex> lock(this->filesMutex);
+	direct = false;
+	StorageBackendPosixFds * fds = this->getFds(high, low, openFlags);
+	if (fds == NULL)
+		return -1;
+
+	//not aligned
+	if (this->useDirect == false || aligned == false)
+		return fds->fd;
+
+	//open the direct one
+	if (fds->directFd < 0) {
+		fds->directFd = open(this->getPath(high, low).c_str(), O_RDWR | O_DIRECT);
+		if (fds->directFd < 0 && errno == EINVAL) {
+			IOC_WARNING_ARG("The filesystem of '%1' does not support O_DIRECT, disable it").arg(this->directory).end();
+			this->useDirect = false;
+		}
+		if (fds->directFd < 0)
+			return fds->fd;
+	}
+
+	//ok
+	direct = true;
+	return fds->directFd;
+}
+
+/****************************************************/
+/**
+ * Read the data from the object file. The part after the end of the file
+ * is filled with zeros.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param buffer The buffer where to place the data.
+ * @param size Size of the data to read.
+ * @param offset Offset in the object.
+ * @return The size which has been read or -1 if the object does not exist or
+ * on error.
+**/
+ssize_t StorageBackendPosix::pread(int64_t high, int64_t low, void * buffer, size_t size, size_t offset)
+{
+	//check
+	assert(buffer != NULL);
+
+	//get file
+	bool direct = false;
+	int fd = this->getFd(high, low, 0, this->isAligned(buffer, size, offset), direct);
+	if (fd < 0) {
+		IOC_DEBUG_ARG("storage:posix", "Fail to open object %1:%2 for read: %3").arg(high).arg(low).argStrErrno().end();
+		return -1;
+	}
+	FdsGuard guard(this, high, low);
+
+	//read
+	size_t done = 0;
+	while (done < size) {
+		ssize_t ret = ::pread(fd, (char*)buffer + done, size - done, offset + done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0) {
+			IOC_WARNING_ARG("Fail to read object %1:%2: %3").arg(high).arg(low).argStrErrno().end();
+			return -1;
+		}
+		done += ret;
+		//end of file (with O_DIRECT we cannot continue on an unaligned offset)
+		if (ret == 0 || (direct && done < size))
+			break;
+	}
+
+	//zero after the end of file
+	if (done < size)
+		memset((char*)buffer + done, 0, size - done);
+
+	//ok
+	return size;
+}
+
+/****************************************************/
+/**
+ * Write the data to the object file. The file is created if it does not
+ * exist.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param buffer The data to write.
+ * @param size Size of the data to write.
+ * @param offset Offset in the object.
+ * @return The size which has been written or -1 on error.
+**/
+ssize_t StorageBackendPosix::pwrite(int64_t high, int64_t low, void * buffer, size_t size, size_t offset)
+{
+	//check
+	assert(buffer != NULL);
+
+	//get file
+	bool direct = false;
+	int fd = this->getFd(high, low, O_CREAT, this->isAligned(buffer, size, offset), direct);
+	if (fd < 0) {
+		IOC_WARNING_ARG("Fail to open object %1:%2 for write: %3").arg(high).arg(low).argStrErrno().end();
+		return -1;
+	}
+	FdsGuard guard(this, high, low);
+
+	//write
+	size_t done = 0;
+	while (done < size) {
+		ssize_t ret = ::pwrite(fd, (char*)buffer + done, size - done, offset + done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0) {
+			IOC_WARNING_ARG("Fail to write object %1:%2: %3").arg(high).arg(low).argStrErrno().end();
+			return -1;
+		}
+		done += ret;
+	}
+
+	//ok
+	return size;
+}
+
+/****************************************************/
+/**
+ * Write a list of buffers contiguous in the object file with a single
+ * pwritev() call. The file is created if it does not exist.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param iov The list of buffers to write.
+ * @param iovcnt Number of buffers in the list.
+ * @param offset Offset in the object.
+ * @return The total size written or -1 on error.
+**/
+ssize_t StorageBackendPosix::pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset)
+{
+	//check
+	assert(iov != NULL);
+	assert(iovcnt > 0);
+
+	//get file
+	bool direct = false;
+	int fd = this->getFd(high, low, O_CREAT, this->isAligned(iov, iovcnt, offset), direct);
+	if (fd < 0) {
+		IOC_WARNING_ARG("Fail to open object %1:%2 for write: %3").arg(high).arg(low).argStrErrno().end();
+		return -1;
+	}
+	FdsGuard guard(this, high, low);
+
+	//copy as we need to move in the list on partial writes
+	std::vector<struct iovec> vec(iov, iov + iovcnt);
+	size_t size = 0;
+	for (auto & it : vec)
+		size += it.iov_len;
+
+	//write
+	size_t done = 0;
+	size_t first = 0;
+	while (done < size) {
+		//skip the already written entries
+		while (vec[first].iov_len == 0)
+			first++;
+
+		//write
+		int cnt = std::min<size_t>(vec.size() - first, IOV_MAX);
+		ssize_t ret = ::pwritev(fd, vec.data() + first, cnt, offset + done);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0) {
+			IOC_WARNING_ARG("Fail to write object %1:%2: %3").arg(high).arg(low).argStrErrno().end();
+			return -1;
+		}
+		done += ret;
+
+		//move in the list
+		for (size_t i = first ; ret > 0 ; i++) {
+			size_t consumed = std::min<size_t>(ret, vec[i].iov_len);
+			vec[i].iov_base = (char*)vec[i].iov_base + consumed;
+			vec[i].iov_len -= consumed;
+			ret -= consumed;
+		}
+	}
+
+	//ok
+	return size;
+}
+
+/****************************************************/
+/**
+ * Create the file of the object.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @return 0 on success, -1 if the object already exist or on error.
+**/
+int StorageBackendPosix::create(int64_t high, int64_t low)
+{
+	//create
+	StorageBackendPosixFds * fds = NULL;
+	{
+		std::lock_guard<std::mutex> lock(this->filesMutex);
+		fds = this->getFds(high, low, O_CREAT | O_EXCL);
+	}
+	if (fds == NULL) {
+		IOC_DEBUG_ARG("storage:posix", "Fail to create object %1:%2: %3").arg(high).arg(low).argStrErrno().end();
+		return -1;
+	}
+
+	//keep it opened for the next operations
+	this->releaseFds(high, low);
+	return 0;
+}
+
+/****************************************************/
+/**
+ * Register the holes of the object file found with SEEK_HOLE and
+ * SEEK_DATA and everything after the end of the file which is read as zeros.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param holes The tracker to fill.
+ * @return True on success, false if the file cannot be opened.
+**/
+bool StorageBackendPosix::findHoles(int64_t high, int64_t low, HoleTracker & holes)
+{
+	//get file
+	bool direct = false;
+	int fd = this->getFd(high, low, 0, false, direct);
+	if (fd < 0) {
+		IOC_DEBUG_ARG("storage:posix", "Fail to open object %1:%2 to search holes: %3").arg(high).arg(low).argStrErrno().end();
+		return false;
+	}
+	FdsGuard guard(this, high, low);
+
+	//get size
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+		return false;
+	off_t fileSize = st.st_size;
+
+	//search the holes inside the file, stop without error if not supported
+	#ifdef SEEK_HOLE
+		off_t cursor = 0;
+		while (cursor < fileSize) {
+			off_t hole = lseek(fd, cursor, SEEK_HOLE);
+			if (hole < 0 || hole >= fileSize)
+				break;
+			off_t data = lseek(fd, hole, SEEK_DATA);
+			if (data < 0)
+				data = fileSize;
+			holes.addHole(hole, data - hole);
+			cursor = data;
+		}
+	#endif
+
+	//after the end of file
+	holes.addHole(fileSize, SIZE_MAX - fileSize);
+
+	//ok
+	return true;
+}
+
+/****************************************************/
+/**
+ * Copy a range between two files in the kernel, sharing the blocks
+ * (reflink) if the filesystem supports it.
+ * @param fdOrig The source file.
+ * @param fdDest The destination file.
+ * @param offset The offset of the range.
+ * @param size The size of the range.
+ * @return The size copied or -1 if not supported.
+**/
+ssize_t StorageBackendPosix::copyRange(int fdOrig, int fdDest, size_t offset, size_t size)
+{
+	//try reflink
+	#ifdef FICLONERANGE
+		struct file_clone_range range;
+		range.src_fd = fdOrig;
+		range.src_offset = offset;
+		range.src_length = size;
+		range.dest_offset = offset;
+		if (ioctl(fdDest, FICLONERANGE, &range) == 0)
+			return size;
+	#endif
+
+	//try copy in kernel, stop at the end of the source file, after it
+	//the dest is a hole so it reads zeros as the source does.
+	#ifdef SYS_copy_file_range
+		loff_t offsetOrig = offset;
+		loff_t offsetDest = offset;
+		size_t done = 0;
+		while (done < size) {
+			ssize_t ret = syscall(SYS_copy_file_range, fdOrig, &offsetOrig, fdDest, &offsetDest, size - done, 0);
+			if (ret < 0 && errno == EINTR)
+				continue;
+			if (ret < 0)
+				return -1;
+			if (ret == 0)
+				break;
+			done += ret;
+		}
+		return size;
+	#else
+		return -1;
+	#endif
+}
+
+/****************************************************/
+/**
+ * Make the copy of the given object range on the storage. It uses reflink
+ * or copy_file_range() if supported, otherwise fallback on the read/write
+ * implementation.
+ * @param highOrig The high part of the source object ID.
+ * @param lowOrig The low part of the source object ID.
+ * @param highDest The high part of the destination object ID.
+ * @param lowDest The low part of the destination object ID.
+ * @param offset The offset of the range to copy.
+ * @param size The size of the range to copy.
+ * @return The size which has been copied.
+**/
+ssize_t StorageBackendPosix::makeCowSegment(int64_t highOrig, int64_t lowOrig, int64_t highDest, int64_t lowDest, size_t offset, size_t size)
+{
+	//get files
+	StorageBackendPosixFds * fdsOrig = NULL;
+	StorageBackendPosixFds * fdsDest = NULL;
+	{
+		std::lock_guard<std::mutex> lock(this->filesMutex);
+		fdsOrig = this->getFds(highOrig, lowOrig, O_CREAT);
+		fdsDest = this->getFds(highDest, lowDest, O_CREAT);
+	}
+
+	//copy in kernel
+	ssize_t status = -1;
+	if (fdsOrig != NULL && fdsDest != NULL)
+		status = this->copyRange(fdsOrig->fd, fdsDest->fd, offset, size);
+
+	//release them
+	if (fdsOrig != NULL)
+		this->releaseFds(highOrig, lowOrig);
+	if (fdsDest != NULL)
+		this->releaseFds(highDest, lowDest);
+
+	//debug
+	IOC_DEBUG_ARG("storage:posix", "COW on segment %1:%2 -> %3:%4 [%5,%6] in kernel: %7")
+		.arg(highOrig)
+		.arg(lowOrig)
+		.arg(highDest)
+		.arg(lowDest)
+		.arg(offset)
+		.arg(size)
+		.arg(status == (ssize_t)size)
+		.end();
+
+	//fallback
+	if (status != (ssize_t)size)
+		status = StorageBackend::makeCowSegment(highOrig, lowOrig, highDest, lowDest, offset, size);
+
+	//return
+	return status;
+}
+
+#ifdef HAVE_LIBURING
+/****************************************************/
+/**
+ * Submit a batch of requests to io_uring. If the ring is full we first wait
+ * for some completions.
+ * @param requests Array of requests to submit.
+ * @param count Number of requests in the array.
+**/
+void StorageBackendPosix::submit(StorageRequest * requests, size_t count)
+{
+	//fallback
+	if (this->ringReady == false) {
+		StorageBackend::submit(requests, count);
+		return;
+	}
+
+	//loop on requests
+	for (size_t i = 0 ; i < count ; i++) {
+		//vars
+		StorageRequest & request = requests[i];
+		bool isRead = (request.type == STORAGE_REQUEST_READ);
+		request.done = false;
+
+		//get file, held until the completion
+		bool direct = false;
+		bool aligned = (request.iov == NULL) ? this->isAligned(request.buffer, request.size, request.offset) : this->isAligned(request.iov, request.iovcnt, request.offset);
+		int fd = this->getFd(request.high, request.low, isRead ? 0 : O_CREAT, aligned, direct);
+		if (fd < 0) {
+			IOC_DEBUG_ARG("storage:posix", "Fail to open object %1:%2: %3").arg(request.high).arg(request.low).argStrErrno().end();
+			request.status = -1;
+			this->pushCompleted(&request);
+			continue;
+		}
+
+		//make room if full
+		if (this->ringInFlight >= IOC_POSIX_URING_DEPTH) {
+			io_uring_submit(&this->ring);
+			this->reapCompletions(true);
+		}
+
+		//get entry
+		struct io_uring_sqe * sqe = io_uring_get_sqe(&this->ring);
+		assert(sqe != NULL);
+
+		//setup
+		if (isRead)
+			io_uring_prep_read(sqe, fd, request.buffer, request.size, request.offset);
+		else if (request.iov != NULL)
+			io_uring_prep_writev(sqe, fd, request.iov, request.iovcnt, request.offset);
+		else
+			io_uring_prep_write(sqe, fd, request.buffer, request.size, request.offset);
+		io_uring_sqe_set_data(sqe, &request);
+		this->ringInFlight++;
+	}
+
+	//submit
+	int status = io_uring_submit(&this->ring);
+	if (status < 0)
+		IOC_WARNING_ARG("Fail to submit the IO to io_uring: %1").arg(strerror(-status)).end();
+}
+
+/****************************************************/
+/**
+ * Fetch the completed operations from io_uring and move them to the
+ * completed list. The short operations (end of file) are finished with
+ * the synchronous implementation.
+ * @param wait Wait at least one completion if there is operations in flight.
+ * @return True if some operations have been fetched or are still in flight.
+**/
+bool StorageBackendPosix::reapCompletions(bool wait)
+{
+	//fallback, executed by submit()
+	if (this->ringReady == false)
+		return false;
+
+	//wait one
+	struct io_uring_cqe * cqe = NULL;
+	if (wait && this->ringInFlight > 0) {
+		int status;
+		do {
+			status = io_uring_wait_cqe(&this->ring, &cqe);
+		} while (status == -EINTR);
+		assumeArg(status == 0, "Fail to wait io_uring completion: %1").arg(strerror(-status)).end();
+	}
+
+	//consume all available
+	bool fetched = false;
+	while (io_uring_peek_cqe(&this->ring, &cqe) == 0) {
+		//extract
+		StorageRequest * request = (StorageRequest*)io_uring_cqe_get_data(cqe);
+		ssize_t res = cqe->res;
+		io_uring_cqe_seen(&this->ring, cqe);
+		assert(this->ringInFlight > 0);
+		this->ringInFlight--;
+
+		//finish
+		if (res < 0) {
+			errno = -res;
+			IOC_WARNING_ARG("Fail to access object %1:%2: %3").arg(request->high).arg(request->low).argStrErrno().end();
+			request->status = -1;
+		} else if ((size_t)res < request->size && request->iov != NULL) {
+			//simpler to redo the whole vectored write
+			request->status = this->pwritev(request->high, request->low, request->iov, request->iovcnt, request->offset);
+		} else if ((size_t)res < request->size) {
+			char * buffer = (char*)request->buffer + res;
+			size_t size = request->size - res;
+			size_t offset = request->offset + res;
+			ssize_t status;
+			if (request->type == STORAGE_REQUEST_READ)
+				status = this->pread(request->high, request->low, buffer, size, offset);
+			else
+				status = this->pwrite(request->high, request->low, buffer, size, offset);
+			request->status = (status == (ssize_t)size) ? request->size : -1;
+		} else {
+			request->status = res;
+		}
+
+		//release the file & push
+		this->releaseFds(request->high, request->low);
+		this->pushCompleted(request);
+		fetched = true;
+	}
+
+	//ret
+	return fetched || this->ringInFlight > 0;
+}
+#endif //HAVE_LIBURING
+
+/****************************************************/
+/**
+ * Return the number of objects with opened files. Used for unit tests.
+**/
+size_t StorageBackendPosix::getOpenFiles(void) const
+{
+	std::lock_guard<std::mutex> lock(this->filesMutex);
+	return this->openFiles.size();
+}
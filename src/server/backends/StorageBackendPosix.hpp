@@ -0,0 +1,141 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_STORAGE_BACKEND_POSIX_HPP
+#define IOC_STORAGE_BACKEND_POSIX_HPP
+
+/****************************************************/
+//std
+#include <string>
+#include <map>
+#include <utility>
+#include <mutex>
+//uring
+#ifdef HAVE_LIBURING
+	#include <liburing.h>
+#endif
+//internal
+#include "../core/StorageBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/** Maximum number of file descriptors kept open by the posix storage backend. **/
+#define IOC_POSIX_MAX_OPEN_FILES 256
+/** Alignement required on buffer, offset and size to use O_DIRECT. **/
+#define IOC_POSIX_DIRECT_ALIGN 4096
+/** Maximum number of asynchronous requests in flight in io_uring. **/
+#define IOC_POSIX_URING_DEPTH 256
+
+/****************************************************/
+/**
+ * The file descriptors opened for an object. The O_DIRECT one is opened
+ * only on the first aligned operation.
+**/
+struct StorageBackendPosixFds
+{
+	/** Descriptor for the buffered operations. **/
+	int fd;
+	/** Descriptor opened with O_DIRECT, -1 if not yet opened. **/
+	int directFd;
+	/** Number of operations using the descriptors, they are not closed while not zero. **/
+	size_t users;
+};
+
+/****************************************************/
+/**
+ * Implement a storage backend storing each object in a file of a local
+ * directory. It can be used as a stand-in for Mero/Motr to test the
+ * flush and load paths end to end on any Linux machine.
+ *
+ * The object high:low is stored as DIR/XX/HIGH-LOW with XX a hash of the
+ * ID to avoid having too many files in the same directory. The reads after
+ * the end of the file return zeros as Mero does for non written ranges.
+ *
+ * The aligned operations bypass the page cache with O_DIRECT if supported
+ * by the filesystem, and the COW is made with a reflink or copy_file_range()
+ * when possible. The holes of the sparse files are reported with SEEK_HOLE
+ * so the server can serve them without reading the file.
+ *
+ * If built with liburing, the asynchronous interface (submit() and
+ * pollCompletions()) keeps up to IOC_POSIX_URING_DEPTH operations in flight
+ * with io_uring, otherwise it falls back on the synchronous implementation.
+ *
+ * The file descriptors are kept open in a small cache protected by a mutex so
+ * the synchronous operations can be called from several threads (flush
+ * engine). The asynchronous interface must be used by a single thread. Each
+ * operation holds the files of its object until it is done, the idle files
+ * are closed to make room when opening a new one or on release if there are
+ * still too many.
+**/
+class StorageBackendPosix : public StorageBackend
+{
+	public:
+		StorageBackendPosix(const std::string & directory, size_t maxOpenFiles = IOC_POSIX_MAX_OPEN_FILES);
+		~StorageBackendPosix(void);
+		virtual ssize_t pread(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override;
+		virtual ssize_t pwrite(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override;
+		virtual ssize_t pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset) override;
+		virtual int create(int64_t high, int64_t low) override;
+		virtual ssize_t makeCowSegment(int64_t highOrig, int64_t lowOrig, int64_t highDest, int64_t lowDest, size_t offset, size_t size) override;
+		virtual bool findHoles(int64_t high, int64_t low, HoleTracker & holes) override;
+		#ifdef HAVE_LIBURING
+			virtual void submit(StorageRequest * requests, size_t count) override;
+		#endif
+		std::string getPath(int64_t high, int64_t low, bool createDir = false) const;
+		size_t getOpenFiles(void) const;
+	protected:
+		#ifdef HAVE_LIBURING
+			virtual bool reapCompletions(bool wait) override;
+		#endif
+	private:
+		/**
+		 * Release the files of an object at the end of a synchronous
+		 * operation so they can be closed again.
+		**/
+		struct FdsGuard
+		{
+			FdsGuard(StorageBackendPosix * backend, int64_t high, int64_t low) {this->backend = backend; this->high = high; this->low = low;};
+			~FdsGuard(void) {this->backend->releaseFds(this->high, this->low);};
+			StorageBackendPosix * backend;
+			int64_t high;
+			int64_t low;
+		};
+	private:
+		StorageBackendPosixFds * getFds(int64_t high, int64_t low, int openFlags);
+		int getFd(int64_t high, int64_t low, int openFlags, bool aligned, bool & direct);
+		void releaseFds(int64_t high, int64_t low);
+		void closeFds(StorageBackendPosixFds & fds);
+		void trimOpenFiles(size_t keep);
+		bool isAligned(void * buffer, size_t size, size_t offset) const;
+		bool isAligned(const struct iovec * iov, int iovcnt, size_t offset) const;
+		ssize_t copyRange(int fdOrig, int fdDest, size_t offset, size_t size);
+	private:
+		/** The directory where to store the objects. **/
+		std::string directory;
+		/** Maximum number of objects with opened files. **/
+		size_t maxOpenFiles;
+		/** Disabled if the filesystem does not support O_DIRECT. **/
+		bool useDirect;
+		/** Keep track of the opened files. **/
+		std::map<std::pair<int64_t, int64_t>, StorageBackendPosixFds> openFiles;
+		/** Protect the opened files cache. **/
+		mutable std::mutex filesMutex;
+		#ifdef HAVE_LIBURING
+			/** The io_uring instance. **/
+			struct io_uring ring;
+			/** True if the ring has been initialized. **/
+			bool ringReady;
+			/** Number of operations in flight in the ring. **/
+			size_t ringInFlight;
+		#endif
+};
+
+}
+
+#endif //IOC_STORAGE_BACKEND_POSIX_HPP
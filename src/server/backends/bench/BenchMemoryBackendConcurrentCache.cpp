@@ -0,0 +1,100 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <cstdlib>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include "../MemoryBackendCache.hpp"
+#include "../MemoryBackendConcurrentCache.hpp"
+#include "../MemoryBackendMalloc.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/** Number of allocation/deallocation pairs made by each thread. **/
+#define BENCH_REPEAT 2000000
+/** Number of chunks kept allocated by each thread. **/
+#define BENCH_KEEP 8
+
+/****************************************************/
+/**
+ * Wrap the non thread safe MemoryBackendCache with a mutex to have
+ * a reference.
+**/
+class MemoryBackendLockedCache : public MemoryBackend
+{
+	public:
+		MemoryBackendLockedCache(MemoryBackend * backend) : MemoryBackend(NULL), cache(backend) {};
+		virtual void * allocate(size_t size) {std::lock_guard<std::mutex> guard(mutex); return cache.allocate(size);};
+		virtual void deallocate(void * addr, size_t size) {std::lock_guard<std::mutex> guard(mutex); cache.deallocate(addr, size);};
+	private:
+		std::mutex mutex;
+		MemoryBackendCache cache;
+};
+
+/****************************************************/
+double benchThreads(MemoryBackend & backend, size_t threads)
+{
+	//vars
+	std::vector<std::thread> workers;
+
+	//start
+	auto start = std::chrono::steady_clock::now();
+
+	//run
+	for (size_t t = 0 ; t < threads ; t++) {
+		workers.emplace_back([&backend](){
+			void * ptrs[BENCH_KEEP];
+			for (size_t i = 0 ; i < BENCH_KEEP ; i++)
+				ptrs[i] = backend.allocate(4096 * (1 + i % 4));
+			for (size_t i = 0 ; i < BENCH_REPEAT ; i++) {
+				size_t id = i % BENCH_KEEP;
+				size_t size = 4096 * (1 + id % 4);
+				backend.deallocate(ptrs[id], size);
+				ptrs[id] = backend.allocate(size);
+			}
+			for (size_t i = 0 ; i < BENCH_KEEP ; i++)
+				backend.deallocate(ptrs[i], 4096 * (1 + i % 4));
+		});
+	}
+
+	//wait
+	for (auto & it : workers)
+		it.join();
+
+	//stop
+	auto stop = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(stop - start).count();
+
+	//return Mops/s
+	return (double)(threads * BENCH_REPEAT) / seconds / 1000000.0;
+}
+
+/****************************************************/
+int main(void)
+{
+	//vars
+	size_t maxThreads = std::thread::hardware_concurrency();
+
+	//bench
+	printf("================== Allocation scaling (M alloc+free/s) =====================\n");
+	printf("%-10s %-20s %-20s\n", "Threads", "Locked cache", "Concurrent cache");
+	for (size_t threads = 1 ; threads <= maxThreads ; threads *= 2) {
+		MemoryBackendLockedCache locked(new MemoryBackendMalloc(NULL));
+		MemoryBackendConcurrentCache concurrent(new MemoryBackendMalloc(NULL));
+		double lockedRate = benchThreads(locked, threads);
+		double concurrentRate = benchThreads(concurrent, threads);
+		printf("%-10lu %-20.02f %-20.02f\n", threads, lockedRate, concurrentRate);
+	}
+
+	//ok
+	return EXIT_SUCCESS;
+}
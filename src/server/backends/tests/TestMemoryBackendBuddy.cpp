@@ -0,0 +1,204 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include "../MemoryBackendBuddy.hpp"
+#include "../MemoryBackendMalloc.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+/**
+ * Sub backend keeping its memory in a cache which has to be trimmed before
+ * it can allocate again.
+**/
+class MemoryBackendNeedTrim : public MemoryBackend
+{
+	public:
+		MemoryBackendNeedTrim(void) : MemoryBackend(NULL) {this->full = true;};
+		virtual void * allocate(size_t size) override {return this->full ? NULL : malloc(size);};
+		virtual void deallocate(void * addr, size_t size) override {free(addr);};
+		virtual size_t trim(void) override {size_t released = this->full ? 1 : 0; this->full = false; return released;};
+	private:
+		bool full;
+};
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, allocate_deallocate_no_domain)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(NULL), 16*1024*1024);
+
+	//allocate
+	void * ptr = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(1, backend.getArenaCount());
+	EXPECT_EQ(size, backend.getUsedSize());
+	EXPECT_EQ(15*1024*1024, backend.getCachedSize());
+
+	//deallocate
+	backend.deallocate(ptr, size);
+	EXPECT_EQ(0, backend.getUsedSize());
+	EXPECT_EQ(16*1024*1024, backend.getCachedSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, allocate_deallocate_domain)
+{
+	//vars
+	const size_t size = 1024*1024;
+	LibfabricDomain domain("localhost", "82222", true);
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(&domain), 16*1024*1024);
+
+	//allocate
+	void * ptr = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr);
+
+	//check registered
+	EXPECT_NE(nullptr, domain.getFidMR(ptr, size));
+
+	//deallocate
+	backend.deallocate(ptr, size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, block_size)
+{
+	EXPECT_EQ(4096, MemoryBackendBuddy::getBlockSize(1));
+	EXPECT_EQ(4096, MemoryBackendBuddy::getBlockSize(4096));
+	EXPECT_EQ(8192, MemoryBackendBuddy::getBlockSize(4097));
+	EXPECT_EQ(32*1024*1024, MemoryBackendBuddy::getBlockSize(24*1024*1024));
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, split_and_merge)
+{
+	//vars
+	const size_t arena = 16*1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(NULL), arena);
+
+	//allocate a full arena and return it
+	char * big = (char*)backend.allocate(arena);
+	ASSERT_NE(nullptr, big);
+	backend.deallocate(big, arena);
+
+	//split it in smaller chunks of different sizes
+	char * ptr1 = (char*)backend.allocate(4*1024*1024);
+	char * ptr2 = (char*)backend.allocate(8*1024*1024);
+	char * ptr3 = (char*)backend.allocate(4*1024*1024);
+	EXPECT_EQ(1, backend.getArenaCount());
+	EXPECT_EQ(0, backend.getCachedSize());
+
+	//all in the same arena
+	EXPECT_GE(ptr1, big); EXPECT_LT(ptr1, big + arena);
+	EXPECT_GE(ptr2, big); EXPECT_LT(ptr2, big + arena);
+	EXPECT_GE(ptr3, big); EXPECT_LT(ptr3, big + arena);
+
+	//return all
+	backend.deallocate(ptr1, 4*1024*1024);
+	backend.deallocate(ptr3, 4*1024*1024);
+	backend.deallocate(ptr2, 8*1024*1024);
+
+	//should merge again to serve a full size request
+	char * big2 = (char*)backend.allocate(arena);
+	EXPECT_EQ(big, big2);
+	EXPECT_EQ(1, backend.getArenaCount());
+	backend.deallocate(big2, arena);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, large_chunk)
+{
+	//vars
+	const size_t arena = 4*1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(NULL), arena);
+
+	//allocate more than the arena size
+	void * ptr = backend.allocate(2 * arena);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(0, backend.getArenaCount());
+	EXPECT_EQ(0, backend.getUsedSize());
+
+	//deallocate
+	backend.deallocate(ptr, 2 * arena);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, trim)
+{
+	//vars
+	const size_t arena = 4*1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(NULL), arena);
+
+	//allocate 3 arenas
+	void * ptr1 = backend.allocate(arena);
+	void * ptr2 = backend.allocate(arena);
+	void * ptr3 = backend.allocate(arena / 2);
+	EXPECT_EQ(3, backend.getArenaCount());
+
+	//return
+	backend.deallocate(ptr1, arena);
+	backend.deallocate(ptr2, arena);
+	EXPECT_EQ(3, backend.getArenaCount());
+
+	//trim, the partially used one need to stay
+	EXPECT_EQ(2 * arena, backend.trim());
+	EXPECT_EQ(1, backend.getArenaCount());
+	EXPECT_EQ(arena / 2, backend.getCachedSize());
+
+	//free last one
+	backend.deallocate(ptr3, arena / 2);
+	EXPECT_EQ(arena, backend.trim());
+	EXPECT_EQ(0, backend.getArenaCount());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, max_cached)
+{
+	//vars
+	const size_t arena = 4*1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendMalloc(NULL), arena, arena);
+
+	//allocate 3 arenas
+	void * ptr1 = backend.allocate(arena);
+	void * ptr2 = backend.allocate(arena);
+	void * ptr3 = backend.allocate(arena);
+	EXPECT_EQ(3, backend.getArenaCount());
+
+	//return, only one need to stay in cache
+	backend.deallocate(ptr1, arena);
+	backend.deallocate(ptr2, arena);
+	backend.deallocate(ptr3, arena);
+	EXPECT_EQ(1, backend.getArenaCount());
+	EXPECT_EQ(arena, backend.getCachedSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendBuddy, trim_sub_backend_on_failure)
+{
+	//vars
+	const size_t arena = 4*1024*1024;
+	MemoryBackendBuddy backend(new MemoryBackendNeedTrim(), arena);
+
+	//the sub backend has to release its cache to provide the arena
+	void * ptr = backend.allocate(arena / 2);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(1, backend.getArenaCount());
+
+	//same for the large chunks
+	MemoryBackendBuddy backend2(new MemoryBackendNeedTrim(), arena);
+	void * large = backend2.allocate(2 * arena);
+	ASSERT_NE(nullptr, large);
+
+	//free
+	backend.deallocate(ptr, arena / 2);
+	backend2.deallocate(large, 2 * arena);
+}
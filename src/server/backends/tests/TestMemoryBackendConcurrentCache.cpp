@@ -0,0 +1,149 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include "../MemoryBackendConcurrentCache.hpp"
+#include "../MemoryBackendMalloc.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+TEST(TestMemoryBackendConcurrentCache, allocate_deallocate_no_domain)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendConcurrentCache backend(new MemoryBackendMalloc(NULL));
+
+	//allocate
+	void * ptr = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr);
+
+	//deallocate
+	backend.deallocate(ptr, size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendConcurrentCache, mem_reuse)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendConcurrentCache backend(new MemoryBackendMalloc(NULL));
+
+	//allocate
+	void * ptr1 = backend.allocate(size); ASSERT_NE(nullptr, ptr1);
+	void * ptr2 = backend.allocate(size); ASSERT_NE(nullptr, ptr2);
+
+	//deallocate
+	backend.deallocate(ptr1, size);
+	backend.deallocate(ptr2, size);
+
+	//allocate again, should take from the magazine
+	void * ptr3 = backend.allocate(size);
+	void * ptr4 = backend.allocate(size);
+	EXPECT_EQ(ptr2, ptr3);
+	EXPECT_EQ(ptr1, ptr4);
+
+	//another size does not take the same memory
+	void * ptr5 = backend.allocate(2*size);
+	EXPECT_NE(ptr1, ptr5);
+	EXPECT_NE(ptr2, ptr5);
+
+	//deallocate
+	backend.deallocate(ptr3, size);
+	backend.deallocate(ptr4, size);
+	backend.deallocate(ptr5, 2*size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendConcurrentCache, overflow_magazine)
+{
+	//vars
+	const size_t size = 4096;
+	const size_t cnt = 4 * IOC_CONCURRENT_CACHE_MAGAZINE;
+	MemoryBackendConcurrentCache backend(new MemoryBackendMalloc(NULL));
+	std::vector<void*> ptrs;
+
+	//allocate & free more than the magazine
+	for (size_t i = 0 ; i < cnt ; i++)
+		ptrs.push_back(backend.allocate(size));
+	for (auto & it : ptrs)
+		backend.deallocate(it, size);
+
+	//allocate again, should get back the same chunks
+	std::vector<void*> ptrs2;
+	for (size_t i = 0 ; i < cnt ; i++)
+		ptrs2.push_back(backend.allocate(size));
+	std::sort(ptrs.begin(), ptrs.end());
+	std::sort(ptrs2.begin(), ptrs2.end());
+	EXPECT_EQ(ptrs, ptrs2);
+
+	//free
+	for (auto & it : ptrs2)
+		backend.deallocate(it, size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendConcurrentCache, many_sizes)
+{
+	//vars
+	const size_t cnt = 2 * IOC_CONCURRENT_CACHE_CLASSES;
+	MemoryBackendConcurrentCache backend(new MemoryBackendMalloc(NULL));
+	std::vector<void*> ptrs;
+
+	//more sizes than classes
+	for (size_t i = 0 ; i < cnt ; i++)
+		ptrs.push_back(backend.allocate((i + 1) * 4096));
+	for (size_t i = 0 ; i < cnt ; i++)
+		backend.deallocate(ptrs[i], (i + 1) * 4096);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendConcurrentCache, threads)
+{
+	//vars
+	const size_t threads = 8;
+	const size_t repeat = 2000;
+	MemoryBackendConcurrentCache backend(new MemoryBackendMalloc(NULL));
+	std::vector<std::thread> workers;
+
+	//run
+	for (size_t t = 0 ; t < threads ; t++) {
+		workers.emplace_back([&backend, t, repeat](){
+			std::vector<char*> ptrs;
+			for (size_t i = 0 ; i < repeat ; i++) {
+				size_t size = 4096 * (1 + i % 4);
+				char * ptr = (char*)backend.allocate(size);
+				ptr[size - 1] = (char)t;
+				ptrs.push_back(ptr);
+				//free in an other order than allocation
+				if (ptrs.size() == 32) {
+					for (size_t j = 0 ; j < ptrs.size() ; j++) {
+						size_t id = (i - ptrs.size() + 1 + j);
+						size_t s = 4096 * (1 + id % 4);
+						ASSERT_EQ((char)t, ptrs[j][s - 1]);
+						backend.deallocate(ptrs[j], s);
+					}
+					ptrs.clear();
+				}
+			}
+			for (size_t j = 0 ; j < ptrs.size() ; j++) {
+				size_t id = (repeat - ptrs.size() + j);
+				backend.deallocate(ptrs[j], 4096 * (1 + id % 4));
+			}
+		});
+	}
+
+	//wait
+	for (auto & it : workers)
+		it.join();
+}
@@ -0,0 +1,122 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include "../MemoryBackendPrefault.hpp"
+#include "../MemoryBackendCache.hpp"
+#include "../MemoryBackendMalloc.hpp"
+#include "../MemoryBackendWatermark.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+TEST(TestMemoryBackendPrefault, allocate_deallocate_no_domain)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendPrefault backend(new MemoryBackendMalloc(NULL), size, 4);
+
+	//wait pool
+	backend.waitPoolFull();
+	EXPECT_EQ(4, backend.getPoolSize());
+
+	//allocate
+	void * ptr = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(3, backend.getPoolSize());
+
+	//deallocate
+	backend.deallocate(ptr, size);
+	EXPECT_EQ(4, backend.getPoolSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendPrefault, refill)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendPrefault backend(new MemoryBackendCache(new MemoryBackendMalloc(NULL)), size, 4);
+	backend.waitPoolFull();
+
+	//take all the pool, it triggers the refill
+	void * ptr[6];
+	for (int i = 0 ; i < 6 ; i++) {
+		ptr[i] = backend.allocate(size);
+		ASSERT_NE(nullptr, ptr[i]);
+	}
+
+	//wait the refill
+	backend.waitPoolFull();
+	EXPECT_EQ(4, backend.getPoolSize());
+
+	//return, the pool does not grow more than requested
+	for (int i = 0 ; i < 6 ; i++)
+		backend.deallocate(ptr[i], size);
+	EXPECT_EQ(4, backend.getPoolSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendPrefault, other_size)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendPrefault backend(new MemoryBackendMalloc(NULL), size, 2);
+	backend.waitPoolFull();
+
+	//allocate another size, go to sub backend
+	void * ptr = backend.allocate(2*size);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(2, backend.getPoolSize());
+	backend.deallocate(ptr, 2*size);
+	EXPECT_EQ(2, backend.getPoolSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendPrefault, trim)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendPrefault backend(new MemoryBackendMalloc(NULL), size, 2);
+	backend.waitPoolFull();
+
+	//trim
+	EXPECT_EQ(2*size, backend.trim());
+	EXPECT_EQ(0, backend.getPoolSize());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendPrefault, out_of_memory)
+{
+	//vars, the sub backend can only provide half the pool
+	const size_t size = 1024*1024;
+	MemoryBackendWatermark * watermark = new MemoryBackendWatermark(new MemoryBackendMalloc(NULL), 2*size);
+	MemoryBackendPrefault backend(watermark, size, 4);
+	backend.waitPoolFull();
+	EXPECT_EQ(2, backend.getPoolSize());
+	EXPECT_EQ(1, watermark->getFailures());
+
+	//empty the pool, the refill does not retry while nothing is returned to the sub backend
+	void * ptr[2];
+	for (int i = 0 ; i < 2 ; i++) {
+		ptr[i] = backend.allocate(size);
+		ASSERT_NE(nullptr, ptr[i]);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	EXPECT_EQ(0, backend.getPoolSize());
+	EXPECT_EQ(1, watermark->getFailures());
+
+	//return the memory to the sub backend, the refill tries again
+	for (int i = 0 ; i < 2 ; i++)
+		backend.deallocate(ptr[i], size);
+	backend.trim();
+	backend.waitPoolFull();
+	EXPECT_EQ(2, backend.getPoolSize());
+	EXPECT_EQ(2, watermark->getFailures());
+}
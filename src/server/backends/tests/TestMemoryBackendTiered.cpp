@@ -0,0 +1,106 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <cstring>
+#include <gtest/gtest.h>
+#include "../MemoryBackendTiered.hpp"
+#include "../MemoryBackendMalloc.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+TEST(TestMemoryBackendTiered, allocate_deallocate_no_domain)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendTiered backend(new MemoryBackendMalloc(NULL), new MemoryBackendMalloc(NULL), 2*size);
+
+	//allocate
+	void * ptr1 = backend.allocate(size);
+	void * ptr2 = backend.allocate(size);
+	void * ptr3 = backend.allocate(size);
+
+	//check placement
+	EXPECT_EQ(MEMORY_TIER_FAST, backend.getTier(ptr1));
+	EXPECT_EQ(MEMORY_TIER_FAST, backend.getTier(ptr2));
+	EXPECT_EQ(MEMORY_TIER_SLOW, backend.getTier(ptr3));
+	EXPECT_EQ(2*size, backend.getFastUsed());
+	EXPECT_EQ(size, backend.getSlowUsed());
+
+	//deallocate
+	backend.deallocate(ptr1, size);
+	backend.deallocate(ptr2, size);
+	backend.deallocate(ptr3, size);
+	EXPECT_EQ(0, backend.getFastUsed());
+	EXPECT_EQ(0, backend.getSlowUsed());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendTiered, rebalance)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendTiered backend(new MemoryBackendMalloc(NULL), new MemoryBackendMalloc(NULL), 2*size, 2);
+	std::vector<std::shared_ptr<ObjectSegmentMemory>> segments;
+
+	//allocate 3 segments, the last one is on the slow tier
+	for (int i = 0 ; i < 3 ; i++) {
+		char * ptr = (char*)backend.allocate(size);
+		memset(ptr, 'a' + i, size);
+		segments.push_back(std::make_shared<ObjectSegmentMemory>(ptr, size, &backend));
+	}
+	EXPECT_EQ(MEMORY_TIER_SLOW, backend.getTier(segments[2]->getBuffer()));
+
+	//make the last one hot and the first one cold
+	for (int i = 0 ; i < 4 ; i++)
+		segments[2]->touch();
+	for (int i = 0 ; i < 2 ; i++)
+		segments[1]->touch();
+
+	//rebalance
+	EXPECT_EQ(2*size, backend.rebalance(segments));
+
+	//check
+	EXPECT_EQ(MEMORY_TIER_SLOW, backend.getTier(segments[0]->getBuffer()));
+	EXPECT_EQ(MEMORY_TIER_FAST, backend.getTier(segments[1]->getBuffer()));
+	EXPECT_EQ(MEMORY_TIER_FAST, backend.getTier(segments[2]->getBuffer()));
+	EXPECT_EQ(2*size, backend.getFastUsed());
+	EXPECT_EQ(size, backend.getSlowUsed());
+
+	//check content
+	for (int i = 0 ; i < 3 ; i++) {
+		EXPECT_EQ('a' + i, segments[i]->getBuffer()[0]);
+		EXPECT_EQ('a' + i, segments[i]->getBuffer()[size - 1]);
+	}
+
+	//counters has been decayed
+	EXPECT_EQ(2, segments[2]->getAccessCount());
+	EXPECT_EQ(1, segments[1]->getAccessCount());
+
+	//nothing more to move
+	EXPECT_EQ(0, backend.rebalance(segments));
+}
+
+/****************************************************/
+TEST(TestMemoryBackendTiered, no_demote_when_room)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendTiered backend(new MemoryBackendMalloc(NULL), new MemoryBackendMalloc(NULL), 4*size, 2);
+	std::vector<std::shared_ptr<ObjectSegmentMemory>> segments;
+
+	//allocate 2 cold segments on the fast tier
+	for (int i = 0 ; i < 2 ; i++)
+		segments.push_back(std::make_shared<ObjectSegmentMemory>((char*)backend.allocate(size), size, &backend));
+
+	//rebalance, nothing to move
+	EXPECT_EQ(0, backend.rebalance(segments));
+	EXPECT_EQ(2*size, backend.getFastUsed());
+}
@@ -0,0 +1,117 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include "../MemoryBackendWatermark.hpp"
+#include "../MemoryBackendCache.hpp"
+#include "../MemoryBackendBalance.hpp"
+#include "../MemoryBackendMalloc.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+TEST(TestMemoryBackendWatermark, used_and_peak)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendWatermark backend(new MemoryBackendMalloc(NULL));
+
+	//allocate
+	void * ptr1 = backend.allocate(size);
+	void * ptr2 = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr1);
+	ASSERT_NE(nullptr, ptr2);
+	EXPECT_EQ(2*size, backend.getUsed());
+	EXPECT_EQ(2*size, backend.getPeak());
+
+	//deallocate, the peak stay
+	backend.deallocate(ptr1, size);
+	backend.deallocate(ptr2, size);
+	EXPECT_EQ(0, backend.getUsed());
+	EXPECT_EQ(2*size, backend.getPeak());
+	EXPECT_EQ(0, backend.getFailures());
+}
+
+/****************************************************/
+TEST(TestMemoryBackendWatermark, limit)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendWatermark backend(new MemoryBackendMalloc(NULL), 2*size);
+
+	//allocate up to the limit
+	void * ptr1 = backend.allocate(size);
+	void * ptr2 = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr1);
+	ASSERT_NE(nullptr, ptr2);
+
+	//over the limit
+	EXPECT_EQ(nullptr, backend.allocate(size));
+	EXPECT_EQ(1, backend.getFailures());
+
+	//free one and retry
+	backend.deallocate(ptr1, size);
+	ptr1 = backend.allocate(size);
+	ASSERT_NE(nullptr, ptr1);
+
+	//deallocate
+	backend.deallocate(ptr1, size);
+	backend.deallocate(ptr2, size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendWatermark, cache_trim_on_failure)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendWatermark * limited = new MemoryBackendWatermark(new MemoryBackendMalloc(NULL), 2*size);
+	MemoryBackendCache backend(limited);
+
+	//fill the cache with one size class
+	void * ptr1 = backend.allocate(size);
+	void * ptr2 = backend.allocate(size);
+	backend.deallocate(ptr1, size);
+	backend.deallocate(ptr2, size);
+	EXPECT_EQ(2*size, limited->getUsed());
+
+	//allocate another size, the cache need to release the free chunks
+	void * ptr = backend.allocate(2*size);
+	ASSERT_NE(nullptr, ptr);
+	EXPECT_EQ(2*size, limited->getUsed());
+
+	//now really out of memory
+	EXPECT_EQ(nullptr, backend.allocate(size));
+
+	//deallocate
+	backend.deallocate(ptr, 2*size);
+}
+
+/****************************************************/
+TEST(TestMemoryBackendWatermark, balance_fallback)
+{
+	//vars
+	const size_t size = 1024*1024;
+	MemoryBackendBalance backend;
+	backend.registerBackend(new MemoryBackendWatermark(new MemoryBackendMalloc(NULL), size));
+	backend.registerBackend(new MemoryBackendWatermark(new MemoryBackendMalloc(NULL), 4*size));
+
+	//fill both, the first get full and the second receive the extra ones
+	void * ptr[4];
+	for (int i = 0 ; i < 4 ; i++) {
+		ptr[i] = backend.allocate(size);
+		ASSERT_NE(nullptr, ptr[i]);
+	}
+	EXPECT_EQ(size, backend.getMem(0));
+	EXPECT_EQ(3*size, backend.getMem(1));
+
+	//deallocate
+	for (int i = 0 ; i < 4 ; i++)
+		backend.deallocate(ptr[i], size);
+}
@@ -0,0 +1,334 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+#include "../StorageBackendPosix.hpp"
+#include <gmock/gmock.h>
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+class TestStorageBackendPosix : public ::testing::Test
+{
+	protected:
+		std::string directory;
+		virtual void SetUp()
+		{
+			char tmpl[] = "/tmp/ioc-test-posix-XXXXXX";
+			ASSERT_NE(nullptr, mkdtemp(tmpl));
+			this->directory = tmpl;
+		}
+
+		virtual void TearDown()
+		{
+			std::string cmd = "rm -rf " + this->directory;
+			ASSERT_EQ(0, system(cmd.c_str()));
+		}
+};
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, create)
+{
+	//create
+	StorageBackendPosix storage(this->directory);
+	EXPECT_EQ(0, storage.create(10, 20));
+
+	//check file exist
+	struct stat st;
+	EXPECT_EQ(0, stat(storage.getPath(10, 20).c_str(), &st));
+
+	//already exist
+	EXPECT_EQ(-1, storage.create(10, 20));
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, read_missing)
+{
+	StorageBackendPosix storage(this->directory);
+	char buffer[1024];
+	EXPECT_EQ(-1, storage.pread(10, 20, buffer, sizeof(buffer), 0));
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, write_read)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	char buffer[1024];
+	memset(buffer, 1, sizeof(buffer));
+
+	//write
+	EXPECT_EQ(sizeof(buffer), storage.pwrite(10, 20, buffer, sizeof(buffer), 1000));
+
+	//read, after the end of file we get zeros
+	char out[2048];
+	memset(out, 2, sizeof(out));
+	EXPECT_EQ(sizeof(out), storage.pread(10, 20, out, sizeof(out), 0));
+	for (size_t i = 0 ; i < sizeof(out) ; i++) {
+		if (i >= 1000 && i < 2024)
+			ASSERT_EQ(1, out[i]) << "i=" << i;
+		else
+			ASSERT_EQ(0, out[i]) << "i=" << i;
+	}
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, findHoles)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	HoleTracker holes;
+	char buffer[4096];
+	memset(buffer, 1, sizeof(buffer));
+
+	//missing object
+	EXPECT_FALSE(storage.findHoles(10, 20, holes));
+
+	//make a sparse file
+	EXPECT_EQ(sizeof(buffer), storage.pwrite(10, 20, buffer, sizeof(buffer), 1024*1024));
+	EXPECT_TRUE(storage.findHoles(10, 20, holes));
+
+	//check, the hole at the beginning is reported by the filesystems supporting SEEK_HOLE
+	EXPECT_TRUE(holes.isHole(0, 4096));
+	EXPECT_FALSE(holes.isHole(1024*1024, 4096));
+	EXPECT_TRUE(holes.isHole(1024*1024+4096, 1024*1024));
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, write_read_aligned)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	const size_t size = 2*IOC_POSIX_DIRECT_ALIGN;
+	char * buffer = NULL;
+	ASSERT_EQ(0, posix_memalign((void**)&buffer, IOC_POSIX_DIRECT_ALIGN, 2*size));
+
+	//write
+	memset(buffer, 1, size);
+	EXPECT_EQ(size, storage.pwrite(10, 20, buffer, size, IOC_POSIX_DIRECT_ALIGN));
+
+	//read more than the file
+	memset(buffer, 2, 2*size);
+	EXPECT_EQ(2*size, storage.pread(10, 20, buffer, 2*size, 0));
+	for (size_t i = 0 ; i < 2*size ; i++) {
+		if (i >= IOC_POSIX_DIRECT_ALIGN && i < IOC_POSIX_DIRECT_ALIGN + size)
+			ASSERT_EQ(1, buffer[i]) << "i=" << i;
+		else
+			ASSERT_EQ(0, buffer[i]) << "i=" << i;
+	}
+
+	//free
+	free(buffer);
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, makeCowSegment)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	char buffer[3*4096];
+	memset(buffer, 1, sizeof(buffer));
+	EXPECT_EQ(sizeof(buffer), storage.pwrite(10, 20, buffer, sizeof(buffer), 0));
+
+	//cow a part
+	EXPECT_EQ(4096, storage.makeCowSegment(10, 20, 10, 21, 4096, 4096));
+
+	//check
+	memset(buffer, 2, sizeof(buffer));
+	EXPECT_EQ(sizeof(buffer), storage.pread(10, 21, buffer, sizeof(buffer), 0));
+	for (size_t i = 0 ; i < sizeof(buffer) ; i++) {
+		if (i >= 4096 && i < 2*4096)
+			ASSERT_EQ(1, buffer[i]) << "i=" << i;
+		else
+			ASSERT_EQ(0, buffer[i]) << "i=" << i;
+	}
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, max_open_files)
+{
+	//vars
+	StorageBackendPosix storage(this->directory, 4);
+	char buffer[64];
+
+	//write many objects
+	for (int i = 0 ; i < 16 ; i++) {
+		memset(buffer, i, sizeof(buffer));
+		EXPECT_EQ(sizeof(buffer), storage.pwrite(10, i, buffer, sizeof(buffer), 0));
+		EXPECT_LE(storage.getOpenFiles(), 4);
+	}
+
+	//read them back
+	for (int i = 0 ; i < 16 ; i++) {
+		EXPECT_EQ(sizeof(buffer), storage.pread(10, i, buffer, sizeof(buffer), 0));
+		EXPECT_EQ(i, buffer[0]);
+	}
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, max_open_files_submit)
+{
+	//vars
+	StorageBackendPosix storage(this->directory, 4);
+	char buffers[16][64];
+	StorageRequest requests[16];
+
+	//write many objects in one batch, the limit holds without polling
+	for (int i = 0 ; i < 16 ; i++) {
+		memset(buffers[i], i, sizeof(buffers[i]));
+		StorageBackend::setupRequest(requests[i], STORAGE_REQUEST_WRITE, 10, i, buffers[i], sizeof(buffers[i]), 0);
+	}
+	storage.submit(requests, 16);
+	storage.wait(requests, 16);
+	EXPECT_LE(storage.getOpenFiles(), 4);
+
+	//check
+	for (int i = 0 ; i < 16 ; i++) {
+		EXPECT_EQ(sizeof(buffers[i]), requests[i].status);
+		EXPECT_EQ(sizeof(buffers[i]), storage.pread(10, i, buffers[i], sizeof(buffers[i]), 0));
+		EXPECT_EQ(i, buffers[i][0]);
+		EXPECT_LE(storage.getOpenFiles(), 4);
+	}
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, submit_write_read)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	const size_t size = 4096;
+	char * buffers[8];
+	StorageRequest requests[8];
+
+	//write
+	for (int i = 0 ; i < 8 ; i++) {
+		ASSERT_EQ(0, posix_memalign((void**)&buffers[i], IOC_POSIX_DIRECT_ALIGN, size));
+		memset(buffers[i], 'a' + i, size);
+		StorageBackend::setupRequest(requests[i], STORAGE_REQUEST_WRITE, 10, 20, buffers[i], size, i * size);
+	}
+	storage.submit(requests, 8);
+	storage.wait(requests, 8);
+	for (int i = 0 ; i < 8 ; i++) {
+		EXPECT_TRUE(requests[i].done);
+		EXPECT_EQ(size, requests[i].status);
+	}
+
+	//read back, the last one crosses the end of file
+	int calls = 0;
+	for (int i = 0 ; i < 8 ; i++) {
+		memset(buffers[i], 0, size);
+		StorageBackend::setupRequest(requests[i], STORAGE_REQUEST_READ, 10, 20, buffers[i], size, (i + 1) * size);
+		requests[i].onComplete = [&calls](StorageRequest &) {calls++;};
+	}
+	storage.submit(requests, 8);
+	storage.wait(requests, 8);
+	EXPECT_EQ(8, calls);
+	for (int i = 0 ; i < 8 ; i++) {
+		EXPECT_EQ(size, requests[i].status);
+		EXPECT_EQ((i < 7) ? 'b' + i : 0, buffers[i][0]);
+		EXPECT_EQ((i < 7) ? 'b' + i : 0, buffers[i][size - 1]);
+	}
+
+	//free
+	for (int i = 0 ; i < 8 ; i++)
+		free(buffers[i]);
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, submit_read_missing)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	char buffer[64];
+	StorageRequest request;
+
+	//read
+	StorageBackend::setupRequest(request, STORAGE_REQUEST_READ, 10, 20, buffer, sizeof(buffer), 0);
+	storage.submit(&request, 1);
+	storage.wait(&request, 1);
+	EXPECT_TRUE(request.done);
+	EXPECT_EQ(-1, request.status);
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, pwritev)
+{
+	//vars
+	StorageBackendPosix storage(this->directory);
+	const size_t size = 4096;
+	char * buffers[3];
+	struct iovec iov[3];
+	for (int i = 0 ; i < 3 ; i++) {
+		ASSERT_EQ(0, posix_memalign((void**)&buffers[i], IOC_POSIX_DIRECT_ALIGN, size));
+		memset(buffers[i], 'a' + i, size);
+		iov[i].iov_base = buffers[i];
+		iov[i].iov_len = size;
+	}
+
+	//write aligned
+	EXPECT_EQ(3 * size, storage.pwritev(10, 20, iov, 3, 0));
+
+	//write unaligned with submit
+	iov[1].iov_len = 100;
+	StorageRequest request;
+	StorageBackend::setupRequestVec(request, 10, 20, iov, 3, 3 * size);
+	EXPECT_EQ(2 * size + 100, request.size);
+	storage.submit(&request, 1);
+	storage.wait(&request, 1);
+	EXPECT_EQ(2 * size + 100, request.status);
+
+	//read back
+	char * check = new char[6 * size];
+	EXPECT_EQ(5 * size + 100, storage.pread(10, 20, check, 5 * size + 100, 0));
+	EXPECT_EQ('a', check[0]);
+	EXPECT_EQ('b', check[size]);
+	EXPECT_EQ('c', check[3 * size - 1]);
+	EXPECT_EQ('a', check[3 * size]);
+	EXPECT_EQ('b', check[4 * size]);
+	EXPECT_EQ('b', check[4 * size + 99]);
+	EXPECT_EQ('c', check[4 * size + 100]);
+	EXPECT_EQ('c', check[5 * size + 99]);
+
+	//free
+	delete [] check;
+	for (int i = 0 ; i < 3 ; i++)
+		free(buffers[i]);
+}
+
+/****************************************************/
+TEST_F(TestStorageBackendPosix, threads)
+{
+	//vars
+	StorageBackendPosix storage(this->directory, 4);
+
+	//write many objects from many threads
+	std::vector<std::thread> threads;
+	for (int t = 0 ; t < 8 ; t++) {
+		threads.emplace_back([&storage, t](){
+			char buffer[64];
+			for (int i = 0 ; i < 32 ; i++) {
+				memset(buffer, t + i, sizeof(buffer));
+				EXPECT_EQ(sizeof(buffer), storage.pwrite(t, i, buffer, sizeof(buffer), 0));
+				EXPECT_EQ(sizeof(buffer), storage.pread(t, i, buffer, sizeof(buffer), 0));
+				EXPECT_EQ(t + i, buffer[sizeof(buffer) - 1]);
+			}
+		});
+	}
+	for (auto & it : threads)
+		it.join();
+
+	//files closed at the end
+	EXPECT_LE(storage.getOpenFiles(), 4);
+}
@@ -14,6 +14,7 @@
 //internal
 #include "base/common/Debug.hpp"
 #include "Config.hpp"
+#include "Consts.hpp"
 
 /****************************************************/
 using namespace IOC;
@@ -26,9 +27,29 @@ static char args_doc[] = "LISTEN_IP";
 static struct argp_option options[] = { 
 	{ "nvdimm", 'n', "PATH", 0, "Store data in nvdimm at the given PATH."},
 	{ "merofile", 'm', "PATH", 0, "Mero ressource file to use."},
+	{ "storage-dir", 's', "PATH", 0, "Store the objects as files in the given directory instead of Mero."},
 	{ "no-consistency-check", 'c', 0, 0, "Disable consistency check."},
 	{ "active-polling", 'p', 0, 0, "Enable active polling."},
 	{ "no-auth", 'a', 0, 0, "Disable client auth."},
+	{ "buddy", 'b', 0, 0, "Use a buddy allocator to cache the memory segments instead of exact size free lists (same as --cache=buddy)."},
+	{ "cache", 'K', "NAME", 0, "Cache used for the memory segments: 'exact' (exact size free lists, default), 'buddy' (buddy allocator) or 'concurrent' (exact size free lists with per thread magazines)."},
+	{ "cache-max", 'C', "SIZE_MB", 0, "Maximum free memory kept in the buddy cache (in MB), 0 for unlimited."},
+	{ "prefault-pool", 'P', "SIZE_MB", 0, "Reserve, prefault and register in background a pool of segments of the given size (in MB)."},
+	{ "dram-tier", 'T', "SIZE_MB", 0, "With nvdimm, keep the hot segments in a DRAM tier of the given size (in MB)."},
+	{ "max-memory", 'M', "SIZE_MB", 0, "Maximum memory used by the segments (in MB), over it the clients are asked to retry later. 0 for unlimited."},
+	{ "max-flush", 'F', "SIZE_MB", 0, "Maximum size of the writes merging the contiguous dirty segments on flush (in MB), 0 to disable."},
+	{ "flush-threads", 'f', "COUNT", 0, "Number of threads writing to the storage in parallel on flush (maximum concurrent writes), 0 to flush from the polling thread."},
+	{ "lazy-create", 'L', 0, 0, "Acknowledge the object creations immediately and create them in the storage in background or before their first flush which reports the errors."},
+	{ "wal", 'W', "PATH", 0, "Acknowledge the flush operations once the data are logged in a write ahead log at PATH (to be placed on NVDIMM) and write them to the storage in background."},
+	{ "flush-bw", 'B', "MB_PER_SEC", 0, "Limit the bandwidth of the flush operations to the storage (in MB/s), 0 for unlimited. Can be changed at runtime by the clients."},
+	{ "miss-bw", 'R', "MB_PER_SEC", 0, "Limit the bandwidth of the storage reads made on the client request misses (in MB/s), over it the clients are asked to retry later. 0 for unlimited."},
+	{ "recv-slabs", 'r', "COUNT", 0, "Number of receive slabs posted to get the client messages, many messages are packed in each slab."},
+	{ "recv-slab-size", 'S', "SIZE_MB", 0, "Size of each receive slab (in MB)."},
+	{ "cq-batch", 'q', "COUNT", 0, "Maximum number of completion entries read at once from the network completion queue."},
+	{ "eager-max", 'e', "SIZE_KB", 0, "Maximum size of the reads and writes sent in the messages instead of RDMA (in KB), the clients can ask for less. The receive buffers are sized from it."},
+	{ "rdma-chunk", 'k', "SIZE_KB", 0, "Split the reads larger than the given size (in KB) in chunks loaded from the storage while the previous ones are sent to the client, 0 to disable."},
+	{ "rdma-inflight", 'i', "COUNT", 0, "Maximum number of chunks of a split read being sent to the client at the same time."},
+	{ "credits", 'w', "COUNT", 0, "Maximum number of messages each client connection can send ahead of the server, bounded by the messages the receive slabs can hold. 0 to disable the flow control."},
 	{ "verbose", 'v', "CATEGORIES", 0, "Enable verbose mode and optionaly provide a filter. Can use 'all' or '*' or 'cat1,cat2...'."},
 	{ 0 } 
 };
@@ -79,6 +100,26 @@ static error_t parseOptions(int key, char *arg, struct argp_state *state) {
 		case 'p': config->activePolling = true; break;
 		case 'a': config->clientAuth = false; break;
 		case 'm': config->meroRcFile = arg; break;
+		case 's': config->storageDir = arg; break;
+		case 'b': config->cache = "buddy"; break;
+		case 'K': config->cache = arg; break;
+		case 'C': config->cacheMaxSize = atol(arg) * 1024UL * 1024UL; break;
+		case 'P': config->prefaultPoolSize = atol(arg) * 1024UL * 1024UL; break;
+		case 'T': config->dramTierSize = atol(arg) * 1024UL * 1024UL; break;
+		case 'M': config->maxMemory = atol(arg) * 1024UL * 1024UL; break;
+		case 'F': config->maxFlushSize = atol(arg) * 1024UL * 1024UL; break;
+		case 'f': config->flushThreads = atol(arg); break;
+		case 'L': config->lazyCreate = true; break;
+		case 'W': config->walPath = arg; break;
+		case 'B': config->flushBandwidth = atol(arg) * 1024UL * 1024UL; break;
+		case 'R': config->missBandwidth = atol(arg) * 1024UL * 1024UL; break;
+		case 'r': config->recvSlabs = atol(arg); break;
+		case 'S': config->recvSlabSize = atol(arg) * 1024UL * 1024UL; break;
+		case 'q': config->cqBatchSize = atol(arg); break;
+		case 'e': config->eagerMax = atol(arg) * 1024UL; break;
+		case 'k': config->rdmaChunkSize = atol(arg) * 1024UL; break;
+		case 'i': config->rdmaMaxInflight = atol(arg); break;
+		case 'w': config->credits = atol(arg); break;
 		case 'v':
 			if (arg == nullptr)
 				DAQ::Debug::enableAll();
@@ -105,10 +146,29 @@ Config::Config(void)
 {
 	this->listenIP = "";
 	this->meroRcFile = "mero_ressource_file.rc";
+	this->storageDir = "";
 	this->consistencyCheck = true;
 	this->clientAuth = true;
 	this->activePolling = true;
 	this->broadcastErrorToClients = false;
+	this->cache = "exact";
+	this->cacheMaxSize = 0;
+	this->prefaultPoolSize = 0;
+	this->dramTierSize = 0;
+	this->maxMemory = 0;
+	this->maxFlushSize = IOC_OBJECT_DEFAULT_MAX_FLUSH_SIZE;
+	this->flushThreads = 0;
+	this->lazyCreate = false;
+	this->walPath = "";
+	this->flushBandwidth = 0;
+	this->missBandwidth = 0;
+	this->recvSlabs = IOC_SERVER_DEFAULT_RECV_SLABS;
+	this->recvSlabSize = IOC_SERVER_DEFAULT_RECV_SLAB_SIZE;
+	this->cqBatchSize = IOC_SERVER_DEFAULT_CQ_BATCH;
+	this->eagerMax = IOC_SERVER_DEFAULT_EAGER_MAX;
+	this->rdmaChunkSize = IOC_SERVER_DEFAULT_RDMA_CHUNK;
+	this->rdmaMaxInflight = IOC_SERVER_DEFAULT_RDMA_INFLIGHT;
+	this->credits = IOC_SERVER_DEFAULT_CREDITS;
 }
 
 /****************************************************/
@@ -138,4 +198,12 @@ void Config::parseArgs(int argc, const char ** argv)
 		fprintf(stderr, "Usage: iocatcher-server {IP}\n");
 		exit(1);
 	}
+	if (this->cache != "exact" && this->cache != "buddy" && this->cache != "concurrent") {
+		fprintf(stderr, "Invalid cache (--cache) '%s', must be exact, buddy or concurrent\n", this->cache.c_str());
+		exit(1);
+	}
+	if (this->rdmaMaxInflight == 0) {
+		fprintf(stderr, "The number of chunks in flight (--rdma-inflight) must be at least 1\n");
+		exit(1);
+	}
 }
@@ -33,12 +33,50 @@ class Config
 		std::vector<std::string> nvdimmMountPath;
 		/** Mero ressource file. **/
 		std::string meroRcFile;
+		/** If not empty, store the objects as files in this directory (posix storage backend). **/
+		std::string storageDir;
 		/** Enable or disable consistency check by tracking the mappgins of clients. **/
 		bool consistencyCheck;
 		/** Enable or disable client authentication tracking **/
 		bool clientAuth;
 		/** Use active polling or passive polling. **/
 		bool activePolling;
+		/** Cache placed on top of the memory backends (exact, buddy or concurrent). **/
+		std::string cache;
+		/** Maximum free memory to keep in the buddy cache, 0 for no limit. **/
+		size_t cacheMaxSize;
+		/** Size of the pool of prefaulted memory to prepare in background, 0 to disable. **/
+		size_t prefaultPoolSize;
+		/** Size of the DRAM tier to place on top of the nvdimms, 0 to disable. **/
+		size_t dramTierSize;
+		/** Maximum memory to be used by the segments, 0 for no limit. **/
+		size_t maxMemory;
+		/** Maximum size of the writes merging contiguous dirty segments on flush, 0 to disable. **/
+		size_t maxFlushSize;
+		/** Number of threads writing to the storage in parallel on flush, 0 to flush from the polling thread. **/
+		size_t flushThreads;
+		/** Acknowledge the object creations immediately and create them in the storage in background or before their first flush. **/
+		bool lazyCreate;
+		/** If not empty, path prefix of the write ahead log used to acknowledge the flush operations before writing to the storage. **/
+		std::string walPath;
+		/** Bandwidth limit of the flush operations (in bytes per second), 0 for unlimited. **/
+		size_t flushBandwidth;
+		/** Bandwidth limit of the storage reads made on the client request misses (in bytes per second), 0 for unlimited. **/
+		size_t missBandwidth;
+		/** Number of receive slabs posted to get the client messages. **/
+		size_t recvSlabs;
+		/** Size of each receive slab. **/
+		size_t recvSlabSize;
+		/** Maximum number of completion entries read at once from the network completion queue. **/
+		size_t cqBatchSize;
+		/** Max size of the reads and writes made with the data in the messages instead of RDMA. **/
+		size_t eagerMax;
+		/** Size of the chunks of the large reads loaded and pushed with a pipeline, 0 to disable. **/
+		size_t rdmaChunkSize;
+		/** Maximum number of chunks of a pipelined read transferred at the same time. **/
+		size_t rdmaMaxInflight;
+		/** Maximum number of messages each client connection can send without waiting for the server, 0 to disable the flow control. **/
+		size_t credits;
 		/** On assume/fatal, boradcast the error message to the clients. To be disabled for unit tests. **/
 		bool broadcastErrorToClients;
 };
@@ -9,5 +9,27 @@
 
 /****************************************************/
 #define IOC_LF_MAX_RDMA_SEGS 4
+/** Alignement of the object segments used by the server. **/
+#define IOC_SERVER_SEGMENT_SIZE (8UL*1024UL*1024UL)
+/** Period between two runs of the maintenance tasks in the polling loop (in milliseconds). **/
+#define IOC_SERVER_PERIODIC_TASKS_MS 1000
+/** Default maximum size of a write made by flush() when merging contiguous dirty segments. **/
+#define IOC_OBJECT_DEFAULT_MAX_FLUSH_SIZE (64UL*1024UL*1024UL)
+/** Default burst of the bandwidth limits, in milliseconds of traffic at the configured rate. **/
+#define IOC_TOKEN_BUCKET_DEFAULT_BURST_MS 100
+/** Default number of receive slabs posted by the server. **/
+#define IOC_SERVER_DEFAULT_RECV_SLABS 16
+/** Default size of each receive slab of the server, many messages are packed in each of them. **/
+#define IOC_SERVER_DEFAULT_RECV_SLAB_SIZE (2UL*1024UL*1024UL)
+/** Default maximum number of completion entries read in one call by the server. **/
+#define IOC_SERVER_DEFAULT_CQ_BATCH 64
+/** Default max size of the reads and writes made with the data in the messages instead of RDMA. **/
+#define IOC_SERVER_DEFAULT_EAGER_MAX (32*1024)
+/** Default size of the chunks of the large reads loaded and pushed with a pipeline. **/
+#define IOC_SERVER_DEFAULT_RDMA_CHUNK (4UL*1024UL*1024UL)
+/** Default maximum number of chunks of a pipelined read transferred at the same time. **/
+#define IOC_SERVER_DEFAULT_RDMA_INFLIGHT 4
+/** Default maximum number of messages each client connection can send without waiting for the server. **/
+#define IOC_SERVER_DEFAULT_CREDITS 4
 
 #endif //IOC_CONSTS_HPP
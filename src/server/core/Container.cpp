@@ -20,6 +20,7 @@ Container::Container(StorageBackend * storageBackend, MemoryBackend * memBack, s
 	this->memoryBackend = memBack;
 	this->storageBackend = storageBackend;
 	this->objectSegmentsAlignement = objectSegmentsAlignement;
+	this->maxFlushSize = IOC_OBJECT_DEFAULT_MAX_FLUSH_SIZE;
 }
 
 /****************************************************/
@@ -62,6 +63,124 @@ void Container::setMemoryBackend(MemoryBackend * memoryBackend)
 		it.second->setMemoryBackend(memoryBackend);
 }
 
+/****************************************************/
+/**
+ * Append the memory of the segments of all objects to the given list.
+ * @param memories The list to fill.
+**/
+void Container::collectSegmentMemories(std::vector<std::shared_ptr<ObjectSegmentMemory>> & memories)
+{
+	for (auto & it: this->objects)
+		it.second->collectSegmentMemories(memories);
+}
+
+/****************************************************/
+/**
+ * Sum the load statistics of all the objects.
+ * @return The statistics of the objects currently in the container.
+**/
+ObjectLoadStats Container::getLoadStats(void)
+{
+	ObjectLoadStats res = {0, 0, 0, 0};
+	for (auto & it: this->objects) {
+		ObjectLoadStats stats = it.second->getLoadStats();
+		res.loads += stats.loads;
+		res.loadedBytes += stats.loadedBytes;
+		res.deduplicated += stats.deduplicated;
+		res.holes += stats.holes;
+	}
+	return res;
+}
+
+/****************************************************/
+/**
+ * Acknowledge the creation of an object and defer its creation in the
+ * storage so it can be made in a batch by applyPendingCreates() or at the
+ * latest before the first flush of the object.
+ * @param objectId The ID of the object to create.
+**/
+void Container::deferObjectCreate(const ObjectId & objectId)
+{
+	Object & object = this->getObject(objectId);
+	if (object.hasPendingCreate() == false) {
+		object.deferCreate();
+		this->pendingCreates.push_back(objectId);
+	}
+}
+
+/****************************************************/
+/**
+ * Create in the storage all the objects whose creation has been deferred.
+ * The errors are reported by the next flush of each object.
+ * @return The number of objects created.
+**/
+size_t Container::applyPendingCreates(void)
+{
+	//nothing to do
+	if (this->pendingCreates.empty())
+		return 0;
+
+	//create, the objects flushed in between are already done
+	size_t cnt = 0;
+	for (auto & it : this->pendingCreates) {
+		auto obj = this->objects.find(it);
+		if (obj != this->objects.end() && obj->second->hasPendingCreate()) {
+			obj->second->applyPendingCreate();
+			cnt++;
+		}
+	}
+
+	//clear
+	this->pendingCreates.clear();
+	return cnt;
+}
+
+/****************************************************/
+/**
+ * Flush the dirty segments of all the objects.
+ * @param throttled If not NULL, do not wait for the bandwidth limit and set
+ * it to true if it has been reached, the remaining objects are then not
+ * flushed. See Object::flush().
+ * @return 0 on success, -1 if one of the writes failed.
+**/
+int Container::flushAll(bool * throttled)
+{
+	int ret = 0;
+	for (auto & it: this->objects) {
+		if (it.second->flush(0, 0, throttled) != 0)
+			ret = -1;
+		if (throttled != NULL && *throttled)
+			break;
+	}
+	return ret;
+}
+
+/****************************************************/
+/**
+ * Flush the dirty segments of all the objects with the flush engine.
+ * @param engine The flush engine to use.
+ * @param onComplete Function called from the polling thread with the status
+ * (0 or -1) when all the writes are done. It can be called immediately if
+ * there is nothing to write.
+**/
+void Container::flushAllAsync(FlushEngine & engine, std::function<void(int status)> onComplete)
+{
+	//track the objects not yet completed, one more to not complete before the end of the loop
+	auto remaining = std::make_shared<size_t>(this->objects.size() + 1);
+	auto status = std::make_shared<int>(0);
+	auto onObjectComplete = [remaining, status, onComplete](int ret) {
+		if (ret != 0)
+			*status = -1;
+		if (--(*remaining) == 0)
+			onComplete(*status);
+	};
+
+	//flush
+	for (auto & it: this->objects)
+		it.second->flushAsync(0, 0, engine, onObjectComplete);
+	onObjectComplete(0);
+}
+
 /****************************************************/
 /**
  * Get an object from its object ID. If not found it will be created.
@@ -76,6 +195,8 @@ Object & Container::getObject(const ObjectId & objectId)
 	//if not found or found
 	if (it == objects.end()) {
 		Object * obj = new Object(this->storageBackend, this->memoryBackend, objectId, objectSegmentsAlignement);
+		obj->setMaxFlushSize(this->maxFlushSize);
+		obj->setThrottles(&this->flushThrottle, &this->missThrottle);
 		objects.emplace(objectId, obj);
 		return *obj;
 	} else {
@@ -121,6 +242,22 @@ void Container::setObjectSegmentsAlignement(size_t alignement)
 	this->objectSegmentsAlignement = alignement;
 }
 
+/****************************************************/
+/**
+ * Change the maximum size of the merged writes made when flushing the objects
+ * (also applied to all existing objects).
+ * @param maxFlushSize The maximum size, 0 to disable the merging.
+**/
+void Container::setMaxFlushSize(size_t maxFlushSize)
+{
+	//setup local
+	this->maxFlushSize = maxFlushSize;
+
+	//apply on existing objects
+	for (auto & it: this->objects)
+		it.second->setMaxFlushSize(maxFlushSize);
+}
+
 /****************************************************/
 /**
  * Make a copy on write operation on the given object on the given range.
@@ -153,6 +290,8 @@ bool Container::makeObjectRangeCow(const ObjectId & sourceId, const ObjectId &de
 		destObj = itDest->second;
 	} else {
 		objects[destId] = destObj = new Object(this->storageBackend, this->memoryBackend, destId, this->objectSegmentsAlignement);
+		destObj->setMaxFlushSize(this->maxFlushSize);
+		destObj->setThrottles(&this->flushThrottle, &this->missThrottle);
 	}
 
 	//apply cow on the given range
@@ -12,6 +12,7 @@
 #include <cstdlib>
 #include <map>
 #include "Object.hpp"
+#include "TokenBucket.hpp"
 #include "MemoryBackend.hpp"
 #include "StorageBackend.hpp"
 #include "../../base/network/LibfabricDomain.hpp"
@@ -36,13 +37,31 @@ class Container
 		bool makeObjectFullCow(const ObjectId & sourceId, const ObjectId &destId, bool allowExist);
 		void onClientDisconnect(uint64_t clientId);
 		void setObjectSegmentsAlignement(size_t alignement);
+		void setMaxFlushSize(size_t maxFlushSize);
+		TokenBucket & getFlushThrottle(void) {return this->flushThrottle;};
+		TokenBucket & getMissThrottle(void) {return this->missThrottle;};
 		void setStorageBackend(StorageBackend * storageBackend);
 		void setMemoryBackend(MemoryBackend * memoryBackend);
+		void collectSegmentMemories(std::vector<std::shared_ptr<ObjectSegmentMemory>> & memories);
+		ObjectLoadStats getLoadStats(void);
+		int flushAll(bool * throttled = NULL);
+		void deferObjectCreate(const ObjectId & objectId);
+		size_t applyPendingCreates(void);
+		size_t getPendingCreates(void) const {return this->pendingCreates.size();};
+		void flushAllAsync(FlushEngine & engine, std::function<void(int status)> onComplete);
 	private:
 		/** List ob objects identified by their object ID. **/
 		std::map<ObjectId, Object*> objects;
+		/** Objects whose creation in the storage has been deferred. **/
+		std::vector<ObjectId> pendingCreates;
 		/** We can force a minimal size for the object segments to get better performance. **/
 		size_t objectSegmentsAlignement;
+		/** Maximum size of the merged writes made when flushing the objects. **/
+		size_t maxFlushSize;
+		/** Bandwidth limit of the flush operations shared by all the objects. **/
+		TokenBucket flushThrottle;
+		/** Bandwidth limit of the loads made on the client request misses shared by all the objects. **/
+		TokenBucket missThrottle;
 		/** Keep track of the storage backend to use. **/
 		StorageBackend * storageBackend;
 		/** Keep track of the memory backend in use. **/
@@ -0,0 +1,230 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//internal
+#include "base/common/Debug.hpp"
+#include "FlushEngine.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the flush engine, it starts the worker threads.
+ * @param threads Number of worker threads, so maximum number of concurrent
+ * storage writes.
+**/
+FlushEngine::FlushEngine(size_t threads)
+{
+	//check
+	assume(threads > 0, "The flush engine needs at least one thread !");
+
+	//setup
+	this->pending = 0;
+	this->queuedBytes = 0;
+	this->stop = false;
+
+	//start the workers
+	for (size_t i = 0 ; i < threads ; i++)
+		this->workers.emplace_back([this](){
+			this->workerMain();
+		});
+}
+
+/****************************************************/
+/**
+ * Destructor of the flush engine, it completes the pending batches and
+ * stops the worker threads.
+**/
+FlushEngine::~FlushEngine(void)
+{
+	//finish the pending work
+	this->pollCompletions(true);
+
+	//stop the threads
+	{
+		std::lock_guard<std::mutex> lockGuard(this->mutex);
+		this->stop = true;
+	}
+	this->queueCond.notify_all();
+	for (auto & it : this->workers)
+		it.join();
+}
+
+/****************************************************/
+/**
+ * Submit a batch of write requests. The engine takes the ownership of the
+ * batch which is deleted after calling its completion function from
+ * pollCompletions().
+ * @param batch The batch to execute.
+**/
+void FlushEngine::submit(FlushBatch * batch)
+{
+	//check
+	assert(batch != NULL);
+	assert(batch->storageBackend != NULL);
+
+	//setup
+	batch->remaining = batch->requests.size();
+	batch->status = 0;
+
+	//enqueue
+	{
+		std::lock_guard<std::mutex> lockGuard(this->mutex);
+		this->pending++;
+		if (batch->requests.empty())
+			this->done.push_back(batch);
+		for (size_t i = 0 ; i < batch->requests.size() ; i++) {
+			this->queue.emplace_back(batch, i);
+			this->queuedBytes += batch->requests[i].size;
+		}
+	}
+
+	//wake up the workers
+	this->queueCond.notify_all();
+}
+
+/****************************************************/
+/**
+ * Run the given action from pollCompletions() once the next batches are
+ * completed. It is used to wait the writes in flight before starting a
+ * new flush of the same segments. It is called by the polling thread.
+ * @param action The action to run, it can defer itself again.
+**/
+void FlushEngine::defer(std::function<void(void)> action)
+{
+	this->deferred.push_back(std::move(action));
+}
+
+/****************************************************/
+/**
+ * Main function of the worker threads, it executes the requests one by one.
+**/
+void FlushEngine::workerMain(void)
+{
+	//lock
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	//loop
+	while (true) {
+		//wait work
+		this->queueCond.wait(lock, [this]{
+			return this->stop || this->queue.empty() == false;
+		});
+		if (this->queue.empty())
+			return;
+
+		//pop
+		FlushBatch * batch = this->queue.front().first;
+		StorageRequest & request = batch->requests[this->queue.front().second];
+		this->queue.pop_front();
+
+		//write out of the lock
+		lock.unlock();
+		if (batch->throttle != NULL)
+			batch->throttle->consume(request.size);
+		if (request.iov != NULL)
+			request.status = batch->storageBackend->pwritev(request.high, request.low, request.iov, request.iovcnt, request.offset);
+		else
+			request.status = batch->storageBackend->pwrite(request.high, request.low, request.buffer, request.size, request.offset);
+		request.done = true;
+		lock.lock();
+
+		//account
+		if (request.status != (ssize_t)request.size)
+			batch->status = -1;
+		this->queuedBytes -= request.size;
+		batch->remaining--;
+		if (batch->remaining == 0) {
+			this->done.push_back(batch);
+			this->doneCond.notify_all();
+		}
+	}
+}
+
+/****************************************************/
+/**
+ * Call the completion function of the finished batches and free them,
+ * then run the deferred actions. It is called by the polling thread.
+ * @param wait If true, wait until all the submitted batches are done,
+ * including the ones submitted by the deferred actions.
+ * @return The number of completed batches.
+**/
+size_t FlushEngine::pollCompletions(bool wait)
+{
+	//vars
+	size_t completed = 0;
+	bool hasPending = false;
+
+	do {
+		//extract
+		std::vector<FlushBatch*> batches;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			if (wait)
+				this->doneCond.wait(lock, [this]{
+					return this->done.size() == this->pending;
+				});
+			batches.swap(this->done);
+			this->pending -= batches.size();
+		}
+
+		//complete
+		for (auto & it : batches) {
+			if (it->onComplete)
+				it->onComplete(it->status);
+			delete it;
+		}
+		completed += batches.size();
+
+		//the writes they were waiting for might be done
+		if (batches.empty() == false && this->deferred.empty() == false) {
+			std::vector<std::function<void(void)>> actions;
+			actions.swap(this->deferred);
+			for (auto & it : actions)
+				it();
+		}
+
+		//check
+		hasPending = (this->getPending() > 0);
+	} while (wait && hasPending);
+
+	//ret
+	return completed;
+}
+
+/****************************************************/
+/**
+ * @return The number of worker threads.
+**/
+size_t FlushEngine::getThreads(void) const
+{
+	return this->workers.size();
+}
+
+/****************************************************/
+/**
+ * @return The number of batches submitted and not yet completed.
+**/
+size_t FlushEngine::getPending(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->pending;
+}
+
+/****************************************************/
+/**
+ * @return The amount of bytes submitted and not yet written, to report the
+ * flush progress.
+**/
+size_t FlushEngine::getQueuedBytes(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->queuedBytes;
+}
@@ -0,0 +1,112 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_FLUSH_ENGINE_HPP
+#define IOC_FLUSH_ENGINE_HPP
+
+/****************************************************/
+//std
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+//linux
+#include <sys/uio.h>
+//internal
+#include "StorageBackend.hpp"
+#include "ObjectSegment.hpp"
+#include "TokenBucket.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * A set of write requests to be executed by the flush engine and reported
+ * with a single completion, typically all the writes of an object flush.
+ * Without flush engine, Object::submitFlush() submits it directly to the
+ * asynchronous interface of the storage backend.
+**/
+struct FlushBatch
+{
+	/** The storage backend to write to. **/
+	StorageBackend * storageBackend;
+	/** The write requests to execute. **/
+	std::vector<StorageRequest> requests;
+	/** The buffer list used by the vectored requests. **/
+	std::vector<struct iovec> iovs;
+	/** Keep the segment memories alive until the writes are done. **/
+	std::vector<std::shared_ptr<ObjectSegmentMemory>> memories;
+	/** If not NULL, bandwidth limit to apply on the writes. **/
+	TokenBucket * throttle;
+	/** Called from pollCompletions() when all the requests are done with 0 or -1 if one failed. **/
+	std::function<void(int status)> onComplete;
+	/** Number of requests not yet executed. **/
+	size_t remaining;
+	/** Final status of the batch. **/
+	int status;
+};
+
+/****************************************************/
+/**
+ * The flush engine executes the storage writes of the flush operations
+ * with a pool of worker threads so independent segments and objects are
+ * written in parallel. The number of threads is the maximum number of
+ * concurrent storage writes of the server.
+ *
+ * The batches are submitted and completed from the polling thread, the
+ * workers only call the storage backend pwrite()/pwritev() which needs
+ * to be thread safe. If the batch has a throttle, the workers wait for
+ * its tokens before each write so the flush bandwidth is limited without
+ * blocking the polling thread.
+ *
+ * The actions which cannot start before the writes in flight are done
+ * (a flush of segments still being written) are deferred with defer() and
+ * run by pollCompletions() after completing the next batches.
+**/
+class FlushEngine
+{
+	public:
+		FlushEngine(size_t threads);
+		~FlushEngine(void);
+		void submit(FlushBatch * batch);
+		void defer(std::function<void(void)> action);
+		size_t pollCompletions(bool wait);
+		size_t getThreads(void) const;
+		size_t getPending(void);
+		size_t getQueuedBytes(void);
+	private:
+		void workerMain(void);
+	private:
+		/** The worker threads. **/
+		std::vector<std::thread> workers;
+		/** Requests waiting for a worker. **/
+		std::deque<std::pair<FlushBatch*, size_t>> queue;
+		/** Batches which are done and wait for pollCompletions(). **/
+		std::vector<FlushBatch*> done;
+		/** Number of batches submitted and not yet completed. **/
+		size_t pending;
+		/** Amount of bytes submitted and not yet written. **/
+		size_t queuedBytes;
+		/** Protect the queue, the done list and the batch counters. **/
+		std::mutex mutex;
+		/** Wake up the workers when there are requests. **/
+		std::condition_variable queueCond;
+		/** Notify pollCompletions(true) when a batch is done. **/
+		std::condition_variable doneCond;
+		/** Tell the workers to exit. **/
+		bool stop;
+		/** Actions waiting for the batches in flight, only accessed by the polling thread. **/
+		std::vector<std::function<void(void)>> deferred;
+};
+
+}
+
+#endif //IOC_FLUSH_ENGINE_HPP
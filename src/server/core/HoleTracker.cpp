@@ -0,0 +1,173 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+//internal
+#include "HoleTracker.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the hole tracker, nothing is known to be a hole.
+**/
+HoleTracker::HoleTracker(void)
+{
+}
+
+/****************************************************/
+/**
+ * Compute the end of a range, saturated to SIZE_MAX so the part after the
+ * end of an object can be registered with a size of SIZE_MAX.
+ * @param offset Offset of the range.
+ * @param size Size of the range.
+ * @return The end of the range (excluded).
+**/
+size_t HoleTracker::getEnd(size_t offset, size_t size)
+{
+	if (size > SIZE_MAX - offset)
+		return SIZE_MAX;
+	else
+		return offset + size;
+}
+
+/****************************************************/
+/**
+ * Register a range as a hole, it is merged with the overlapping and
+ * contiguous holes.
+ * @param offset Offset of the range.
+ * @param size Size of the range.
+**/
+void HoleTracker::addHole(size_t offset, size_t size)
+{
+	//nothing to do
+	if (size == 0)
+		return;
+
+	//vars
+	size_t start = offset;
+	size_t end = getEnd(offset, size);
+
+	//start from the previous one if it touches
+	auto it = this->holes.upper_bound(start);
+	if (it != this->holes.begin() && std::prev(it)->second >= start)
+		--it;
+
+	//merge
+	while (it != this->holes.end() && it->first <= end) {
+		start = std::min(start, it->first);
+		end = std::max(end, it->second);
+		it = this->holes.erase(it);
+	}
+
+	//insert
+	this->holes[start] = end;
+}
+
+/****************************************************/
+/**
+ * Remove a range from the holes when it is written.
+ * @param offset Offset of the range.
+ * @param size Size of the range.
+**/
+void HoleTracker::removeRange(size_t offset, size_t size)
+{
+	//nothing to do
+	if (size == 0 || this->holes.empty())
+		return;
+
+	//vars
+	size_t start = offset;
+	size_t end = getEnd(offset, size);
+
+	//start from the previous one if it overlaps
+	auto it = this->holes.upper_bound(start);
+	if (it != this->holes.begin() && std::prev(it)->second > start)
+		--it;
+
+	//cut, keeping the parts before and after
+	size_t beforeStart = 0;
+	size_t afterEnd = 0;
+	bool hasBefore = false;
+	bool hasAfter = false;
+	while (it != this->holes.end() && it->first < end) {
+		if (it->first < start) {
+			beforeStart = it->first;
+			hasBefore = true;
+		}
+		if (it->second > end) {
+			afterEnd = it->second;
+			hasAfter = true;
+		}
+		it = this->holes.erase(it);
+	}
+
+	//insert remaining parts
+	if (hasBefore)
+		this->holes[beforeStart] = start;
+	if (hasAfter)
+		this->holes[end] = afterEnd;
+}
+
+/****************************************************/
+/**
+ * Check if the given range is fully covered by a hole.
+ * @param offset Offset of the range.
+ * @param size Size of the range.
+ * @return True if the range contains only zeros on the storage.
+**/
+bool HoleTracker::isHole(size_t offset, size_t size) const
+{
+	//search the hole starting before
+	auto it = this->holes.upper_bound(offset);
+	if (it == this->holes.begin())
+		return false;
+	--it;
+
+	//check it covers, they are merged so one has to cover all
+	return it->second >= getEnd(offset, size);
+}
+
+/****************************************************/
+/**
+ * Forget all the holes.
+**/
+void HoleTracker::clear(void)
+{
+	this->holes.clear();
+}
+
+/****************************************************/
+/**
+ * @return The number of separated holes tracked.
+**/
+size_t HoleTracker::getCount(void) const
+{
+	return this->holes.size();
+}
+
+/****************************************************/
+/**
+ * Check if a buffer contains only zeros. It compares the buffer with itself
+ * shifted by one byte to exploit the optimized memcmp().
+ * @param buffer The buffer to check.
+ * @param size Size of the buffer.
+ * @return True if all the bytes are zero.
+**/
+bool HoleTracker::isZero(const char * buffer, size_t size)
+{
+	if (size == 0)
+		return true;
+	if (buffer[0] != 0)
+		return false;
+	return memcmp(buffer, buffer + 1, size - 1) == 0;
+}
@@ -0,0 +1,48 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_HOLE_TRACKER_HPP
+#define IOC_HOLE_TRACKER_HPP
+
+/****************************************************/
+//std
+#include <cstdlib>
+#include <map>
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Track the ranges of an object known to contain only zeros on the storage
+ * (never written ranges, holes of a sparse file...) so they can be served
+ * without reading the storage. The ranges are merged when they overlap or
+ * touch so a range is a hole if it is fully covered by a single entry.
+ *
+ * The tracker is not thread safe, the object protects it with its load
+ * mutex.
+**/
+class HoleTracker
+{
+	public:
+		HoleTracker(void);
+		void addHole(size_t offset, size_t size);
+		void removeRange(size_t offset, size_t size);
+		bool isHole(size_t offset, size_t size) const;
+		void clear(void);
+		size_t getCount(void) const;
+		static bool isZero(const char * buffer, size_t size);
+	private:
+		static size_t getEnd(size_t offset, size_t size);
+	private:
+		/** The holes identified by their offset with their end (excluded) as value. **/
+		std::map<size_t, size_t> holes;
+};
+
+}
+
+#endif //IOC_HOLE_TRACKER_HPP
@@ -6,6 +6,7 @@
 
 /****************************************************/
 //internal
+#include "base/common/Debug.hpp"
 #include "MemoryBackend.hpp"
 
 /****************************************************/
@@ -39,3 +40,38 @@ LibfabricDomain * MemoryBackend::getLfDomain(void)
 {
 	return this->lfDomain;
 }
+
+/****************************************************/
+/**
+ * Return the cached but unused memory to the lower layers. By default
+ * there is no cache so it does nothing.
+ * @return The amount of memory released.
+**/
+size_t MemoryBackend::trim(void)
+{
+	return 0;
+}
+
+/****************************************************/
+/**
+ * Allocate memory and in case of failure trim the caches and retry once.
+ * This is used by the objects to survive to a memory pressure before
+ * reporting the failure to the client.
+ * @param size Size of the memory to allocate.
+ * @return The address of the memory or NULL if still out of memory.
+**/
+void * MemoryBackend::allocateWithTrim(size_t size)
+{
+	//try
+	void * ptr = this->allocate(size);
+	if (ptr != NULL)
+		return ptr;
+
+	//trim & retry
+	size_t released = this->trim();
+	IOC_DEBUG_ARG("memory", "Out of memory when allocating %1, trimmed %2 and retry")
+		.argUnit1024(size)
+		.argUnit1024(released)
+		.end();
+	return this->allocate(size);
+}
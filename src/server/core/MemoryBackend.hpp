@@ -30,6 +30,8 @@ class MemoryBackend
 		virtual ~MemoryBackend(void);
 		virtual void * allocate(size_t size) = 0;
 		virtual void deallocate(void * addr, size_t size) = 0;
+		virtual size_t trim(void);
+		void * allocateWithTrim(size_t size);
 		LibfabricDomain * getLfDomain(void);
 	protected:
 		/** Keep track of the libfabric domain for memory registration/deregistration. **/
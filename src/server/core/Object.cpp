@@ -35,7 +35,33 @@ Object::Object(StorageBackend * storageBackend, MemoryBackend * memBack, const O
 	this->memoryBackend = memBack;
 	this->storageBackend = storageBackend;
 	this->alignement = alignement;
+	this->maxFlushSize = IOC_OBJECT_DEFAULT_MAX_FLUSH_SIZE;
+	this->flushThrottle = NULL;
+	this->missThrottle = NULL;
+	this->createPending = false;
+	this->createError = 0;
+	this->loadStats = ObjectLoadStats{0, 0, 0, 0};
+	this->holesQueried = false;
 	this->objectId = objectId;
+	this->alive = std::make_shared<bool>(true);
+	this->submittedFlushes = 0;
+}
+
+/****************************************************/
+/**
+ * Destructor of the object. The loads and flushes still in flight complete
+ * without touching it.
+**/
+Object::~Object(void)
+{
+	//mark
+	*this->alive = false;
+
+	//fail the flushes waiting for the ones in flight
+	std::vector<std::function<void(bool alive)>> waiters;
+	waiters.swap(this->flushWaiters);
+	for (auto & it : waiters)
+		it(false);
 }
 
 /****************************************************/
@@ -55,6 +81,8 @@ const ObjectId & Object::getObjectId(void)
 void Object::setStorageBackend(StorageBackend * storageBackend)
 {
 	this->storageBackend = storageBackend;
+	this->holes.clear();
+	this->holesQueried = false;
 }
 
 /****************************************************/
@@ -67,6 +95,19 @@ void Object::setMemoryBackend(MemoryBackend * memoryBackend)
 	this->memoryBackend = memoryBackend;
 }
 
+/****************************************************/
+/**
+ * Append the memory of all the segments to the given list. This is used
+ * by the memory backends which need to move segments (see
+ * MemoryBackendTiered). Segments shared by COW appear once per sharer.
+ * @param memories The list to fill.
+**/
+void Object::collectSegmentMemories(std::vector<std::shared_ptr<ObjectSegmentMemory>> & memories)
+{
+	for (auto & it : this->segmentMap)
+		memories.push_back(it.second.getMemory());
+}
+
 /****************************************************/
 /**
  * Mark a given range as dirty.
@@ -78,6 +119,9 @@ void Object::setMemoryBackend(MemoryBackend * memoryBackend)
 **/
 void Object::markDirty(size_t base, size_t size)
 {
+	//the range will be written to the storage so it is not a hole anymore
+	this->holes.removeRange(base, size);
+
 	//extract
 	for (auto & it : this->segmentMap) {
 		//if overlap
@@ -98,6 +142,30 @@ void Object::forceAlignement(size_t alignment)
 	this->alignement = alignment;
 }
 
+/****************************************************/
+/**
+ * Change the maximum size of the writes made by flush() when merging the
+ * contiguous dirty segments.
+ * @param maxFlushSize The maximum size, 0 to not merge the segments.
+**/
+void Object::setMaxFlushSize(size_t maxFlushSize)
+{
+	this->maxFlushSize = maxFlushSize;
+}
+
+/****************************************************/
+/**
+ * Set the bandwidth limits to apply on the storage operations. They are
+ * shared by all the objects of the container.
+ * @param flushThrottle Limit of the writes made by flush(), NULL for unlimited.
+ * @param missThrottle Limit of the reads loading the missing segments, NULL for unlimited.
+**/
+void Object::setThrottles(TokenBucket * flushThrottle, TokenBucket * missThrottle)
+{
+	this->flushThrottle = flushThrottle;
+	this->missThrottle = missThrottle;
+}
+
 /****************************************************/
 /**
  * Check if the object is fully overlapped by the requested range.
@@ -128,173 +196,1040 @@ bool Object::isFullyOverlapped(size_t segOffset, size_t segSize, size_t reqOffse
  * we want to report error on a read operation. Also on write op we load the data from
  * storage only if the loaded segment is larger than the requested range (in other word
  * if due to alignement the caller will not write the full segment).
- * @return True if OK, false in case it fails to read content while creating the segments.
+ * @param status If not NULL, filled with the reason of the failure so the caller
+ * can ask the client to retry later when the memory is exhausted.
+ * @return True if OK, false in case it fails to read content or to allocate
+ * the memory while creating the segments.
+ * If a missing range is being loaded by loadAsync(), this load is completed
+ * and reused instead of reading the range again from the storage. The ranges
+ * known to be holes (new object, sparse file, previous read of zeros) are
+ * filled with zeros without reading the storage.
 **/
-bool Object::getBuffers(ObjectSegmentList & segments, size_t base, size_t size, ObjectAccessMode accessMode, bool load, bool isForWriteOp)
+bool Object::getBuffers(ObjectSegmentList & segments, size_t base, size_t size, ObjectAccessMode accessMode, bool load, bool isForWriteOp, ObjectBuffersStatus * status)
 {
+	//default status
+	if (status != NULL)
+		*status = OBJECT_BUFFERS_OK;
+
+	//create before loading if deferred, the storage is read only if the object already existed
+	if (load && this->createPending)
+		this->applyPendingCreate();
+
 	//keep orig range
 	size_t origBase = base;
 	size_t origSize = size;
 
 	//align
-	if (this->alignement > 0)  {
-		size += base % alignement;
-		base -= base % alignement;
-		if (size % alignement > 0)
-			size += alignement - (size % alignement);
+	this->alignRange(base, size);
+
+	//extract & search the missing ranges until none of them is being loaded by loadAsync()
+	std::vector<ObjectSegmentDescr> missing;
+	std::vector<bool> needLoad;
+	bool waited = false;
+	while (true) {
+		//extract
+		for (auto it = this->segmentMap.lower_bound(base) ; it != this->segmentMap.end() && it->second.overlap(base, size) ; ++it) {
+			//to ease access
+			ObjectSegment & segment = it->second;
+
+			//if overlap
+			if (segment.overlap(base, size)) {
+				//check if need to cow
+				if (accessMode == ACCESS_WRITE && segment.isCow()) {
+					if (segment.applyCow() == false) {
+						segments.clear();
+						if (status != NULL)
+							*status = OBJECT_BUFFERS_NO_MEMORY;
+						return false;
+					}
+				}
+
+				//add to list
+				segment.touch();
+				segments.push_back(segment.getSegmentDescr());
+			}
+		}
+
+		//search the missing ranges
+		this->searchMissingRanges(segments, base, size, origBase, origSize, load, isForWriteOp, missing, needLoad);
+
+		//nobody is loading them
+		ObjectLoadRange * inFlight = this->findLoadInFlight(missing);
+		if (inFlight == NULL)
+			break;
+
+		//complete the other load and search again
+		if (waited == false)
+			this->loadStats.deduplicated++;
+		waited = true;
+		segments.clear();
+		missing.clear();
+		needLoad.clear();
+		std::shared_ptr<ObjectLoad> other = inFlight->load;
+		this->storageBackend->wait(other->requests.data(), other->requests.size());
 	}
 
-	//extract
-	for (auto it = this->segmentMap.lower_bound(base) ; it != this->segmentMap.end() && it->second.overlap(base, size) ; ++it) {
-		//to ease access
-		ObjectSegment & segment = it->second;
+	//load them all in one batch
+	if (missing.empty() == false) {
+		//serve the known holes with zeros instead of reading the storage
+		std::vector<bool> zero;
+		this->skipKnownHoles(missing, needLoad, zero);
+
+		//load
+		bool loaded = this->loadSegments(missing, needLoad, isForWriteOp, status);
+
+		//fill the holes & learn the ones read as zeros (failed reads are accepted on write ops so do not trust them)
+		std::vector<bool> learned(missing.size(), false);
+		for (size_t i = 0 ; i < missing.size() && loaded ; i++) {
+			if (zero[i])
+				memset(missing[i].ptr, 0, missing[i].size);
+			else if (needLoad[i] && this->storageBackend != NULL && isForWriteOp == false)
+				learned[i] = HoleTracker::isZero(missing[i].ptr, missing[i].size);
+		}
 
-		//if overlap
-		if (segment.overlap(base, size)) {
-			//check if need to cow
-			if (accessMode == ACCESS_WRITE && segment.isCow())
-				segment.applyCow();
+		//error
+		if (loaded == false) {
+			segments.clear();
+			return false;
+		}
+
+		//register
+		this->registerSegments(missing);
+		for (size_t i = 0 ; i < missing.size() ; i++) {
+			segments.push_back(missing[i]);
+			if (needLoad[i] && this->storageBackend != NULL) {
+				this->loadStats.loads++;
+				this->loadStats.loadedBytes += missing[i].size;
+			}
+			if (zero[i])
+				this->loadStats.holes++;
+			if (learned[i])
+				this->holes.addHole(missing[i].offset, missing[i].size);
+		}
+	}
+
+	//sort
+	segments.sort();
+
+	//ok
+	return true;
+}
+
+/****************************************************/
+/**
+ * Make sure the given range is in memory without waiting the storage. The
+ * missing ranges are read with the asynchronous interface of the storage
+ * backend and registered when the reads complete, from the
+ * StorageBackend::pollCompletions() of the polling loop. A request missing a
+ * range already being loaded waits for this load instead of reading it
+ * again. The caller then gets the segments with getBuffers() which fills
+ * the known holes and the ranges not to be loaded without reading the storage.
+ * It must be called from the polling thread.
+ * @param base The base address of the range to consider.
+ * @param size The size of the range to consider.
+ * @param isForWriteOp Same semantic than for getBuffers(), the failed reads
+ * are then accepted and replaced by zeros.
+ * @param onLoaded Function called with the status once the range is in memory
+ * or the load failed. It is called immediately if nothing has to be read. The
+ * bandwidth limit of the misses is applied so it can get OBJECT_BUFFERS_THROTTLED.
+ * On OBJECT_BUFFERS_LOAD_ERROR the object may have been destroyed meanwhile
+ * so it must not be accessed anymore.
+**/
+void Object::loadAsync(size_t base, size_t size, bool isForWriteOp, ObjectLoadCallback onLoaded)
+{
+	//nothing to load
+	if (this->storageBackend == NULL) {
+		onLoaded(OBJECT_BUFFERS_OK);
+		return;
+	}
+
+	//create before loading if deferred, the storage is read only if the object already existed
+	if (this->createPending)
+		this->applyPendingCreate();
+
+	//keep orig range & align
+	size_t origBase = base;
+	size_t origSize = size;
+	this->alignRange(base, size);
+
+	//search the missing ranges
+	ObjectSegmentList segments;
+	for (auto it = this->segmentMap.lower_bound(base) ; it != this->segmentMap.end() && it->second.overlap(base, size) ; ++it)
+		segments.push_back(it->second.getSegmentDescr());
+	std::vector<ObjectSegmentDescr> missing;
+	std::vector<bool> needLoad;
+	this->searchMissingRanges(segments, base, size, origBase, origSize, true, isForWriteOp, missing, needLoad);
+
+	//wait the load in flight on the same ranges and search again after
+	ObjectLoadRange * inFlight = this->findLoadInFlight(missing);
+	if (inFlight != NULL) {
+		assert(inFlight->load);
+		this->loadStats.deduplicated++;
+		std::shared_ptr<bool> alive = this->alive;
+		inFlight->load->waiters.push_back([this, alive, origBase, origSize, isForWriteOp, onLoaded](ObjectBuffersStatus status) {
+			if (*alive)
+				this->loadAsync(origBase, origSize, isForWriteOp, onLoaded);
+			else
+				onLoaded(OBJECT_BUFFERS_LOAD_ERROR);
+		});
+		return;
+	}
+
+	//keep only the ranges to read from the storage, getBuffers() makes the others
+	std::vector<bool> zero;
+	this->skipKnownHoles(missing, needLoad, zero);
+	std::shared_ptr<ObjectLoad> load = std::make_shared<ObjectLoad>();
+	for (size_t i = 0 ; i < missing.size() ; i++)
+		if (needLoad[i])
+			load->ranges.push_back(missing[i]);
+
+	//nothing to read
+	if (load->ranges.empty()) {
+		onLoaded(OBJECT_BUFFERS_OK);
+		return;
+	}
+
+	//apply the bandwidth limit of the misses
+	size_t loadSize = 0;
+	for (auto & it : load->ranges)
+		loadSize += it.size;
+	if (this->missThrottle != NULL && this->missThrottle->tryConsume(loadSize) == false) {
+		IOC_DEBUG_ARG("object", "Throttle load of %1").argUnit1024(loadSize).end();
+		onLoaded(OBJECT_BUFFERS_THROTTLED);
+		return;
+	}
+
+	//allocate memory
+	for (auto & it : load->ranges) {
+		it.ptr = (char*)this->memoryBackend->allocateWithTrim(it.size);
+		if (it.ptr == NULL) {
+			IOC_DEBUG_ARG("object", "Out of memory while allocating segment of %1").argUnit1024(it.size).end();
+			this->releaseSegments(load->ranges);
+			onLoaded(OBJECT_BUFFERS_NO_MEMORY);
+			return;
+		}
+	}
+
+	//build the reads, they keep the load alive until they complete
+	std::shared_ptr<bool> alive = this->alive;
+	load->remaining = load->ranges.size();
+	load->acceptLoadFail = isForWriteOp;
+	load->memoryBackend = this->memoryBackend;
+	load->waiters.push_back(onLoaded);
+	load->requests.resize(load->ranges.size());
+	for (size_t i = 0 ; i < load->ranges.size() ; i++) {
+		StorageRequest & request = load->requests[i];
+		StorageBackend::setupRequest(request, STORAGE_REQUEST_READ, this->objectId.high, this->objectId.low, load->ranges[i].ptr, load->ranges[i].size, load->ranges[i].offset);
+		request.onComplete = [this, alive, load](StorageRequest & request) {
+			if (--load->remaining > 0)
+				return;
+			if (*alive) {
+				this->onLoadDone(*load);
+			} else {
+				for (auto & it : load->ranges)
+					load->memoryBackend->deallocate(it.ptr, it.size);
+				for (auto & it : load->waiters)
+					it(OBJECT_BUFFERS_LOAD_ERROR);
+			}
+		};
+	}
+
+	//mark in flight & submit
+	for (auto & it : load->ranges)
+		this->inFlightLoads[it.offset] = ObjectLoadRange{it.size, load};
+	this->storageBackend->submit(load->requests.data(), load->requests.size());
+}
 
-			//add to list
-			segments.push_back(segment.getSegmentDescr());
+/****************************************************/
+/**
+ * Called when all the reads of a load made by loadAsync() are done. It
+ * registers the segments and calls the functions waiting for them.
+ * @param load The completed load.
+**/
+void Object::onLoadDone(ObjectLoad & load)
+{
+	//check the reads, the failed ones are accepted on write ops as the object may not exist yet
+	ObjectBuffersStatus status = OBJECT_BUFFERS_OK;
+	std::vector<bool> learned(load.ranges.size(), false);
+	for (size_t i = 0 ; i < load.ranges.size() ; i++) {
+		if (load.requests[i].status != (ssize_t)load.ranges[i].size) {
+			if (load.acceptLoadFail)
+				memset(load.ranges[i].ptr, 0, load.ranges[i].size);
+			else
+				status = OBJECT_BUFFERS_LOAD_ERROR;
+		} else if (load.acceptLoadFail == false) {
+			learned[i] = HoleTracker::isZero(load.ranges[i].ptr, load.ranges[i].size);
 		}
 	}
 
-	//complete
+	//register
+	for (auto & it : load.ranges)
+		this->inFlightLoads.erase(it.offset);
+	if (status == OBJECT_BUFFERS_OK) {
+		this->registerSegments(load.ranges);
+		for (size_t i = 0 ; i < load.ranges.size() ; i++) {
+			this->loadStats.loads++;
+			this->loadStats.loadedBytes += load.ranges[i].size;
+			if (learned[i])
+				this->holes.addHole(load.ranges[i].offset, load.ranges[i].size);
+		}
+	} else {
+		this->releaseSegments(load.ranges);
+	}
+
+	//wake up
+	std::vector<ObjectLoadCallback> waiters;
+	waiters.swap(load.waiters);
+	for (auto & it : waiters)
+		it(status);
+}
+
+/****************************************************/
+/**
+ * Wait the completion of the loads made by loadAsync(). It is used with the
+ * passive polling as the polling loop does not check the storage completions
+ * before the next network event.
+**/
+void Object::waitLoads(void)
+{
+	while (this->inFlightLoads.empty() == false) {
+		std::shared_ptr<ObjectLoad> load = this->inFlightLoads.begin()->second.load;
+		this->storageBackend->wait(load->requests.data(), load->requests.size());
+	}
+}
+
+/****************************************************/
+/**
+ * Align a range on the segment alignement of the object.
+ * @param base The base offset to align.
+ * @param size The size to extend so the aligned range covers the original one.
+**/
+void Object::alignRange(size_t & base, size_t & size)
+{
+	if (this->alignement > 0)  {
+		size += base % alignement;
+		base -= base % alignement;
+		if (size % alignement > 0)
+			size += alignement - (size % alignement);
+	}
+}
+
+/****************************************************/
+/**
+ * Search the ranges not covered by the given segments.
+ * @param segments The segments of the object overlapping the aligned range, sorted by offset.
+ * @param base Base of the aligned range.
+ * @param size Size of the aligned range.
+ * @param origBase Base of the range requested by the caller.
+ * @param origSize Size of the range requested by the caller.
+ * @param load Same semantic than for getBuffers().
+ * @param isForWriteOp Same semantic than for getBuffers().
+ * @param missing The list of missing ranges to fill.
+ * @param needLoad Filled with true for each missing range to read from the storage.
+**/
+void Object::searchMissingRanges(const ObjectSegmentList & segments, size_t base, size_t size, size_t origBase, size_t origSize, bool load, bool isForWriteOp, std::vector<ObjectSegmentDescr> & missing, std::vector<bool> & needLoad)
+{
+	//between the segments
 	size_t lastOffset = base;
-	ObjectSegmentList tmp;
-	for (auto it : segments) {
+	for (auto & it : segments) {
 		if (it.offset > lastOffset) {
 			size_t size = it.offset - lastOffset;
-			bool needLoad = load;
-			if (isForWriteOp && isFullyOverlapped(lastOffset, size, origBase, origSize))
-				needLoad = false;
-			ObjectSegmentDescr descr = this->loadSegment(lastOffset, size, needLoad, isForWriteOp);
-			if (descr.ptr == NULL) {
-				segments.clear();
-				return false;
-			}
-			tmp.push_back(descr);
+			missing.push_back(ObjectSegmentDescr{NULL, lastOffset, size});
+			needLoad.push_back(load && !(isForWriteOp && isFullyOverlapped(lastOffset, size, origBase, origSize)));
 		}
 		lastOffset = it.offset + it.size;
 	}
 
-	//merge list
-	for (auto it : tmp)
-		segments.push_back(it);
-
-	//load last
+	//last one
 	size_t endOffset = base + size;
 	if (lastOffset < endOffset) {
 		size_t size = endOffset - lastOffset;
-		bool needLoad = load;
-		if (isForWriteOp && isFullyOverlapped(lastOffset, size, origBase, origSize))
-			needLoad = false;
-		ObjectSegmentDescr descr = this->loadSegment(lastOffset, size, needLoad, isForWriteOp);
-		if (descr.ptr == NULL) {
-			segments.clear();
-			return false;
+		missing.push_back(ObjectSegmentDescr{NULL, lastOffset, size});
+		needLoad.push_back(load && !(isForWriteOp && isFullyOverlapped(lastOffset, size, origBase, origSize)));
+	}
+}
+
+/****************************************************/
+/**
+ * Check which missing ranges are known holes (new object, sparse file,
+ * previous read of zeros) to fill them with zeros instead of reading the
+ * storage. The storage is asked once for the holes of the object. The load
+ * mutex must be held.
+ * @param missing The missing ranges.
+ * @param needLoad Reset to false for the known holes.
+ * @param zero Filled with true for each known hole.
+**/
+void Object::skipKnownHoles(const std::vector<ObjectSegmentDescr> & missing, std::vector<bool> & needLoad, std::vector<bool> & zero)
+{
+	zero.assign(missing.size(), false);
+	if (this->storageBackend == NULL)
+		return;
+	for (size_t i = 0 ; i < missing.size() ; i++) {
+		if (needLoad[i] && this->holesQueried == false) {
+			this->holesQueried = true;
+			this->storageBackend->findHoles(this->objectId.high, this->objectId.low, this->holes);
+		}
+		if (needLoad[i] && this->holes.isHole(missing[i].offset, missing[i].size)) {
+			needLoad[i] = false;
+			zero[i] = true;
 		}
-		segments.push_back(descr);
 	}
+}
 
-	//sort
-	segments.sort();
+/****************************************************/
+/**
+ * Search a load in flight overlapping one of the given ranges.
+ * @param ranges The ranges to check.
+ * @return The first overlapping range being loaded or NULL if none.
+**/
+ObjectLoadRange * Object::findLoadInFlight(const std::vector<ObjectSegmentDescr> & ranges)
+{
+	//nothing in flight
+	if (this->inFlightLoads.empty())
+		return NULL;
+
+	//check each range
+	for (auto & range : ranges) {
+		//first load starting after the range start, the previous one can also overlap
+		auto it = this->inFlightLoads.upper_bound(range.offset);
+		if (it != this->inFlightLoads.begin()) {
+			auto prev = std::prev(it);
+			if (prev->first + prev->second.size > range.offset)
+				return &prev->second;
+		}
+		if (it != this->inFlightLoads.end() && it->first < range.offset + range.size)
+			return &it->second;
+	}
 
 	//ok
-	return true;
+	return NULL;
 }
 
 /****************************************************/
 /**
- * Load a segment for the given range. It will allocated its memory (on nvdimm if enabled),
- * then load the data from mero if enabled and register the segment to the libfabric 
- * domain for RDMA operations.
- * @param offset Offset of the range to consider.
- * @param size Size of the range to consider.
- * @param load If need to load data from mero.
+ * Load the segments for the given ranges. It allocates their memory (on nvdimm if enabled),
+ * then loads the data from the storage if enabled. The segments are registered
+ * in the object by the caller with registerSegments().
+ * All the reads are submitted in one batch to the storage backend so they can be
+ * made in parallel.
+ * @param ranges The ranges to load, the pointers are filled on success.
+ * @param load Tell for each range if we need to load the data from the storage.
  * @param acceptLoadFail This option is used on a first write access if the write
  * we first load the old data before overriting it. But as it is a write op we
  * do not fail if the load operation fails.
- * @return The loaded object segment.
+ * @param status If not NULL, filled with the reason of the failure.
+ * The bandwidth limit of the misses is applied only when it is given and the
+ * function then fails with OBJECT_BUFFERS_THROTTLED if the limit is reached.
+ * @return False in case of failure, none of the segments is then registered.
 **/
-ObjectSegmentDescr Object::loadSegment(size_t offset, size_t size, bool load, bool acceptLoadFail)
+bool Object::loadSegments(std::vector<ObjectSegmentDescr> & ranges, const std::vector<bool> & load, bool acceptLoadFail, ObjectBuffersStatus * status)
 {
+	//check
+	assert(ranges.size() == load.size());
+
 	//allocate memory
-	char* buffer = (char*)this->memoryBackend->allocate(size);
+	for (size_t i = 0 ; i < ranges.size() ; i++) {
+		ranges[i].ptr = (char*)this->memoryBackend->allocateWithTrim(ranges[i].size);
+		if (ranges[i].ptr == NULL) {
+			IOC_DEBUG_ARG("object", "Out of memory while allocating segment of %1").argUnit1024(ranges[i].size).end();
+			this->releaseSegments(ranges);
+			if (status != NULL)
+				*status = OBJECT_BUFFERS_NO_MEMORY;
+			return false;
+		}
+	}
 
 	//load data
-	if (load) {
-		size_t status = this->pread(buffer, size, offset);
-		//if fail to read
-		if (status != size && !acceptLoadFail) {
-			this->memoryBackend->deallocate(buffer, size);
-			ObjectSegmentDescr errDescr = {
-				NULL,
-				0,
-				0
-			};
-			return errDescr;
+	if (this->storageBackend != NULL) {
+		//build requests
+		std::vector<StorageRequest> requests;
+		requests.reserve(ranges.size());
+		for (size_t i = 0 ; i < ranges.size() ; i++) {
+			if (load[i]) {
+				requests.emplace_back();
+				StorageBackend::setupRequest(requests.back(), STORAGE_REQUEST_READ, this->objectId.high, this->objectId.low, ranges[i].ptr, ranges[i].size, ranges[i].offset);
+			}
+		}
+
+		//apply the bandwidth limit of the misses if the caller can make the client retry
+		if (this->missThrottle != NULL && status != NULL && requests.empty() == false) {
+			size_t loadSize = 0;
+			for (auto & it : requests)
+				loadSize += it.size;
+			if (this->missThrottle->tryConsume(loadSize) == false) {
+				IOC_DEBUG_ARG("object", "Throttle load of %1").argUnit1024(loadSize).end();
+				this->releaseSegments(ranges);
+				if (status != NULL)
+					*status = OBJECT_BUFFERS_THROTTLED;
+				return false;
+			}
+		}
+
+		//submit & wait
+		this->storageBackend->submit(requests.data(), requests.size());
+		this->storageBackend->wait(requests.data(), requests.size());
+
+		//check
+		for (auto & it : requests) {
+			if (it.status != (ssize_t)it.size && !acceptLoadFail) {
+				this->releaseSegments(ranges);
+				if (status != NULL)
+					*status = OBJECT_BUFFERS_LOAD_ERROR;
+				return false;
+			}
 		}
 	}
 
+	//ok
+	return true;
+}
+
+/****************************************************/
+/**
+ * Register the segments loaded by loadSegments() in the object.
+ * @param ranges The loaded ranges.
+**/
+void Object::registerSegments(std::vector<ObjectSegmentDescr> & ranges)
+{
 	//register using end address to be able to use lower_bound() to quick search
-	ObjectSegment & segment = this->segmentMap[offset+size-1];
-	segment = ObjectSegment(offset, size, buffer, this->memoryBackend);
+	for (auto & it : ranges) {
+		ObjectSegment & segment = this->segmentMap[it.offset+it.size-1];
+		segment = ObjectSegment(it.offset, it.size, it.ptr, this->memoryBackend);
+		segment.touch();
+	}
+}
 
-	//return descr
-	return segment.getSegmentDescr();
+/****************************************************/
+/**
+ * Return the statistics of the loads made to fill the missing segments, the
+ * deduplicated counter tells how many requests reused a load already in flight.
+ * @return The statistics since the creation of the object.
+**/
+ObjectLoadStats Object::getLoadStats(void)
+{
+	return this->loadStats;
+}
+
+/****************************************************/
+/**
+ * Check if a range is known to contain only zeros on the storage.
+ * @param offset Offset of the range.
+ * @param size Size of the range.
+ * @return True if the range is a known hole.
+**/
+bool Object::isKnownHole(size_t offset, size_t size)
+{
+	return this->holes.isHole(offset, size);
+}
+
+/****************************************************/
+/**
+ * Return the memory of segments which failed to be loaded.
+ * @param ranges The ranges, the non NULL pointers are released.
+**/
+void Object::releaseSegments(std::vector<ObjectSegmentDescr> & ranges)
+{
+	for (auto & it : ranges) {
+		if (it.ptr != NULL)
+			this->memoryBackend->deallocate(it.ptr, it.size);
+		it.ptr = NULL;
+	}
 }
 
 /****************************************************/
 /**
  * Loop on all the segments and flush the dirty one overlapping the given range.
+ * The contiguous segments are merged in vectored writes up to maxFlushSize and
+ * the writes are submitted in one batch to the storage backend so they can be
+ * made in parallel.
  * @param offset Base offset from where to flush.
  * @param size Size of the range to flus. Use 0 to flush all.
+ * @param throttled If not NULL, the bandwidth limit is checked without
+ * waiting as the polling thread cannot block. If it is reached, nothing is
+ * written, the segments stay dirty and it is set to true so the caller can
+ * retry later. If NULL, wait until the limit permits the writes.
+ * @return 0 on success, -1 if one of the writes failed.
 **/
-int Object::flush(size_t offset, size_t size)
+int Object::flush(size_t offset, size_t size, bool * throttled)
 {
-	int ret = 0;
-	for (auto & it : this->segmentMap) {
-		if (it.second.isDirty()) {
-			if (size == 0 || it.second.overlap(offset, size)) {
-				if (this->pwrite(it.second.getBuffer(), it.second.getSize(), it.second.getOffset()) != (ssize_t)it.second.getSize())
-					ret = -1;
-				it.second.setDirty(false);
-			}
+	//create in the storage if deferred, its error is consumed only when returned
+	this->applyPendingCreate();
+
+	//select the dirty segments
+	std::vector<ObjectSegment*> dirty;
+	this->collectDirtySegments(dirty, offset, size);
+
+	//nothing to do
+	if (dirty.empty())
+		return (this->ensureCreated() == 0) ? 0 : -1;
+
+	//no storage
+	if (this->storageBackend == NULL) {
+		for (auto & it : dirty)
+			it->setDirty(false);
+		return (this->ensureCreated() == 0) ? 0 : -1;
+	}
+
+	//build the requests
+	std::vector<struct iovec> iovs;
+	std::vector<StorageRequest> requests;
+	this->buildFlushRequests(dirty, iovs, requests);
+
+	//apply the bandwidth limit, without blocking if the caller can retry
+	if (this->flushThrottle != NULL && throttled != NULL) {
+		size_t flushSize = 0;
+		for (auto & it : requests)
+			flushSize += it.size;
+		if (this->flushThrottle->tryConsume(flushSize) == false) {
+			IOC_DEBUG_ARG("object", "Throttle flush of %1").argUnit1024(flushSize).end();
+			*throttled = true;
+			return 0;
 		}
+	} else if (this->flushThrottle != NULL) {
+		for (auto & it : requests)
+			this->flushThrottle->consume(it.size);
 	}
+
+	//report the creation error with this flush
+	int ret = (this->ensureCreated() == 0) ? 0 : -1;
+
+	//submit all in one batch & wait
+	this->storageBackend->submit(requests.data(), requests.size());
+	this->storageBackend->wait(requests.data(), requests.size());
+
+	//check
+	for (auto & it : requests)
+		if (it.status != (ssize_t)it.size)
+			ret = -1;
+	for (auto & it : dirty)
+		it->setDirty(false);
+
+	//ret
 	return ret;
 }
 
+/****************************************************/
+/**
+ * Flush the dirty segments overlapping the given range with the flush
+ * engine so the writes are made in parallel by its threads. The segments
+ * stay dirty until their write completes and are then marked clean only
+ * if they have not been written meanwhile. If some of them are still being
+ * written by a previous flush, the flush is deferred until it is done so
+ * the storage receives the writes in order.
+ * @param offset Base offset from where to flush.
+ * @param size Size of the range to flush. Use 0 to flush all.
+ * @param engine The flush engine to use.
+ * @param onComplete Function called from the polling thread with the status
+ * (0 or -1) when all the writes are done. It can be called immediately if
+ * there is nothing to write.
+**/
+void Object::flushAsync(size_t offset, size_t size, FlushEngine & engine, std::function<void(int status)> onComplete)
+{
+	//select the dirty segments
+	std::vector<ObjectSegment*> dirty;
+	this->collectDirtySegments(dirty, offset, size);
+
+	//wait the writes in flight on the same segments
+	for (auto & it : dirty) {
+		if (it->getMemory()->isFlushing()) {
+			std::shared_ptr<bool> alive = this->alive;
+			engine.defer([this, alive, offset, size, &engine, onComplete]() {
+				if (*alive)
+					this->flushAsync(offset, size, engine, onComplete);
+				else
+					onComplete(-1);
+			});
+			return;
+		}
+	}
+
+	//create in the storage if deferred and report its error on completion
+	if (this->ensureCreated() != 0) {
+		onComplete = [onComplete](int status) {
+			onComplete(-1);
+		};
+	}
+
+	//nothing to write
+	if (dirty.empty() || this->storageBackend == NULL) {
+		for (auto & it : dirty)
+			it->setDirty(false);
+		onComplete(0);
+		return;
+	}
+
+	//build the batch
+	FlushBatch * batch = this->buildFlushBatch(dirty, onComplete);
+	batch->throttle = this->flushThrottle;
+
+	//submit
+	engine.submit(batch);
+}
+
+/****************************************************/
+/**
+ * Build the batch writing the given dirty segments. They are marked as
+ * flushing until the completion of the batch which then calls onFlushDone()
+ * if the object still exists.
+ * @param dirty The dirty segments to write.
+ * @param onComplete Function to call with the status once onFlushDone() is done.
+ * @return The batch, without throttle.
+**/
+FlushBatch * Object::buildFlushBatch(std::vector<ObjectSegment*> & dirty, std::function<void(int status)> onComplete)
+{
+	//remember what is written, it also keeps the memories alive in case the segments are changed
+	std::vector<ObjectFlushedSegment> flushed;
+	flushed.reserve(dirty.size());
+	for (auto & it : dirty) {
+		it->getMemory()->setFlushing(true);
+		flushed.push_back(ObjectFlushedSegment{it->getOffset() + it->getSize() - 1, it->getMemory(), it->getDirtyVersion()});
+	}
+
+	//build the batch
+	std::shared_ptr<bool> alive = this->alive;
+	FlushBatch * batch = new FlushBatch;
+	batch->storageBackend = this->storageBackend;
+	batch->throttle = NULL;
+	batch->onComplete = [this, alive, flushed, onComplete](int status) mutable {
+		if (*alive)
+			this->onFlushDone(flushed, status);
+		else
+			for (auto & it : flushed)
+				it.memory->setFlushing(false);
+		onComplete(status);
+	};
+	for (auto & it : dirty)
+		batch->memories.push_back(it->getMemory());
+	this->buildFlushRequests(dirty, batch->iovs, batch->requests);
+
+	//ret
+	return batch;
+}
+
+/****************************************************/
+/**
+ * Flush the dirty segments overlapping the given range with the asynchronous
+ * interface of the storage backend. It is used when there is no flush engine
+ * so the polling thread does not wait the writes. As with flushAsync(), the
+ * segments are marked clean on completion if they have not been written
+ * meanwhile and a flush of segments still being written waits for the
+ * previous one.
+ * @param offset Base offset from where to flush.
+ * @param size Size of the range to flush. Use 0 to flush all.
+ * @param onComplete Function called from StorageBackend::pollCompletions()
+ * with the status (0 or -1) when all the writes are done. It can be called
+ * immediately if there is nothing to write.
+ * @return False if the bandwidth limit of the flushes is reached, nothing is
+ * then written and onComplete is not called so the caller can ask the client
+ * to retry later.
+**/
+bool Object::submitFlush(size_t offset, size_t size, std::function<void(int status)> onComplete)
+{
+	//apply the bandwidth limit on the dirty data
+	if (this->flushThrottle != NULL && this->storageBackend != NULL) {
+		std::vector<ObjectSegment*> dirty;
+		this->collectDirtySegments(dirty, offset, size);
+		size_t flushSize = 0;
+		for (auto & it : dirty)
+			flushSize += it->getSize();
+		if (flushSize > 0 && this->flushThrottle->tryConsume(flushSize) == false) {
+			IOC_DEBUG_ARG("object", "Throttle flush of %1").argUnit1024(flushSize).end();
+			return false;
+		}
+	}
+
+	//flush
+	this->submitFlushNow(offset, size, onComplete);
+	return true;
+}
+
+/****************************************************/
+/**
+ * Implement submitFlush() once the bandwidth limit has been applied.
+ * @param offset Base offset from where to flush.
+ * @param size Size of the range to flush. Use 0 to flush all.
+ * @param onComplete Function called with the status when all the writes are done.
+**/
+void Object::submitFlushNow(size_t offset, size_t size, std::function<void(int status)> onComplete)
+{
+	//select the dirty segments
+	std::vector<ObjectSegment*> dirty;
+	this->collectDirtySegments(dirty, offset, size);
+
+	//wait the writes in flight on the same segments, a shared COW memory may be flushed by another object
+	for (auto & it : dirty) {
+		if (it->getMemory()->isFlushing() && this->submittedFlushes > 0) {
+			this->flushWaiters.push_back([this, offset, size, onComplete](bool alive) {
+				if (alive)
+					this->submitFlushNow(offset, size, onComplete);
+				else
+					onComplete(-1);
+			});
+			return;
+		}
+	}
+
+	//create in the storage if deferred and report its error on completion
+	if (this->ensureCreated() != 0) {
+		onComplete = [onComplete](int status) {
+			onComplete(-1);
+		};
+	}
+
+	//nothing to write
+	if (dirty.empty() || this->storageBackend == NULL) {
+		for (auto & it : dirty)
+			it->setDirty(false);
+		onComplete(0);
+		return;
+	}
+
+	//build the batch, the flushes waiting for it are restarted on completion
+	std::shared_ptr<bool> alive = this->alive;
+	std::shared_ptr<FlushBatch> batch(this->buildFlushBatch(dirty, [this, alive, onComplete](int status) {
+		std::vector<std::function<void(bool alive)>> waiters;
+		if (*alive) {
+			this->submittedFlushes--;
+			waiters.swap(this->flushWaiters);
+		}
+		onComplete(status);
+		for (auto & it : waiters)
+			it(true);
+	}));
+
+	//count the writes, they keep the batch alive until they complete
+	batch->remaining = batch->requests.size();
+	batch->status = 0;
+	for (auto & it : batch->requests) {
+		it.onComplete = [batch](StorageRequest & request) {
+			if (request.status != (ssize_t)request.size)
+				batch->status = -1;
+			if (--batch->remaining == 0)
+				batch->onComplete(batch->status);
+		};
+	}
+
+	//submit
+	this->submittedFlushes++;
+	this->storageBackend->submit(batch->requests.data(), batch->requests.size());
+}
+
+/****************************************************/
+/**
+ * Called from the polling thread when the writes of a flush are done. The
+ * segments are released and marked clean if the writes succeeded and they
+ * have not been written nor replaced meanwhile.
+ * @param flushed The segments which have been written.
+ * @param status Status of the writes, 0 on success.
+**/
+void Object::onFlushDone(std::vector<ObjectFlushedSegment> & flushed, int status)
+{
+	for (auto & it : flushed) {
+		//release
+		it.memory->setFlushing(false);
+
+		//keep dirty to retry on the next flush
+		if (status != 0)
+			continue;
+
+		//mark clean if unchanged
+		auto seg = this->segmentMap.find(it.key);
+		if (seg != this->segmentMap.end() && seg->second.getMemory() == it.memory && seg->second.getDirtyVersion() == it.dirtyVersion)
+			seg->second.setDirty(false);
+	}
+}
+
+/****************************************************/
+/**
+ * Record the dirty segments overlapping the given range in the write ahead
+ * log so the flush can be acknowledged before writing to the storage. The
+ * segments stay dirty and are written later by flush(). Without storage
+ * backend the log would never be destaged so it is not used.
+ * @param offset Base offset from where to flush.
+ * @param size Size of the range to flush. Use 0 to flush all.
+ * @param wal The write ahead log to use.
+ * @return 0 on success, -1 if the log cannot be written or is not used, the
+ * caller then falls back on flush().
+**/
+int Object::logFlush(size_t offset, size_t size, WriteAheadLog & wal)
+{
+	//no storage to destage the log to
+	if (this->storageBackend == NULL)
+		return -1;
+
+	//create in the storage if deferred, let flush() report the error
+	this->applyPendingCreate();
+	if (this->createError != 0)
+		return -1;
+
+	//select the dirty segments
+	std::vector<ObjectSegment*> dirty;
+	this->collectDirtySegments(dirty, offset, size);
+
+	//build the extents
+	std::vector<ObjectSegmentDescr> extents;
+	extents.reserve(dirty.size());
+	for (auto & it : dirty)
+		extents.push_back(it->getSegmentDescr());
+
+	//log
+	if (wal.append(this->objectId.high, this->objectId.low, extents))
+		return 0;
+	else
+		return -1;
+}
+
+/****************************************************/
+/**
+ * Select the dirty segments overlapping the given range.
+ * @param dirty The list to fill, ordered by offset.
+ * @param offset Base offset of the range.
+ * @param size Size of the range, 0 for all the object.
+**/
+void Object::collectDirtySegments(std::vector<ObjectSegment*> & dirty, size_t offset, size_t size)
+{
+	for (auto & it : this->segmentMap)
+		if (it.second.isDirty() && (size == 0 || it.second.overlap(offset, size)))
+			dirty.push_back(&it.second);
+}
+
+/****************************************************/
+/**
+ * Build the write requests to flush the given segments. The contiguous
+ * segments are merged in vectored writes up to maxFlushSize.
+ * @param dirty The segments to flush ordered by offset.
+ * @param iovs The buffer list to fill, used by the vectored requests so it
+ * must not be modified until they are done.
+ * @param requests The request list to fill.
+**/
+void Object::buildFlushRequests(std::vector<ObjectSegment*> & dirty, std::vector<struct iovec> & iovs, std::vector<StorageRequest> & requests)
+{
+	//build the buffer list
+	iovs.resize(dirty.size());
+	for (size_t i = 0 ; i < dirty.size() ; i++) {
+		iovs[i].iov_base = dirty[i]->getBuffer();
+		iovs[i].iov_len = dirty[i]->getSize();
+	}
+
+	//build the requests merging the contiguous segments up to maxFlushSize
+	requests.reserve(dirty.size());
+	size_t i = 0;
+	while (i < dirty.size()) {
+		//extend the group
+		size_t first = i;
+		size_t groupSize = dirty[i]->getSize();
+		for (i++ ; i < dirty.size() ; i++) {
+			bool contiguous = (dirty[i]->getOffset() == dirty[i-1]->getOffset() + dirty[i-1]->getSize());
+			if (contiguous == false || groupSize + dirty[i]->getSize() > this->maxFlushSize)
+				break;
+			groupSize += dirty[i]->getSize();
+		}
+
+		//setup
+		requests.emplace_back();
+		if (i - first == 1)
+			StorageBackend::setupRequest(requests.back(), STORAGE_REQUEST_WRITE, this->objectId.high, this->objectId.low, dirty[first]->getBuffer(), dirty[first]->getSize(), dirty[first]->getOffset());
+		else
+			StorageBackend::setupRequestVec(requests.back(), this->objectId.high, this->objectId.low, &iovs[first], i - first, dirty[first]->getOffset());
+	}
+}
+
 /****************************************************/
 /**
  * Make a mero object creation before accessing the object.
 **/
 int Object::create(void)
 {
-	if (this->storageBackend != NULL)
-		return this->storageBackend->create(this->objectId.high, this->objectId.low);
-	else
+	//no storage
+	if (this->storageBackend == NULL)
 		return 0;
+
+	//create
+	int status = this->storageBackend->create(this->objectId.high, this->objectId.low);
+
+	//a new object contains only zeros
+	if (status == 0)
+		this->markAsNew();
+
+	//ret
+	return status;
 }
 
 /****************************************************/
-/** Just a wrapper to check if we have a storage backend or not. **/
-ssize_t Object::pwrite(void * buffer, size_t size, size_t offset)
+/**
+ * Mark the whole object as a hole once its creation succeeded so the reads
+ * do not load from the storage. It is not done if some segments are already
+ * in memory as they may contain data which is not a hole.
+**/
+void Object::markAsNew(void)
+{
+	if (this->segmentMap.empty()) {
+		this->holes.clear();
+		this->holes.addHole(0, SIZE_MAX);
+		this->holesQueried = true;
+	}
+}
+
+/****************************************************/
+/**
+ * Defer the creation of the object in the storage. It is made later by
+ * applyPendingCreate() or at the latest before the first load or flush
+ * which reports the error if it fails. The object may already exist in the
+ * storage so it is considered as new only once its creation succeeded.
+**/
+void Object::deferCreate(void)
+{
+	this->createPending = true;
+}
+
+/****************************************************/
+/**
+ * Create the object in the storage if its creation has been deferred. A
+ * failure is kept to be reported by the next flush.
+ * @return The status of the creation, 0 if there was nothing to do.
+**/
+int Object::applyPendingCreate(void)
 {
+	//nothing to do
+	if (this->createPending == false)
+		return 0;
+
+	//create
+	this->createPending = false;
+	int status = 0;
 	if (this->storageBackend != NULL)
-		return this->storageBackend->pwrite(objectId.high, objectId.low, buffer, size, offset);
-	else
-		return size;
+		status = this->storageBackend->create(this->objectId.high, this->objectId.low);
+
+	//a new object contains only zeros, otherwise keep the error for the next flush
+	if (status == 0 && this->storageBackend != NULL) {
+		this->markAsNew();
+	} else if (status != 0) {
+		IOC_DEBUG_ARG("object", "Deferred creation of object %1:%2 failed with %3").arg(this->objectId.high).arg(this->objectId.low).arg(status).end();
+		this->createError = status;
+	}
+	return status;
+}
+
+/****************************************************/
+/**
+ * Make sure the deferred creation is done before flushing and return its
+ * error once.
+ * @return The error of the deferred creation or 0.
+**/
+int Object::ensureCreated(void)
+{
+	this->applyPendingCreate();
+	int ret = this->createError;
+	this->createError = 0;
+	return ret;
 }
 
 /****************************************************/
 /** Just a wrapper to check if we have a storage backend or not. **/
-ssize_t Object::pread(void * buffer, size_t size, size_t offset)
+ssize_t Object::pwrite(void * buffer, size_t size, size_t offset)
 {
 	if (this->storageBackend != NULL)
-		return this->storageBackend->pread(objectId.high, objectId.low, buffer, size, offset);
+		return this->storageBackend->pwrite(objectId.high, objectId.low, buffer, size, offset);
 	else
 		return size;
 }
@@ -449,6 +1384,13 @@ void Object::rangeCopyOnWriteSegment(ObjectSegment & origSegment, size_t offset,
 **/
 void Object::rangeCopyOnWrite(Object & origObject, size_t offset, size_t size)
 {
+	//complete the loads in flight so they do not register segments over the copied ones
+	this->waitLoads();
+	origObject.waitLoads();
+
+	//the range gets the content of the original object
+	this->holes.removeRange(offset, size);
+
 	//search first segment
 	auto itTarget = origObject.segmentMap.lower_bound(offset);
 
@@ -476,13 +1418,22 @@ void Object::rangeCopyOnWrite(Object & origObject, size_t offset, size_t size)
 **/
 Object * Object::makeFullCopyOnWrite(const ObjectId & targetObjectId, bool allowExist)
 {
+	//complete the loads in flight so the copy sees their segments
+	this->waitLoads();
+
 	//spawn the new object
 	Object * cow = new Object(storageBackend, memoryBackend, targetObjectId, alignement);
+	cow->setMaxFlushSize(this->maxFlushSize);
+	cow->setThrottles(this->flushThrottle, this->missThrottle);
 
 	//Create
 	int createStatus = cow->create();
 	assume(createStatus == 0 || allowExist, "Failed to create object on the storage for COW !");
 
+	//the copy below writes the storage without marking the ranges dirty, forget the holes
+	cow->holes.clear();
+	cow->holesQueried = false;
+
 	//loop on all segments
 	size_t cursor = 0;
 	for (auto & it : this->segmentMap) {
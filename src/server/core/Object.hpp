@@ -16,12 +16,18 @@
 #include <ostream>
 #include <vector>
 #include <string>
+#include <functional>
 //linux
 #include <sys/uio.h>
 //internal
+#include "Consts.hpp"
 #include "ObjectSegment.hpp"
 #include "MemoryBackend.hpp"
 #include "StorageBackend.hpp"
+#include "FlushEngine.hpp"
+#include "TokenBucket.hpp"
+#include "HoleTracker.hpp"
+#include "WriteAheadLog.hpp"
 #include "ConsistencyTracker.hpp"
 #include "../../base/network/LibfabricDomain.hpp"
 #include "../../base/network/Protocol.hpp"
@@ -43,6 +49,38 @@ enum ObjectAccessMode
 	ACCESS_WRITE,
 };
 
+/****************************************************/
+/**
+ * Status reported by getBuffers() to let the caller know why it failed.
+**/
+enum ObjectBuffersStatus
+{
+	/** All the segments are available. **/
+	OBJECT_BUFFERS_OK,
+	/** Fail to load the content of a segment from the storage backend. **/
+	OBJECT_BUFFERS_LOAD_ERROR,
+	/** The memory backend is out of memory, the request can be retried later. **/
+	OBJECT_BUFFERS_NO_MEMORY,
+	/** The bandwidth limit of the misses is reached, the request can be retried later. **/
+	OBJECT_BUFFERS_THROTTLED,
+};
+
+/****************************************************/
+/**
+ * Statistics of the loads made by an object to fill the missing segments.
+**/
+struct ObjectLoadStats
+{
+	/** Number of ranges read from the storage backend. **/
+	size_t loads;
+	/** Amount of data read from the storage backend. **/
+	size_t loadedBytes;
+	/** Number of requests which waited for a load already in flight instead of loading the same range again. **/
+	size_t deduplicated;
+	/** Number of ranges filled with zeros without reading the storage because they are known holes. **/
+	size_t holes;
+};
+
 /****************************************************/
 /**
  * Define what is object ID.
@@ -61,6 +99,60 @@ struct ObjectId
 	int64_t high;
 };
 
+/****************************************************/
+/**
+ * A segment written by a flush in flight, to mark it clean when its write
+ * completes if it has not been written meanwhile.
+**/
+struct ObjectFlushedSegment
+{
+	/** Key of the segment in the segment map (its last byte offset). **/
+	size_t key;
+	/** The memory being written. **/
+	std::shared_ptr<ObjectSegmentMemory> memory;
+	/** Dirty version of the segment when the write has been submitted. **/
+	size_t dirtyVersion;
+};
+
+/****************************************************/
+/** Function called when the ranges requested with Object::loadAsync() are in memory. **/
+typedef std::function<void(ObjectBuffersStatus status)> ObjectLoadCallback;
+
+/****************************************************/
+/**
+ * A batch of missing ranges read asynchronously by Object::loadAsync(). The
+ * memory is allocated at submission and the segments are registered when
+ * all the reads are done.
+**/
+struct ObjectLoad
+{
+	/** The ranges being read. **/
+	std::vector<ObjectSegmentDescr> ranges;
+	/** The reads, one per range. **/
+	std::vector<StorageRequest> requests;
+	/** Number of reads not yet completed. **/
+	size_t remaining;
+	/** The load is made for a write op so a failed read is accepted. **/
+	bool acceptLoadFail;
+	/** Memory backend to release the ranges if the object is destroyed meanwhile. **/
+	MemoryBackend * memoryBackend;
+	/** Functions to call once the ranges are registered or the load failed. **/
+	std::vector<ObjectLoadCallback> waiters;
+};
+
+/****************************************************/
+/**
+ * A range being loaded by loadAsync(), registered in the object so the
+ * requests missing the same range reuse it instead of reading it again.
+**/
+struct ObjectLoadRange
+{
+	/** Size of the range. **/
+	size_t size;
+	/** The asynchronous load reading it. **/
+	std::shared_ptr<ObjectLoad> load;
+};
+
 /****************************************************/
 /** Define an object segment list. **/
 typedef std::list<ObjectSegmentDescr> ObjectSegmentList;
@@ -68,32 +160,73 @@ typedef std::list<ObjectSegmentDescr> ObjectSegmentList;
 typedef std::map<size_t, ObjectSegment> ObjectSegmentMap;
 
 /****************************************************/
+/**
+ * An object handled by the server, made of segments loaded from the storage
+ * on demand and flushed back when dirty.
+ *
+ * The object is not thread safe, all its operations are made by the polling
+ * thread. The hooks do not wait the storage there: they load the missing
+ * ranges with loadAsync() and flush with submitFlush() or flushAsync(), then
+ * answer the client from the completion function called by the polling loop.
+ *
+ * The ranges read by loadAsync() are registered as in flight until their
+ * completion so an overlapping request reuses the load instead of reading
+ * the storage again: loadAsync() queues behind it and getBuffers() completes
+ * it before searching the missing ranges again.
+**/
 class Object
 {
 	public:
 		Object(StorageBackend * backend, MemoryBackend * memBackend, const ObjectId & objectId, size_t alignement = 0);
+		~Object(void);
 		const ObjectId & getObjectId(void);
 		char * getUniqBuffer(size_t base, size_t size, ObjectAccessMode accessMode, bool load = true);
-		bool getBuffers(ObjectSegmentList & segments, size_t base, size_t size, ObjectAccessMode accessMode, bool load = true, bool isForWriteOp = false);
+		bool getBuffers(ObjectSegmentList & segments, size_t base, size_t size, ObjectAccessMode accessMode, bool load = true, bool isForWriteOp = false, ObjectBuffersStatus * status = NULL);
+		void loadAsync(size_t base, size_t size, bool isForWriteOp, ObjectLoadCallback onLoaded);
+		void waitLoads(void);
 		void fillBuffer(size_t offset, size_t size, char value);
 		bool checkBuffer(size_t offset, size_t size, char value);
 		bool checkUniq(size_t offset, size_t size);
 		static iovec * buildIovec(ObjectSegmentList & segments, size_t offset, size_t size);
 		void markDirty(size_t base, size_t size);
-		int flush(size_t offset, size_t size);
+		int flush(size_t offset, size_t size, bool * throttled = NULL);
+		void flushAsync(size_t offset, size_t size, FlushEngine & engine, std::function<void(int status)> onComplete);
+		bool submitFlush(size_t offset, size_t size, std::function<void(int status)> onComplete);
+		int logFlush(size_t offset, size_t size, WriteAheadLog & wal);
 		int create(void);
+		void deferCreate(void);
+		bool hasPendingCreate(void) const {return this->createPending;};
+		int applyPendingCreate(void);
 		void forceAlignement(size_t alignment);
+		void setMaxFlushSize(size_t maxFlushSize);
+		void setThrottles(TokenBucket * flushThrottle, TokenBucket * missThrottle);
 		ConsistencyTracker & getConsistencyTracker(void);
 		Object * makeFullCopyOnWrite(const ObjectId & targetObjectId, bool allowExist);
 		void rangeCopyOnWrite(Object & origObject, size_t offset, size_t size);
 		void setStorageBackend(StorageBackend * storageBackend);
 		void setMemoryBackend(MemoryBackend * memoryBackend);
+		void collectSegmentMemories(std::vector<std::shared_ptr<ObjectSegmentMemory>> & memories);
+		ObjectLoadStats getLoadStats(void);
+		bool isKnownHole(size_t offset, size_t size);
 	private:
 		void rangeCopyOnWriteSegment(ObjectSegment & origSegment, size_t offset, size_t size);
-		ObjectSegmentDescr loadSegment(size_t offset, size_t size, bool load = true, bool acceptLoadFail = false);
+		void alignRange(size_t & base, size_t & size);
+		void searchMissingRanges(const ObjectSegmentList & segments, size_t base, size_t size, size_t origBase, size_t origSize, bool load, bool isForWriteOp, std::vector<ObjectSegmentDescr> & missing, std::vector<bool> & needLoad);
+		void skipKnownHoles(const std::vector<ObjectSegmentDescr> & missing, std::vector<bool> & needLoad, std::vector<bool> & zero);
+		bool loadSegments(std::vector<ObjectSegmentDescr> & ranges, const std::vector<bool> & load, bool acceptLoadFail, ObjectBuffersStatus * status);
+		void onLoadDone(ObjectLoad & load);
+		void registerSegments(std::vector<ObjectSegmentDescr> & ranges);
+		void releaseSegments(std::vector<ObjectSegmentDescr> & ranges);
+		ObjectLoadRange * findLoadInFlight(const std::vector<ObjectSegmentDescr> & ranges);
+		void collectDirtySegments(std::vector<ObjectSegment*> & dirty, size_t offset, size_t size);
+		void buildFlushRequests(std::vector<ObjectSegment*> & dirty, std::vector<struct iovec> & iovs, std::vector<StorageRequest> & requests);
 		ssize_t pwrite(void * buffer, size_t size, size_t offset);
-		ssize_t pread(void * buffer, size_t size, size_t offset);
 		bool isFullyOverlapped(size_t segOffset, size_t segSize, size_t reqOffset, size_t reqSize);
+		int ensureCreated(void);
+		void markAsNew(void);
+		FlushBatch * buildFlushBatch(std::vector<ObjectSegment*> & dirty, std::function<void(int status)> onComplete);
+		void submitFlushNow(size_t offset, size_t size, std::function<void(int status)> onComplete);
+		void onFlushDone(std::vector<ObjectFlushedSegment> & flushed, int status);
 	private:
 		/** Object ID **/
 		ObjectId objectId;
@@ -101,12 +234,36 @@ class Object
 		ObjectSegmentMap segmentMap;
 		/** Base alignement to use. **/
 		size_t alignement;
+		/** Maximum size of a write when flush() merges contiguous dirty segments. **/
+		size_t maxFlushSize;
+		/** If not NULL, bandwidth limit of the writes made by the flush operations. **/
+		TokenBucket * flushThrottle;
+		/** If not NULL, bandwidth limit of the reads made to load the missing segments. **/
+		TokenBucket * missThrottle;
 		/** Consistency tracker to track ranges mapped by clients and guaranty exclusive write access. **/
 		ConsistencyTracker consistencyTracker;
+		/** The creation of the object in the storage has been acknowledged but not yet made. **/
+		bool createPending;
+		/** Error of the deferred creation to be reported by the next flush. **/
+		int createError;
 		/** Keep track of the storage backend to be used to dump data. **/
 		StorageBackend * storageBackend;
 		/** Keep track of the memory backend used to allocate memory. **/
 		MemoryBackend * memoryBackend;
+		/** Ranges being loaded, identified by their offset. **/
+		std::map<size_t, ObjectLoadRange> inFlightLoads;
+		/** Statistics of the loads. **/
+		ObjectLoadStats loadStats;
+		/** Ranges known to contain only zeros on the storage, served without reading it. **/
+		HoleTracker holes;
+		/** The storage backend has already been asked for the holes of the object. **/
+		bool holesQueried;
+		/** Set to false on destruction so the flushes in flight do not access the object anymore. **/
+		std::shared_ptr<bool> alive;
+		/** Number of flushes made by submitFlush() whose writes are in flight. **/
+		size_t submittedFlushes;
+		/** Flushes of submitFlush() waiting for the writes in flight on their segments, called with false on destruction. **/
+		std::vector<std::function<void(bool alive)>> flushWaiters;
 };
 
 /****************************************************/
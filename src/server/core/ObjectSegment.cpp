@@ -29,6 +29,8 @@ ObjectSegmentMemory::ObjectSegmentMemory(char * buffer, size_t size, MemoryBacke
 	this->buffer = buffer;
 	this->size = size;
 	this->memoryBackend = memoryBackend;
+	this->accessCount = 0;
+	this->flushing = false;
 }
 
 /****************************************************/
@@ -56,6 +58,19 @@ MemoryBackend * ObjectSegmentMemory::getMemoryBackend(void)
 	return this->memoryBackend;
 }
 
+/****************************************************/
+/**
+ * Replace the buffer by a new one containing the same data. This is used
+ * by the memory backends to migrate the segment from one memory to another.
+ * The memory backend keeps the responsability to free the old buffer.
+ * @param buffer The new buffer address.
+**/
+void ObjectSegmentMemory::setBuffer(char * buffer)
+{
+	assert(buffer != NULL);
+	this->buffer = buffer;
+}
+
 /****************************************************/
 /**
  * Default constructor, it sets everything to NULL of zero.
@@ -65,6 +80,7 @@ ObjectSegment::ObjectSegment(void)
 	this->memory = nullptr;
 	this->offset = 0;
 	this->dirty = false;
+	this->dirtyVersion = 0;
 }
 
 /****************************************************/
@@ -79,6 +95,7 @@ ObjectSegment::ObjectSegment(size_t offset, size_t size, char * buffer, MemoryBa
 {
 	this->offset = offset;
 	this->dirty = false;
+	this->dirtyVersion = 0;
 	this->memory = std::make_shared<ObjectSegmentMemory>(buffer, size, memoryBackend);
 }
 
@@ -126,14 +143,17 @@ void ObjectSegment::makeCowOf(ObjectSegment & orig)
 {
 	this->memory = orig.memory;
 	this->dirty = orig.dirty;
+	this->dirtyVersion = orig.dirtyVersion;
 	this->offset = orig.offset;
 }
 
 /****************************************************/
 /**
  * Function to be called on a first write access to a shared COW segment.
+ * @return False if the memory backend is out of memory, the segment then
+ * stays shared.
 **/
-void ObjectSegment::applyCow(void)
+bool ObjectSegment::applyCow(void)
 {
 	//check
 	assert(this->memory != nullptr);
@@ -144,14 +164,18 @@ void ObjectSegment::applyCow(void)
 	MemoryBackend * memoryBackend = this->memory->getMemoryBackend();
 
 	//allocate new ptr
-	char * new_ptr = (char*)memoryBackend->allocate(size);
-	assert(new_ptr != NULL);
+	char * new_ptr = (char*)memoryBackend->allocateWithTrim(size);
+	if (new_ptr == NULL)
+		return false;
 
 	//copy content
 	memcpy(new_ptr, this->memory->getBuffer(), size);
 
 	//override the shared pointer
 	this->memory = std::make_shared<ObjectSegmentMemory>(new_ptr, size, memoryBackend);
+
+	//ok
+	return true;
 }
 
 /****************************************************/
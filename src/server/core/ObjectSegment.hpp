@@ -49,6 +49,12 @@ class ObjectSegmentMemory
 		char * getBuffer(void) {return this->buffer;};
 		size_t getSize(void) {return this->size;}
 		MemoryBackend * getMemoryBackend(void);
+		void setBuffer(char * buffer);
+		void touch(void) {this->accessCount++;};
+		size_t getAccessCount(void) const {return this->accessCount;};
+		void decayAccessCount(void) {this->accessCount /= 2;};
+		void setFlushing(bool value) {this->flushing = value;};
+		bool isFlushing(void) const {return this->flushing;};
 	private:
 		/** Keep track of the buffer address, can be NULL for none (for unit tests). **/
 		char * buffer;
@@ -56,6 +62,13 @@ class ObjectSegmentMemory
 		size_t size;
 		/** Keep track of the memory backend to know how to free. ***/
 		MemoryBackend * memoryBackend;
+		/** Count the accesses to know if the segment is hot or cold. **/
+		size_t accessCount;
+		/**
+		 * A flush engine thread is writing the buffer to the storage, it must
+		 * not be migrated and not be flushed again before it is done.
+		**/
+		bool flushing;
 };
 
 /****************************************************/
@@ -74,13 +87,16 @@ class ObjectSegment
 		size_t getSize(void) const {assert(memory != nullptr); return this->memory->getSize();};
 		size_t getOffset(void) const {return this->offset;};
 		bool isDirty(void) {return this->dirty;};
-		void setDirty(bool value) {this->dirty = value;};
+		void setDirty(bool value) {this->dirty = value; if (value) this->dirtyVersion++;};
+		size_t getDirtyVersion(void) const {return this->dirtyVersion;};
 		char * getBuffer(void) {assert(memory != nullptr); return this->memory->getBuffer();};
 		const char * getBuffer(void) const {assert(memory != nullptr); return this->memory->getBuffer();};
 		void makeCowOf(ObjectSegment & orig);
-		void applyCow(void);
+		bool applyCow(void);
 		ObjectSegment & operator=(ObjectSegment && orig) = default;
 		bool isCow(void);
+		void touch(void) {assert(memory != nullptr); this->memory->touch();};
+		std::shared_ptr<ObjectSegmentMemory> & getMemory(void) {return this->memory;};
 	private:
 		/** Address of the memory buffer storing this segment. **/
 		std::shared_ptr<ObjectSegmentMemory> memory;
@@ -88,6 +104,8 @@ class ObjectSegment
 		size_t offset;
 		/** Store ditry state to know if we need to flush it or not. **/
 		bool dirty;
+		/** Incremented on every write so a flush in flight knows if the segment has been written meanwhile. **/
+		size_t dirtyVersion;
 };
 
 }
@@ -9,6 +9,7 @@
 #include <cstring>
 #include <random>
 #include <cassert>
+#include <algorithm>
 #include "Server.hpp"
 #include "Consts.hpp"
 #include "StorageBackend.hpp"
@@ -17,11 +18,15 @@
 #include "../hooks/HookRangeRegister.hpp"
 #include "../hooks/HookRangeUnregister.hpp"
 #include "../hooks/HookObjectCreate.hpp"
+#include "../hooks/HookQos.hpp"
 #include "../hooks/HookObjectRead.hpp"
 #include "../hooks/HookObjectWrite.hpp"
 #include "../hooks/HookObjectCow.hpp"
 #include "base/common/Debug.hpp"
 #include "../backends/MemoryBackendCache.hpp"
+#include "../backends/MemoryBackendBuddy.hpp"
+#include "../backends/MemoryBackendConcurrentCache.hpp"
+#include "../backends/MemoryBackendPrefault.hpp"
 #include "../backends/MemoryBackendBalance.hpp"
 #include "../backends/MemoryBackendNvdimm.hpp"
 #include "../backends/MemoryBackendMalloc.hpp"
@@ -37,6 +42,10 @@ ServerStats::ServerStats(void)
 {
 	this->readSize = 0;
 	this->writeSize = 0;
+	this->retryLater = 0;
+	this->loads = 0;
+	this->deduplicatedLoads = 0;
+	this->holeLoads = 0;
 }
 
 /****************************************************/
@@ -59,12 +68,15 @@ Server::Server(const Config * config, const std::string & port)
 
 	//setup domain
 	this->domain = new LibfabricDomain(config->listenIP, port, true);
-	this->domain->setMsgBufferSize(IOC_POST_RECEIVE_READ);
+	this->domain->setMsgBufferSize(IOC_POST_RECEIVE_SIZE(config->eagerMax));
 
 	//establish connections
 	this->connection = new LibfabricConnection(this->domain, !config->activePolling);
-	assert(IOC_POST_RECEIVE_WRITE < 1024*1024);
-	this->connection->postReceives(1024*1024, 128);
+	this->connection->setCqBatchSize(config->cqBatchSize);
+	this->connection->setEagerLimits(config->eagerMax, config->eagerMax);
+	this->connection->postMultiReceives(config->recvSlabSize, config->recvSlabs, IOC_POST_RECEIVE_SIZE(config->eagerMax));
+	if (config->credits > 0)
+		this->connection->enableCredits(config->recvSlabs * (config->recvSlabSize / IOC_POST_RECEIVE_SIZE(config->eagerMax)), config->credits);
 	if (config->clientAuth)
 		this->connection->setCheckClientAuth(true);
 
@@ -75,20 +87,44 @@ Server::Server(const Config * config, const std::string & port)
 
 	//spawn storage backend
 	this->storageBackend = NULL;
-	this->memoryBackend = new MemoryBackendCache(new MemoryBackendMalloc(domain));
+	this->tieredBackend = NULL;
+	this->memoryBackend = this->buildCache(new MemoryBackendMalloc(domain));
+
+	//prefault pool, if nvdimm is used it will be done by setNvdimm()
+	if (config->nvdimmMountPath.empty())
+		this->memoryBackend = this->buildPool(this->memoryBackend);
+
+	//track memory usage & apply the limit
+	this->watermarkBackend = new MemoryBackendWatermark(this->memoryBackend, config->maxMemory);
+	this->memoryBackend = this->watermarkBackend;
 
 	//create container
-	this->container = new Container(storageBackend, memoryBackend, 8*1024*1024);
+	this->container = new Container(storageBackend, memoryBackend, IOC_SERVER_SEGMENT_SIZE);
+	this->container->setMaxFlushSize(config->maxFlushSize);
+	this->container->getFlushThrottle().setRate(config->flushBandwidth);
+	this->container->getMissThrottle().setRate(config->missBandwidth);
+
+	//parallel flush
+	this->flushEngine = NULL;
+	if (config->flushThreads > 0)
+		this->flushEngine = new FlushEngine(config->flushThreads);
+
+	//durable flush
+	this->wal = NULL;
+	this->walDestaging = false;
+	if (config->walPath.empty() == false)
+		this->wal = new WriteAheadLog(config->walPath);
 
 	//register hooks
 	this->connection->registerHook(IOC_LF_MSG_PING, new HookPingPong(this->domain));
-	this->connection->registerHook(IOC_LF_MSG_OBJ_FLUSH, new HookFlush(this->container));
+	this->connection->registerHook(IOC_LF_MSG_OBJ_FLUSH, new HookFlush(this->container, this->flushEngine, !config->activePolling, this->wal));
 	this->connection->registerHook(IOC_LF_MSG_OBJ_RANGE_REGISTER, new HookRangeRegister(this->config, this->container));
 	this->connection->registerHook(IOC_LF_MSG_OBJ_RANGE_UNREGISTER, new HookRangeUnregister(this->config, this->container));
-	this->connection->registerHook(IOC_LF_MSG_OBJ_CREATE, new HookObjectCreate(this->container));
-	this->connection->registerHook(IOC_LF_MSG_OBJ_READ, new HookObjectRead(this->container, &this->stats));
-	this->connection->registerHook(IOC_LF_MSG_OBJ_WRITE, new HookObjectWrite(this->container, &this->stats));
+	this->connection->registerHook(IOC_LF_MSG_OBJ_CREATE, new HookObjectCreate(this->container, config->lazyCreate));
+	this->connection->registerHook(IOC_LF_MSG_OBJ_READ, new HookObjectRead(this->container, &this->stats, config->rdmaChunkSize, config->rdmaMaxInflight, !config->activePolling));
+	this->connection->registerHook(IOC_LF_MSG_OBJ_WRITE, new HookObjectWrite(this->container, &this->stats, !config->activePolling));
 	this->connection->registerHook(IOC_LF_MSG_OBJ_COW, new HookObjectCow(this->container));
+	this->connection->registerHook(IOC_LF_MSG_SET_QOS, new HookQos(this->container));
 
 	//set error dispatch
 	if (config->broadcastErrorToClients) {
@@ -115,6 +151,10 @@ Server::Server(const Config * config, const std::string & port)
 Server::~Server(void)
 {
 	this->stop();
+	if (this->flushEngine != NULL)
+		delete this->flushEngine;
+	if (this->wal != NULL)
+		delete this->wal;
 	delete this->container;
 	delete this->memoryBackend;
 	delete this->connection;
@@ -131,11 +171,18 @@ void Server::setStorageBackend(StorageBackend * storageBackend)
 {
 	this->storageBackend = storageBackend;
 	this->container->setStorageBackend(storageBackend);
+
+	//write the data acknowledged before a restart
+	if (this->wal != NULL && storageBackend != NULL) {
+		bool status = this->wal->replay(storageBackend);
+		assume(status, "Fail to replay the write ahead log to the storage backend !");
+	}
 }
 
 /****************************************************/
 /**
- * Attach a memory backend to the server.
+ * Attach a memory backend to the server. It is wrapped to track the
+ * memory usage and apply the memory limit.
  * @param memoryBackend Pointer to the backend to be used.
 **/
 void Server::setMemoryBackend(MemoryBackend * memoryBackend)
@@ -144,13 +191,54 @@ void Server::setMemoryBackend(MemoryBackend * memoryBackend)
 	MemoryBackend * old = this->memoryBackend;
 
 	//replace in chiles
-	this->memoryBackend = memoryBackend;
-	this->container->setMemoryBackend(memoryBackend);
+	this->watermarkBackend = new MemoryBackendWatermark(memoryBackend, this->config->maxMemory);
+	this->memoryBackend = this->watermarkBackend;
+	this->tieredBackend = NULL;
+	this->container->setMemoryBackend(this->memoryBackend);
 
 	//delete old
 	delete old;
 }
 
+/****************************************************/
+/**
+ * Build the cache layer to be placed on top of a low level memory backend
+ * depending on the configuration.
+ * @param backend The low level backend to be cached. It will be deleted
+ * by the cache.
+ * @return The cached memory backend.
+**/
+MemoryBackend * Server::buildCache(MemoryBackend * backend)
+{
+	if (this->config->cache == "buddy")
+		return new MemoryBackendBuddy(backend, IOC_BUDDY_DEFAULT_ARENA_SIZE, this->config->cacheMaxSize);
+	else if (this->config->cache == "concurrent")
+		return new MemoryBackendConcurrentCache(backend);
+	else
+		return new MemoryBackendCache(backend);
+}
+
+/****************************************************/
+/**
+ * Place the prefaulted memory pool on top of the given backend if
+ * enabled by the configuration.
+ * @param backend The backend to place under the pool. It will be deleted
+ * by the pool.
+ * @return The backend to be used by the container.
+**/
+MemoryBackend * Server::buildPool(MemoryBackend * backend)
+{
+	//disabled
+	if (this->config->prefaultPoolSize == 0)
+		return backend;
+
+	//build
+	size_t chunks = this->config->prefaultPoolSize / IOC_SERVER_SEGMENT_SIZE;
+	if (chunks == 0)
+		chunks = 1;
+	return new MemoryBackendPrefault(backend, IOC_SERVER_SEGMENT_SIZE, chunks);
+}
+
 /****************************************************/
 /**
  * Setup the TCP server to receive new clients. It starts a new thread
@@ -207,11 +295,101 @@ void Server::setOnClientConnect(std::function<void(int id)> handler)
 void Server::poll(void)
 {
 	this->pollRunning = true;
-	while(this->pollRunning)
+	this->nextPeriodicTasks = std::chrono::steady_clock::now();
+	while(this->pollRunning) {
 		this->connection->poll(false);
+		if (this->storageBackend != NULL)
+			this->storageBackend->pollCompletions(false);
+		if (this->flushEngine != NULL)
+			this->flushEngine->pollCompletions(false);
+		this->runPeriodicTasks();
+	}
 	this->pollRunning = true;
 }
 
+/****************************************************/
+/**
+ * Run the maintenance tasks which need to access the objects so run
+ * in the polling thread. It is called on every loop but does something
+ * only every IOC_SERVER_PERIODIC_TASKS_MS. Notice with passive polling
+ * it runs only after an event.
+**/
+void Server::runPeriodicTasks(void)
+{
+	//check time
+	auto now = std::chrono::steady_clock::now();
+	if (now < this->nextPeriodicTasks)
+		return;
+	this->nextPeriodicTasks = now + std::chrono::milliseconds(IOC_SERVER_PERIODIC_TASKS_MS);
+
+	//move segments between memory tiers if there is no RDMA nor flush in flight
+	bool flushing = (this->flushEngine != NULL && this->flushEngine->getPending() > 0);
+	if (this->tieredBackend != NULL && this->connection->getPendingActions() == 0 && !flushing) {
+		std::vector<std::shared_ptr<ObjectSegmentMemory>> memories;
+		this->container->collectSegmentMemories(memories);
+		this->tieredBackend->rebalance(memories);
+	}
+
+	//create the objects whose creation has been deferred
+	this->container->applyPendingCreates();
+
+	//update the load stats printed by the stats thread
+	ObjectLoadStats loadStats = this->container->getLoadStats();
+	this->stats.loads = loadStats.loads;
+	this->stats.deduplicatedLoads = loadStats.deduplicated;
+	this->stats.holeLoads = loadStats.holes;
+
+	//write the logged data to the storage, continue a destaging stopped by the
+	//bandwidth limit or retry the replay of the sealed part if it failed before
+	if (this->wal != NULL && this->storageBackend != NULL && this->walDestaging && this->flushEngine == NULL) {
+		this->destageWal();
+	} else if (this->wal != NULL && this->storageBackend != NULL && this->walDestaging == false) {
+		if (this->wal->hasSealed())
+			this->wal->replaySealed(this->storageBackend);
+		else if (this->wal->hasRecords())
+			this->destageWal();
+	}
+}
+
+/****************************************************/
+/**
+ * Write the dirty segments to the storage to release the records of the
+ * write ahead log. The active file of the log is sealed before so the
+ * flushes acknowledged during the destaging are logged in the other file.
+ * If the destaging fails, the sealed records are replayed to the storage.
+ * Without flush engine, the destaging stops when reaching the bandwidth
+ * limit and is continued by the next periodic tasks.
+**/
+void Server::destageWal(void)
+{
+	//new records go to the other file
+	if (this->walDestaging == false) {
+		this->wal->seal();
+		this->walDestaging = true;
+	}
+
+	//release or replay on completion
+	auto onComplete = [this](int status) {
+		if (status == 0) {
+			this->wal->releaseSealed();
+		} else {
+			IOC_WARNING("Fail to destage the dirty segments, replay the write ahead log instead");
+			this->wal->replaySealed(this->storageBackend);
+		}
+		this->walDestaging = false;
+	};
+
+	//flush all the objects, without blocking the polling thread on the bandwidth limit
+	if (this->flushEngine == NULL) {
+		bool throttled = false;
+		int status = this->container->flushAll(&throttled);
+		if (throttled == false || status != 0)
+			onComplete(status);
+	} else {
+		this->container->flushAllAsync(*this->flushEngine, onComplete);
+	}
+}
+
 /****************************************************/
 /**
  * Start the statistics thread to print the bandwidths 
@@ -225,12 +403,54 @@ void Server::startStatsThread(void)
 		while (this->statsRunning) {
 			sleep(1);
 			printf("Read: %g GB/s, Write: %g GB/s\n", (double)this->stats.readSize/1.0/1024.0/1024.0/1024.0, (double) this->stats.writeSize/1.0/1024.0/1024.0/1024.0);
+			printf("Memory: %g GB, peak: %g GB, alloc failures: %zu, retry later: %zu\n",
+				(double)this->watermarkBackend->getUsed()/1024.0/1024.0/1024.0,
+				(double)this->watermarkBackend->getPeak()/1024.0/1024.0/1024.0,
+				this->watermarkBackend->getFailures(),
+				this->stats.retryLater);
+			this->printThrottleStats();
 			this->stats.readSize = 0;
 			this->stats.writeSize = 0;
 		}
 	});
 }
 
+/****************************************************/
+/**
+ * Print the flush progress and the state of the bandwidth limits, called
+ * every second by the stats thread.
+**/
+void Server::printThrottleStats(void)
+{
+	//vars
+	TokenBucket & flushThrottle = this->container->getFlushThrottle();
+	TokenBucket & missThrottle = this->container->getMissThrottle();
+	TokenBucketStats flushStats = flushThrottle.takeStats();
+	TokenBucketStats missStats = missThrottle.takeStats();
+	size_t pending = 0;
+	size_t queued = 0;
+	if (this->flushEngine != NULL) {
+		pending = this->flushEngine->getPending();
+		queued = this->flushEngine->getQueuedBytes();
+	}
+
+	//print
+	printf("Flush: %g MB/s (limit: %g MB/s), pending: %zu, queued: %g MB, throttled: %zu for %g ms\n",
+		(double)flushStats.consumed/1024.0/1024.0,
+		(double)flushThrottle.getRate()/1024.0/1024.0,
+		pending,
+		(double)queued/1024.0/1024.0,
+		flushStats.throttled,
+		(double)flushStats.throttledTimeUs/1000.0);
+	printf("Miss: %g MB/s (limit: %g MB/s), throttled: %zu, loads: %zu, deduplicated: %zu, holes: %zu\n",
+		(double)missStats.consumed/1024.0/1024.0,
+		(double)missThrottle.getRate()/1024.0/1024.0,
+		missStats.throttled,
+		this->stats.loads,
+		this->stats.deduplicatedLoads,
+		this->stats.holeLoads);
+}
+
 /****************************************************/
 /**
  * Stop the tcp thread and the polling.
@@ -278,12 +498,14 @@ void Server::onClientConnect(uint64_t tcpClientId, uint64_t key)
 /****************************************************/
 /**
  * On client disconnection we need to remove it from the allowed client list in
- * the connection.
+ * the connection. It is called by the TCP thread, the connection releases
+ * the credits of the client from the polling thread.
 **/
 void Server::onClientDisconnect(uint64_t tcpClientId)
 {
 	IOC_DEBUG_ARG("client:tcp", "Client disconnect tcpId=%1").arg(tcpClientId).end();
 	connection->getClientRegistry().disconnectClient(tcpClientId);
+	connection->onClientDisconnect(tcpClientId);
 	container->onClientDisconnect(tcpClientId);
 }
 
@@ -297,14 +519,24 @@ void Server::setNvdimm(const std::vector<std::string> & nvdimmPaths)
 	for (auto & it : nvdimmPaths) {
 		//allocate low level backend
 		MemoryBackendNvdimm * lowLevelBackend = new MemoryBackendNvdimm(this->domain, it);
+		lowLevelBackend->setPopulate(this->config->prefaultPoolSize > 0);
 
 		//setup cache
-		MemoryBackendCache * cache = new MemoryBackendCache(lowLevelBackend);
+		MemoryBackend * cache = this->buildCache(lowLevelBackend);
 
 		//register to round robin
 		backend->registerBackend(cache);
 	}
 
-	//setup
-	this->setMemoryBackend(backend);
+	//no dram tier
+	if (this->config->dramTierSize == 0) {
+		this->setMemoryBackend(this->buildPool(backend));
+		return;
+	}
+
+	//place the dram on top
+	MemoryBackend * dram = this->buildPool(this->buildCache(new MemoryBackendMalloc(this->domain)));
+	MemoryBackendTiered * tiered = new MemoryBackendTiered(dram, backend, this->config->dramTierSize);
+	this->setMemoryBackend(tiered);
+	this->tieredBackend = tiered;
 }
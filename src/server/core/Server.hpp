@@ -10,12 +10,17 @@
 /****************************************************/
 //std
 #include <thread>
+#include <chrono>
 //local
 #include "Config.hpp"
 #include "Container.hpp"
 #include "ServerStats.hpp"
 #include "StorageBackend.hpp"
+#include "FlushEngine.hpp"
+#include "WriteAheadLog.hpp"
 #include "MemoryBackend.hpp"
+#include "../backends/MemoryBackendTiered.hpp"
+#include "../backends/MemoryBackendWatermark.hpp"
 #include "../../base/network/LibfabricDomain.hpp"
 #include "../../base/network/LibfabricConnection.hpp"
 #include "../../base/network/TcpServer.hpp"
@@ -44,6 +49,12 @@ class Server
 	private:
 		//setups
 		void setupTcpServer(int port, int maxport);
+		MemoryBackend * buildCache(MemoryBackend * backend);
+		MemoryBackend * buildPool(MemoryBackend * backend);
+		//maintenance
+		void runPeriodicTasks(void);
+		void printThrottleStats(void);
+		void destageWal(void);
 		//conn tracking
 		void onClientConnect(uint64_t id, uint64_t key);
 		void onClientDisconnect(uint64_t id);
@@ -72,6 +83,18 @@ class Server
 		StorageBackend * storageBackend;
 		/** Keep track of the memory backend in use. **/
 		MemoryBackend * memoryBackend;
+		/** The top level memory backend tracking the memory usage for the stats. **/
+		MemoryBackendWatermark * watermarkBackend;
+		/** If the tiered memory backend is in use, pointer to it to rebalance it. **/
+		MemoryBackendTiered * tieredBackend;
+		/** If not NULL, engine used to flush the objects in parallel. **/
+		FlushEngine * flushEngine;
+		/** If not NULL, log used to acknowledge the flush operations before writing to the storage. **/
+		WriteAheadLog * wal;
+		/** True while the objects are flushed to release the sealed part of the log. **/
+		bool walDestaging;
+		/** Next time we need to run the periodic tasks from the polling loop. **/
+		std::chrono::steady_clock::time_point nextPeriodicTasks;
 };
 
 }
@@ -26,6 +26,14 @@ struct ServerStats
 	size_t readSize;
 	/** how much bytes we wrote. **/
 	size_t writeSize;
+	/** How many requests we asked to retry later due to memory exhaustion. **/
+	size_t retryLater;
+	/** How many ranges have been loaded from the storage by the objects. **/
+	size_t loads;
+	/** How many misses waited for a load already in flight instead of loading again. **/
+	size_t deduplicatedLoads;
+	/** How many misses have been filled with zeros without reading the storage. **/
+	size_t holeLoads;
 };
 
 }
@@ -66,3 +66,238 @@ ssize_t StorageBackend::makeCowSegment(int64_t highOrig, int64_t lowOrig, int64_
 	//retu
 	return size;
 }
+
+/****************************************************/
+/**
+ * Write a list of buffers which are contiguous in the object. The default
+ * implementation makes one pwrite() per buffer, the backends able to
+ * make a single operation override it.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param iov The list of buffers to write.
+ * @param iovcnt Number of buffers in the list.
+ * @param offset Offset in the object.
+ * @return The total size written or negative number in case of error.
+**/
+ssize_t StorageBackend::pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset)
+{
+	size_t done = 0;
+	for (int i = 0 ; i < iovcnt ; i++) {
+		ssize_t status = this->pwrite(high, low, iov[i].iov_base, iov[i].iov_len, offset + done);
+		if (status != (ssize_t)iov[i].iov_len)
+			return -1;
+		done += iov[i].iov_len;
+	}
+	return done;
+}
+
+/****************************************************/
+/**
+ * Register in the tracker the ranges of the object which are known to
+ * contain only zeros so they can be served without reading the storage.
+ * The default implementation knows nothing.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param holes The tracker to fill.
+ * @return True if the holes of the object have been registered, false if the
+ * backend cannot tell.
+**/
+bool StorageBackend::findHoles(int64_t high, int64_t low, HoleTracker & holes)
+{
+	return false;
+}
+
+/****************************************************/
+/**
+ * Init a request before submitting it.
+ * @param request The request to init.
+ * @param type The type of operation.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param buffer The buffer to read to or write from.
+ * @param size Size of the operation.
+ * @param offset Offset in the object.
+**/
+void StorageBackend::setupRequest(StorageRequest & request, StorageRequestType type, int64_t high, int64_t low, void * buffer, size_t size, size_t offset)
+{
+	request.type = type;
+	request.high = high;
+	request.low = low;
+	request.buffer = buffer;
+	request.size = size;
+	request.offset = offset;
+	request.iov = NULL;
+	request.iovcnt = 0;
+	request.status = 0;
+	request.done = false;
+	request.onComplete = nullptr;
+}
+
+/****************************************************/
+/**
+ * Init a vectored write request before submitting it.
+ * @param request The request to init.
+ * @param high The high part of the object ID.
+ * @param low The low part of the object ID.
+ * @param iov The list of buffers to write, must stay valid until completion.
+ * @param iovcnt Number of buffers in the list.
+ * @param offset Offset in the object.
+**/
+void StorageBackend::setupRequestVec(StorageRequest & request, int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset)
+{
+	//compute size
+	size_t size = 0;
+	for (int i = 0 ; i < iovcnt ; i++)
+		size += iov[i].iov_len;
+
+	//setup
+	setupRequest(request, STORAGE_REQUEST_WRITE, high, low, NULL, size, offset);
+	request.iov = iov;
+	request.iovcnt = iovcnt;
+}
+
+/****************************************************/
+/**
+ * Submit a batch of requests. The default implementation executes them
+ * synchronously with pread() and pwrite(), they are then reported as
+ * completed by the next call to pollCompletions(). The backends supporting
+ * asynchronous IO override it to keep many requests in flight.
+ * @param requests Array of requests to submit.
+ * @param count Number of requests in the array.
+**/
+void StorageBackend::submit(StorageRequest * requests, size_t count)
+{
+	for (size_t i = 0 ; i < count ; i++) {
+		StorageRequest & request = requests[i];
+		if (request.type == STORAGE_REQUEST_READ)
+			request.status = this->pread(request.high, request.low, request.buffer, request.size, request.offset);
+		else if (request.iov != NULL)
+			request.status = this->pwritev(request.high, request.low, request.iov, request.iovcnt, request.offset);
+		else
+			request.status = this->pwrite(request.high, request.low, request.buffer, request.size, request.offset);
+		this->pushCompleted(&request);
+	}
+}
+
+/****************************************************/
+/**
+ * Add a request to the list of the executed requests waiting for
+ * pollCompletions().
+ * @param request The request which has been executed.
+**/
+void StorageBackend::pushCompleted(StorageRequest * request)
+{
+	this->completed.push_back(request);
+}
+
+/****************************************************/
+/**
+ * Remove a request from the list of the executed requests if it is there.
+ * @param request The request to search.
+ * @return True if the request has been executed and removed from the list.
+**/
+bool StorageBackend::takeCompleted(StorageRequest * request)
+{
+	for (auto it = this->completed.begin() ; it != this->completed.end() ; ++it) {
+		if (*it == request) {
+			this->completed.erase(it);
+			return true;
+		}
+	}
+	return false;
+}
+
+/****************************************************/
+/**
+ * Fetch the operations executed by the backend and move them to the list
+ * of the completed requests with pushCompleted(). The default implementation
+ * executes the requests in submit() so there is nothing to fetch.
+ * @param wait Wait at least one operation if some are in flight.
+ * @return True if some operations are still in flight or have been fetched,
+ * false if the backend has nothing to report.
+**/
+bool StorageBackend::reapCompletions(bool wait)
+{
+	return false;
+}
+
+/****************************************************/
+/**
+ * @return True if some executed requests wait for pollCompletions().
+**/
+bool StorageBackend::hasCompleted(void)
+{
+	return this->completed.empty() == false;
+}
+
+/****************************************************/
+/**
+ * Mark the request as done and call its completion function.
+ * @param request The request which has been completed.
+ * @param status The status of the operation.
+**/
+void StorageBackend::complete(StorageRequest & request, ssize_t status)
+{
+	//mark
+	request.status = status;
+	request.done = true;
+
+	//take the function out of the request so it can release the request
+	std::function<void(StorageRequest & request)> onComplete;
+	onComplete.swap(request.onComplete);
+	if (onComplete)
+		onComplete(request);
+}
+
+/****************************************************/
+/**
+ * Check the completed requests and call their completion function. It is
+ * called by the server loop so the loads and flushes submitted by the hooks
+ * answer the clients when their IO is done.
+ * @param wait If true, wait at least one completion if there are requests
+ * in flight.
+ * @return The number of completed requests.
+**/
+size_t StorageBackend::pollCompletions(bool wait)
+{
+	//fetch
+	this->reapCompletions(wait && this->hasCompleted() == false);
+
+	//swap in case the completion functions submit new requests
+	std::vector<StorageRequest*> requests;
+	requests.swap(this->completed);
+
+	//complete
+	for (auto & it : requests)
+		this->complete(*it, it->status);
+
+	//ret
+	return requests.size();
+}
+
+/****************************************************/
+/**
+ * Wait the completion of the given requests and call their completion
+ * function. The other requests completed meanwhile are kept for the next
+ * pollCompletions().
+ * @param requests Array of requests to wait.
+ * @param count Number of requests in the array.
+**/
+void StorageBackend::wait(StorageRequest * requests, size_t count)
+{
+	for (size_t i = 0 ; i < count ; i++) {
+		while (true) {
+			//complete it if executed
+			if (requests[i].done)
+				break;
+			if (this->takeCompleted(&requests[i])) {
+				this->complete(requests[i], requests[i].status);
+				break;
+			}
+
+			//wait the backend
+			bool inFlight = this->reapCompletions(true);
+			assume(inFlight, "Waiting a storage request which has not been submitted !");
+		}
+	}
+}
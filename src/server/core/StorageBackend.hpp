@@ -10,16 +10,74 @@
 /****************************************************/
 //std
 #include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <sys/types.h>
+#include <sys/uio.h>
+//internal
+#include "HoleTracker.hpp"
 
 /****************************************************/
 namespace IOC
 {
 
+/****************************************************/
+/**
+ * Define the type of an asynchronous storage request.
+**/
+enum StorageRequestType
+{
+	/** Read data from the storage. **/
+	STORAGE_REQUEST_READ,
+	/** Write data to the storage. **/
+	STORAGE_REQUEST_WRITE,
+};
+
+/****************************************************/
+/**
+ * Describe an asynchronous storage request submitted with
+ * StorageBackend::submit(). The request must stay valid until
+ * it is completed.
+**/
+struct StorageRequest
+{
+	/** Type of operation. **/
+	StorageRequestType type;
+	/** The high part of the object ID. **/
+	int64_t high;
+	/** The low part of the object ID. **/
+	int64_t low;
+	/** The buffer to read to or write from. **/
+	void * buffer;
+	/** Size of the operation. **/
+	size_t size;
+	/** Offset in the object. **/
+	size_t offset;
+	/** If not NULL, make a vectored write from this list of buffers instead of buffer. **/
+	const struct iovec * iov;
+	/** Number of buffers in iov. **/
+	int iovcnt;
+	/** Result of the operation, same semantic than pread() and pwrite(). **/
+	ssize_t status;
+	/** Set to true when the request has been completed. **/
+	bool done;
+	/** Optional function called on completion from pollCompletions(). **/
+	std::function<void(StorageRequest & request)> onComplete;
+};
+
 /****************************************************/
 /**
  * A storage backend is an object handling the read and write operation to
  * data storage from the object in order to read / write or flush the data
  * to/from the storage.
+ *
+ * The asynchronous interface is not thread safe, it is used by the polling
+ * thread only. The server loop calls pollCompletions() so the requests submitted by
+ * the hooks are completed without blocking the polling thread. wait()
+ * only completes the given requests, the other ones are left to the next
+ * pollCompletions() so their completion functions are not called from
+ * inside an operation waiting for its own IO.
 **/
 class StorageBackend
 {
@@ -48,11 +106,27 @@ class StorageBackend
 		 * @return The size which has been written or negativ number in case of error.
 		**/
 		virtual ssize_t pwrite(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) = 0;
+		virtual ssize_t pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset);
 		/**
 		 * Make a mero object creation before accessing the object.
 		**/
 		virtual int create(int64_t high, int64_t low) = 0;
 		virtual ssize_t makeCowSegment(int64_t highOrig, int64_t lowOrig, int64_t highDest, int64_t lowDest, size_t offset, size_t size);
+		virtual bool findHoles(int64_t high, int64_t low, HoleTracker & holes);
+		virtual void submit(StorageRequest * requests, size_t count);
+		virtual size_t pollCompletions(bool wait);
+		void wait(StorageRequest * requests, size_t count);
+		static void setupRequest(StorageRequest & request, StorageRequestType type, int64_t high, int64_t low, void * buffer, size_t size, size_t offset);
+		static void setupRequestVec(StorageRequest & request, int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset);
+	protected:
+		virtual bool reapCompletions(bool wait);
+		void complete(StorageRequest & request, ssize_t status);
+		void pushCompleted(StorageRequest * request);
+		bool takeCompleted(StorageRequest * request);
+		bool hasCompleted(void);
+	private:
+		/** Requests already executed and waiting for pollCompletions() to call their completion function. **/
+		std::vector<StorageRequest*> completed;
 };
 
 }
@@ -0,0 +1,183 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <algorithm>
+//internal
+#include "Consts.hpp"
+#include "TokenBucket.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the token bucket.
+ * @param rate The bandwidth limit in bytes per second, 0 for unlimited.
+ * @param burst The maximum amount of bytes accumulated while idle, 0 to
+ * use IOC_TOKEN_BUCKET_DEFAULT_BURST_MS of traffic at the given rate.
+**/
+TokenBucket::TokenBucket(size_t rate, size_t burst)
+{
+	this->rate = 0;
+	this->burst = 0;
+	this->tokens = 0;
+	this->lastRefill = std::chrono::steady_clock::now();
+	this->stats = TokenBucketStats{0, 0, 0};
+	this->setRate(rate, burst);
+}
+
+/****************************************************/
+/**
+ * Change the bandwidth limit. The operations waiting in consume() are woken
+ * up to apply the new rate.
+ * @param rate The bandwidth limit in bytes per second, 0 for unlimited.
+ * @param burst The maximum amount of bytes accumulated while idle, 0 to
+ * use IOC_TOKEN_BUCKET_DEFAULT_BURST_MS of traffic at the given rate.
+**/
+void TokenBucket::setRate(size_t rate, size_t burst)
+{
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+
+	//account what was accumulated with the old rate
+	auto now = std::chrono::steady_clock::now();
+	this->refill(now);
+	bool wasUnlimited = (this->rate == 0);
+
+	//setup
+	this->rate = rate;
+	this->burst = burst;
+	if (this->burst == 0)
+		this->burst = rate * IOC_TOKEN_BUCKET_DEFAULT_BURST_MS / 1000;
+	if (this->burst == 0 && rate > 0)
+		this->burst = 1;
+
+	//start full if it was not limited before
+	if (wasUnlimited)
+		this->tokens = this->burst;
+	this->tokens = std::min(this->tokens, (double)this->burst);
+	this->lastRefill = now;
+
+	//wake up the waiters
+	this->rateCond.notify_all();
+}
+
+/****************************************************/
+/**
+ * @return The current bandwidth limit in bytes per second, 0 if unlimited.
+**/
+size_t TokenBucket::getRate(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->rate;
+}
+
+/****************************************************/
+/**
+ * @return The maximum amount of bytes accumulated while idle.
+**/
+size_t TokenBucket::getBurst(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	return this->burst;
+}
+
+/****************************************************/
+/**
+ * Add the tokens accumulated since the last refill. The mutex must be held.
+ * @param now The current time.
+**/
+void TokenBucket::refill(std::chrono::steady_clock::time_point now)
+{
+	//unlimited
+	if (this->rate == 0) {
+		this->lastRefill = now;
+		return;
+	}
+
+	//add
+	std::chrono::duration<double> elapsed = now - this->lastRefill;
+	this->tokens = std::min(this->tokens + elapsed.count() * this->rate, (double)this->burst);
+	this->lastRefill = now;
+}
+
+/****************************************************/
+/**
+ * Try to consume the given amount of bytes without waiting. It is used by
+ * the polling thread which cannot block, the caller has to delay the
+ * operation if it fails.
+ * @param size The amount of bytes.
+ * @return True if the operation can be made, false if it has to wait.
+**/
+bool TokenBucket::tryConsume(size_t size)
+{
+	//lock
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+
+	//refill & check
+	this->refill(std::chrono::steady_clock::now());
+	if (this->rate > 0 && this->tokens < 1) {
+		this->stats.throttled++;
+		return false;
+	}
+
+	//consume
+	if (this->rate > 0)
+		this->tokens -= size;
+	this->stats.consumed += size;
+	return true;
+}
+
+/****************************************************/
+/**
+ * Consume the given amount of bytes, waiting until the bucket is not empty.
+ * It is used by the flush threads.
+ * @param size The amount of bytes.
+**/
+void TokenBucket::consume(size_t size)
+{
+	//lock
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	//wait tokens
+	auto start = std::chrono::steady_clock::now();
+	bool waited = false;
+	while (true) {
+		auto now = std::chrono::steady_clock::now();
+		this->refill(now);
+		if (this->rate == 0 || this->tokens >= 1)
+			break;
+		std::chrono::duration<double> delay((1.0 - this->tokens) / this->rate);
+		waited = true;
+		this->rateCond.wait_for(lock, delay);
+	}
+
+	//account
+	if (waited) {
+		this->stats.throttled++;
+		this->stats.throttledTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//consume
+	if (this->rate > 0)
+		this->tokens -= size;
+	this->stats.consumed += size;
+}
+
+/****************************************************/
+/**
+ * Return the statistics accumulated since the last call and reset them.
+ * @return The statistics.
+**/
+TokenBucketStats TokenBucket::takeStats(void)
+{
+	std::lock_guard<std::mutex> lockGuard(this->mutex);
+	TokenBucketStats res = this->stats;
+	this->stats = TokenBucketStats{0, 0, 0};
+	return res;
+}
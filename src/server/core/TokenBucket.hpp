@@ -0,0 +1,78 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_TOKEN_BUCKET_HPP
+#define IOC_TOKEN_BUCKET_HPP
+
+/****************************************************/
+//std
+#include <cstdlib>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Statistics accumulated by a token bucket since the last call to
+ * TokenBucket::takeStats().
+**/
+struct TokenBucketStats
+{
+	/** Number of bytes consumed. **/
+	size_t consumed;
+	/** Number of operations which had to wait or have been refused. **/
+	size_t throttled;
+	/** Time spent waiting for tokens in consume() (in microseconds). **/
+	size_t throttledTimeUs;
+};
+
+/****************************************************/
+/**
+ * Token bucket used to limit the bandwidth of an operation class (flush,
+ * foreground misses...). The bucket is refilled at the given rate up to the
+ * burst size. An operation is accepted as soon as the bucket holds at least
+ * one token and can make it go in debt so requests larger than the burst
+ * still pass while the average bandwidth is respected. A rate of 0 disables the limit.
+ *
+ * The bucket is thread safe so it can be used by the flush threads and
+ * reconfigured at runtime from the polling thread.
+**/
+class TokenBucket
+{
+	public:
+		TokenBucket(size_t rate = 0, size_t burst = 0);
+		void setRate(size_t rate, size_t burst = 0);
+		size_t getRate(void);
+		size_t getBurst(void);
+		bool tryConsume(size_t size);
+		void consume(size_t size);
+		TokenBucketStats takeStats(void);
+	private:
+		void refill(std::chrono::steady_clock::time_point now);
+	private:
+		/** Refill rate in bytes per second, 0 for unlimited. **/
+		size_t rate;
+		/** Maximum amount of tokens which can be accumulated. **/
+		size_t burst;
+		/** Current amount of tokens, negative when in debt. **/
+		double tokens;
+		/** Last time the bucket has been refilled. **/
+		std::chrono::steady_clock::time_point lastRefill;
+		/** Statistics to be reported by takeStats(). **/
+		TokenBucketStats stats;
+		/** Protect the state. **/
+		std::mutex mutex;
+		/** Wake up the waiting consume() calls when the rate is changed. **/
+		std::condition_variable rateCond;
+};
+
+}
+
+#endif //IOC_TOKEN_BUCKET_HPP
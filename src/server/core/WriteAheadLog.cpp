@@ -0,0 +1,415 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <climits>
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE4_2__
+	#include <nmmintrin.h>
+#endif
+//unix
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+//internal
+#include "base/common/Debug.hpp"
+#include "WriteAheadLog.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/** Magic value placed at the beginning of each record ("IOCWAL"). **/
+#define IOC_WAL_MAGIC 0x494f4357414cUL
+
+/****************************************************/
+/**
+ * Constructor of the write ahead log. It opens or creates the two files of
+ * the log and drops the records partially written before a crash. The
+ * remaining records are kept until replay() is called.
+ * @param path Path prefix of the log files, typically in a FSDAX mountpoint
+ * to exploit the NVDIMM memory. The files are PATH.0 and PATH.1.
+**/
+WriteAheadLog::WriteAheadLog(const std::string & path)
+{
+	//setup
+	this->path = path;
+	this->active = 0;
+	this->sequence = 0;
+
+	//open the files & drop the torn records
+	uint64_t firstSequence[2];
+	uint64_t lastSequence[2];
+	for (int i = 0 ; i < 2 ; i++) {
+		std::string fname = path + "." + std::to_string(i);
+		this->fds[i] = open(fname.c_str(), O_RDWR | O_CREAT, 0600);
+		assumeArg(this->fds[i] >= 0, "Fail to open the write ahead log file '%1': %2").arg(fname).argStrErrno().end();
+		bool ok = true;
+		this->sizes[i] = this->scan(this->fds[i], NULL, firstSequence[i], lastSequence[i], ok);
+		int status = ftruncate(this->fds[i], this->sizes[i]);
+		assumeArg(status == 0, "Fail to truncate the write ahead log file '%1': %2").arg(fname).argStrErrno().end();
+	}
+
+	//continue the most recent file, the other one is the sealed one
+	for (int i = 0 ; i < 2 ; i++) {
+		if (this->sizes[i] > 0 && lastSequence[i] + 1 > this->sequence) {
+			this->active = i;
+			this->sequence = lastSequence[i] + 1;
+		}
+	}
+
+	//debug
+	IOC_DEBUG_ARG("wal", "Open write ahead log %1 with %2 of records").arg(path).argUnit1024(this->getSize()).end();
+}
+
+/****************************************************/
+/**
+ * Destructor of the write ahead log, it closes the files and keeps the
+ * records which are not yet released.
+**/
+WriteAheadLog::~WriteAheadLog(void)
+{
+	for (int i = 0 ; i < 2 ; i++)
+		close(this->fds[i]);
+}
+
+/****************************************************/
+/**
+ * Tables of the CRC32C (Castagnoli) software implementation processing 8
+ * bytes per step (slicing-by-8).
+**/
+struct WriteAheadLogCrcTables
+{
+	WriteAheadLogCrcTables(void);
+	uint32_t table[8][256];
+};
+
+/****************************************************/
+/**
+ * Build the tables with the reflected polynomial 0x82F63B78.
+**/
+WriteAheadLogCrcTables::WriteAheadLogCrcTables(void)
+{
+	for (uint32_t i = 0 ; i < 256 ; i++) {
+		uint32_t crc = i;
+		for (int j = 0 ; j < 8 ; j++)
+			crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1)));
+		this->table[0][i] = crc;
+	}
+	for (uint32_t i = 0 ; i < 256 ; i++)
+		for (int k = 1 ; k < 8 ; k++)
+			this->table[k][i] = (this->table[k-1][i] >> 8) ^ this->table[0][this->table[k-1][i] & 0xFF];
+}
+
+/****************************************************/
+/**
+ * Update a CRC32C with the given buffer. It uses the SSE4.2 instruction
+ * when the build enables it and the word-wise tables otherwise.
+ * @param crc The current CRC, inverted.
+ * @param buffer The buffer to add.
+ * @param size Size of the buffer.
+ * @return The updated CRC, inverted.
+**/
+static uint32_t crc32c(uint32_t crc, const void * buffer, size_t size)
+{
+	//vars
+	const unsigned char * cursor = (const unsigned char *)buffer;
+
+#ifdef __SSE4_2__
+	//by words
+	uint64_t crc64 = crc;
+	for ( ; size >= 8 ; size -= 8, cursor += 8) {
+		uint64_t word;
+		memcpy(&word, cursor, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+	}
+	crc = crc64;
+
+	//remaining bytes
+	for ( ; size > 0 ; size--, cursor++)
+		crc = _mm_crc32_u8(crc, *cursor);
+#else
+	//tables built on first use
+	static const WriteAheadLogCrcTables tables;
+	const uint32_t (*table)[256] = tables.table;
+
+	//by words, the tables expect the little endian order
+	for ( ; size >= 8 ; size -= 8, cursor += 8) {
+		uint32_t low = crc ^ ((uint32_t)cursor[0] | (uint32_t)cursor[1] << 8 | (uint32_t)cursor[2] << 16 | (uint32_t)cursor[3] << 24);
+		crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+			^ table[3][cursor[4]] ^ table[2][cursor[5]] ^ table[1][cursor[6]] ^ table[0][cursor[7]];
+	}
+
+	//remaining bytes
+	for ( ; size > 0 ; size--, cursor++)
+		crc = (crc >> 8) ^ table[0][(crc ^ *cursor) & 0xFF];
+#endif
+
+	//ret
+	return crc;
+}
+
+/****************************************************/
+/**
+ * Compute the checksum of a record with the CRC32C.
+ * @param record The header of the record, the checksum field is ignored.
+ * @param data The data of the record.
+ * @return The checksum.
+**/
+uint64_t WriteAheadLog::checksum(const WriteAheadLogRecord & record, const void * data)
+{
+	//vars
+	WriteAheadLogRecord header = record;
+	header.checksum = 0;
+
+	//header & data
+	uint32_t crc = 0xFFFFFFFFU;
+	crc = crc32c(crc, &header, sizeof(header));
+	crc = crc32c(crc, data, record.size);
+
+	//ret
+	return ~crc;
+}
+
+/****************************************************/
+/**
+ * Append the given extents of an object to the log and wait until they are
+ * persistent.
+ * @param high High part of the object ID.
+ * @param low Low part of the object ID.
+ * @param extents The object ranges to log with their data.
+ * @return True on success, false if the log cannot be written, nothing is
+ * then logged.
+**/
+bool WriteAheadLog::append(int64_t high, int64_t low, const std::vector<ObjectSegmentDescr> & extents)
+{
+	//nothing to do
+	if (extents.empty())
+		return true;
+
+	//build the records
+	std::vector<WriteAheadLogRecord> records(extents.size());
+	std::vector<struct iovec> iov(2 * extents.size());
+	size_t total = 0;
+	for (size_t i = 0 ; i < extents.size() ; i++) {
+		WriteAheadLogRecord & record = records[i];
+		record.magic = IOC_WAL_MAGIC;
+		record.sequence = this->sequence++;
+		record.high = high;
+		record.low = low;
+		record.offset = extents[i].offset;
+		record.size = extents[i].size;
+		record.checksum = checksum(record, extents[i].ptr);
+		iov[2*i].iov_base = &record;
+		iov[2*i].iov_len = sizeof(record);
+		iov[2*i+1].iov_base = extents[i].ptr;
+		iov[2*i+1].iov_len = extents[i].size;
+		total += sizeof(record) + extents[i].size;
+	}
+
+	//write by chunks of IOV_MAX
+	int fd = this->fds[this->active];
+	size_t offset = this->sizes[this->active];
+	bool ok = true;
+	for (size_t i = 0 ; i < iov.size() && ok ; i += IOV_MAX) {
+		int cnt = std::min(iov.size() - i, (size_t)IOV_MAX);
+		size_t expected = 0;
+		for (int j = 0 ; j < cnt ; j++)
+			expected += iov[i+j].iov_len;
+		ssize_t ret = ::pwritev(fd, &iov[i], cnt, offset);
+		ok = (ret == (ssize_t)expected);
+		offset += expected;
+	}
+
+	//make it persistent
+	if (ok)
+		ok = (fdatasync(fd) == 0);
+
+	//error, drop what was partially written
+	if (ok == false) {
+		IOC_WARNING_ARG("Fail to write the write ahead log '%1': %2").arg(this->path).argStrErrno().end();
+		if (ftruncate(fd, this->sizes[this->active]) != 0)
+			IOC_WARNING_ARG("Fail to truncate the write ahead log '%1': %2").arg(this->path).argStrErrno().end();
+		return false;
+	}
+
+	//ok
+	this->sizes[this->active] += total;
+	return true;
+}
+
+/****************************************************/
+/**
+ * @return True if the active file contains records not yet destaged.
+**/
+bool WriteAheadLog::hasRecords(void) const
+{
+	return this->sizes[this->active] > 0;
+}
+
+/****************************************************/
+/**
+ * @return True if the sealed file contains records not yet released.
+**/
+bool WriteAheadLog::hasSealed(void) const
+{
+	return this->sizes[1 - this->active] > 0;
+}
+
+/****************************************************/
+/**
+ * Seal the active file when starting to destage the dirty segments. The new
+ * records go to the other file which must have been released.
+**/
+void WriteAheadLog::seal(void)
+{
+	assume(this->hasSealed() == false, "Cannot seal the write ahead log before releasing the previous sealed file !");
+	this->active = 1 - this->active;
+}
+
+/****************************************************/
+/**
+ * Release the sealed records when their data have been written to the
+ * storage backend.
+**/
+void WriteAheadLog::releaseSealed(void)
+{
+	this->reset(1 - this->active);
+}
+
+/****************************************************/
+/**
+ * Truncate one of the files.
+ * @param id Index of the file to reset.
+**/
+void WriteAheadLog::reset(int id)
+{
+	int status = ftruncate(this->fds[id], 0);
+	assumeArg(status == 0, "Fail to truncate the write ahead log '%1': %2").arg(this->path).argStrErrno().end();
+	fdatasync(this->fds[id]);
+	this->sizes[id] = 0;
+}
+
+/****************************************************/
+/**
+ * Loop on the valid records of a file and write them to the storage backend
+ * if one is given.
+ * @param fd The file descriptor of the file.
+ * @param storageBackend If not NULL, write the records to this backend.
+ * @param firstSequence Set to the sequence number of the first record.
+ * @param lastSequence Set to the sequence number of the last record.
+ * @param ok Set to false if one of the writes to the storage failed.
+ * @return The size of the valid records.
+**/
+size_t WriteAheadLog::scan(int fd, StorageBackend * storageBackend, uint64_t & firstSequence, uint64_t & lastSequence, bool & ok)
+{
+	//vars
+	size_t offset = 0;
+	std::vector<char> data;
+	firstSequence = 0;
+	lastSequence = 0;
+
+	//loop on records
+	while (true) {
+		//read header
+		WriteAheadLogRecord record;
+		ssize_t ret = ::pread(fd, &record, sizeof(record), offset);
+		if (ret != sizeof(record) || record.magic != IOC_WAL_MAGIC)
+			break;
+
+		//read data
+		data.resize(record.size);
+		ret = ::pread(fd, data.data(), record.size, offset + sizeof(record));
+		if (ret != (ssize_t)record.size || checksum(record, data.data()) != record.checksum)
+			break;
+
+		//write to the storage
+		if (storageBackend != NULL) {
+			ret = storageBackend->pwrite(record.high, record.low, data.data(), record.size, record.offset);
+			if (ret != (ssize_t)record.size)
+				ok = false;
+		}
+
+		//move
+		if (offset == 0)
+			firstSequence = record.sequence;
+		lastSequence = record.sequence;
+		offset += sizeof(record) + record.size;
+	}
+
+	//ret
+	return offset;
+}
+
+/****************************************************/
+/**
+ * Write the records of the sealed file to the storage backend and release
+ * them. It is used when the destaging of the segments failed.
+ * @param storageBackend The storage backend to write to.
+ * @return True on success, false if some writes failed, the records are
+ * then kept.
+**/
+bool WriteAheadLog::replaySealed(StorageBackend * storageBackend)
+{
+	//check
+	assert(storageBackend != NULL);
+
+	//replay
+	uint64_t firstSequence, lastSequence;
+	bool ok = true;
+	this->scan(this->fds[1 - this->active], storageBackend, firstSequence, lastSequence, ok);
+
+	//release
+	if (ok)
+		this->releaseSealed();
+	return ok;
+}
+
+/****************************************************/
+/**
+ * Write all the records to the storage backend in order and release them. It
+ * is used on restart to write the data acknowledged before a crash.
+ * @param storageBackend The storage backend to write to.
+ * @return True on success, false if some writes failed, the records are
+ * then kept.
+**/
+bool WriteAheadLog::replay(StorageBackend * storageBackend)
+{
+	//check
+	assert(storageBackend != NULL);
+
+	//nothing to do
+	if (this->getSize() == 0)
+		return true;
+
+	//replay the sealed one first as it is the oldest
+	IOC_DEBUG_ARG("wal", "Replay %1 of records from %2").argUnit1024(this->getSize()).arg(this->path).end();
+	uint64_t firstSequence, lastSequence;
+	bool ok = true;
+	this->scan(this->fds[1 - this->active], storageBackend, firstSequence, lastSequence, ok);
+	this->scan(this->fds[this->active], storageBackend, firstSequence, lastSequence, ok);
+
+	//release
+	if (ok) {
+		this->reset(0);
+		this->reset(1);
+	}
+	return ok;
+}
+
+/****************************************************/
+/**
+ * @return The size of the records in the two files.
+**/
+size_t WriteAheadLog::getSize(void) const
+{
+	return this->sizes[0] + this->sizes[1];
+}
@@ -0,0 +1,93 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_WRITE_AHEAD_LOG_HPP
+#define IOC_WRITE_AHEAD_LOG_HPP
+
+/****************************************************/
+//std
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+//internal
+#include "ObjectSegment.hpp"
+#include "StorageBackend.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Header placed before the data of each record of the log.
+**/
+struct WriteAheadLogRecord
+{
+	/** Magic value to detect the end of the valid records. **/
+	uint64_t magic;
+	/** Sequence number of the record, to replay the two files in order. **/
+	uint64_t sequence;
+	/** High part of the object ID. **/
+	int64_t high;
+	/** Low part of the object ID. **/
+	int64_t low;
+	/** Offset of the data in the object. **/
+	uint64_t offset;
+	/** Size of the data following the header. **/
+	uint64_t size;
+	/** Checksum of the header (with checksum at 0) and the data to detect torn writes. **/
+	uint64_t checksum;
+};
+
+/****************************************************/
+/**
+ * Write ahead log used to acknowledge the flush operations as soon as the
+ * dirty data are persistent on the local NVDIMM. The data are copied in the
+ * log because the segments files are not kept over a restart. The segments
+ * stay dirty and are destaged later to the storage backend.
+ *
+ * The log is made of two files used in turn. When the destaging starts the
+ * active file is sealed and the new records go to the other one. When all the
+ * data sealed are written to the storage, the sealed file is released
+ * (truncated). On restart, the records of both files are replayed in order
+ * to the storage backend.
+ *
+ * The log is used only from the polling thread so it is not thread safe.
+**/
+class WriteAheadLog
+{
+	public:
+		WriteAheadLog(const std::string & path);
+		~WriteAheadLog(void);
+		bool append(int64_t high, int64_t low, const std::vector<ObjectSegmentDescr> & extents);
+		bool hasRecords(void) const;
+		bool hasSealed(void) const;
+		void seal(void);
+		void releaseSealed(void);
+		bool replaySealed(StorageBackend * storageBackend);
+		bool replay(StorageBackend * storageBackend);
+		size_t getSize(void) const;
+	private:
+		size_t scan(int fd, StorageBackend * storageBackend, uint64_t & firstSequence, uint64_t & lastSequence, bool & ok);
+		void reset(int id);
+		static uint64_t checksum(const WriteAheadLogRecord & record, const void * data);
+	private:
+		/** Path prefix of the two files. **/
+		std::string path;
+		/** File descriptors of the two files. **/
+		int fds[2];
+		/** Amount of valid data in each file. **/
+		size_t sizes[2];
+		/** Index of the file receiving the new records. **/
+		int active;
+		/** Sequence number of the next record. **/
+		uint64_t sequence;
+};
+
+}
+
+#endif //IOC_WRITE_AHEAD_LOG_HPP
@@ -42,3 +42,40 @@ TEST(TestBackend, makeCowSegment)
 
 	storage.makeCowSegment(20, 10, 20, 11, 1000, 500);
 }
+
+/****************************************************/
+TEST(TestBackend, submit_default)
+{
+	//vars
+	StorageBackendGMock storage;
+	char buffer[1000];
+	StorageRequest requests[2];
+	int calls = 0;
+
+	//expect calls
+	EXPECT_CALL(storage, pread(20, 10, buffer, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+	EXPECT_CALL(storage, pwrite(20, 10, buffer + 500, 500, 0))
+		.Times(1)
+		.WillOnce(Return(-1));
+
+	//submit
+	StorageBackend::setupRequest(requests[0], STORAGE_REQUEST_READ, 20, 10, buffer, 500, 1000);
+	StorageBackend::setupRequest(requests[1], STORAGE_REQUEST_WRITE, 20, 10, buffer + 500, 500, 0);
+	requests[0].onComplete = [&calls](StorageRequest &) {calls++;};
+	storage.submit(requests, 2);
+
+	//not yet completed
+	EXPECT_FALSE(requests[0].done);
+	EXPECT_EQ(0, calls);
+
+	//poll
+	EXPECT_EQ(2, storage.pollCompletions(false));
+	EXPECT_EQ(0, storage.pollCompletions(false));
+	EXPECT_EQ(1, calls);
+	EXPECT_TRUE(requests[0].done);
+	EXPECT_EQ(500, requests[0].status);
+	EXPECT_TRUE(requests[1].done);
+	EXPECT_EQ(-1, requests[1].status);
+}
@@ -26,21 +26,59 @@ TEST(TestConfig, options)
 		"--no-auth",
 		"--verbose=core",
 		"--merofile=./mero.rc",
+		"--storage-dir=/tmp/storage",
+		"--buddy",
+		"--cache-max=64",
+		"--prefault-pool=128",
+		"--dram-tier=256",
+		"--max-memory=512",
+		"--max-flush=32",
+		"--flush-threads=4",
+		"--lazy-create",
+		"--wal=/tmp/wal",
+		"--flush-bw=100",
+		"--miss-bw=200",
+		"--recv-slabs=8",
+		"--recv-slab-size=4",
+		"--cq-batch=32",
+		"--eager-max=256",
+		"--rdma-chunk=1024",
+		"--rdma-inflight=2",
+		"--credits=8",
 		"127.0.0.1",
 		"\0"
 	};
 
 	//parse
-	config.parseArgs(8, argv);
+	config.parseArgs(27, argv);
 
 	//check status
 	EXPECT_EQ(2, config.nvdimmMountPath.size());
 	EXPECT_EQ("/path1", config.nvdimmMountPath[0]);
 	EXPECT_EQ("/path2", config.nvdimmMountPath[1]);
 	EXPECT_EQ("./mero.rc", config.meroRcFile);
+	EXPECT_EQ("/tmp/storage", config.storageDir);
 	EXPECT_FALSE(config.consistencyCheck);
 	EXPECT_TRUE(config.activePolling);
 	EXPECT_FALSE(config.clientAuth);
+	EXPECT_EQ("buddy", config.cache);
+	EXPECT_EQ(64UL*1024UL*1024UL, config.cacheMaxSize);
+	EXPECT_EQ(128UL*1024UL*1024UL, config.prefaultPoolSize);
+	EXPECT_EQ(256UL*1024UL*1024UL, config.dramTierSize);
+	EXPECT_EQ(512UL*1024UL*1024UL, config.maxMemory);
+	EXPECT_EQ(32UL*1024UL*1024UL, config.maxFlushSize);
+	EXPECT_EQ(4, config.flushThreads);
+	EXPECT_TRUE(config.lazyCreate);
+	EXPECT_EQ("/tmp/wal", config.walPath);
+	EXPECT_EQ(100UL*1024UL*1024UL, config.flushBandwidth);
+	EXPECT_EQ(200UL*1024UL*1024UL, config.missBandwidth);
+	EXPECT_EQ(8, config.recvSlabs);
+	EXPECT_EQ(4UL*1024UL*1024UL, config.recvSlabSize);
+	EXPECT_EQ(32, config.cqBatchSize);
+	EXPECT_EQ(256UL*1024UL, config.eagerMax);
+	EXPECT_EQ(1024UL*1024UL, config.rdmaChunkSize);
+	EXPECT_EQ(2, config.rdmaMaxInflight);
+	EXPECT_EQ(8, config.credits);
 }
 
 /****************************************************/
@@ -52,3 +90,21 @@ TEST(TestConfig, initForUnitTest)
 	EXPECT_TRUE(config.activePolling);
 	EXPECT_EQ("127.0.0.1", config.listenIP);
 }
+
+/****************************************************/
+TEST(TestConfig, cache)
+{
+	//build object to test
+	Config config;
+	EXPECT_EQ("exact", config.cache);
+
+	//select
+	const char * argv[] = {
+		"ioc-server",
+		"--cache=concurrent",
+		"127.0.0.1",
+		"\0"
+	};
+	config.parseArgs(3, argv);
+	EXPECT_EQ("concurrent", config.cache);
+}
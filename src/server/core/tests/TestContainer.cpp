@@ -8,9 +8,11 @@
 #include <gtest/gtest.h>
 #include "../Container.hpp"
 #include "../../backends/MemoryBackendMalloc.hpp"
+#include "../../backends/StorageBackendGMock.hpp"
 
 /****************************************************/
 using namespace IOC;
+using namespace testing;
 
 /****************************************************/
 TEST(TestContainer, constructor)
@@ -143,3 +145,82 @@ TEST(TestContainer, makeObjectRangeCow_ok_exist)
 	bool res = container.makeObjectRangeCow(ObjectId(10,20), ObjectId(10,21), false, 1000, 500);
 	ASSERT_FALSE(res);
 }
+
+/****************************************************/
+TEST(TestContainer, flushAll)
+{
+	//setup
+	MemoryBackendMalloc mback(NULL);
+	StorageBackendGMock storage;
+	Container container(&storage, &mback);
+	for (int i = 0 ; i < 2 ; i++) {
+		ObjectSegmentList lst;
+		Object & object = container.getObject(ObjectId(10, 20 + i));
+		object.getBuffers(lst, 0, 500, ACCESS_WRITE, false);
+		object.markDirty(0, 500);
+	}
+
+	//expect writes
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 0)).Times(1).WillOnce(Return(500));
+	EXPECT_CALL(storage, pwrite(10, 21, _, 500, 0)).Times(1).WillOnce(Return(-1));
+
+	//flush, all are written even if one failed
+	EXPECT_EQ(-1, container.flushAll());
+	EXPECT_EQ(0, container.flushAll());
+}
+
+/****************************************************/
+TEST(TestContainer, flushAllAsync)
+{
+	//setup
+	MemoryBackendMalloc mback(NULL);
+	StorageBackendGMock storage;
+	Container container(&storage, &mback);
+	FlushEngine engine(2);
+	for (int i = 0 ; i < 2 ; i++) {
+		ObjectSegmentList lst;
+		Object & object = container.getObject(ObjectId(10, 20 + i));
+		object.getBuffers(lst, 0, 500, ACCESS_WRITE, false);
+		object.markDirty(0, 500);
+	}
+
+	//expect writes
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 0)).Times(1).WillOnce(Return(500));
+	EXPECT_CALL(storage, pwrite(10, 21, _, 500, 0)).Times(1).WillOnce(Return(500));
+
+	//flush
+	int status = 1;
+	container.flushAllAsync(engine, [&status](int ret) {status = ret;});
+	engine.pollCompletions(true);
+	EXPECT_EQ(0, status);
+
+	//nothing to do, complete immediately
+	status = 1;
+	container.flushAllAsync(engine, [&status](int ret) {status = ret;});
+	EXPECT_EQ(0, status);
+}
+
+/****************************************************/
+TEST(TestContainer, applyPendingCreates)
+{
+	//setup
+	MemoryBackendMalloc mback(NULL);
+	StorageBackendGMock storage;
+	Container container(&storage, &mback);
+
+	//defer, nothing done
+	container.deferObjectCreate(ObjectId(10, 20));
+	container.deferObjectCreate(ObjectId(10, 21));
+	container.deferObjectCreate(ObjectId(10, 21));
+	EXPECT_EQ(2, container.getPendingCreates());
+
+	//flush the first one, created before
+	EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(0));
+	EXPECT_EQ(0, container.getObject(ObjectId(10, 20)).flush(0, 0));
+
+	//batch the others
+	EXPECT_CALL(storage, create(10, 21)).Times(1).WillOnce(Return(0));
+	EXPECT_EQ(1, container.applyPendingCreates());
+	EXPECT_EQ(0, container.getPendingCreates());
+	EXPECT_EQ(0, container.applyPendingCreates());
+}
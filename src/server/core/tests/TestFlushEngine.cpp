@@ -0,0 +1,222 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <atomic>
+#include <unistd.h>
+#include <chrono>
+#include "../FlushEngine.hpp"
+#include "../Object.hpp"
+#include "../../backends/MemoryBackendMalloc.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Storage backend counting the concurrent writes.
+**/
+class StorageBackendConcurrency : public StorageBackend
+{
+	public:
+		StorageBackendConcurrency(void) {this->current = 0; this->max = 0; this->writes = 0; this->fail = false;};
+		virtual ssize_t pread(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override {return size;};
+		virtual ssize_t pwrite(int64_t high, int64_t low, void * buffer, size_t size, size_t offset) override {
+			size_t cur = ++this->current;
+			size_t old = this->max;
+			while (cur > old && !this->max.compare_exchange_weak(old, cur)) {};
+			usleep(2000);
+			this->current--;
+			this->writes++;
+			return this->fail ? -1 : size;
+		};
+		virtual int create(int64_t high, int64_t low) override {return 0;};
+		std::atomic<size_t> current;
+		std::atomic<size_t> max;
+		std::atomic<size_t> writes;
+		bool fail;
+};
+
+/****************************************************/
+static FlushBatch * buildBatch(StorageBackend * storage, size_t count, int * status)
+{
+	static char buffer[64];
+	FlushBatch * batch = new FlushBatch;
+	batch->storageBackend = storage;
+	batch->throttle = NULL;
+	batch->requests.resize(count);
+	for (size_t i = 0 ; i < count ; i++)
+		StorageBackend::setupRequest(batch->requests[i], STORAGE_REQUEST_WRITE, 10, 20, buffer, sizeof(buffer), i * sizeof(buffer));
+	batch->onComplete = [status](int ret) {*status = ret;};
+	return batch;
+}
+
+/****************************************************/
+TEST(TestFlushEngine, constructor)
+{
+	FlushEngine engine(4);
+	EXPECT_EQ(4, engine.getThreads());
+	EXPECT_EQ(0, engine.getPending());
+}
+
+/****************************************************/
+TEST(TestFlushEngine, parallel)
+{
+	//vars
+	StorageBackendConcurrency storage;
+	FlushEngine engine(4);
+	int status1 = 1;
+	int status2 = 1;
+
+	//submit two batches
+	engine.submit(buildBatch(&storage, 16, &status1));
+	engine.submit(buildBatch(&storage, 16, &status2));
+	EXPECT_EQ(2, engine.getPending());
+
+	//wait
+	EXPECT_EQ(2, engine.pollCompletions(true));
+	EXPECT_EQ(0, engine.getPending());
+	EXPECT_EQ(0, status1);
+	EXPECT_EQ(0, status2);
+	EXPECT_EQ(32, storage.writes);
+
+	//check concurrency cap
+	EXPECT_GT(storage.max, 1);
+	EXPECT_LE(storage.max, 4);
+}
+
+/****************************************************/
+TEST(TestFlushEngine, throttle)
+{
+	//vars
+	StorageBackendConcurrency storage;
+	FlushEngine engine(4);
+	TokenBucket throttle(6400, 64);
+	int status = 1;
+
+	//submit, each write needs 10ms of tokens
+	FlushBatch * batch = buildBatch(&storage, 8, &status);
+	batch->throttle = &throttle;
+	auto start = std::chrono::steady_clock::now();
+	engine.submit(batch);
+	EXPECT_LE(engine.getQueuedBytes(), 8 * 64);
+
+	//wait
+	EXPECT_EQ(1, engine.pollCompletions(true));
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	EXPECT_EQ(0, status);
+	EXPECT_EQ(0, engine.getQueuedBytes());
+	EXPECT_GE(elapsed, std::chrono::milliseconds(50));
+
+	//check stats
+	TokenBucketStats stats = throttle.takeStats();
+	EXPECT_EQ(8 * 64, stats.consumed);
+	EXPECT_GT(stats.throttled, 0);
+}
+
+/****************************************************/
+TEST(TestFlushEngine, failure)
+{
+	//vars
+	StorageBackendConcurrency storage;
+	storage.fail = true;
+	FlushEngine engine(2);
+	int status = 1;
+
+	//submit & wait
+	engine.submit(buildBatch(&storage, 4, &status));
+	EXPECT_EQ(1, engine.pollCompletions(true));
+	EXPECT_EQ(-1, status);
+}
+
+/****************************************************/
+TEST(TestFlushEngine, empty_batch)
+{
+	//vars
+	StorageBackendConcurrency storage;
+	FlushEngine engine(2);
+	int status = 1;
+
+	//submit & poll
+	engine.submit(buildBatch(&storage, 0, &status));
+	EXPECT_EQ(1, engine.pollCompletions(false));
+	EXPECT_EQ(0, status);
+}
+
+/****************************************************/
+TEST(TestFlushEngine, object_flushAsync)
+{
+	//vars
+	MemoryBackendMalloc mback(NULL);
+	StorageBackendConcurrency storage;
+	FlushEngine engine(4);
+	Object object(&storage, &mback, ObjectId(10, 20));
+	object.setMaxFlushSize(0);
+
+	//make dirty segments
+	for (size_t i = 0 ; i < 8 ; i++) {
+		ObjectSegmentList lst;
+		object.getBuffers(lst, i * 1024, 1024, ACCESS_WRITE, false);
+	}
+	object.markDirty(0, 8 * 1024);
+
+	//flush
+	int status = 1;
+	object.flushAsync(0, 0, engine, [&status](int ret) {status = ret;});
+	EXPECT_EQ(1, engine.pollCompletions(true));
+	EXPECT_EQ(0, status);
+	EXPECT_EQ(8, storage.writes);
+
+	//nothing more to flush, complete immediately
+	status = 1;
+	object.flushAsync(0, 0, engine, [&status](int ret) {status = ret;});
+	EXPECT_EQ(0, status);
+	EXPECT_EQ(0, engine.getPending());
+	EXPECT_EQ(8, storage.writes);
+}
+
+/****************************************************/
+TEST(TestFlushEngine, object_flushAsync_redirty_in_flight)
+{
+	//vars
+	MemoryBackendMalloc mback(NULL);
+	StorageBackendConcurrency storage;
+	FlushEngine engine(4);
+	Object object(&storage, &mback, ObjectId(10, 20));
+	object.setMaxFlushSize(0);
+
+	//make dirty segments
+	for (size_t i = 0 ; i < 8 ; i++) {
+		ObjectSegmentList lst;
+		object.getBuffers(lst, i * 1024, 1024, ACCESS_WRITE, false);
+	}
+	object.markDirty(0, 8 * 1024);
+
+	//flush & write again while in flight
+	int status1 = 1;
+	object.flushAsync(0, 0, engine, [&status1](int ret) {status1 = ret;});
+	object.markDirty(0, 1024);
+
+	//the second flush waits the first one
+	int status2 = 1;
+	object.flushAsync(0, 0, engine, [&status2](int ret) {status2 = ret;});
+	EXPECT_EQ(1, engine.getPending());
+	EXPECT_EQ(1, status2);
+
+	//both complete, the segment written meanwhile is written again
+	EXPECT_EQ(2, engine.pollCompletions(true));
+	EXPECT_EQ(0, status1);
+	EXPECT_EQ(0, status2);
+	EXPECT_EQ(9, storage.writes);
+
+	//all clean now
+	int status3 = 1;
+	object.flushAsync(0, 0, engine, [&status3](int ret) {status3 = ret;});
+	EXPECT_EQ(0, status3);
+	EXPECT_EQ(0, engine.getPending());
+	EXPECT_EQ(9, storage.writes);
+}
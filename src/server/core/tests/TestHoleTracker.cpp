@@ -0,0 +1,120 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include "../HoleTracker.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+TEST(TestHoleTracker, constructor)
+{
+	HoleTracker holes;
+	EXPECT_EQ(0, holes.getCount());
+	EXPECT_FALSE(holes.isHole(0, 100));
+}
+
+/****************************************************/
+TEST(TestHoleTracker, addHole)
+{
+	HoleTracker holes;
+	holes.addHole(1000, 500);
+	EXPECT_TRUE(holes.isHole(1000, 500));
+	EXPECT_TRUE(holes.isHole(1100, 100));
+	EXPECT_FALSE(holes.isHole(900, 200));
+	EXPECT_FALSE(holes.isHole(1400, 200));
+	EXPECT_FALSE(holes.isHole(0, 100));
+}
+
+/****************************************************/
+TEST(TestHoleTracker, addHole_merge)
+{
+	HoleTracker holes;
+
+	//contiguous
+	holes.addHole(1000, 500);
+	holes.addHole(1500, 500);
+	EXPECT_EQ(1, holes.getCount());
+	EXPECT_TRUE(holes.isHole(1000, 1000));
+
+	//separated
+	holes.addHole(3000, 500);
+	EXPECT_EQ(2, holes.getCount());
+	EXPECT_FALSE(holes.isHole(1000, 2500));
+
+	//fill the gap
+	holes.addHole(1800, 1500);
+	EXPECT_EQ(1, holes.getCount());
+	EXPECT_TRUE(holes.isHole(1000, 2500));
+}
+
+/****************************************************/
+TEST(TestHoleTracker, addHole_end)
+{
+	HoleTracker holes;
+	holes.addHole(4096, SIZE_MAX - 4096);
+	EXPECT_TRUE(holes.isHole(4096, 100));
+	EXPECT_TRUE(holes.isHole(1UL << 40, 1UL << 20));
+	EXPECT_FALSE(holes.isHole(0, 4096));
+
+	//the whole object
+	holes.addHole(0, SIZE_MAX);
+	EXPECT_EQ(1, holes.getCount());
+	EXPECT_TRUE(holes.isHole(0, 4096));
+}
+
+/****************************************************/
+TEST(TestHoleTracker, removeRange)
+{
+	HoleTracker holes;
+	holes.addHole(1000, 1000);
+
+	//split
+	holes.removeRange(1200, 100);
+	EXPECT_EQ(2, holes.getCount());
+	EXPECT_TRUE(holes.isHole(1000, 200));
+	EXPECT_FALSE(holes.isHole(1000, 300));
+	EXPECT_FALSE(holes.isHole(1250, 10));
+	EXPECT_TRUE(holes.isHole(1300, 700));
+
+	//remove on several
+	holes.removeRange(1100, 1000);
+	EXPECT_EQ(1, holes.getCount());
+	EXPECT_TRUE(holes.isHole(1000, 100));
+	EXPECT_FALSE(holes.isHole(1000, 200));
+
+	//remove all
+	holes.removeRange(0, 5000);
+	EXPECT_EQ(0, holes.getCount());
+}
+
+/****************************************************/
+TEST(TestHoleTracker, clear)
+{
+	HoleTracker holes;
+	holes.addHole(1000, 1000);
+	holes.clear();
+	EXPECT_EQ(0, holes.getCount());
+	EXPECT_FALSE(holes.isHole(1000, 10));
+}
+
+/****************************************************/
+TEST(TestHoleTracker, isZero)
+{
+	char buffer[4096];
+	memset(buffer, 0, sizeof(buffer));
+	EXPECT_TRUE(HoleTracker::isZero(buffer, sizeof(buffer)));
+	EXPECT_TRUE(HoleTracker::isZero(buffer, 0));
+	buffer[4095] = 1;
+	EXPECT_FALSE(HoleTracker::isZero(buffer, sizeof(buffer)));
+	buffer[4095] = 0;
+	buffer[0] = 1;
+	EXPECT_FALSE(HoleTracker::isZero(buffer, sizeof(buffer)));
+}
@@ -9,11 +9,42 @@
 #include "../Object.hpp"
 #include "../../backends/StorageBackendGMock.hpp"
 #include "../../backends/MemoryBackendMalloc.hpp"
+#include "../../backends/MemoryBackendWatermark.hpp"
 
 /****************************************************/
 using namespace IOC;
 using namespace testing;
 
+/****************************************************/
+/**
+ * Storage backend recording the vectored writes.
+**/
+class StorageBackendGMockRecordWritev : public StorageBackendGMock
+{
+	public:
+		virtual ssize_t pwritev(int64_t high, int64_t low, const struct iovec * iov, int iovcnt, size_t offset) override {
+			ssize_t status = StorageBackend::pwritev(high, low, iov, iovcnt, offset);
+			this->writes.push_back(std::make_pair(offset, iovcnt));
+			return status;
+		};
+		std::vector<std::pair<size_t, int>> writes;
+};
+
+/****************************************************/
+/**
+ * Storage backend reporting the first 4 KB as a hole.
+**/
+class StorageBackendGMockHoles : public StorageBackendGMock
+{
+	public:
+		virtual bool findHoles(int64_t high, int64_t low, HoleTracker & holes) override {
+			this->queries++;
+			holes.addHole(0, 4096);
+			return true;
+		};
+		int queries{0};
+};
+
 /****************************************************/
 TEST(TestObject, getBuffers_1)
 {
@@ -168,6 +199,111 @@ TEST(TestObject, data_load)
 	bool status = object.getBuffers(lst, 1000,500, ACCESS_READ);
 	EXPECT_TRUE(status);
 	EXPECT_EQ(1, lst.size());
+
+	//stats
+	ObjectLoadStats stats = object.getLoadStats();
+	EXPECT_EQ(1, stats.loads);
+	EXPECT_EQ(500, stats.loadedBytes);
+	EXPECT_EQ(0, stats.deduplicated);
+}
+
+/****************************************************/
+TEST(TestObject, data_load_async)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//expect a single load
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			memset(buffer, 1, size);
+			return size;
+		}));
+
+	//load, the second request waits the first one
+	int calls = 0;
+	object.loadAsync(1000, 500, false, [&calls](ObjectBuffersStatus status) {
+		EXPECT_EQ(OBJECT_BUFFERS_OK, status);
+		calls++;
+	});
+	object.loadAsync(1200, 100, false, [&calls](ObjectBuffersStatus status) {
+		EXPECT_EQ(OBJECT_BUFFERS_OK, status);
+		calls++;
+	});
+	EXPECT_EQ(0, calls);
+
+	//completed by the polling loop
+	storage.pollCompletions(false);
+	EXPECT_EQ(2, calls);
+
+	//in memory now
+	EXPECT_TRUE(object.checkBuffer(1000, 500, 1));
+	ObjectLoadStats stats = object.getLoadStats();
+	EXPECT_EQ(1, stats.loads);
+	EXPECT_EQ(500, stats.loadedBytes);
+	EXPECT_EQ(1, stats.deduplicated);
+}
+
+/****************************************************/
+TEST(TestObject, data_load_async_getBuffers)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//expect a single load
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+
+	//load
+	bool loaded = false;
+	object.loadAsync(1000, 500, false, [&loaded](ObjectBuffersStatus status) {
+		loaded = true;
+	});
+
+	//a synchronous request on an overlapping range completes it instead of reading again
+	ObjectSegmentList lst;
+	EXPECT_TRUE(object.getBuffers(lst, 1200, 100, ACCESS_READ));
+	EXPECT_TRUE(loaded);
+	ASSERT_EQ(1, lst.size());
+	EXPECT_EQ(1000, lst.front().offset);
+	EXPECT_EQ(500, lst.front().size);
+
+	//stats
+	ObjectLoadStats stats = object.getLoadStats();
+	EXPECT_EQ(1, stats.loads);
+	EXPECT_EQ(500, stats.loadedBytes);
+	EXPECT_EQ(1, stats.deduplicated);
+}
+
+/****************************************************/
+TEST(TestObject, data_load_async_destroyed)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object * object = new Object(&storage, &mback, objectId);
+
+	//expect a single load
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+
+	//load & destroy
+	ObjectBuffersStatus loadStatus = OBJECT_BUFFERS_OK;
+	object->loadAsync(1000, 500, false, [&loadStatus](ObjectBuffersStatus status) {
+		loadStatus = status;
+	});
+	delete object;
+
+	//the completion does not access the object
+	storage.pollCompletions(false);
+	EXPECT_EQ(OBJECT_BUFFERS_LOAD_ERROR, loadStatus);
 }
 
 /****************************************************/
@@ -196,6 +332,105 @@ TEST(TestObject, data_load_failure)
 	EXPECT_EQ(1, lst2.size());
 }
 
+/****************************************************/
+TEST(TestObject, out_of_memory)
+{
+	MemoryBackendWatermark mback(new MemoryBackendMalloc(NULL), 1000);
+	ObjectId objectId(10, 20);
+	Object object(NULL, &mback, objectId, 1000);
+
+	//fit in memory
+	ObjectSegmentList lst;
+	ObjectBuffersStatus status = OBJECT_BUFFERS_LOAD_ERROR;
+	EXPECT_TRUE(object.getBuffers(lst, 0, 500, ACCESS_WRITE, true, true, &status));
+	EXPECT_EQ(OBJECT_BUFFERS_OK, status);
+	EXPECT_EQ(1, lst.size());
+
+	//out of memory
+	ObjectSegmentList lst2;
+	EXPECT_FALSE(object.getBuffers(lst2, 2000, 500, ACCESS_WRITE, true, true, &status));
+	EXPECT_EQ(OBJECT_BUFFERS_NO_MEMORY, status);
+	EXPECT_EQ(0, lst2.size());
+	EXPECT_GT(mback.getFailures(), 0);
+
+	//cow also need memory on first write
+	Object * cow = object.makeFullCopyOnWrite(ObjectId(10, 21), false);
+	ObjectSegmentList lst3;
+	EXPECT_FALSE(cow->getBuffers(lst3, 0, 500, ACCESS_WRITE, true, true, &status));
+	EXPECT_EQ(OBJECT_BUFFERS_NO_MEMORY, status);
+	EXPECT_TRUE(cow->getBuffers(lst3, 0, 500, ACCESS_READ, true, false, &status));
+	delete cow;
+}
+
+/****************************************************/
+TEST(TestObject, throttle_miss)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	TokenBucket missThrottle(1, 100);
+	Object object(&storage, &mback, objectId);
+	object.setThrottles(NULL, &missThrottle);
+
+	//expect one load, the second one is throttled
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+
+	//first can go in debt
+	ObjectSegmentList lst;
+	ObjectBuffersStatus status = OBJECT_BUFFERS_LOAD_ERROR;
+	EXPECT_TRUE(object.getBuffers(lst, 1000, 500, ACCESS_READ, true, false, &status));
+	EXPECT_EQ(OBJECT_BUFFERS_OK, status);
+
+	//throttled
+	ObjectSegmentList lst2;
+	EXPECT_FALSE(object.getBuffers(lst2, 2000, 500, ACCESS_READ, true, false, &status));
+	EXPECT_EQ(OBJECT_BUFFERS_THROTTLED, status);
+	EXPECT_EQ(0, lst2.size());
+
+	//already loaded segments are not throttled
+	ObjectSegmentList lst3;
+	EXPECT_TRUE(object.getBuffers(lst3, 1000, 500, ACCESS_READ, true, false, &status));
+	EXPECT_EQ(1, missThrottle.takeStats().throttled);
+}
+
+/****************************************************/
+TEST(TestObject, throttle_flush)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	TokenBucket flushThrottle(1, 100);
+	Object object(&storage, &mback, objectId);
+	object.setThrottles(&flushThrottle, NULL);
+
+	//expect two writes, the throttled flush writes nothing
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(2)
+		.WillRepeatedly(Return(500));
+
+	//make dirty
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+
+	//first can go in debt
+	bool throttled = false;
+	EXPECT_EQ(0, object.flush(0, 0, &throttled));
+	EXPECT_FALSE(throttled);
+
+	//throttled, stays dirty
+	object.markDirty(1000, 500);
+	EXPECT_EQ(0, object.flush(0, 0, &throttled));
+	EXPECT_TRUE(throttled);
+	EXPECT_EQ(1, flushThrottle.takeStats().throttled);
+
+	//without the flag it waits, let it go
+	flushThrottle.setRate(0);
+	EXPECT_EQ(0, object.flush(0, 0));
+}
+
 /****************************************************/
 TEST(TestObject, data_create)
 {
@@ -213,6 +448,221 @@ TEST(TestObject, data_create)
 	object.create();
 }
 
+/****************************************************/
+TEST(TestObject, data_hole_create)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//create
+	EXPECT_CALL(storage, create(10,20)).Times(1).WillOnce(Return(0));
+	EXPECT_EQ(0, object.create());
+
+	//read without load
+	EXPECT_CALL(storage, pread(_, _, _, _, _)).Times(0);
+	EXPECT_TRUE(object.checkBuffer(1000, 500, 0));
+	EXPECT_EQ(1, object.getLoadStats().holes);
+	EXPECT_EQ(0, object.getLoadStats().loads);
+
+	//written ranges are not holes anymore
+	object.markDirty(1000, 500);
+	EXPECT_FALSE(object.isKnownHole(1000, 500));
+	EXPECT_TRUE(object.isKnownHole(2000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, data_hole_storage)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMockHoles storage;
+	Object object(&storage, &mback, objectId);
+
+	//in the hole
+	EXPECT_CALL(storage, pread(_, _, _, _, _)).Times(0);
+	EXPECT_TRUE(object.checkBuffer(1000, 500, 0));
+	Mock::VerifyAndClearExpectations(&storage);
+
+	//after the hole
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 5000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			memset(buffer, 1, size);
+			return size;
+		}));
+	EXPECT_TRUE(object.checkBuffer(5000, 500, 1));
+
+	//asked once
+	EXPECT_EQ(1, storage.queries);
+	EXPECT_FALSE(object.isKnownHole(5000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, data_hole_zero_read)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//read zeros
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			memset(buffer, 0, size);
+			return size;
+		}));
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 2000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			memset(buffer, 1, size);
+			return size;
+		}));
+	ObjectSegmentList lst1, lst2;
+	EXPECT_TRUE(object.getBuffers(lst1, 1000, 500, ACCESS_READ));
+	EXPECT_TRUE(object.getBuffers(lst2, 2000, 500, ACCESS_READ));
+
+	//learned
+	EXPECT_TRUE(object.isKnownHole(1000, 500));
+	EXPECT_FALSE(object.isKnownHole(2000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, data_deferred_create)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//defer, nothing done
+	object.deferCreate();
+	EXPECT_TRUE(object.hasPendingCreate());
+
+	//make dirty
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+
+	//created before the first flush, the error is reported by the flush
+	{
+		InSequence seq;
+		EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(-1));
+		EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000)).Times(1).WillOnce(Return(500));
+	}
+	EXPECT_EQ(-1, object.flush(0, 0));
+	EXPECT_FALSE(object.hasPendingCreate());
+
+	//reported only once
+	EXPECT_EQ(0, object.flush(0, 0));
+}
+
+/****************************************************/
+TEST(TestObject, data_deferred_create_read)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//defer
+	object.deferCreate();
+
+	//the first load creates the object which is new so it reads zeros without load
+	EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(0));
+	EXPECT_CALL(storage, pread(_, _, _, _, _)).Times(0);
+	EXPECT_TRUE(object.checkBuffer(1000, 500, 0));
+	EXPECT_FALSE(object.hasPendingCreate());
+	EXPECT_EQ(1, object.getLoadStats().holes);
+	EXPECT_EQ(0, object.getLoadStats().loads);
+	EXPECT_TRUE(object.isKnownHole(5000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, data_deferred_create_existing)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//defer
+	object.deferCreate();
+
+	//already exist in the storage so the original content is loaded
+	EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(-1));
+	EXPECT_CALL(storage, pread(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			memset(buffer, 1, size);
+			return size;
+		}));
+	EXPECT_TRUE(object.checkBuffer(1000, 500, 1));
+	EXPECT_EQ(0, object.getLoadStats().holes);
+	EXPECT_EQ(1, object.getLoadStats().loads);
+	EXPECT_FALSE(object.isKnownHole(5000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, data_deferred_create_after_write)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//defer & write without load
+	object.deferCreate();
+	ObjectSegmentList lst;
+	EXPECT_TRUE(object.getBuffers(lst, 3000, 500, ACCESS_WRITE, false));
+	object.markDirty(3000, 500);
+
+	//the creation does not reset an object having segments
+	EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(0));
+	EXPECT_EQ(0, object.applyPendingCreate());
+	EXPECT_FALSE(object.isKnownHole(5000, 500));
+	EXPECT_FALSE(object.isKnownHole(3000, 500));
+}
+
+/****************************************************/
+TEST(TestObject, throttle_flush_create_error)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	TokenBucket flushThrottle(1, 100);
+	Object object(&storage, &mback, objectId);
+	object.setThrottles(&flushThrottle, NULL);
+
+	//the creation fails
+	EXPECT_CALL(storage, create(10, 20)).Times(1).WillOnce(Return(-1));
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(2)
+		.WillRepeatedly(Return(500));
+
+	//make dirty & go in debt
+	object.deferCreate();
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+	flushThrottle.consume(500);
+
+	//throttled, the error is kept for the retry
+	bool throttled = false;
+	object.flush(0, 0, &throttled);
+	EXPECT_TRUE(throttled);
+	flushThrottle.setRate(0);
+	throttled = false;
+	EXPECT_EQ(-1, object.flush(0, 0, &throttled));
+	EXPECT_FALSE(throttled);
+
+	//reported once
+	object.markDirty(1000, 500);
+	EXPECT_EQ(0, object.flush(0, 0, &throttled));
+}
+
 /****************************************************/
 TEST(TestObject, data_flush)
 {
@@ -246,6 +696,166 @@ TEST(TestObject, data_flush)
 	object.flush(0,0);
 }
 
+/****************************************************/
+TEST(TestObject, data_submitFlush)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+
+	//expect a single write
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+
+	//make dirty
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+
+	//flush, the second one waits the first write
+	int ret1 = 1;
+	int ret2 = 1;
+	EXPECT_TRUE(object.submitFlush(0, 0, [&ret1](int status) {ret1 = status;}));
+	EXPECT_TRUE(object.submitFlush(0, 0, [&ret2](int status) {ret2 = status;}));
+	EXPECT_EQ(1, ret1);
+	EXPECT_EQ(1, ret2);
+
+	//completed by the polling loop, the segment is clean so the second writes nothing
+	storage.pollCompletions(false);
+	EXPECT_EQ(0, ret1);
+	EXPECT_EQ(0, ret2);
+}
+
+/****************************************************/
+TEST(TestObject, data_logFlush)
+{
+	//setup
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMock storage;
+	Object object(&storage, &mback, objectId);
+	char tmpl[] = "/tmp/ioc-test-object-wal-XXXXXX";
+	ASSERT_NE(nullptr, mkdtemp(tmpl));
+	WriteAheadLog wal(std::string(tmpl) + "/wal");
+
+	//nothing to log
+	EXPECT_EQ(0, object.logFlush(0, 0, wal));
+	EXPECT_EQ(0, wal.getSize());
+
+	//make dirty
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+
+	//log, nothing written to the storage
+	EXPECT_EQ(0, object.logFlush(0, 0, wal));
+	EXPECT_EQ(sizeof(WriteAheadLogRecord) + 500, wal.getSize());
+
+	//still dirty so written on flush
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Return(500));
+	EXPECT_EQ(0, object.flush(0, 0));
+
+	//clean
+	std::string cmd = std::string("rm -rf ") + tmpl;
+	ASSERT_EQ(0, system(cmd.c_str()));
+}
+
+/****************************************************/
+TEST(TestObject, data_logFlush_no_storage)
+{
+	//setup
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	Object object(NULL, &mback, objectId);
+	char tmpl[] = "/tmp/ioc-test-object-wal-XXXXXX";
+	ASSERT_NE(nullptr, mkdtemp(tmpl));
+	WriteAheadLog wal(std::string(tmpl) + "/wal");
+
+	//make dirty
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 1000, 500, ACCESS_WRITE, false);
+	object.markDirty(1000, 500);
+
+	//not logged, fallback on flush
+	EXPECT_EQ(-1, object.logFlush(0, 0, wal));
+	EXPECT_EQ(0, wal.getSize());
+	EXPECT_EQ(0, object.flush(0, 0));
+
+	//clean
+	std::string cmd = std::string("rm -rf ") + tmpl;
+	ASSERT_EQ(0, system(cmd.c_str()));
+}
+
+/****************************************************/
+TEST(TestObject, data_flush_merge)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMockRecordWritev storage;
+	Object object(&storage, &mback, objectId);
+
+	//make 3 contiguous segments and a separated one
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 0, 1000, ACCESS_WRITE, false);
+	lst.clear();
+	object.getBuffers(lst, 1000, 1000, ACCESS_WRITE, false);
+	lst.clear();
+	object.getBuffers(lst, 2000, 1000, ACCESS_WRITE, false);
+	lst.clear();
+	object.getBuffers(lst, 4000, 1000, ACCESS_WRITE, false);
+	object.markDirty(0, 3000);
+	object.markDirty(4000, 1000);
+
+	//expect calls to write
+	EXPECT_CALL(storage, pwrite(10, 20, _, 1000, _))
+		.Times(4)
+		.WillRepeatedly(Return(1000));
+
+	//flush
+	EXPECT_EQ(0, object.flush(0,0));
+
+	//check
+	ASSERT_EQ(1, storage.writes.size());
+	EXPECT_EQ(0, storage.writes[0].first);
+	EXPECT_EQ(3, storage.writes[0].second);
+}
+
+/****************************************************/
+TEST(TestObject, data_flush_merge_max)
+{
+	MemoryBackendMalloc mback(NULL);
+	ObjectId objectId(10, 20);
+	StorageBackendGMockRecordWritev storage;
+	Object object(&storage, &mback, objectId);
+	object.setMaxFlushSize(2000);
+
+	//make 3 contiguous segments
+	ObjectSegmentList lst;
+	object.getBuffers(lst, 0, 1000, ACCESS_WRITE, false);
+	lst.clear();
+	object.getBuffers(lst, 1000, 1000, ACCESS_WRITE, false);
+	lst.clear();
+	object.getBuffers(lst, 2000, 1000, ACCESS_WRITE, false);
+	object.markDirty(0, 3000);
+
+	//expect calls to write
+	EXPECT_CALL(storage, pwrite(10, 20, _, 1000, _))
+		.Times(3)
+		.WillRepeatedly(Return(1000));
+
+	//flush
+	EXPECT_EQ(0, object.flush(0,0));
+
+	//check
+	ASSERT_EQ(1, storage.writes.size());
+	EXPECT_EQ(0, storage.writes[0].first);
+	EXPECT_EQ(2, storage.writes[0].second);
+}
+
 /****************************************************/
 TEST(TestObject, getObejctId)
 {
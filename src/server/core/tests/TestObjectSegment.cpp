@@ -159,3 +159,23 @@ TEST(TestObjectSegment, move_operator)
 	EXPECT_FALSE(second.isCow());
 	EXPECT_EQ(buffer, (void*)second.getBuffer());
 }
+
+/****************************************************/
+TEST(TestObjectSegment, access_count)
+{
+	//build orig
+	MemoryBackendMalloc mback(NULL);
+	void * buffer = mback.allocate(64);
+	ObjectSegment segment(512, 64, (char*)buffer, &mback);
+	EXPECT_EQ(0, segment.getMemory()->getAccessCount());
+
+	//touch
+	segment.touch();
+	segment.touch();
+	segment.touch();
+	EXPECT_EQ(3, segment.getMemory()->getAccessCount());
+
+	//decay
+	segment.getMemory()->decayAccessCount();
+	EXPECT_EQ(1, segment.getMemory()->getAccessCount());
+}
@@ -0,0 +1,93 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <thread>
+#include "../TokenBucket.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+TEST(TestTokenBucket, constructor)
+{
+	TokenBucket bucket(1000);
+	EXPECT_EQ(1000, bucket.getRate());
+	EXPECT_EQ(100, bucket.getBurst());
+}
+
+/****************************************************/
+TEST(TestTokenBucket, unlimited)
+{
+	TokenBucket bucket;
+	EXPECT_EQ(0, bucket.getRate());
+	for (int i = 0 ; i < 100 ; i++)
+		EXPECT_TRUE(bucket.tryConsume(1024UL*1024UL*1024UL));
+	bucket.consume(1024UL*1024UL*1024UL);
+
+	//check stats
+	TokenBucketStats stats = bucket.takeStats();
+	EXPECT_EQ(101UL*1024UL*1024UL*1024UL, stats.consumed);
+	EXPECT_EQ(0, stats.throttled);
+	EXPECT_EQ(0, bucket.takeStats().consumed);
+}
+
+/****************************************************/
+TEST(TestTokenBucket, tryConsume)
+{
+	//one byte per second so it does not refill during the test
+	TokenBucket bucket(1, 100);
+
+	//can go in debt
+	EXPECT_TRUE(bucket.tryConsume(500));
+	EXPECT_FALSE(bucket.tryConsume(10));
+	EXPECT_FALSE(bucket.tryConsume(10));
+
+	//check stats
+	TokenBucketStats stats = bucket.takeStats();
+	EXPECT_EQ(500, stats.consumed);
+	EXPECT_EQ(2, stats.throttled);
+}
+
+/****************************************************/
+TEST(TestTokenBucket, consume)
+{
+	//vars
+	TokenBucket bucket(10000, 100);
+
+	//the first one empties the bucket, the next ones make 10ms of debt
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0 ; i < 6 ; i++)
+		bucket.consume(100);
+	auto elapsed = std::chrono::steady_clock::now() - start;
+
+	//check
+	EXPECT_GE(elapsed, std::chrono::milliseconds(35));
+	TokenBucketStats stats = bucket.takeStats();
+	EXPECT_EQ(600, stats.consumed);
+	EXPECT_EQ(5, stats.throttled);
+	EXPECT_GE(stats.throttledTimeUs, 35000);
+}
+
+/****************************************************/
+TEST(TestTokenBucket, setRate_wakeup)
+{
+	//vars
+	TokenBucket bucket(1, 1);
+	bucket.consume(1000);
+
+	//would wait for ages without the rate change
+	std::thread thread([&bucket](){
+		bucket.consume(10);
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	bucket.setRate(0);
+	thread.join();
+
+	//check
+	EXPECT_EQ(1010, bucket.takeStats().consumed);
+}
@@ -0,0 +1,204 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../WriteAheadLog.hpp"
+#include "../../backends/StorageBackendGMock.hpp"
+
+/****************************************************/
+using namespace IOC;
+using namespace testing;
+
+/****************************************************/
+class TestWriteAheadLog : public ::testing::Test
+{
+	protected:
+		std::string directory;
+		std::string path;
+		char data1[500];
+		char data2[500];
+		virtual void SetUp()
+		{
+			char tmpl[] = "/tmp/ioc-test-wal-XXXXXX";
+			ASSERT_NE(nullptr, mkdtemp(tmpl));
+			this->directory = tmpl;
+			this->path = this->directory + "/wal";
+			memset(this->data1, 'a', sizeof(this->data1));
+			memset(this->data2, 'b', sizeof(this->data2));
+		}
+
+		virtual void TearDown()
+		{
+			std::string cmd = "rm -rf " + this->directory;
+			ASSERT_EQ(0, system(cmd.c_str()));
+		}
+};
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, constructor)
+{
+	WriteAheadLog wal(this->path);
+	EXPECT_EQ(0, wal.getSize());
+	EXPECT_FALSE(wal.hasRecords());
+	EXPECT_FALSE(wal.hasSealed());
+}
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, append_replay)
+{
+	//append
+	{
+		WriteAheadLog wal(this->path);
+		std::vector<ObjectSegmentDescr> extents = {{this->data1, 1000, 500}, {this->data2, 2000, 500}};
+		EXPECT_TRUE(wal.append(10, 20, extents));
+		EXPECT_TRUE(wal.hasRecords());
+		EXPECT_EQ(2 * (sizeof(WriteAheadLogRecord) + 500), wal.getSize());
+	}
+
+	//reopen after a "crash"
+	WriteAheadLog wal(this->path);
+	EXPECT_EQ(2 * (sizeof(WriteAheadLogRecord) + 500), wal.getSize());
+
+	//replay
+	StorageBackendGMock storage;
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			EXPECT_EQ('a', ((char*)buffer)[0]);
+			return size;
+		}));
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 2000))
+		.Times(1)
+		.WillOnce(Invoke([](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			EXPECT_EQ('b', ((char*)buffer)[499]);
+			return size;
+		}));
+	EXPECT_TRUE(wal.replay(&storage));
+	EXPECT_EQ(0, wal.getSize());
+
+	//nothing more after replay
+	WriteAheadLog wal2(this->path);
+	EXPECT_EQ(0, wal2.getSize());
+}
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, torn_record)
+{
+	//append
+	{
+		WriteAheadLog wal(this->path);
+		std::vector<ObjectSegmentDescr> extents = {{this->data1, 1000, 500}};
+		EXPECT_TRUE(wal.append(10, 20, extents));
+	}
+
+	//simulate a partial write
+	int fd = open((this->path + ".0").c_str(), O_WRONLY | O_APPEND);
+	ASSERT_GE(fd, 0);
+	WriteAheadLogRecord record;
+	memset(&record, 0, sizeof(record));
+	ASSERT_EQ(sizeof(record), write(fd, &record, sizeof(record)));
+	ASSERT_EQ(100, write(fd, this->data2, 100));
+	close(fd);
+
+	//reopen, the torn record is dropped
+	WriteAheadLog wal(this->path);
+	EXPECT_EQ(sizeof(WriteAheadLogRecord) + 500, wal.getSize());
+
+	//append after
+	std::vector<ObjectSegmentDescr> extents = {{this->data2, 2000, 500}};
+	EXPECT_TRUE(wal.append(10, 20, extents));
+
+	//replay both
+	StorageBackendGMock storage;
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000)).Times(1).WillOnce(Return(500));
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 2000)).Times(1).WillOnce(Return(500));
+	EXPECT_TRUE(wal.replay(&storage));
+}
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, seal_release)
+{
+	//append
+	WriteAheadLog wal(this->path);
+	std::vector<ObjectSegmentDescr> extents1 = {{this->data1, 1000, 500}};
+	EXPECT_TRUE(wal.append(10, 20, extents1));
+
+	//seal
+	wal.seal();
+	EXPECT_FALSE(wal.hasRecords());
+	EXPECT_TRUE(wal.hasSealed());
+
+	//new records go to the other file
+	std::vector<ObjectSegmentDescr> extents2 = {{this->data2, 2000, 400}};
+	EXPECT_TRUE(wal.append(10, 20, extents2));
+	EXPECT_TRUE(wal.hasRecords());
+
+	//release
+	wal.releaseSealed();
+	EXPECT_FALSE(wal.hasSealed());
+	EXPECT_TRUE(wal.hasRecords());
+	EXPECT_EQ(sizeof(WriteAheadLogRecord) + 400, wal.getSize());
+}
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, replay_order)
+{
+	//log the same range twice in the two files
+	{
+		WriteAheadLog wal(this->path);
+		std::vector<ObjectSegmentDescr> extents1 = {{this->data1, 1000, 500}};
+		EXPECT_TRUE(wal.append(10, 20, extents1));
+		wal.seal();
+		std::vector<ObjectSegmentDescr> extents2 = {{this->data2, 1000, 500}};
+		EXPECT_TRUE(wal.append(10, 20, extents2));
+	}
+
+	//reopen, the newest file continues
+	WriteAheadLog wal(this->path);
+	EXPECT_TRUE(wal.hasRecords());
+	EXPECT_TRUE(wal.hasSealed());
+
+	//replay the oldest first
+	std::string order;
+	StorageBackendGMock storage;
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(2)
+		.WillRepeatedly(Invoke([&order](int64_t, int64_t, void * buffer, size_t size, size_t) {
+			order += ((char*)buffer)[0];
+			return size;
+		}));
+	EXPECT_TRUE(wal.replay(&storage));
+	EXPECT_EQ("ab", order);
+}
+
+/****************************************************/
+TEST_F(TestWriteAheadLog, replay_failure)
+{
+	//append
+	WriteAheadLog wal(this->path);
+	std::vector<ObjectSegmentDescr> extents = {{this->data1, 1000, 500}};
+	EXPECT_TRUE(wal.append(10, 20, extents));
+	wal.seal();
+
+	//fail, keep the records
+	StorageBackendGMock storage;
+	EXPECT_CALL(storage, pwrite(10, 20, _, 500, 1000))
+		.Times(2)
+		.WillOnce(Return(-1))
+		.WillOnce(Return(500));
+	EXPECT_FALSE(wal.replaySealed(&storage));
+	EXPECT_TRUE(wal.hasSealed());
+
+	//retry
+	EXPECT_TRUE(wal.replaySealed(&storage));
+	EXPECT_FALSE(wal.hasSealed());
+}
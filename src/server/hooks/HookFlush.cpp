@@ -16,10 +16,20 @@ using namespace IOC;
 /**
  * Constructor of the flush hook.
  * @param container The container to be able to access objects to flush.
+ * @param flushEngine If not NULL, make the writes in parallel with this engine
+ * and send the ack when they are all done. Otherwise submit them to the
+ * storage backend and send the ack from its completion.
+ * @param waitCompletion Wait the completion before returning (needed with
+ * passive polling), the flush is then synchronous without flush engine.
+ * @param wal If not NULL, send the ack once the dirty data are recorded in
+ * this write ahead log and let the server destage them later.
 **/
-HookFlush::HookFlush(Container * container)
+HookFlush::HookFlush(Container * container, FlushEngine * flushEngine, bool waitCompletion, WriteAheadLog * wal)
 {
 	this->container = container;
+	this->flushEngine = flushEngine;
+	this->waitCompletion = waitCompletion;
+	this->wal = wal;
 }
 
 /****************************************************/
@@ -35,12 +45,31 @@ LibfabricActionResult HookFlush::onMessage(LibfabricConnection * connection, Lib
 		.arg(request.lfClientId)
 		.end();
 
-	//flush object
+	//flush object, with the log ack once logged and fallback on a real flush if it fails
 	Object & object = this->container->getObject(objFlush.objectId);
-	int ret = object.flush(objFlush.offset, objFlush.size);
-
-	//send response
-	connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, request.lfClientId, ret);
+	if (this->wal != NULL && object.logFlush(objFlush.offset, objFlush.size, *this->wal) == 0) {
+		connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, request.lfClientId, 0);
+	} else if (this->flushEngine == NULL && this->waitCompletion) {
+		bool throttled = false;
+		int ret = object.flush(objFlush.offset, objFlush.size, &throttled);
+		if (throttled && ret == 0)
+			ret = IOC_LF_STATUS_RETRY_LATER;
+		connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, request.lfClientId, ret);
+	} else if (this->flushEngine == NULL) {
+		uint64_t lfClientId = request.lfClientId;
+		bool submitted = object.submitFlush(objFlush.offset, objFlush.size, [connection, lfClientId](int ret) {
+			connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, lfClientId, ret);
+		});
+		if (submitted == false)
+			connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, request.lfClientId, IOC_LF_STATUS_RETRY_LATER);
+	} else {
+		uint64_t lfClientId = request.lfClientId;
+		object.flushAsync(objFlush.offset, objFlush.size, *this->flushEngine, [connection, lfClientId](int ret) {
+			connection->sendResponse(IOC_LF_MSG_OBJ_FLUSH_ACK, lfClientId, ret);
+		});
+		if (this->waitCompletion)
+			this->flushEngine->pollCompletions(true);
+	}
 
 	//republish
 	request.terminate();
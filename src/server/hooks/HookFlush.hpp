@@ -10,6 +10,8 @@
 /****************************************************/
 #include "base/network/Hook.hpp"
 #include "../core/Container.hpp"
+#include "../core/FlushEngine.hpp"
+#include "../core/WriteAheadLog.hpp"
 
 /****************************************************/
 namespace IOC
@@ -22,11 +24,17 @@ namespace IOC
 class HookFlush : public Hook
 {
 	public:
-		HookFlush(Container * container);
+		HookFlush(Container * container, FlushEngine * flushEngine = NULL, bool waitCompletion = false, WriteAheadLog * wal = NULL);
 		virtual LibfabricActionResult onMessage(LibfabricConnection * connection, LibfabricClientRequest & request) override;
 	private:
 		/** Pointer to the container to be able to access objects **/
 		Container * container;
+		/** If not NULL, flush in parallel with this engine and ack on completion. **/
+		FlushEngine * flushEngine;
+		/** Wait the completion in the hook (for passive polling as the polling loop would not check it). **/
+		bool waitCompletion;
+		/** If not NULL, ack once the dirty data are logged, the server writes them later to the storage. **/
+		WriteAheadLog * wal;
 };
 
 }
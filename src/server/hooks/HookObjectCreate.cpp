@@ -16,10 +16,13 @@ using namespace IOC;
 /**
  * Constructor of the object create hook.
  * @param container The container to be able to access objects to create.
+ * @param lazyCreate Acknowledge immediately and let the container create the
+ * object in the storage later, the errors are then reported on flush.
 **/
-HookObjectCreate::HookObjectCreate(Container * container)
+HookObjectCreate::HookObjectCreate(Container * container, bool lazyCreate)
 {
 	this->container = container;
+	this->lazyCreate = lazyCreate;
 }
 
 /****************************************************/
@@ -36,8 +39,11 @@ LibfabricActionResult HookObjectCreate::onMessage(LibfabricConnection * connecti
 		.end();
 
 	//create object
-	Object & object = this->container->getObject(objCreate.objectId);
-	int ret = object.create();
+	int ret = 0;
+	if (this->lazyCreate)
+		this->container->deferObjectCreate(objCreate.objectId);
+	else
+		ret = this->container->getObject(objCreate.objectId).create();
 
 	//send response
 	connection->sendResponse(IOC_LF_MSG_OBJ_CREATE_ACK, request.lfClientId, ret);
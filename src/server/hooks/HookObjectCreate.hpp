@@ -22,11 +22,13 @@ namespace IOC
 class HookObjectCreate : public Hook
 {
 	public:
-		HookObjectCreate(Container * container);
+		HookObjectCreate(Container * container, bool lazyCreate = false);
 		virtual LibfabricActionResult onMessage(LibfabricConnection * connection, LibfabricClientRequest & request) override;
 	private:
 		/** Pointer to the container to be able to access objects **/
 		Container * container;
+		/** Acknowledge immediately and defer the creation in the storage. **/
+		bool lazyCreate;
 };
 
 }
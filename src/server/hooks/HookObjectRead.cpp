@@ -13,6 +13,8 @@
 #include "base/network/LibfabricConnection.hpp"
 #include "HookObjectRead.hpp"
 #include "../core/Consts.hpp"
+#include "RdmaAckPostAction.hpp"
+#include "RdmaPushPipeline.hpp"
 
 /****************************************************/
 using namespace IOC;
@@ -21,16 +23,27 @@ using namespace IOC;
 /**
  * Constructor of the object read hook.
  * @param container The container to be able to access objects to with read operation.
+ * @param stats The server stats to account the reads.
+ * @param rdmaChunkSize Size of the chunks of the reads larger than it, which are
+ * loaded and pushed with a pipeline. 0 to load the whole range before pushing it.
+ * @param rdmaMaxInflight Maximum number of chunks of a pipelined read being
+ * transferred at the same time.
+ * @param waitCompletion Wait the loads from the storage before returning
+ * (needed with passive polling).
 **/
-HookObjectRead::HookObjectRead(Container * container, ServerStats * stats)
+HookObjectRead::HookObjectRead(Container * container, ServerStats * stats, size_t rdmaChunkSize, size_t rdmaMaxInflight, bool waitCompletion)
 {
 	//check
 	assert(container != NULL);
 	assert(stats != NULL);
+	assert(rdmaMaxInflight > 0);
 
 	//assign
 	this->container = container;
 	this->stats = stats;
+	this->rdmaChunkSize = rdmaChunkSize;
+	this->rdmaMaxInflight = rdmaMaxInflight;
+	this->waitCompletion = waitCompletion;
 }
 
 /****************************************************/
@@ -71,23 +84,7 @@ void HookObjectRead::objRdmaPushToClient(LibfabricConnection * connection, uint6
 		uint64_t key = objReadWrite.iov.key;
 
 		//emit rdma write vec & implement callback
-		connection->rdmaWritev(clientId, iov + i, cnt, addr, key, [this, connection, ops,size, clientId](void){
-			//decrement
-			(*ops)--;
-
-			if (*ops == 0) {
-				//stats
-				this->stats->readSize += size;
-
-				//send response
-				connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, clientId, 0);
-
-				//clean
-				delete ops;
-			}
-			
-			return LF_WAIT_LOOP_KEEP_WAITING;
-		});
+		connection->rdmaWritev(clientId, iov + i, cnt, addr, key, connection->newPostAction<RdmaAckPostAction>(connection, clientId, ops, size, &this->stats->readSize));
 
 		//update offset
 		for (size_t j = 0 ; j < cnt ; j++)
@@ -142,6 +139,7 @@ void HookObjectRead::objEagerPushToClient(LibfabricConnection * connection, uint
 
 		//progress
 		cur += copySize;
+		i++;
 	}
 
 	//stats
@@ -169,22 +167,58 @@ LibfabricActionResult HookObjectRead::onMessage(LibfabricConnection * connection
 
 	//get buffers from object
 	Object & object = this->container->getObject(objReadWrite.objectId);
+
+	//large read, load the next chunks while pushing the first ones
+	size_t eagerMax = connection->getEagerLimits(request.lfClientId).maxRead;
+	if (this->rdmaChunkSize > 0 && objReadWrite.size > eagerMax && objReadWrite.size > this->rdmaChunkSize) {
+		RdmaPushPipeline * pipeline = new RdmaPushPipeline(connection, request.lfClientId, &object, objReadWrite, this->rdmaChunkSize, this->rdmaMaxInflight, this->stats, this->waitCompletion);
+		pipeline->start();
+		request.terminate();
+		return LF_WAIT_LOOP_KEEP_WAITING;
+	}
+
+	//whole range, answer once loaded without waiting the storage
+	uint64_t lfClientId = request.lfClientId;
+	object.loadAsync(objReadWrite.offset, objReadWrite.size, false, [this, connection, lfClientId, &object, objReadWrite](ObjectBuffersStatus loadStatus) mutable {
+		this->onLoaded(connection, lfClientId, object, objReadWrite, loadStatus);
+	});
+	if (this->waitCompletion)
+		object.waitLoads();
+
+	//republish
+	request.terminate();
+
+	return LF_WAIT_LOOP_KEEP_WAITING;
+}
+
+/****************************************************/
+/**
+ * Push the data to the client once the range has been loaded.
+ * @param connection The connection to answer.
+ * @param clientId The libfabric client ID.
+ * @param object The object to read, not accessed if the load failed as it may
+ * have been destroyed.
+ * @param objReadWrite The read request.
+ * @param loadStatus The status of the load.
+**/
+void HookObjectRead::onLoaded(LibfabricConnection * connection, uint64_t clientId, Object & object, LibfabricObjReadWriteInfos & objReadWrite, ObjectBuffersStatus loadStatus)
+{
+	//get buffers, the storage is not read anymore
 	ObjectSegmentList segments;
-	bool status = object.getBuffers(segments, objReadWrite.offset, objReadWrite.size, ACCESS_READ);
+	ObjectBuffersStatus buffersStatus = loadStatus;
+	bool status = (loadStatus == OBJECT_BUFFERS_OK) && object.getBuffers(segments, objReadWrite.offset, objReadWrite.size, ACCESS_READ, true, false, &buffersStatus);
 
 	//eager or rdma
 	if (status) {
-		if (objReadWrite.size <= IOC_EAGER_MAX_READ) {
-			this->objEagerPushToClient(connection, request.lfClientId, objReadWrite, segments);
+		if (objReadWrite.size <= connection->getEagerLimits(clientId).maxRead) {
+			this->objEagerPushToClient(connection, clientId, objReadWrite, segments);
 		} else {
-			this->objRdmaPushToClient(connection, request.lfClientId, objReadWrite, segments);
+			this->objRdmaPushToClient(connection, clientId, objReadWrite, segments);
 		}
+	} else if (buffersStatus == OBJECT_BUFFERS_NO_MEMORY || buffersStatus == OBJECT_BUFFERS_THROTTLED) {
+		this->stats->retryLater++;
+		connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, clientId, IOC_LF_STATUS_RETRY_LATER);
 	} else {
-		connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, request.lfClientId, -1);
+		connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, clientId, -1);
 	}
-
-	//republish
-	request.terminate();
-
-	return LF_WAIT_LOOP_KEEP_WAITING;
 }
@@ -23,15 +23,22 @@ namespace IOC
 class HookObjectRead : public Hook
 {
 	public:
-		HookObjectRead(Container * container, ServerStats * stats);
+		HookObjectRead(Container * container, ServerStats * stats, size_t rdmaChunkSize, size_t rdmaMaxInflight, bool waitCompletion = false);
 		virtual LibfabricActionResult onMessage(LibfabricConnection * connection, LibfabricClientRequest & request) override;
 	private:
+		void onLoaded(LibfabricConnection * connection, uint64_t clientId, Object & object, LibfabricObjReadWriteInfos & objReadWrite, ObjectBuffersStatus loadStatus);
 		void objRdmaPushToClient(LibfabricConnection * connection, uint64_t clientId, LibfabricObjReadWriteInfos & objReadWrite, ObjectSegmentList & segments);
 		void objEagerPushToClient(LibfabricConnection * connection, uint64_t clientId, LibfabricObjReadWriteInfos & objReadWrite, ObjectSegmentList & segments);
 	private:
 		/** Pointer to the container to be able to access objects **/
 		Container * container;
 		ServerStats * stats;
+		/** Size of the chunks of the large reads pushed with a pipeline, 0 to disable. **/
+		size_t rdmaChunkSize;
+		/** Maximum number of chunks of a pipelined read transferred at the same time. **/
+		size_t rdmaMaxInflight;
+		/** Wait the loads in the hook (for passive polling as the polling loop would not check them). **/
+		bool waitCompletion;
 };
 
 }
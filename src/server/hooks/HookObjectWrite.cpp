@@ -13,6 +13,7 @@
 #include "base/network/LibfabricConnection.hpp"
 #include "HookObjectWrite.hpp"
 #include "../core/Consts.hpp"
+#include "RdmaAckPostAction.hpp"
 
 /****************************************************/
 using namespace IOC;
@@ -21,8 +22,11 @@ using namespace IOC;
 /**
  * Constructor of the object write hook.
  * @param container The container to be able to access objects to with write operation.
+ * @param stats The server stats to account the writes.
+ * @param waitCompletion Wait the loads from the storage before returning
+ * (needed with passive polling).
 **/
-HookObjectWrite::HookObjectWrite(Container * container, ServerStats * stats)
+HookObjectWrite::HookObjectWrite(Container * container, ServerStats * stats, bool waitCompletion)
 {
 	//check
 	assert(container != NULL);
@@ -31,6 +35,7 @@ HookObjectWrite::HookObjectWrite(Container * container, ServerStats * stats)
 	//assign
 	this->container = container;
 	this->stats = stats;
+	this->waitCompletion = waitCompletion;
 }
 
 /****************************************************/
@@ -63,23 +68,7 @@ void HookObjectWrite::objRdmaFetchFromClient(LibfabricConnection * connection, u
 		//emit rdma write vec & implement callback
 		LibfabricAddr addr = objReadWrite.iov.addr + offset;
 		uint64_t key = objReadWrite.iov.key;
-		connection->rdmaReadv(clientId, iov + i, cnt, addr, key, [connection, ops, size, this, clientId](void){
-			//decrement
-			(*ops)--;
-
-			if (*ops == 0) {
-				//stats
-				this->stats->writeSize += size;
-
-				//send response
-				connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, clientId, 0);
-
-				//clean
-				delete ops;
-			}
-			
-			return LF_WAIT_LOOP_KEEP_WAITING;
-		});
+		connection->rdmaReadv(clientId, iov + i, cnt, addr, key, connection->newPostAction<RdmaAckPostAction>(connection, clientId, ops, size, &this->stats->writeSize));
 
 		//update offset
 		for (size_t j = 0 ; j < cnt ; j++)
@@ -151,10 +140,50 @@ LibfabricActionResult HookObjectWrite::onMessage(LibfabricConnection * connectio
 		.arg(request.lfClientId)
 		.end();
 
-	//get buffers from object
+	//load the partially written segments, answer once loaded without waiting the storage
 	Object & object = this->container->getObject(objReadWrite.objectId);
+	object.loadAsync(objReadWrite.offset, objReadWrite.size, true, [this, connection, request, &object, objReadWrite](ObjectBuffersStatus loadStatus) mutable {
+		this->onLoaded(connection, request, object, objReadWrite, loadStatus);
+	});
+	if (this->waitCompletion)
+		object.waitLoads();
+
+	return LF_WAIT_LOOP_KEEP_WAITING;
+}
+
+/****************************************************/
+/**
+ * Copy the data to the object once the partially written segments have been
+ * loaded and terminate the request. The request buffer is kept until then
+ * as it contains the eager data.
+ * @param connection The connection to answer.
+ * @param request The request of the client.
+ * @param object The object to write, not accessed if the load failed as it
+ * may have been destroyed.
+ * @param objReadWrite The write request.
+ * @param loadStatus The status of the load.
+**/
+void HookObjectWrite::onLoaded(LibfabricConnection * connection, LibfabricClientRequest & request, Object & object, LibfabricObjReadWriteInfos & objReadWrite, ObjectBuffersStatus loadStatus)
+{
+	//the object has been destroyed
+	if (loadStatus == OBJECT_BUFFERS_LOAD_ERROR) {
+		connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, request.lfClientId, -1);
+		request.terminate();
+		return;
+	}
+
+	//get buffers from object
 	ObjectSegmentList segments;
-	bool status = object.getBuffers(segments, objReadWrite.offset, objReadWrite.size, ACCESS_WRITE, true, true);
+	ObjectBuffersStatus buffersStatus = loadStatus;
+	bool status = (loadStatus == OBJECT_BUFFERS_OK) && object.getBuffers(segments, objReadWrite.offset, objReadWrite.size, ACCESS_WRITE, true, true, &buffersStatus);
+
+	//out of memory or throttled, ask the client to retry later, nothing has been written
+	if (status == false && (buffersStatus == OBJECT_BUFFERS_NO_MEMORY || buffersStatus == OBJECT_BUFFERS_THROTTLED)) {
+		this->stats->retryLater++;
+		connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, request.lfClientId, IOC_LF_STATUS_RETRY_LATER);
+		request.terminate();
+		return;
+	}
 
 	//eager or rdma
 	if (status) {
@@ -172,6 +201,4 @@ LibfabricActionResult HookObjectWrite::onMessage(LibfabricConnection * connectio
 
 	//republish
 	request.terminate();
-
-	return LF_WAIT_LOOP_KEEP_WAITING;
 }
@@ -23,15 +23,18 @@ namespace IOC
 class HookObjectWrite : public Hook
 {
 	public:
-		HookObjectWrite(Container * container, ServerStats * stats);
+		HookObjectWrite(Container * container, ServerStats * stats, bool waitCompletion = false);
 		virtual LibfabricActionResult onMessage(LibfabricConnection * connection, LibfabricClientRequest & request) override;
 	private:
+		void onLoaded(LibfabricConnection * connection, LibfabricClientRequest & request, Object & object, LibfabricObjReadWriteInfos & objReadWrite, ObjectBuffersStatus loadStatus);
 		void objRdmaFetchFromClient(LibfabricConnection * connection, uint64_t clientId, LibfabricObjReadWriteInfos & objReadWrite, ObjectSegmentList & segments);
 		void objEagerExtractFromMessage(LibfabricConnection * connection, uint64_t clientId, LibfabricObjReadWriteInfos & objReadWrite, ObjectSegmentList & segments);
 	private:
 		/** Pointer to the container to be able to access objects **/
 		Container * container;
 		ServerStats * stats;
+		/** Wait the loads in the hook (for passive polling as the polling loop would not check them). **/
+		bool waitCompletion;
 };
 
 }
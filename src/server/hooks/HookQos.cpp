@@ -0,0 +1,50 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include "base/common/Debug.hpp"
+#include "base/network/LibfabricConnection.hpp"
+#include "HookQos.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the qos hook.
+ * @param container The container holding the bandwidth limits.
+**/
+HookQos::HookQos(Container * container)
+{
+	this->container = container;
+}
+
+/****************************************************/
+LibfabricActionResult HookQos::onMessage(LibfabricConnection * connection, LibfabricClientRequest & request)
+{
+	//extract
+	LibfabricQosInfos qos;
+	request.deserializer.apply("qos", qos);
+
+	//debug
+	IOC_DEBUG_ARG("hook:qos", "Get qos %1 from client %2")
+		.arg(Serializer::stringify(qos))
+		.arg(request.lfClientId)
+		.end();
+
+	//apply
+	this->container->getFlushThrottle().setRate(qos.flushBandwidth);
+	this->container->getMissThrottle().setRate(qos.missBandwidth);
+
+	//send response
+	connection->sendResponse(IOC_LF_MSG_SET_QOS_ACK, request.lfClientId, 0);
+
+	//republish
+	request.terminate();
+
+	//ret
+	return LF_WAIT_LOOP_KEEP_WAITING;
+}
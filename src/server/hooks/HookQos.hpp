@@ -0,0 +1,34 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_HOOK_QOS_HPP
+#define IOC_HOOK_QOS_HPP
+
+/****************************************************/
+#include "base/network/Hook.hpp"
+#include "../core/Container.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Implement the server side handling of the bandwidth limits changes.
+**/
+class HookQos : public Hook
+{
+	public:
+		HookQos(Container * container);
+		virtual LibfabricActionResult onMessage(LibfabricConnection * connection, LibfabricClientRequest & request) override;
+	private:
+		/** Pointer to the container to access the bandwidth limits. **/
+		Container * container;
+};
+
+}
+
+#endif //IOC_HOOK_QOS_HPP
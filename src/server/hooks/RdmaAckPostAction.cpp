@@ -0,0 +1,62 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+//local
+#include "RdmaAckPostAction.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the post action.
+ * @param connection The connection to send the acknowledgement.
+ * @param clientId The libfabric client ID.
+ * @param ops Counter of RDMA operations of the request shared by all its actions.
+ * It is deleted by the last one.
+ * @param size The size of the request to account.
+ * @param statCounter The stat counter to increment by the size.
+**/
+RdmaAckPostAction::RdmaAckPostAction(LibfabricConnection * connection, uint64_t clientId, int * ops, size_t size, size_t * statCounter)
+{
+	//check
+	assert(connection != NULL);
+	assert(ops != NULL);
+	assert(statCounter != NULL);
+
+	//assign
+	this->ackConnection = connection;
+	this->clientId = clientId;
+	this->ops = ops;
+	this->size = size;
+	this->statCounter = statCounter;
+}
+
+/****************************************************/
+/**
+ * Decrement the pending operations and acknowledge the request on the last one.
+**/
+LibfabricActionResult RdmaAckPostAction::runPostAction(void)
+{
+	//decrement
+	(*this->ops)--;
+
+	if (*this->ops == 0) {
+		//stats
+		*this->statCounter += this->size;
+
+		//send response
+		this->ackConnection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, this->clientId, 0);
+
+		//clean
+		delete this->ops;
+	}
+
+	return LF_WAIT_LOOP_KEEP_WAITING;
+}
@@ -0,0 +1,45 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_RDMA_ACK_POST_ACTION_HPP
+#define IOC_RDMA_ACK_POST_ACTION_HPP
+
+/****************************************************/
+#include "base/network/LibfabricConnection.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Post action attached to each of the RDMA operations of an object read or
+ * write request. The last one to complete accounts the size in the stats
+ * and sends the acknowledgement to the client. It is built in the pool of the
+ * connection with LibfabricConnection::newPostAction() so handling a request
+ * does not allocate a std::function per RDMA operation.
+**/
+class RdmaAckPostAction : public LibfabricPostAction
+{
+	public:
+		RdmaAckPostAction(LibfabricConnection * connection, uint64_t clientId, int * ops, size_t size, size_t * statCounter);
+		virtual LibfabricActionResult runPostAction(void) override;
+	private:
+		/** Connection to send the acknowledgement. **/
+		LibfabricConnection * ackConnection;
+		/** Libfabric ID of the client to acknowledge. **/
+		uint64_t clientId;
+		/** Number of RDMA operations of the request not yet completed, shared by the actions. **/
+		int * ops;
+		/** Size of the request to account. **/
+		size_t size;
+		/** Stat counter to increment by the size. **/
+		size_t * statCounter;
+};
+
+}
+
+#endif //IOC_RDMA_ACK_POST_ACTION_HPP
@@ -0,0 +1,228 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+//std
+#include <cassert>
+#include <algorithm>
+//local
+#include "base/common/Debug.hpp"
+#include "../core/Consts.hpp"
+#include "RdmaPushPipeline.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+/**
+ * Constructor of the pipeline.
+ * @param connection The connection to make the RDMA operations.
+ * @param clientId The libfabric client ID.
+ * @param object The object to read.
+ * @param objReadWrite The read request of the client.
+ * @param chunkSize Size of the chunks, the chunks are aligned on it in the object.
+ * @param maxInflight Maximum number of chunks being transferred at the same time.
+ * @param stats The stats to account the read size and the retries.
+ * @param waitLoads Wait the loads of the chunks from the storage (needed with
+ * passive polling).
+**/
+RdmaPushPipeline::RdmaPushPipeline(LibfabricConnection * connection, uint64_t clientId, Object * object, const LibfabricObjReadWriteInfos & objReadWrite, size_t chunkSize, size_t maxInflight, ServerStats * stats, bool waitLoads)
+{
+	//check
+	assert(connection != NULL);
+	assert(object != NULL);
+	assert(chunkSize > 0);
+	assert(maxInflight > 0);
+	assert(stats != NULL);
+
+	//assign
+	this->connection = connection;
+	this->clientId = clientId;
+	this->object = object;
+	this->iov = objReadWrite.iov;
+	this->baseOffset = objReadWrite.offset;
+	this->size = objReadWrite.size;
+	this->nextOffset = objReadWrite.offset;
+	this->chunkSize = chunkSize;
+	this->slotOps.assign(maxInflight, 0);
+	this->inflight = 0;
+	this->status = 0;
+	this->stats = stats;
+	this->waitLoads = waitLoads;
+	this->refilling = false;
+}
+
+/****************************************************/
+/**
+ * Push the first chunks. The pipeline deletes itself when done so it must
+ * not be used after this call.
+**/
+void RdmaPushPipeline::start(void)
+{
+	this->refill();
+}
+
+/****************************************************/
+/**
+ * Push chunks until the pipeline is full and finish if nothing is in
+ * flight anymore. The pipeline is deleted in this case so it must not be
+ * used after this call.
+**/
+void RdmaPushPipeline::refill(void)
+{
+	//a load completing immediately, the loop of the caller continues
+	if (this->refilling)
+		return;
+
+	//fill the pipeline
+	this->refilling = true;
+	while (this->inflight < this->slotOps.size() && this->pushNextChunk()) {};
+	this->refilling = false;
+
+	//all done or failed on the first chunk
+	if (this->inflight == 0)
+		this->finish();
+}
+
+/****************************************************/
+/**
+ * Start the load of the next chunk, it is pushed to the client by
+ * onChunkLoaded().
+ * @return False if there is no more chunk to push or a load failed.
+**/
+bool RdmaPushPipeline::pushNextChunk(void)
+{
+	//nothing more to do
+	size_t endOffset = this->baseOffset + this->size;
+	if (this->status != 0 || this->nextOffset >= endOffset)
+		return false;
+
+	//compute chunk
+	size_t chunkOffset = this->nextOffset;
+	size_t chunkEnd = std::min(endOffset, (chunkOffset / this->chunkSize + 1) * this->chunkSize);
+	size_t chunkSize = chunkEnd - chunkOffset;
+
+	//get a free slot, the load counts as one operation
+	size_t slot = 0;
+	while (this->slotOps[slot] != 0)
+		slot++;
+	assert(slot < this->slotOps.size());
+	this->slotOps[slot] = 1;
+
+	//progress
+	this->inflight++;
+	this->nextOffset = chunkEnd;
+
+	//load
+	this->object->loadAsync(chunkOffset, chunkSize, false, [this, slot, chunkOffset, chunkSize](ObjectBuffersStatus loadStatus) {
+		this->onChunkLoaded(slot, chunkOffset, chunkSize, loadStatus);
+	});
+	if (this->waitLoads)
+		this->object->waitLoads();
+	return true;
+}
+
+/****************************************************/
+/**
+ * Push the segments of a chunk to the client once loaded.
+ * @param slot The slot of the chunk.
+ * @param chunkOffset Offset of the chunk in the object.
+ * @param chunkSize Size of the chunk.
+ * @param loadStatus Status of the load, the object is not accessed if it failed.
+**/
+void RdmaPushPipeline::onChunkLoaded(size_t slot, size_t chunkOffset, size_t chunkSize, ObjectBuffersStatus loadStatus)
+{
+	//get buffers, the storage is not read anymore
+	ObjectSegmentList segments;
+	ObjectBuffersStatus buffersStatus = loadStatus;
+	if (loadStatus != OBJECT_BUFFERS_OK || this->object->getBuffers(segments, chunkOffset, chunkSize, ACCESS_READ, true, false, &buffersStatus) == false) {
+		if (buffersStatus == OBJECT_BUFFERS_NO_MEMORY || buffersStatus == OBJECT_BUFFERS_THROTTLED) {
+			this->stats->retryLater++;
+			this->status = IOC_LF_STATUS_RETRY_LATER;
+		} else {
+			this->status = -1;
+		}
+		this->onRdmaDone(slot);
+		return;
+	}
+
+	//count number of ops
+	iovec * iov = Object::buildIovec(segments, chunkOffset, chunkSize);
+	for (size_t i = 0 ; i < segments.size() ; i += IOC_LF_MAX_RDMA_SEGS)
+		this->slotOps[slot]++;
+
+	//loop on all send groups (because LF cannot send more than 256 at same time)
+	size_t offset = chunkOffset - this->baseOffset;
+	for (size_t i = 0 ; i < segments.size() ; i += IOC_LF_MAX_RDMA_SEGS) {
+		//calc cnt
+		size_t cnt = std::min(segments.size() - i, (size_t)IOC_LF_MAX_RDMA_SEGS);
+
+		//emit rdma write vec
+		LibfabricAddr addr = this->iov.addr + offset;
+		this->connection->rdmaWritev(this->clientId, iov + i, cnt, addr, this->iov.key, this->connection->newPostAction<RdmaPushPipelinePostAction>(this, slot));
+
+		//update offset
+		for (size_t j = 0 ; j < cnt ; j++)
+			offset += iov[i+j].iov_len;
+	}
+
+	//remove temp
+	delete [] iov;
+
+	//the load is done
+	this->onRdmaDone(slot);
+}
+
+/****************************************************/
+/**
+ * Called when a RDMA operation or the load of a chunk completes. When the
+ * whole chunk is done it pushes the next one or finishes the request.
+ * @param slot The slot of the chunk.
+**/
+void RdmaPushPipeline::onRdmaDone(size_t slot)
+{
+	//check
+	assert(slot < this->slotOps.size());
+	assert(this->slotOps[slot] > 0);
+
+	//chunk not finished
+	if (--this->slotOps[slot] > 0)
+		return;
+
+	//refill
+	this->inflight--;
+	this->refill();
+}
+
+/****************************************************/
+/**
+ * Acknowledge the client and delete the pipeline.
+**/
+void RdmaPushPipeline::finish(void)
+{
+	//check
+	assert(this->inflight == 0);
+
+	//stats
+	if (this->status == 0)
+		this->stats->readSize += this->size;
+
+	//send response
+	this->connection->sendResponse(IOC_LF_MSG_OBJ_READ_WRITE_ACK, this->clientId, this->status);
+
+	//done
+	delete this;
+}
+
+/****************************************************/
+/**
+ * Notify the pipeline.
+**/
+LibfabricActionResult RdmaPushPipelinePostAction::runPostAction(void)
+{
+	this->pipeline->onRdmaDone(this->slot);
+	return LF_WAIT_LOOP_KEEP_WAITING;
+}
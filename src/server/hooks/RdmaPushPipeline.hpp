@@ -0,0 +1,95 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+#ifndef IOC_RDMA_PUSH_PIPELINE_HPP
+#define IOC_RDMA_PUSH_PIPELINE_HPP
+
+/****************************************************/
+//std
+#include <vector>
+//local
+#include "base/network/LibfabricConnection.hpp"
+#include "../core/Object.hpp"
+#include "../core/ServerStats.hpp"
+
+/****************************************************/
+namespace IOC
+{
+
+/****************************************************/
+/**
+ * Push a large object read to the client chunk by chunk so the segments of
+ * the next chunks are loaded from the storage while the previous ones are
+ * being transferred by RDMA. Only a bounded number of chunks are in flight,
+ * the completion of a chunk triggers the load and the push of the next one.
+ * The chunks are loaded with Object::loadAsync() and pushed when their load
+ * completes, which counts as one operation of their slot.
+ * The client is acknowledged once the last chunk has been transferred.
+ *
+ * It is allocated by the read hook and deletes itself when done. Everything
+ * runs in the polling thread of the connection.
+**/
+class RdmaPushPipeline
+{
+	public:
+		RdmaPushPipeline(LibfabricConnection * connection, uint64_t clientId, Object * object, const LibfabricObjReadWriteInfos & objReadWrite, size_t chunkSize, size_t maxInflight, ServerStats * stats, bool waitLoads = false);
+		void start(void);
+		void onRdmaDone(size_t slot);
+	private:
+		void refill(void);
+		bool pushNextChunk(void);
+		void onChunkLoaded(size_t slot, size_t chunkOffset, size_t chunkSize, ObjectBuffersStatus loadStatus);
+		void finish(void);
+	private:
+		/** Connection to make the RDMA operations and send the acknowledgement. **/
+		LibfabricConnection * connection;
+		/** Libfabric ID of the client. **/
+		uint64_t clientId;
+		/** The object to read. **/
+		Object * object;
+		/** Description of the client buffer. **/
+		Iov iov;
+		/** Offset of the read in the object. **/
+		size_t baseOffset;
+		/** Size of the read. **/
+		size_t size;
+		/** Offset in the object of the next chunk to push. **/
+		size_t nextOffset;
+		/** Size of the chunks. **/
+		size_t chunkSize;
+		/** Number of RDMA operations not yet completed for each in flight chunk, 0 if the slot is free. **/
+		std::vector<int> slotOps;
+		/** Number of chunks in flight. **/
+		size_t inflight;
+		/** Status to return to the client, a failing chunk stops the pipeline. **/
+		int32_t status;
+		/** Stats to account the read size and the retries. **/
+		ServerStats * stats;
+		/** Wait the loads of the chunks (for passive polling). **/
+		bool waitLoads;
+		/** Set while refill() is pushing the chunks, the loads completing immediately then let it continue. **/
+		bool refilling;
+};
+
+/****************************************************/
+/**
+ * Post action attached to the RDMA operations of a chunk of a pipeline.
+**/
+class RdmaPushPipelinePostAction : public LibfabricPostAction
+{
+	public:
+		RdmaPushPipelinePostAction(RdmaPushPipeline * pipeline, size_t slot) {this->pipeline = pipeline; this->slot = slot;};
+		virtual LibfabricActionResult runPostAction(void) override;
+	private:
+		/** The pipeline to notify. **/
+		RdmaPushPipeline * pipeline;
+		/** Slot of the chunk in the pipeline. **/
+		size_t slot;
+};
+
+}
+
+#endif //IOC_RDMA_PUSH_PIPELINE_HPP
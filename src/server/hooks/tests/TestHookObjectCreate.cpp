@@ -60,3 +60,32 @@ TEST_F(TestHookObjectCreate, simple_create)
 	ioc_client_obj_create(client, 10, 20);
 	ASSERT_TRUE(container.hasObject(ObjectId(10,20)));
 }
+
+/****************************************************/
+class TestHookObjectCreateLazy : public TestHookObjectCreate
+{
+	protected:
+		virtual void SetUp()
+		{
+			config.lazyCreate = true;
+			TestHookObjectCreate::SetUp();
+		}
+};
+
+/****************************************************/
+TEST_F(TestHookObjectCreateLazy, lazy_create)
+{
+	//replace backend
+	StorageBackendGMock storageBackend;
+	this->server->setStorageBackend(&storageBackend);
+
+	//ack without creating, the create is done before the flush reporting the error
+	Container & container = this->server->getContainer();
+	ASSERT_EQ(0, ioc_client_obj_create(client, 10, 20));
+	ASSERT_TRUE(container.hasObject(ObjectId(10,20)));
+	EXPECT_CALL(storageBackend, create(10, 20)).Times(1).WillOnce(Return(-1));
+	ASSERT_EQ(-1, ioc_client_obj_flush(client, 10, 20, 0, 0));
+
+	//replace
+	this->server->setStorageBackend(NULL);
+}
@@ -74,3 +74,86 @@ TEST_F(TestHookObjectFlush, simple_flush)
 	//replace
 	this->server->setStorageBackend(NULL);
 }
+
+/****************************************************/
+class TestHookObjectFlushThreads : public TestHookObjectFlush
+{
+	protected:
+		virtual void SetUp()
+		{
+			config.flushThreads = 2;
+			TestHookObjectFlush::SetUp();
+		}
+};
+
+/****************************************************/
+TEST_F(TestHookObjectFlushThreads, parallel_flush)
+{
+	//set buffer
+	char buffer[32];
+	memset(buffer, 8, sizeof(buffer));
+
+	//replace backend
+	StorageBackendGMock storageBackend;
+	this->server->setStorageBackend(&storageBackend);
+	this->server->getContainer().setMaxFlushSize(0);
+
+	//write in two segments
+	EXPECT_CALL(storageBackend, pread(10, 20, _, ALIGNEMENT, _)).Times(2).WillRepeatedly(Return(ALIGNEMENT));
+	ASSERT_EQ(0, ioc_client_obj_write(client, 10, 20, buffer, sizeof(buffer), 64));
+	ASSERT_EQ(0, ioc_client_obj_write(client, 10, 20, buffer, sizeof(buffer), ALIGNEMENT + 64));
+
+	//flush, the two writes are made by the engine threads
+	EXPECT_CALL(storageBackend, pwrite(10, 20, _, ALIGNEMENT, 0)).Times(1).WillOnce(Return(ALIGNEMENT));
+	EXPECT_CALL(storageBackend, pwrite(10, 20, _, ALIGNEMENT, ALIGNEMENT)).Times(1).WillOnce(Return(ALIGNEMENT));
+	ASSERT_EQ(0, ioc_client_obj_flush(client, 10, 20, 0, 0));
+
+	//replace
+	this->server->setStorageBackend(NULL);
+}
+
+/****************************************************/
+class TestHookObjectFlushWal : public TestHookObjectFlush
+{
+	protected:
+		std::string directory;
+		virtual void SetUp()
+		{
+			char tmpl[] = "/tmp/ioc-test-hook-wal-XXXXXX";
+			ASSERT_NE(nullptr, mkdtemp(tmpl));
+			this->directory = tmpl;
+			config.walPath = this->directory + "/wal";
+			TestHookObjectFlush::SetUp();
+		}
+
+		virtual void TearDown()
+		{
+			TestHookObjectFlush::TearDown();
+			std::string cmd = "rm -rf " + this->directory;
+			ASSERT_EQ(0, system(cmd.c_str()));
+		}
+};
+
+/****************************************************/
+TEST_F(TestHookObjectFlushWal, durable_flush)
+{
+	//set buffer
+	char buffer[32];
+	memset(buffer, 8, sizeof(buffer));
+
+	//replace backend
+	StorageBackendGMock storageBackend;
+	this->server->setStorageBackend(&storageBackend);
+
+	//write
+	EXPECT_CALL(storageBackend, pread(10, 20, _, ALIGNEMENT, 0)).Times(1).WillOnce(Return(ALIGNEMENT));
+	ASSERT_EQ(0, ioc_client_obj_write(client, 10, 20, buffer, sizeof(buffer), 64));
+
+	//ack once logged, the data are written by the periodic tasks
+	EXPECT_CALL(storageBackend, pwrite(10, 20, _, ALIGNEMENT, 0)).Times(1).WillOnce(Return(ALIGNEMENT));
+	ASSERT_EQ(0, ioc_client_obj_flush(client, 10, 20, 0, 0));
+	usleep(2 * IOC_SERVER_PERIODIC_TASKS_MS * 1000);
+
+	//replace
+	this->server->setStorageBackend(NULL);
+}
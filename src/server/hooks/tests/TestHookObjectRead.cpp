@@ -74,6 +74,31 @@ TEST_F(TestHookObjectRead, eager_comm_bug_brdm4216)
 		ASSERT_EQ(1, buffer[i]) << "i=" << i;
 }
 
+/****************************************************/
+TEST_F(TestHookObjectRead, rdma_pipeline)
+{
+	//fill two segments, read is split in 4 MB chunks by default
+	size_t size = 2 * ALIGNEMENT;
+	ASSERT_GT(size, this->config.rdmaChunkSize);
+	for (size_t seg = 0 ; seg < 2 ; seg++) {
+		char * ptr = (char*)this->server->getContainer().getObject(ObjectId(10,20)).getUniqBuffer(seg * ALIGNEMENT, ALIGNEMENT, ACCESS_READ, false);
+		ASSERT_NE(nullptr, ptr);
+		for (size_t i = 0 ; i < ALIGNEMENT ; i++)
+			ptr[i] = (seg * ALIGNEMENT + i) % 251;
+	}
+
+	//read starting in the middle of a chunk
+	size_t offset = 1024;
+	char * buffer = new char[size - offset];
+	ssize_t ret = ioc_client_obj_read(client, 10, 20, buffer, size - offset, offset);
+	ASSERT_EQ(size - offset, ret);
+
+	//check content
+	for (size_t i = 0 ; i < size - offset ; i++)
+		ASSERT_EQ((char)((offset + i) % 251), buffer[i]) << "i=" << i;
+	delete [] buffer;
+}
+
 /****************************************************/
 TEST_F(TestHookObjectRead, invalid)
 {
@@ -9,6 +9,7 @@
 #include <thread>
 #include "client/ioc-client.h"
 #include "server/core/Server.hpp"
+#include "server/backends/MemoryBackendMalloc.hpp"
 #include <gmock/gmock.h>
 
 /****************************************************/
@@ -71,3 +72,23 @@ TEST_F(TestHookObjectWrite, eager_comm_bug_brdm4216)
 			ASSERT_EQ(1, ptr[i]) << "i=" << i;
 	}
 }
+
+/****************************************************/
+TEST_F(TestHookObjectWrite, out_of_memory_retry_later)
+{
+	//limit the memory to one segment
+	config.maxMemory = ALIGNEMENT;
+	this->server->setMemoryBackend(new MemoryBackendMalloc(NULL));
+
+	//first segment fit in memory
+	char buffer[IOC_EAGER_MAX_WRITE];
+	memset(buffer, 1, sizeof(buffer));
+	EXPECT_EQ(0, ioc_client_obj_write(client, 10, 20, buffer, sizeof(buffer), 0));
+
+	//second one does not, the client give up after retrying
+	EXPECT_EQ(IOC_LF_STATUS_RETRY_LATER, ioc_client_obj_write(client, 10, 20, buffer, sizeof(buffer), ALIGNEMENT));
+
+	//the first one is still there
+	char * ptr = (char*)this->server->getContainer().getObject(ObjectId(10,20)).getUniqBuffer(0, sizeof(buffer), ACCESS_READ, false);
+	EXPECT_EQ(1, ptr[0]);
+}
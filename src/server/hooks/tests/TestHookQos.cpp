@@ -0,0 +1,60 @@
+/*****************************************************
+*  PROJECT  : IO Catcher                             *
+*  LICENSE  : Apache 2.0                             *
+*  COPYRIGHT: 2020-2022 Bull SAS All rights reserved *
+*****************************************************/
+
+/****************************************************/
+#include <gtest/gtest.h>
+#include <thread>
+#include "client/ioc-client.h"
+#include "server/core/Server.hpp"
+
+/****************************************************/
+using namespace IOC;
+
+/****************************************************/
+class TestHookQos : public ::testing::Test
+{
+	protected:
+		Server * server;
+		ioc_client_t * client;
+		Config config;
+		std::thread thread;
+		virtual void SetUp()
+		{
+			static int port = 9666;
+			char p[16];
+			sprintf(p, "%d", port);
+			port += 4;
+			config.initForUnitTests();
+			this->server = new Server(&config, p);
+			this->thread = std::thread([this](){
+				this->server->poll();
+			});
+			this->server->setOnClientConnect([](int){});
+			this->client = ioc_client_init("127.0.0.1", p);
+		}
+
+		virtual void TearDown()
+		{
+			ioc_client_fini(this->client);
+			this->server->stop();
+			this->thread.join();
+			delete this->server;
+		}
+};
+
+/****************************************************/
+TEST_F(TestHookQos, set_qos)
+{
+	Container & container = this->server->getContainer();
+	ASSERT_EQ(0, container.getFlushThrottle().getRate());
+	ASSERT_EQ(0, container.getMissThrottle().getRate());
+	ASSERT_EQ(0, ioc_client_set_qos(client, 100*1024*1024, 200*1024*1024));
+	ASSERT_EQ(100*1024*1024, container.getFlushThrottle().getRate());
+	ASSERT_EQ(200*1024*1024, container.getMissThrottle().getRate());
+	ASSERT_EQ(0, ioc_client_set_qos(client, 0, 0));
+	ASSERT_EQ(0, container.getFlushThrottle().getRate());
+	ASSERT_EQ(0, container.getMissThrottle().getRate());
+}
@@ -25,6 +25,7 @@
 	#include "clovis_api.h"
 	#include "backends/StorageBackendMero.hpp"
 #endif
+#include "backends/StorageBackendPosix.hpp"
 
 /****************************************************/
 using namespace IOC;
@@ -40,24 +41,30 @@ int main(int argc, const char ** argv)
 	//info
 	printf("LISTEN: %s\n", config.listenIP.c_str());
 
-	//init mero
+	//init storage
 	StorageBackend * storageBackend = NULL;
-	#ifdef NOMERO
-		printf("NOT USING MERO/MOTR\n");
-	#elif defined(HAVE_MERO)
-		printf("USING MERO RESSOURCE FILE: %s\n", config.meroRcFile.c_str());
-		int status = c0appz_init(0, (char*)config.meroRcFile.c_str());
-		assume(status == 0, "Failed to connect to Mero !");
-		storageBackend = new StorageBackendMero();
-	#elif defined(HAVE_MOTR)
-		printf("USING MOTR RESSOURCE FILE: %s\n", config.meroRcFile.c_str());
-		c0appz_set_manual_rc((char*)config.meroRcFile.c_str());
-		int status = c0appz_init(0);
-		assume(status == 0, "Failed to connect to Mero !");
-		storageBackend = new StorageBackendMero();
-	#else
-		#error "Shoud not compile this lins !"
-	#endif
+	bool useMero = config.storageDir.empty();
+	if (useMero == false) {
+		printf("USING POSIX STORAGE IN: %s\n", config.storageDir.c_str());
+		storageBackend = new StorageBackendPosix(config.storageDir);
+	} else {
+		#ifdef NOMERO
+			printf("NOT USING MERO/MOTR\n");
+		#elif defined(HAVE_MERO)
+			printf("USING MERO RESSOURCE FILE: %s\n", config.meroRcFile.c_str());
+			int status = c0appz_init(0, (char*)config.meroRcFile.c_str());
+			assume(status == 0, "Failed to connect to Mero !");
+			storageBackend = new StorageBackendMero();
+		#elif defined(HAVE_MOTR)
+			printf("USING MOTR RESSOURCE FILE: %s\n", config.meroRcFile.c_str());
+			c0appz_set_manual_rc((char*)config.meroRcFile.c_str());
+			int status = c0appz_init(0);
+			assume(status == 0, "Failed to connect to Mero !");
+			storageBackend = new StorageBackendMero();
+		#else
+			#error "Shoud not compile this lins !"
+		#endif
+	}
 
 	//run server
 	Server server(&config, "8556");
@@ -87,6 +94,7 @@ int main(int argc, const char ** argv)
 
 	//close clovis
 	#ifndef NOMERO
-		c0appz_free();
+		if (useMero)
+			c0appz_free();
 	#endif
 }